@@ -0,0 +1,5 @@
+
+#include <lz4.h>
+int main(){ char out[64]; return LZ4_compress_default("lz4", out, 3, sizeof(out)) > 0 ? 0 : 1; }
+
+
@@ -0,0 +1,2 @@
+$(TOP)/mk/gen/phony-list.mk: $(patsubst ./%,$(TOP)/%,$(filter-out %.d, mk/main.mk mk/check-env.mk mk/gen/allowed-variables.mk mk/configure.mk config.mk mk/defaults.mk mk/lib.mk mk/paths.mk mk/support/build.mk mk/install.mk admin/build.mk src/build.mk mk/packaging.mk mk/tools.mk))
+PHONY_LIST += default-goal FORCE sense love fetch support fetch-coffee-script build-coffee-script clean-coffee-script shrinkwrap-coffee-script list-patches-coffee-script support-coffee-script support-coffee-script_1.10.0 clean-coffee-script_1.10.0 fetch-browserify build-browserify clean-browserify shrinkwrap-browserify list-patches-browserify support-browserify support-browserify_13.1.0 clean-browserify_13.1.0 fetch-admin-deps build-admin-deps clean-admin-deps shrinkwrap-admin-deps list-patches-admin-deps support-admin-deps support-admin-deps_2.0.4 clean-admin-deps_2.0.4 fetch-gtest build-gtest clean-gtest shrinkwrap-gtest list-patches-gtest support-gtest support-gtest_1.7.0 clean-gtest_1.7.0 fetch-v8 build-v8 clean-v8 shrinkwrap-v8 list-patches-v8 support-v8 support-v8_3.30.33.16-patched clean-v8_3.30.33.16-patched fetch-re2 build-re2 clean-re2 shrinkwrap-re2 list-patches-re2 support-re2 support-re2_2015-11-01 clean-re2_2015-11-01 fetch-jemalloc build-jemalloc clean-jemalloc shrinkwrap-jemalloc list-patches-jemalloc support-jemalloc support-jemalloc_4.5.0 clean-jemalloc_4.5.0 support-include-jemalloc support-include-jemalloc_4.5.0 support-include-gtest support-include-gtest_1.7.0 support-include-v8 support-include-v8_3.30.33.16-patched support-include-re2 support-include-re2_2015-11-01 install-binaries install-manpages install-init install-config install-data install-docs install web-assets-watch web-assets generate-web-assets-cc src/all rethinkdb cache-bench deps build-clean check-syntax prepare_deb_package_dirs build-deb-src deb-src-dir build-deb install-osx build-osx clean-dist-dir reset-dist-dir dist-dir dist tags etags cscope clean all generate test))
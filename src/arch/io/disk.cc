@@ -25,6 +25,8 @@
 #include "arch/io/disk/conflict_resolving.hpp"
 #include "arch/io/disk/stats.hpp"
 #include "arch/io/disk/accounting.hpp"
+#include "arch/io/disk/scheduling.hpp"
+#include "arch/io/disk/uring.hpp"
 #include "backtrace.hpp"
 #include "config/args.hpp"
 #include "do_on_thread.hpp"
@@ -50,26 +52,54 @@ public:
     linux_disk_manager_t(linux_event_queue_t *queue,
                          int batch_factor,
                          int max_concurrent_io_requests,
+                         file_io_backend_t io_backend,
                          perfmon_collection_t *stats) :
         stack_stats(stats, "stack"),
         conflict_resolver(stats),
+        scheduler(stats, max_concurrent_io_requests),
         accounter(batch_factor),
         backend_stats(stats, "backend", accounter.producer),
-        backend(queue, backend_stats.producer, max_concurrent_io_requests),
         outstanding_txn(0)
     {
+        /* Create the backend that actually talks to the OS. */
+        std::function<void(pool_diskmgr_t::action_t *)> backend_done_fun
+            = std::bind(&stats_diskmgr_2_t::done, &backend_stats, ph::_1);
+        if (io_backend == file_io_backend_t::uring) {
+#if USE_IO_URING
+            if (uring_diskmgr_t::is_supported()) {
+                uring_backend.init(new uring_diskmgr_t(queue, backend_stats.producer,
+                                                       max_concurrent_io_requests));
+                uring_backend->done_fun = backend_done_fun;
+            } else {
+                logWRN("io_uring is not available on this system. Falling back to "
+                       "the thread pool I/O backend.");
+            }
+#else
+            logWRN("This build of RethinkDB doesn't support io_uring. Falling back to "
+                   "the thread pool I/O backend.");
+#endif
+        }
+        if (!uring_backend.has()) {
+            pool_backend.init(new pool_diskmgr_t(queue, backend_stats.producer,
+                                                 max_concurrent_io_requests));
+            pool_backend->done_fun = backend_done_fun;
+        }
+
         /* Hook up the `submit_fun`s of the parts of the IO stack that are above the
         queue. (The parts below the queue use the `passive_producer_t` interface instead
         of a callback function.) */
         stack_stats.submit_fun = std::bind(&conflict_resolving_diskmgr_t::submit,
                                            &conflict_resolver, ph::_1);
-        conflict_resolver.submit_fun = std::bind(&accounting_diskmgr_t::submit,
-                                                 &accounter, ph::_1);
+        conflict_resolver.submit_fun = std::bind(&scheduling_diskmgr_t::submit,
+                                                 &scheduler, ph::_1);
+        scheduler.submit_fun = std::bind(&accounting_diskmgr_t::submit,
+                                         &accounter, ph::_1);
 
         /* Hook up everything's `done_fun`. */
-        backend.done_fun = std::bind(&stats_diskmgr_2_t::done, &backend_stats, ph::_1);
         backend_stats.done_fun = std::bind(&accounting_diskmgr_t::done, &accounter, ph::_1);
-        accounter.done_fun = std::bind(&conflict_resolving_diskmgr_t::done,
+        accounter.done_fun = std::bind(&scheduling_diskmgr_t::done,
+                                       &scheduler, ph::_1);
+        scheduler.done_fun = std::bind(&conflict_resolving_diskmgr_t::done,
                                        &conflict_resolver, ph::_1);
         conflict_resolver.done_fun = std::bind(&stats_diskmgr_t::done, &stack_stats, ph::_1);
         stack_stats.done_fun = std::bind(&linux_disk_manager_t::done, this, ph::_1);
@@ -81,8 +111,9 @@ public:
                 outstanding_txn);
     }
 
-    void *create_account(int pri, int outstanding_requests_limit) {
-        return new accounting_diskmgr_t::account_t(&accounter, pri, outstanding_requests_limit);
+    void *create_account(int pri, int outstanding_requests_limit, io_class_t io_class) {
+        return new accounting_diskmgr_t::account_t(&accounter, pri,
+                                                   outstanding_requests_limit, io_class);
     }
 
     void destroy_account(void *account) {
@@ -178,9 +209,13 @@ private:
     action_t object for each operation and record its callback. Then it passes through
     the conflict resolver, which enforces ordering constraints between IO operations by
     holding back operations that must be run after other, currently-running, operations.
-    Then it goes to the account manager, which queues up running IO operations according
-    to which account they are part of. Finally the "backend" pops the IO operations
-    from the queue.
+    Then it goes to the scheduler, which holds back operations of latency classes
+    (such as GC) that currently have too many operations in flight, see
+    `scheduling_diskmgr_t`. Then it goes to the account manager, which queues up
+    running IO operations according to which account they are part of. Finally the
+    "backend" pops the IO operations from the queue. The backend is either a thread
+    pool running blocking syscalls, or an io_uring instance driven from this thread's
+    event loop; exactly one of `pool_backend` and `uring_backend` is set.
 
     At two points in the process--once as soon as it is submitted, and again right
     as the backend pops it off the queue--its statistics are recorded. The "stack stats"
@@ -191,9 +226,11 @@ private:
 
     stats_diskmgr_t stack_stats;
     conflict_resolving_diskmgr_t conflict_resolver;
+    scheduling_diskmgr_t scheduler;
     accounting_diskmgr_t accounter;
     stats_diskmgr_2_t backend_stats;
-    pool_diskmgr_t backend;
+    scoped_ptr_t<pool_diskmgr_t> pool_backend;
+    scoped_ptr_t<uring_diskmgr_t> uring_backend;
 
 
     intptr_t outstanding_txn;
@@ -202,11 +239,13 @@ private:
 };
 
 io_backender_t::io_backender_t(file_direct_io_mode_t _direct_io_mode,
-                               int max_concurrent_io_requests)
+                               int max_concurrent_io_requests,
+                               file_io_backend_t io_backend)
     : direct_io_mode(_direct_io_mode),
       diskmgr(new linux_disk_manager_t(&linux_thread_pool_t::get_thread()->queue,
                                        DEFAULT_IO_BATCH_FACTOR,
                                        max_concurrent_io_requests,
+                                       io_backend,
                                        &stats)) { }
 
 io_backender_t::~io_backender_t() { }
@@ -369,9 +408,10 @@ bool linux_file_t::coop_lock_and_check() {
 #endif
 }
 
-void *linux_file_t::create_account(int priority, int outstanding_requests_limit) {
+void *linux_file_t::create_account(int priority, int outstanding_requests_limit,
+                                   io_class_t io_class) {
     assert_thread();
-    return diskmgr->create_account(priority, outstanding_requests_limit);
+    return diskmgr->create_account(priority, outstanding_requests_limit, io_class);
 }
 
 void linux_file_t::destroy_account(void *account) {
@@ -29,10 +29,12 @@ public:
     // stops us from specifying this on a file-by-file basis, but right now there's no desire for
     // that.  See https://github.com/rethinkdb/rethinkdb/issues/97#issuecomment-19778177 .
     io_backender_t(file_direct_io_mode_t direct_io_mode,
-                   int max_concurrent_io_requests = DEFAULT_MAX_CONCURRENT_IO_REQUESTS);
+                   int max_concurrent_io_requests = DEFAULT_MAX_CONCURRENT_IO_REQUESTS,
+                   file_io_backend_t io_backend = file_io_backend_t::pool);
     ~io_backender_t();
     linux_disk_manager_t *get_diskmgr_ptr() { return diskmgr.get(); }
     file_direct_io_mode_t get_direct_io_mode() const;
+    perfmon_collection_t *get_stats() { return &stats; }
 
 protected:
     const file_direct_io_mode_t direct_io_mode;
@@ -85,7 +87,8 @@ public:
 
     bool coop_lock_and_check();
 
-    void *create_account(int priority, int outstanding_requests_limit);
+    void *create_account(int priority, int outstanding_requests_limit,
+                         io_class_t io_class);
     void destroy_account(void *account);
 
     ~linux_file_t();
@@ -47,13 +47,15 @@ struct accounting_diskmgr_account_t {
 
     accounting_diskmgr_account_t(accounting_diskmgr_t *_par,
                                  int _pri,
-                                 int _outstanding_requests_limit);
+                                 int _outstanding_requests_limit,
+                                 io_class_t _io_class);
 
     ~accounting_diskmgr_account_t();
 
     void push(action_t *action);
     void on_semaphore_available();
     co_semaphore_t *get_outstanding_requests_limiter();
+    io_class_t get_io_class() const { return io_class; }
 
 private:
     typedef accounting_diskmgr_eager_account_t eager_account_t;
@@ -63,6 +65,7 @@ private:
     accounting_diskmgr_t *par;
     int pri;
     int outstanding_requests_limit;
+    io_class_t io_class;
     scoped_ptr_t<eager_account_t> eager_account;
     // A scoped pointer because we create the drainer lazily on first use.
     scoped_ptr_t<auto_drainer_t> requests_drainer;
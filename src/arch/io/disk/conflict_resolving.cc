@@ -10,7 +10,7 @@
 void debug_print(printf_buffer_t *buf,
                  const conflict_resolving_diskmgr_action_t &action) {
     buf->appendf("cr_diskmgr_action{conflict_count=%d}<", action.conflict_count);
-    const accounting_diskmgr_action_t &parent_action = action;
+    const scheduling_diskmgr_action_t &parent_action = action;
     debug_print(buf, parent_action);
 }
 
@@ -142,12 +142,12 @@ void conflict_resolving_diskmgr_t::submit(action_t *action) {
 }
 
 void conflict_resolving_diskmgr_t::submit_action_downwards(action_t *action) {
-    accounting_diskmgr_action_t *action_payload =
-        static_cast<accounting_diskmgr_action_t *>(action);
+    scheduling_diskmgr_action_t *action_payload =
+        static_cast<scheduling_diskmgr_action_t *>(action);
     submit_fun(action_payload);
 }
 
-void conflict_resolving_diskmgr_t::done(accounting_diskmgr_action_t *payload) {
+void conflict_resolving_diskmgr_t::done(scheduling_diskmgr_action_t *payload) {
     /* The only payloads we get back via done() should be payloads that we sent into
     submit_fun(), which means they should actually be action_t objects secretly. */
     action_t *action = static_cast<action_t *>(payload);
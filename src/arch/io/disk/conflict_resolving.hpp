@@ -6,7 +6,7 @@
 #include <functional>
 #include <map>
 
-#include "arch/io/disk/accounting.hpp"
+#include "arch/io/disk/scheduling.hpp"
 #include "arch/runtime/runtime_utils.hpp"
 #include "config/args.hpp"
 #include "math.hpp"
@@ -51,7 +51,7 @@ functions:
 You should make a separate conflict_resolving_diskmgr_t for each file. */
 
 
-struct conflict_resolving_diskmgr_action_t : public accounting_diskmgr_action_t {
+struct conflict_resolving_diskmgr_action_t : public scheduling_diskmgr_action_t {
     int conflict_count;
 };
 
@@ -72,8 +72,8 @@ struct conflict_resolving_diskmgr_t {
     /* conflict_resolving_diskmgr_t calls submit_fun() to send actions down to the next
     level. The next level should call done() when the operation passed to submit_fun()
     is done. */
-    std::function<void(accounting_diskmgr_action_t *)> submit_fun;
-    void done(accounting_diskmgr_action_t *payload);
+    std::function<void(scheduling_diskmgr_action_t *)> submit_fun;
+    void done(scheduling_diskmgr_action_t *payload);
 
 private:
 
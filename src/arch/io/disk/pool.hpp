@@ -22,6 +22,7 @@
 struct iovec;
 class pool_diskmgr_t;
 class printf_buffer_t;
+class uring_diskmgr_t;
 
 /* The pool disk manager uses a thread pool in conjunction with synchronous
 (blocking) IO calls to asynchronously run IO requests. */
@@ -103,6 +104,7 @@ struct pool_diskmgr_action_t
 
 private:
     friend class pool_diskmgr_t;
+    friend class uring_diskmgr_t;
     pool_diskmgr_t *parent;
 
     enum action_type_t {ACTION_READ, ACTION_WRITE, ACTION_RESIZE};
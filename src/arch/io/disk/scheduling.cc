@@ -0,0 +1,202 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "arch/io/disk/scheduling.hpp"
+
+#include <inttypes.h>
+
+#include <algorithm>
+
+#include "containers/printf_buffer.hpp"
+
+// How long the scheduler observes completion latencies before it adapts the depth
+// limits.
+const int64_t IO_SCHED_WINDOW_MS = 100;
+
+// The latency target of each `io_sched_class_t`, in microseconds. Classes are
+// ordered by how tight their target is.
+const int64_t IO_SCHED_LATENCY_TARGETS_US[NUM_IO_SCHED_CLASSES] = {
+    2000,       // foreground_read
+    10000,      // foreground_write
+    50000,      // gc
+    100000      // backfill
+};
+
+const char *const IO_SCHED_CLASS_NAMES[NUM_IO_SCHED_CLASSES] = {
+    "foreground_read",
+    "foreground_write",
+    "gc",
+    "backfill"
+};
+
+class scheduling_diskmgr_t::sched_class_t {
+public:
+    sched_class_t(perfmon_collection_t *stats, const std::string &name,
+                  int64_t latency_target_us, int _depth_limit)
+        : latency_target(ticks_t{latency_target_us * THOUSAND}),
+          depth_limit(_depth_limit),
+          in_flight(0),
+          window_latency(ticks_t{0}),
+          window_completions(0),
+          pm_latency(secs_to_ticks(1), true),
+          stats_membership(stats,
+                           &pm_queued, (name + "_queued").c_str(),
+                           &pm_depth_limit, (name + "_depth_limit").c_str(),
+                           &pm_latency, (name + "_latency").c_str()) {
+        pm_depth_limit += depth_limit;
+    }
+
+    ~sched_class_t() {
+        rassert(waiting.empty());
+        rassert(in_flight == 0);
+    }
+
+    bool can_dispatch() const {
+        return !waiting.empty() && in_flight < depth_limit;
+    }
+
+    int64_t next_deadline() {
+        return waiting.head()->submit_time.nanos + latency_target.nanos;
+    }
+
+    void set_depth_limit(int new_depth_limit) {
+        pm_depth_limit += new_depth_limit - depth_limit;
+        depth_limit = new_depth_limit;
+    }
+
+    const ticks_t latency_target;
+    int depth_limit;
+    int in_flight;
+    intrusive_list_t<action_t> waiting;
+
+    // The completion latencies we observed during the current window.
+    ticks_t window_latency;
+    int64_t window_completions;
+
+    perfmon_counter_t pm_queued;
+    perfmon_counter_t pm_depth_limit;
+    perfmon_duration_sampler_t pm_latency;
+    perfmon_multi_membership_t stats_membership;
+
+private:
+    DISABLE_COPYING(sched_class_t);
+};
+
+void debug_print(printf_buffer_t *buf,
+                 const scheduling_diskmgr_action_t &action) {
+    buf->appendf("scheduling_diskmgr_action{class=%d, submit_time=%" PRIi64 "}<",
+                 static_cast<int>(action.sched_class), action.submit_time.nanos);
+    const accounting_diskmgr_action_t &parent_action = action;
+    debug_print(buf, parent_action);
+}
+
+scheduling_diskmgr_t::scheduling_diskmgr_t(perfmon_collection_t *stats,
+                                           int _max_depth)
+    : max_depth(_max_depth), window_start(get_ticks()) {
+    rassert(max_depth > 0);
+    for (int i = 0; i < NUM_IO_SCHED_CLASSES; ++i) {
+        classes[i].init(new sched_class_t(
+            stats, std::string("scheduler_") + IO_SCHED_CLASS_NAMES[i],
+            IO_SCHED_LATENCY_TARGETS_US[i], max_depth));
+    }
+}
+
+scheduling_diskmgr_t::~scheduling_diskmgr_t() { }
+
+void scheduling_diskmgr_t::submit(action_t *action) {
+    assert_thread();
+    switch (action->account->get_io_class()) {
+    case io_class_t::foreground:
+        action->sched_class = action->get_is_read()
+            ? io_sched_class_t::foreground_read
+            : io_sched_class_t::foreground_write;
+        break;
+    case io_class_t::gc:
+        action->sched_class = io_sched_class_t::gc;
+        break;
+    case io_class_t::backfill:
+        action->sched_class = io_sched_class_t::backfill;
+        break;
+    default:
+        unreachable();
+    }
+    action->submit_time = get_ticks();
+
+    sched_class_t *sched_class = classes[static_cast<int>(action->sched_class)].get();
+    sched_class->waiting.push_back(action);
+    ++sched_class->pm_queued;
+    dispatch();
+}
+
+void scheduling_diskmgr_t::done(accounting_diskmgr_action_t *payload) {
+    assert_thread();
+    /* We only get back actions that we passed to `submit_fun()`. */
+    action_t *action = static_cast<action_t *>(payload);
+    sched_class_t *sched_class = classes[static_cast<int>(action->sched_class)].get();
+
+    const ticks_t now = get_ticks();
+    rassert(sched_class->in_flight > 0);
+    --sched_class->in_flight;
+    sched_class->window_latency.nanos += now.nanos - action->dispatch_time.nanos;
+    ++sched_class->window_completions;
+    sched_class->pm_latency.end(&action->dispatch_time);
+
+    maybe_adapt_depth_limits(now);
+    dispatch();
+
+    done_fun(action);
+}
+
+void scheduling_diskmgr_t::dispatch() {
+    for (;;) {
+        sched_class_t *next_class = nullptr;
+        for (int i = 0; i < NUM_IO_SCHED_CLASSES; ++i) {
+            sched_class_t *sched_class = classes[i].get();
+            if (sched_class->can_dispatch()
+                && (next_class == nullptr
+                    || sched_class->next_deadline() < next_class->next_deadline())) {
+                next_class = sched_class;
+            }
+        }
+        if (next_class == nullptr) {
+            break;
+        }
+
+        action_t *action = next_class->waiting.head();
+        next_class->waiting.pop_front();
+        --next_class->pm_queued;
+        ++next_class->in_flight;
+        next_class->pm_latency.begin(&action->dispatch_time);
+        submit_fun(action);
+    }
+}
+
+void scheduling_diskmgr_t::maybe_adapt_depth_limits(ticks_t now) {
+    if (now.nanos - window_start.nanos < IO_SCHED_WINDOW_MS * MILLION) {
+        return;
+    }
+    window_start = now;
+
+    // Find the class with the tightest target that missed it.
+    int first_missed = NUM_IO_SCHED_CLASSES;
+    for (int i = 0; i < NUM_IO_SCHED_CLASSES; ++i) {
+        sched_class_t *sched_class = classes[i].get();
+        if (sched_class->window_completions > 0
+            && sched_class->window_latency.nanos
+               > sched_class->latency_target.nanos * sched_class->window_completions) {
+            first_missed = std::min(first_missed, i);
+        }
+        sched_class->window_latency = ticks_t{0};
+        sched_class->window_completions = 0;
+    }
+
+    for (int i = 0; i < NUM_IO_SCHED_CLASSES; ++i) {
+        sched_class_t *sched_class = classes[i].get();
+        if (first_missed == NUM_IO_SCHED_CLASSES) {
+            // Everyone is happy, let the throttled classes ramp up again.
+            sched_class->set_depth_limit(std::min(
+                max_depth,
+                sched_class->depth_limit + std::max(1, sched_class->depth_limit / 4)));
+        } else if (i > first_missed) {
+            sched_class->set_depth_limit(std::max(1, sched_class->depth_limit / 2));
+        }
+    }
+}
@@ -0,0 +1,82 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef ARCH_IO_DISK_SCHEDULING_HPP_
+#define ARCH_IO_DISK_SCHEDULING_HPP_
+
+#include <functional>
+#include <string>
+
+#include "arch/io/disk/accounting.hpp"
+#include "containers/intrusive_list.hpp"
+#include "containers/scoped.hpp"
+#include "perfmon/perfmon.hpp"
+#include "time.hpp"
+
+/* `scheduling_diskmgr_t` keeps background I/O (GC, backfills) from driving up the
+latency of foreground I/O on the same device. It sits between the
+`conflict_resolving_diskmgr_t` and the `accounting_diskmgr_t`, so all the operations
+it sees are free of conflicts and may be reordered.
+
+Every operation falls into one of the latency classes below, depending on the
+`io_class_t` of its account and whether it's a read. Each class has a latency target
+and a depth limit, which is the number of its operations that may be handed on to
+the accounter (and thus to the device) at a time. Operations beyond the limit wait
+in a per-class queue. Whenever a class has room, the waiting operation with the
+earliest deadline (the time it was submitted plus its class's latency target) goes
+first.
+
+The depth limits adapt to the observed completion latency, in the spirit of Linux's
+kyber scheduler: every `IO_SCHED_WINDOW_MS`, if the mean completion latency of a
+class exceeded its target, the depth limits of all classes with looser targets get
+halved. If every class met its target, the throttled limits grow again. */
+
+enum class io_sched_class_t {
+    foreground_read = 0,
+    foreground_write,
+    gc,
+    backfill
+};
+
+const int NUM_IO_SCHED_CLASSES = 4;
+
+struct scheduling_diskmgr_action_t
+    : public accounting_diskmgr_action_t,
+      public intrusive_list_node_t<scheduling_diskmgr_action_t> {
+    io_sched_class_t sched_class;
+    // When the action was submitted to the scheduler, and when it was passed on.
+    ticks_t submit_time;
+    ticks_t dispatch_time;
+};
+
+void debug_print(printf_buffer_t *buf,
+                 const scheduling_diskmgr_action_t &action);
+
+class scheduling_diskmgr_t : public home_thread_mixin_t {
+public:
+    typedef scheduling_diskmgr_action_t action_t;
+
+    // No class ever gets a depth limit above `max_depth`.
+    scheduling_diskmgr_t(perfmon_collection_t *stats, int max_depth);
+    ~scheduling_diskmgr_t();
+
+    void submit(action_t *action);
+    std::function<void(action_t *)> done_fun;
+
+    std::function<void(accounting_diskmgr_action_t *)> submit_fun;
+    void done(accounting_diskmgr_action_t *payload);
+
+private:
+    class sched_class_t;
+
+    // Passes on waiting actions for as long as some class has room.
+    void dispatch();
+    // Adjusts the depth limits if the current window is over.
+    void maybe_adapt_depth_limits(ticks_t now);
+
+    const int max_depth;
+    scoped_ptr_t<sched_class_t> classes[NUM_IO_SCHED_CLASSES];
+    ticks_t window_start;
+
+    DISABLE_COPYING(scheduling_diskmgr_t);
+};
+
+#endif /* ARCH_IO_DISK_SCHEDULING_HPP_ */
@@ -0,0 +1,381 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "arch/io/disk/uring.hpp"
+
+#if USE_IO_URING
+
+#include <linux/io_uring.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "arch/io/disk.hpp"
+#include "logger.hpp"
+
+// The kernel refuses to create rings with more entries than this.
+const unsigned int URING_MAX_ENTRIES = 32768;
+
+int sys_io_uring_setup(unsigned int entries, io_uring_params *params) {
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+int sys_io_uring_enter(int ring_fd, unsigned int to_submit, unsigned int min_complete,
+                       unsigned int flags) {
+    return syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags,
+                   nullptr, 0);
+}
+
+int sys_io_uring_register(int ring_fd, unsigned int opcode, const void *arg,
+                          unsigned int nr_args) {
+    return syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args);
+}
+
+/* `uring_ring_t` owns the ring file descriptor and the memory mappings that the
+kernel shares with us. It's only ever touched from the home thread of its
+`uring_diskmgr_t`, so the only synchronization we need is with the kernel. */
+struct uring_ring_t {
+    explicit uring_ring_t(unsigned int entries) : sq_ptr(nullptr), cq_ptr(nullptr),
+                                                  sqes(nullptr) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        ring_fd = sys_io_uring_setup(entries, &params);
+        guarantee_err(ring_fd >= 0, "io_uring_setup failed");
+
+        sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+        cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+        }
+
+        sq_ptr = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+        guarantee_err(sq_ptr != MAP_FAILED, "Could not map io_uring submission ring");
+        if (single_mmap) {
+            cq_ptr = sq_ptr;
+        } else {
+            cq_ptr = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+            guarantee_err(cq_ptr != MAP_FAILED,
+                          "Could not map io_uring completion ring");
+        }
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe *>(
+            mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES));
+        guarantee_err(sqes != MAP_FAILED, "Could not map io_uring submission entries");
+
+        char *sq = static_cast<char *>(sq_ptr);
+        sq_tail = reinterpret_cast<unsigned int *>(sq + params.sq_off.tail);
+        sq_mask = *reinterpret_cast<unsigned int *>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned int *>(sq + params.sq_off.array);
+        sq_entries = params.sq_entries;
+        local_sq_tail = *sq_tail;
+
+        char *cq = static_cast<char *>(cq_ptr);
+        cq_head = reinterpret_cast<unsigned int *>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned int *>(cq + params.cq_off.tail);
+        cq_mask = *reinterpret_cast<unsigned int *>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    }
+
+    ~uring_ring_t() {
+        munmap(sqes, sqes_size);
+        if (cq_ptr != sq_ptr) {
+            munmap(cq_ptr, cq_ring_size);
+        }
+        munmap(sq_ptr, sq_ring_size);
+        int res = close(ring_fd);
+        guarantee_err(res == 0, "Could not close io_uring file descriptor");
+    }
+
+    void register_eventfd(int event_fd) {
+        int res = sys_io_uring_register(ring_fd, IORING_REGISTER_EVENTFD, &event_fd, 1);
+        guarantee_err(res == 0, "Could not register eventfd with io_uring");
+    }
+
+    // Returns a zeroed submission entry. The caller must make sure that the ring
+    // isn't full.
+    io_uring_sqe *next_sqe() {
+        unsigned int index = local_sq_tail & sq_mask;
+        io_uring_sqe *sqe = &sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sq_array[index] = index;
+        ++local_sq_tail;
+        return sqe;
+    }
+
+    // Publishes all entries handed out by `next_sqe()` and submits up to `count` of
+    // them to the kernel. Returns how many it took, or the error if it took none
+    // because it's short of resources or of room for completions (`EAGAIN` or
+    // `EBUSY`).
+    int submit(unsigned int count) {
+        __atomic_store_n(sq_tail, local_sq_tail, __ATOMIC_RELEASE);
+        for (;;) {
+            int res = sys_io_uring_enter(ring_fd, count, 0, 0);
+            if (res >= 0) {
+                return res;
+            }
+            const int errsv = get_errno();
+            if (errsv == EINTR) {
+                continue;
+            }
+            guarantee_xerr(errsv == EAGAIN || errsv == EBUSY, errsv,
+                           "io_uring_enter failed");
+            return -errsv;
+        }
+    }
+
+    int ring_fd;
+    void *sq_ptr;
+    void *cq_ptr;
+    size_t sq_ring_size;
+    size_t cq_ring_size;
+
+    io_uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned int *sq_tail;
+    unsigned int sq_mask;
+    unsigned int *sq_array;
+    unsigned int sq_entries;
+    unsigned int local_sq_tail;
+
+    unsigned int *cq_head;
+    unsigned int *cq_tail;
+    unsigned int cq_mask;
+    io_uring_cqe *cqes;
+
+    DISABLE_COPYING(uring_ring_t);
+};
+
+/* An `op_t` tracks one action while it's in the ring. Actions that want datasyncs go
+through up to three phases; only one submission entry per action is ever in flight,
+so short reads and writes can simply be resubmitted for the remainder. */
+struct uring_diskmgr_t::op_t {
+    enum phase_t { PRE_SYNC, IO, POST_SYNC };
+
+    action_t *action;
+    phase_t phase;
+    scoped_array_t<iovec> vecs;
+    iovec *remaining_vecs;
+    size_t remaining_count;
+    int64_t bytes_done;
+    int64_t total_bytes;
+};
+
+bool uring_diskmgr_t::is_supported() {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int ring_fd = sys_io_uring_setup(1, &params);
+    if (ring_fd < 0) {
+        return false;
+    }
+    int res = close(ring_fd);
+    guarantee_err(res == 0, "Could not close io_uring file descriptor");
+    return true;
+}
+
+int uring_queue_depth(int max_concurrent_io_requests) {
+    guarantee(max_concurrent_io_requests > 0);
+    guarantee(max_concurrent_io_requests < MAXIMUM_MAX_CONCURRENT_IO_REQUESTS);
+    // Keep the same amount of queued requests as the pool disk manager would.
+    return std::min<int>(max_concurrent_io_requests * 2, URING_MAX_ENTRIES);
+}
+
+uring_diskmgr_t::uring_diskmgr_t(linux_event_queue_t *_queue,
+                                 passive_producer_t<action_t *> *_source,
+                                 int max_concurrent_io_requests)
+    : queue(_queue),
+      queue_depth(uring_queue_depth(max_concurrent_io_requests)),
+      source(_source),
+      ring(new uring_ring_t(queue_depth)),
+      n_pending(0),
+      n_unsubmitted(0),
+      n_in_flight(0),
+      fallback_pool(_queue, &fallback_queue, 1) {
+    // Every action has at most one submission entry in the ring at any time, so
+    // keeping `n_pending` below the ring size means the ring never overflows.
+    guarantee(ring->sq_entries >= static_cast<unsigned int>(queue_depth));
+    fallback_pool.done_fun = std::bind(&uring_diskmgr_t::on_fallback_done, this,
+                                       ph::_1);
+    ring->register_eventfd(completion_event.get_notify_fd());
+    queue->watch_event(&completion_event, this);
+
+    if (source->available->get()) {
+        pump();
+        submit_prepared();
+    }
+    source->available->set_callback(this);
+}
+
+uring_diskmgr_t::~uring_diskmgr_t() {
+    assert_thread();
+    rassert(n_pending == 0, "Destroying uring_diskmgr_t with pending operations");
+    source->available->unset_callback();
+    queue->forget_event(&completion_event, this);
+}
+
+void uring_diskmgr_t::on_source_availability_changed() {
+    assert_thread();
+    if (source->available->get()) {
+        pump();
+        submit_prepared();
+    }
+}
+
+void uring_diskmgr_t::on_event(DEBUG_VAR int events) {
+    assert_thread();
+    rassert(events == poll_event_in);
+    completion_event.consume_wakey_wakeys();
+    reap_completions();
+    pump();
+    submit_prepared();
+}
+
+void uring_diskmgr_t::pump() {
+    assert_thread();
+    while (source->available->get() && n_pending < queue_depth) {
+        action_t *a = source->pop();
+        n_pending++;
+
+        if (a->get_is_resize()) {
+            fallback_queue.push(a);
+            continue;
+        }
+
+        op_t *op = new op_t;
+        op->action = a;
+        op->phase = a->ds_op == datasync_op::wrap_in_datasyncs
+            ? op_t::PRE_SYNC
+            : op_t::IO;
+        a->copy_vectors(&op->vecs);
+        op->remaining_vecs = op->vecs.data();
+        op->remaining_count = op->vecs.size();
+        op->bytes_done = 0;
+        op->total_bytes = 0;
+        for (size_t i = 0; i < op->vecs.size(); ++i) {
+            op->total_bytes += op->vecs[i].iov_len;
+        }
+        prepare_sqe(op);
+    }
+}
+
+void uring_diskmgr_t::prepare_sqe(op_t *op) {
+    io_uring_sqe *sqe = ring->next_sqe();
+    action_t *a = op->action;
+    sqe->fd = a->fd;
+    sqe->user_data = reinterpret_cast<uintptr_t>(op);
+    switch (op->phase) {
+    case op_t::PRE_SYNC:
+    case op_t::POST_SYNC:
+        sqe->opcode = IORING_OP_FSYNC;
+        sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+        break;
+    case op_t::IO:
+        sqe->opcode = a->get_is_read() ? IORING_OP_READV : IORING_OP_WRITEV;
+        sqe->addr = reinterpret_cast<uintptr_t>(op->remaining_vecs);
+        sqe->len = std::min<size_t>(op->remaining_count, IOV_MAX);
+        sqe->off = a->offset + op->bytes_done;
+        break;
+    default:
+        unreachable();
+    }
+    ++n_unsubmitted;
+}
+
+void uring_diskmgr_t::submit_prepared() {
+    while (n_unsubmitted > 0) {
+        const int res = ring->submit(n_unsubmitted);
+        if (res >= 0) {
+            n_unsubmitted -= res;
+            n_in_flight += res;
+        } else if (reap_completions() == 0 && n_in_flight > 0) {
+            // The kernel is busy. Reaping completions makes room for more, and the
+            // ones still in flight will call `on_event()`, which submits the rest.
+            return;
+        }
+    }
+}
+
+int uring_diskmgr_t::reap_completions() {
+    int reaped = 0;
+    unsigned int head = *ring->cq_head;
+    unsigned int tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        const io_uring_cqe *cqe = &ring->cqes[head & ring->cq_mask];
+        op_t *op = reinterpret_cast<op_t *>(static_cast<uintptr_t>(cqe->user_data));
+        const int res = cqe->res;
+        ++head;
+        // Release the entry before handling it, so the kernel can reuse it.
+        __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+        --n_in_flight;
+        ++reaped;
+
+        action_t *a = op->action;
+        if (res == -EINTR || res == -EAGAIN) {
+            prepare_sqe(op);
+        } else if (res < 0) {
+            a->io_result = res;
+            finish(op);
+        } else if (op->phase == op_t::PRE_SYNC) {
+            op->phase = op_t::IO;
+            prepare_sqe(op);
+        } else if (op->phase == op_t::POST_SYNC) {
+            finish(op);
+        } else if (res == 0) {
+            // See `pool_diskmgr_action_t::perform_read_write` for why these errors
+            // are chosen.
+            if (a->get_is_write()) {
+                logERR("Failed I/O: vectored write of %" PRIi64 " bytes stopped after "
+                       "%" PRIi64 " bytes. Assuming we ran out of disk space.",
+                       op->total_bytes, op->bytes_done);
+                a->io_result = -ENOSPC;
+            } else {
+                logERR("Failed I/O: we tried to read from behind the end of the file. "
+                       "Either the file got truncated, or there is a bug in RethinkDB.");
+                a->io_result = -EINVAL;
+            }
+            finish(op);
+        } else {
+            op->bytes_done += action_t::advance_vector(&op->remaining_vecs,
+                                                       &op->remaining_count, res);
+            if (op->bytes_done < op->total_bytes) {
+                prepare_sqe(op);
+            } else {
+                a->io_result = op->total_bytes;
+                if (a->ds_op == datasync_op::wrap_in_datasyncs
+                    || a->ds_op == datasync_op::datasync_after) {
+                    op->phase = op_t::POST_SYNC;
+                    prepare_sqe(op);
+                } else {
+                    finish(op);
+                }
+            }
+        }
+        // `finish()` may have run callbacks that took more completions.
+        head = *ring->cq_head;
+        tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    }
+    return reaped;
+}
+
+void uring_diskmgr_t::finish(op_t *op) {
+    action_t *a = op->action;
+    delete op;
+    n_pending--;
+    done_fun(a);
+}
+
+void uring_diskmgr_t::on_fallback_done(action_t *action) {
+    assert_thread();
+    n_pending--;
+    pump();
+    submit_prepared();
+    done_fun(action);
+}
+
+#endif  // USE_IO_URING
@@ -0,0 +1,100 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef ARCH_IO_DISK_URING_HPP_
+#define ARCH_IO_DISK_URING_HPP_
+
+#include <functional>
+
+#include "arch/io/disk/pool.hpp"
+#include "arch/runtime/event_queue.hpp"
+#include "arch/runtime/system_event.hpp"
+#include "concurrency/queue/passive_producer.hpp"
+#include "concurrency/queue/unlimited_fifo.hpp"
+#include "containers/scoped.hpp"
+
+#if defined(__linux__) && !defined(NO_EVENTFD) && !defined(LEGACY_LINUX)
+#include <linux/version.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 6, 0)
+#define USE_IO_URING 1
+#else
+#define USE_IO_URING 0
+#endif
+#else
+#define USE_IO_URING 0
+#endif
+
+/* The uring disk manager is a drop-in replacement for `pool_diskmgr_t`. Instead of
+handing each action to a blocker pool thread, it submits reads and writes to a Linux
+io_uring instance owned by the event loop of its home thread. New actions are drawn
+from `source` in batches and submitted with a single `io_uring_enter` call, and
+completions are reaped in batches when the ring's eventfd fires.
+
+Resizes have no io_uring equivalent on the kernels we support, so they (and anything
+else the ring can't handle) are forwarded to an internal `pool_diskmgr_t`. If the
+kernel doesn't support io_uring at all, `uring_diskmgr_t::is_supported()` returns
+false and the caller should use `pool_diskmgr_t` instead. */
+
+class uring_diskmgr_t;
+
+#if USE_IO_URING
+
+struct uring_ring_t;
+
+class uring_diskmgr_t : private availability_callback_t,
+                        private linux_event_callback_t,
+                        public home_thread_mixin_debug_only_t {
+public:
+    typedef pool_diskmgr_action_t action_t;
+
+    /* Returns true if io_uring can be set up on the running kernel. */
+    static bool is_supported();
+
+    uring_diskmgr_t(linux_event_queue_t *queue, passive_producer_t<action_t *> *source,
+                    int max_concurrent_io_requests);
+    std::function<void(action_t *)> done_fun;
+    ~uring_diskmgr_t();
+
+private:
+    struct op_t;
+
+    void on_source_availability_changed();
+    void on_event(int events);
+
+    void pump();
+    void prepare_sqe(op_t *op);
+    void submit_prepared();
+    // Returns how many completions it handled.
+    int reap_completions();
+    void finish(op_t *op);
+    void on_fallback_done(action_t *action);
+
+    linux_event_queue_t *const queue;
+    const int queue_depth;
+    passive_producer_t<action_t *> *source;
+
+    scoped_ptr_t<uring_ring_t> ring;
+    system_event_t completion_event;
+
+    // Number of actions currently owned by this disk manager, including those that
+    // were forwarded to `fallback_pool`.
+    int n_pending;
+    // Number of SQEs that have been prepared but not yet passed to the kernel.
+    unsigned int n_unsubmitted;
+    // Number of SQEs that the kernel has taken but not completed yet.
+    unsigned int n_in_flight;
+
+    unlimited_fifo_queue_t<action_t *> fallback_queue;
+    pool_diskmgr_t fallback_pool;
+
+    DISABLE_COPYING(uring_diskmgr_t);
+};
+
+#else  // USE_IO_URING
+
+class uring_diskmgr_t {
+public:
+    static bool is_supported() { return false; }
+};
+
+#endif  // USE_IO_URING
+
+#endif  // ARCH_IO_DISK_URING_HPP_
@@ -0,0 +1,188 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/runtime/numa.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <string>
+#include <utility>
+
+#include "arch/runtime/runtime.hpp"
+#include "errors.hpp"
+#include "utils.hpp"
+
+namespace {
+
+std::vector<numa_node_placement_t> numa_placement;
+
+// Indexed by thread number.
+std::vector<int> numa_node_of_thread;
+
+#ifdef __linux__
+// Parses a sysfs CPU list like "0-7,16-23".  Returns false if it isn't one.
+bool parse_cpu_list(const std::string &list, std::vector<int32_t> *cpus_out) {
+    cpus_out->clear();
+    const char *p = list.c_str();
+    while (*p != '\0' && *p != '\n') {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p || first < 0) {
+            return false;
+        }
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            ++p;
+            last = strtol(p, &end, 10);
+            if (end == p || last < first) {
+                return false;
+            }
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; ++cpu) {
+            cpus_out->push_back(cpu);
+        }
+        if (*p == ',') {
+            ++p;
+        }
+    }
+    return true;
+}
+
+bool read_small_file(const std::string &path, std::string *contents_out) {
+    FILE *file = fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        return false;
+    }
+    char buf[4096];
+    size_t size = fread(buf, 1, sizeof(buf) - 1, file);
+    fclose(file);
+    contents_out->assign(buf, size);
+    return true;
+}
+#endif  // __linux__
+
+}  // namespace
+
+std::vector<numa_node_placement_t> read_numa_topology() {
+    std::vector<numa_node_placement_t> nodes;
+#ifdef __linux__
+    for (int32_t os_node = 0; os_node < MAX_NUMA_NODES; ++os_node) {
+        std::string list;
+        if (!read_small_file(
+                strprintf("/sys/devices/system/node/node%d/cpulist", os_node),
+                &list)) {
+            continue;
+        }
+        numa_node_placement_t node;
+        node.os_node = os_node;
+        if (!parse_cpu_list(list, &node.cpus)) {
+            return std::vector<numa_node_placement_t>();
+        }
+        // Nodes that only have memory are of no use to us.
+        if (!node.cpus.empty()) {
+            nodes.push_back(std::move(node));
+        }
+    }
+#endif
+    return nodes;
+}
+
+std::vector<int32_t> place_numa_threads(int num_db_threads,
+                                        std::vector<numa_node_placement_t> *nodes) {
+    size_t total_cpus = 0;
+    for (const numa_node_placement_t &node : *nodes) {
+        guarantee(!node.cpus.empty());
+        total_cpus += node.cpus.size();
+    }
+
+    // Node `i` gets the threads from `num_db_threads * (the CPUs of nodes before
+    // it) / total_cpus` on, so that the threads are split up in proportion to the
+    // CPUs.  Consecutive threads end up on the same node.
+    std::vector<int32_t> thread_cpus;
+    thread_cpus.reserve(num_db_threads);
+    size_t cpus_before = 0;
+    for (numa_node_placement_t &node : *nodes) {
+        node.threads.clear();
+        cpus_before += node.cpus.size();
+        const int32_t end = num_db_threads * cpus_before / total_cpus;
+        for (int32_t thread = thread_cpus.size(); thread < end; ++thread) {
+            thread_cpus.push_back(node.cpus[node.threads.size() % node.cpus.size()]);
+            node.threads.push_back(thread);
+        }
+    }
+    guarantee(thread_cpus.size() == static_cast<size_t>(num_db_threads));
+
+    // With fewer threads than nodes, some nodes don't get any.
+    std::vector<numa_node_placement_t> used_nodes;
+    for (numa_node_placement_t &node : *nodes) {
+        if (!node.threads.empty()) {
+            used_nodes.push_back(std::move(node));
+        }
+    }
+    *nodes = std::move(used_nodes);
+    return thread_cpus;
+}
+
+void set_numa_placement(std::vector<numa_node_placement_t> &&nodes) {
+    numa_node_of_thread.clear();
+    if (nodes.size() < 2) {
+        numa_placement.clear();
+        return;
+    }
+    numa_placement = std::move(nodes);
+    for (size_t i = 0; i < numa_placement.size(); ++i) {
+        for (int32_t thread : numa_placement[i].threads) {
+            if (numa_node_of_thread.size() <= static_cast<size_t>(thread)) {
+                numa_node_of_thread.resize(thread + 1, -1);
+            }
+            numa_node_of_thread[thread] = i;
+        }
+    }
+}
+
+const std::vector<numa_node_placement_t> &get_numa_placement() {
+    return numa_placement;
+}
+
+bool numa_mode_enabled() {
+    return !numa_placement.empty();
+}
+
+int get_num_numa_nodes() {
+    return numa_placement.size();
+}
+
+int get_thread_numa_node(threadnum_t thread) {
+    if (thread.threadnum < 0
+        || static_cast<size_t>(thread.threadnum) >= numa_node_of_thread.size()) {
+        return -1;
+    }
+    return numa_node_of_thread[thread.threadnum];
+}
+
+int get_current_numa_node() {
+    return get_thread_numa_node(get_thread_id());
+}
+
+void prefer_numa_node_for_memory(void *ptr, size_t size, int node) {
+    if (node < 0) {
+        return;
+    }
+    rassert(static_cast<size_t>(node) < numa_placement.size());
+#if defined(__linux__) && defined(SYS_mbind)
+    // `MPOL_PREFERRED` from <linux/mempolicy.h>, which we'd rather not depend on.
+    const int mpol_preferred = 1;
+    unsigned long node_mask = 1UL << numa_placement[node].os_node;
+    // This only fails on kernels without NUMA support, where there's nothing to do.
+    UNUSED long res = syscall(SYS_mbind, ptr, size, mpol_preferred, &node_mask,
+                              sizeof(node_mask) * 8 + 1, 0);
+#else
+    (void)ptr;
+    (void)size;
+#endif
+}
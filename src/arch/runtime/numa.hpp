@@ -0,0 +1,59 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_RUNTIME_NUMA_HPP_
+#define ARCH_RUNTIME_NUMA_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "threading.hpp"
+
+/* In NUMA mode (`--numa`), the thread pool splits the db threads among the NUMA
+nodes of the machine in proportion to how many CPUs each node has, and pins every db
+thread to one CPU of its node.  Whatever a thread allocates afterwards, and touches
+first, ends up in its node's memory.  The `buf_slab` allocator and the store thread
+allocation also ask here which node a thread is on.
+
+Outside of NUMA mode, and on machines with a single node, there is no placement and
+every thread is on node -1. */
+
+#define MAX_NUMA_NODES 64
+
+struct numa_node_placement_t {
+    // The node's number as the OS knows it, which is what `server_status` shows.
+    int32_t os_node;
+    std::vector<int32_t> cpus;
+    // The thread pool's threads that are pinned to the node's CPUs.
+    std::vector<int32_t> threads;
+};
+
+/* Reads the nodes that have CPUs and the CPUs of each from sysfs.  The `threads` are
+left empty.  Returns an empty vector if the system doesn't tell (which includes every
+platform other than Linux). */
+std::vector<numa_node_placement_t> read_numa_topology();
+
+/* Fills in the `threads` of `*nodes` for a thread pool with `num_db_threads` db
+threads, and returns the CPU each db thread should be pinned to. */
+std::vector<int32_t> place_numa_threads(int num_db_threads,
+                                        std::vector<numa_node_placement_t> *nodes);
+
+/* The thread pool sets the placement before it starts its threads and clears it
+after they've stopped.  A placement with fewer than two nodes means NUMA mode is off. */
+void set_numa_placement(std::vector<numa_node_placement_t> &&nodes);
+const std::vector<numa_node_placement_t> &get_numa_placement();
+
+bool numa_mode_enabled();
+int get_num_numa_nodes();
+
+/* Returns the index into `get_numa_placement()` of the node that `thread` is on, or
+-1 if NUMA mode is off or the thread isn't pinned (like the utility thread). */
+int get_thread_numa_node(threadnum_t thread);
+int get_current_numa_node();
+
+/* Asks the OS to take the pages of the given range from the node (an index into
+`get_numa_placement()`) when they get touched for the first time.  The OS still falls
+back to other nodes if the node has no free memory. */
+void prefer_numa_node_for_memory(void *ptr, size_t size, int node);
+
+#endif  // ARCH_RUNTIME_NUMA_HPP_
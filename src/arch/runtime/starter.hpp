@@ -8,8 +8,9 @@
 
 /* `run_in_thread_pool()` starts a RethinkDB thread pool, runs the given
 function in a coroutine inside of it, waits for the function to return, and then
-shuts down the thread pool. */
+shuts down the thread pool.  `numa_mode` is explained in numa.hpp. */
 
-void run_in_thread_pool(const std::function<void()> &fun, int worker_threads);
+void run_in_thread_pool(const std::function<void()> &fun, int worker_threads,
+                        bool numa_mode = false);
 
 #endif  // ARCH_RUNTIME_STARTER_HPP_
@@ -15,6 +15,7 @@
 #include "arch/os_signal.hpp"
 #include "arch/io/timer_provider.hpp"
 #include "arch/runtime/event_queue.hpp"
+#include "arch/runtime/numa.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/timing.hpp"
 #include "errors.hpp"
@@ -62,7 +63,8 @@ void linux_thread_pool_t::set_thread(linux_thread_t *val) {
     thread = val;
 }
 
-linux_thread_pool_t::linux_thread_pool_t(int worker_threads, bool _do_set_affinity) :
+linux_thread_pool_t::linux_thread_pool_t(int worker_threads, bool _do_set_affinity,
+                                         bool numa_mode) :
 #ifndef NDEBUG
       coroutine_summary(false),
 #endif
@@ -74,6 +76,15 @@ linux_thread_pool_t::linux_thread_pool_t(int worker_threads, bool _do_set_affini
     rassert(n_threads > 1);             // we want at least one non-utility thread
     rassert(n_threads <= MAX_THREADS);
 
+    if (numa_mode) {
+        std::vector<numa_node_placement_t> nodes = read_numa_topology();
+        numa_thread_cpus = place_numa_threads(worker_threads, &nodes);
+        set_numa_placement(std::move(nodes));
+        if (!numa_mode_enabled()) {
+            numa_thread_cpus.clear();
+        }
+    }
+
     int res;
 
     res = pthread_cond_init(&shutdown_cond, nullptr);
@@ -228,7 +239,15 @@ void linux_thread_pool_t::run_thread_pool(linux_thread_message_t *initial_messag
         guarantee_xerr(res == 0, res, "Could not create thread");
 
         // Don't set affinity for the utility thread
-        if (do_set_affinity && !is_utility_thread) {
+        if (!numa_thread_cpus.empty() && !is_utility_thread) {
+#ifdef _GNU_SOURCE
+            cpu_set_t mask;
+            CPU_ZERO(&mask);
+            CPU_SET(numa_thread_cpus[i], &mask);
+            res = pthread_setaffinity_np(pthreads[i], sizeof(cpu_set_t), &mask);
+            guarantee_xerr(res == 0, res, "Could not set thread affinity");
+#endif
+        } else if (do_set_affinity && !is_utility_thread) {
             // On Apple, the thread affinity API has awful documentation, so we don't even bother.
 #ifdef _GNU_SOURCE
             // Distribute threads evenly among CPUs
@@ -445,6 +464,10 @@ void linux_thread_pool_t::shutdown_thread_pool() {
 }
 
 linux_thread_pool_t::~linux_thread_pool_t() {
+    if (!numa_thread_cpus.empty()) {
+        set_numa_placement(std::vector<numa_node_placement_t>());
+    }
+
     int res;
 
     res = pthread_cond_destroy(&shutdown_cond);
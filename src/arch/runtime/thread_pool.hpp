@@ -6,6 +6,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 #include <atomic>
 
 #include "arch/compiler.hpp"
@@ -41,7 +42,10 @@ and shutting down the threads and event queues. */
 
 class linux_thread_pool_t {
 public:
-    linux_thread_pool_t(int worker_threads, bool do_set_affinity);
+    // In `numa_mode`, the worker threads get pinned to CPUs by NUMA node instead, as
+    // described in numa.hpp.  NUMA mode stays off on machines with a single node.
+    linux_thread_pool_t(int worker_threads, bool do_set_affinity,
+                        bool numa_mode = false);
 
     // When the process receives a SIGINT or SIGTERM, interrupt_message will be delivered to the
     // same thread that initial_message was delivered to, and interrupt_message will be set to
@@ -102,6 +106,8 @@ public:
 
     int n_threads;
     bool do_set_affinity;
+    // The CPU each worker thread gets pinned to in NUMA mode, or empty.
+    std::vector<int32_t> numa_thread_cpus;
 
 #ifdef _WIN32
     static linux_thread_pool_t *get_global_thread_pool();
@@ -105,8 +105,25 @@ enum class file_direct_io_mode_t {
     buffered_desired
 };
 
+// Which disk manager performs the actual file I/O.  `uring` falls back to `pool` if
+// io_uring isn't available on the running kernel.
+enum class file_io_backend_t {
+    pool,
+    uring
+};
+
 enum class datasync_op { no_datasyncs, wrap_in_datasyncs, datasync_after };
 
+// The kind of work that a file account's I/O belongs to.  The disk manager gives
+// foreground I/O lower latency than GC and backfills, see `scheduling_diskmgr_t`.
+// `backfill` covers other bulk background work, such as secondary index
+// post-construction, as well.
+enum class io_class_t {
+    foreground,
+    gc,
+    backfill
+};
+
 // A linux file.  It expects reads and writes and buffers to have an
 // alignment of DEVICE_BLOCK_SIZE.
 class file_t {
@@ -127,7 +144,8 @@ public:
     virtual void writev_async(int64_t offset, size_t length, scoped_array_t<iovec> &&bufs,
                               file_account_t *account, linux_iocallback_t *cb) = 0;
 
-    virtual void *create_account(int priority, int outstanding_requests_limit) = 0;
+    virtual void *create_account(int priority, int outstanding_requests_limit,
+                                 io_class_t io_class) = 0;
     virtual void destroy_account(void *account) = 0;
 
     virtual bool coop_lock_and_check() = 0;
@@ -138,7 +156,8 @@ private:
 
 class file_account_t {
 public:
-    file_account_t(file_t *f, int p, int outstanding_requests_limit = UNLIMITED_OUTSTANDING_REQUESTS);
+    file_account_t(file_t *f, int p, int outstanding_requests_limit = UNLIMITED_OUTSTANDING_REQUESTS,
+                   io_class_t io_class = io_class_t::foreground);
     ~file_account_t();
     void *get_account() { return account; }
 
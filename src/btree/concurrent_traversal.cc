@@ -107,6 +107,10 @@ public:
             ? continue_bool_t::ABORT : continue_bool_t::CONTINUE;
     }
 
+    virtual size_t read_ahead_budget() {
+        return cb_->read_ahead_budget();
+    }
+
     virtual profile::trace_t *get_trace() THROWS_NOTHING {
         return cb_->get_trace();
     }
@@ -7,6 +7,10 @@
 
 class concurrent_traversal_adapter_t;
 
+// The default number of leaves a concurrent traversal loads ahead of time.  See
+// `depth_first_traversal_callback_t::read_ahead_budget()`.
+const size_t DEFAULT_CONCURRENT_TRAVERSAL_READ_AHEAD_BUDGET = 16;
+
 namespace profile { class trace_t; }
 
 class concurrent_traversal_fifo_enforcer_signal_t {
@@ -54,6 +58,12 @@ public:
             concurrent_traversal_fifo_enforcer_signal_t waiter)
             THROWS_ONLY(interrupted_exc_t) = 0;
 
+    /* See `depth_first_traversal_callback_t`. Range reads load a few leaves ahead by
+    default. */
+    virtual size_t read_ahead_budget() {
+        return DEFAULT_CONCURRENT_TRAVERSAL_READ_AHEAD_BUDGET;
+    }
+
     virtual profile::trace_t *get_trace() THROWS_NOTHING { return nullptr; }
 
 protected:
@@ -1,6 +1,9 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "btree/depth_first_traversal.hpp"
 
+#include <algorithm>
+#include <deque>
+
 #include "btree/internal_node.hpp"
 #include "btree/leaf_node.hpp"
 #include "btree/operations.hpp"
@@ -18,7 +21,6 @@ scoped_key_value_t::scoped_key_value_t(scoped_key_value_t &&movee)
     : key_(movee.key_),
       value_(movee.value_),
       buf_(std::move(movee.buf_)) {
-    movee.key_ = nullptr;
     movee.value_ = nullptr;
 }
 
@@ -36,6 +38,16 @@ void scoped_key_value_t::reset() {
 }
 
 
+/* The read-ahead state of a whole traversal. We only read ahead in the internal nodes
+right above the leaves, which are the ones at depth `leaf_depth - 1`. Since the
+B-tree is balanced, we learn `leaf_depth` when we reach the first leaf. */
+struct traversal_read_ahead_t {
+    explicit traversal_read_ahead_t(size_t _budget)
+        : budget(_budget), leaf_depth(-1) { }
+    const size_t budget;
+    int leaf_depth;
+};
+
 /* Returns `true` if we reached the end of the subtree or range, and `false` if
 `cb->handle_value()` returned `false`. */
 continue_bool_t btree_depth_first_traversal(
@@ -46,6 +58,8 @@ continue_bool_t btree_depth_first_traversal(
         direction_t direction,
         const btree_key_t *left_excl_or_null,
         const btree_key_t *right_incl,
+        int depth,
+        traversal_read_ahead_t *read_ahead,
         signal_t *interruptor);
 
 continue_bool_t btree_depth_first_traversal(
@@ -104,9 +118,13 @@ continue_bool_t btree_depth_first_traversal(
             wait_interruptible(root_block->lock.read_acq_signal(), interruptor);
         }
 
+        // Read-ahead takes read locks on the blocks ahead, so it's only for reads.
+        traversal_read_ahead_t read_ahead(
+            access == access_t::read ? cb->read_ahead_budget() : 0);
         return btree_depth_first_traversal(
             std::move(root_block), range, cb, access, direction,
-            left_excl_or_null, right_incl_buf.btree_key(), interruptor);
+            left_excl_or_null, right_incl_buf.btree_key(), 0, &read_ahead,
+            interruptor);
     }
 }
 
@@ -146,6 +164,21 @@ void get_child_key_range(
     }
 }
 
+/* Acquires the given child of `parent` for read-ahead, and starts loading it if that
+doesn't involve waiting for other acquirers of the block. */
+counted_t<counted_buf_lock_and_read_t> acquire_for_read_ahead(
+        const counted_t<counted_buf_lock_and_read_t> &parent,
+        block_id_t child_id) {
+    counted_t<counted_buf_lock_and_read_t> lock
+        = make_counted<counted_buf_lock_and_read_t>(
+            &parent->lock, child_id, access_t::read);
+    if (lock->lock.read_acq_signal()->is_pulsed()) {
+        lock->read.init(new buf_read_t(&lock->lock));
+        lock->read->start_loading();
+    }
+    return lock;
+}
+
 continue_bool_t btree_depth_first_traversal(
         counted_t<counted_buf_lock_and_read_t> block,
         const key_range_t &range,
@@ -154,6 +187,8 @@ continue_bool_t btree_depth_first_traversal(
         direction_t direction,
         const btree_key_t *left_excl_or_null,
         const btree_key_t *right_incl,
+        int depth,
+        traversal_read_ahead_t *read_ahead,
         signal_t *interruptor) {
     bool skip;
     if (continue_bool_t::ABORT == cb->filter_range_ts(
@@ -164,7 +199,9 @@ continue_bool_t btree_depth_first_traversal(
     if (skip) {
         return continue_bool_t::CONTINUE;
     }
-    block->read.init(new buf_read_t(&block->lock));
+    if (!block->read.has()) {
+        block->read.init(new buf_read_t(&block->lock));
+    }
     const node_t *node = static_cast<const node_t *>(block->read->get_data_read());
     if (node::is_internal(node)) {
         if (continue_bool_t::ABORT == cb->handle_pre_internal(
@@ -181,10 +218,39 @@ continue_bool_t btree_depth_first_traversal(
             r.decrement();
             end_index = internal_node::get_offset_index(inode, r.btree_key()) + 1;
         }
-        for (int i = 0; i < end_index - start_index; ++i) {
-            int true_index = (direction == FORWARD ? start_index + i : (end_index - 1) - i);
+        const int num_children = end_index - start_index;
+        auto child_index = [&](int i) {
+            return direction == FORWARD ? start_index + i : (end_index - 1) - i;
+        };
+
+        // The read-ahead locks for the children after the current one, in traversal
+        // order.  They only get released when we get to them, or when we return.
+        std::deque<counted_t<counted_buf_lock_and_read_t> > read_ahead_locks;
+        int next_read_ahead = 1;
+
+        for (int i = 0; i < num_children; ++i) {
+            int true_index = child_index(i);
             const btree_internal_pair *pair = internal_node::get_pair_by_index(inode, true_index);
 
+            counted_t<counted_buf_lock_and_read_t> read_ahead_lock;
+            if (!read_ahead_locks.empty()) {
+                rassert(next_read_ahead > i);
+                read_ahead_lock = std::move(read_ahead_locks.front());
+                read_ahead_locks.pop_front();
+            }
+            if (depth + 1 == read_ahead->leaf_depth) {
+                next_read_ahead = std::max(next_read_ahead, i + 1);
+                while (next_read_ahead < num_children
+                       && read_ahead_locks.size() < read_ahead->budget) {
+                    const btree_internal_pair *ahead_pair =
+                        internal_node::get_pair_by_index(
+                            inode, child_index(next_read_ahead));
+                    read_ahead_locks.push_back(
+                        acquire_for_read_ahead(block, ahead_pair->lnode));
+                    ++next_read_ahead;
+                }
+            }
+
             // Get the child key range
             const btree_key_t *child_left_excl_or_null;
             const btree_key_t *child_right_incl;
@@ -203,19 +269,28 @@ continue_bool_t btree_depth_first_traversal(
                         cb->get_trace() != nullptr,
                         "Acquire block for read.",
                         cb->get_trace());
-                    lock = make_counted<counted_buf_lock_and_read_t>(
-                        &block->lock, pair->lnode, access);
+                    if (read_ahead_lock.has()) {
+                        lock = std::move(read_ahead_lock);
+                    } else {
+                        lock = make_counted<counted_buf_lock_and_read_t>(
+                            &block->lock, pair->lnode, access);
+                    }
                     wait_interruptible(lock->lock.read_acq_signal(), interruptor);
                 }
                 if (continue_bool_t::ABORT == btree_depth_first_traversal(
                         std::move(lock), range, cb, access, direction,
-                        child_left_excl_or_null, child_right_incl, interruptor)) {
+                        child_left_excl_or_null, child_right_incl, depth + 1,
+                        read_ahead, interruptor)) {
                     return continue_bool_t::ABORT;
                 }
             }
         }
         return continue_bool_t::CONTINUE;
     } else {
+        if (read_ahead->leaf_depth == -1) {
+            read_ahead->leaf_depth = depth;
+        }
+        rassert(read_ahead->leaf_depth == depth);
         if (continue_bool_t::ABORT == cb->handle_pre_leaf(
                 block, left_excl_or_null, right_incl, interruptor, &skip)) {
             return continue_bool_t::ABORT;
@@ -37,7 +37,7 @@ public:
 
     const btree_key_t *key() const {
         guarantee(buf_.has());
-        return key_;
+        return key_.btree_key();
     }
     const void *value() const {
         guarantee(buf_.has());
@@ -50,7 +50,8 @@ public:
     void reset();
 
 private:
-    const btree_key_t *key_;
+    // A copy, because leaf nodes with a key prefix don't store the whole key.
+    store_key_t key_;
     const void *value_;
     movable_t<counted_buf_lock_and_read_t> buf_;
 
@@ -126,6 +127,13 @@ public:
     resulting key ranges would be contiguous and non-overlapping, and they would together
     cover the full range of the traversal. */
 
+    /* How many blocks a read traversal may acquire and start loading ahead of the one
+    it's currently on. Read-ahead happens in the internal nodes right above the
+    leaves: when the traversal moves on to a leaf, it also starts loading up to this
+    many of the leaves that come after it, so a cold range read doesn't wait for the
+    disk one leaf at a time. The default of 0 disables read-ahead. */
+    virtual size_t read_ahead_budget() { return 0; }
+
     virtual profile::trace_t *get_trace() THROWS_NOTHING { return nullptr; }
 protected:
     virtual ~depth_first_traversal_callback_t() { }
@@ -0,0 +1,371 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "btree/erase_range.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include "btree/internal_node.hpp"
+#include "btree/leaf_node.hpp"
+#include "btree/node.hpp"
+#include "btree/operations.hpp"
+#include "buffer_cache/alt.hpp"
+
+// Detaches the value from the leaf node in `buf`, and then deletes it.
+void erase_value(buf_lock_t *buf, const void *value,
+                 const value_deleter_t *detacher, const value_deleter_t *deleter) {
+    detacher->delete_value(buf_parent_t(buf), value);
+    deleter->delete_value(buf_parent_t(buf->txn()), value);
+}
+
+// Erases the entries in `range` from the leaf node in `buf`, and returns how many of
+// them were values.
+int erase_leaf_entries_in_range(value_sizer_t *sizer, buf_lock_t *buf,
+                                const key_range_t &range,
+                                const value_deleter_t *detacher,
+                                const value_deleter_t *deleter) {
+    std::vector<store_key_t> keys;
+    int erased_values = 0;
+    {
+        buf_read_t read(buf);
+        auto node = static_cast<const leaf_node_t *>(read.get_data_read());
+        leaf::visit_entries(sizer, node, buf->get_recency(),
+            [&](const btree_key_t *key, repli_timestamp_t, const void *value) {
+                if (range.contains_key(key)) {
+                    if (value != nullptr) {
+                        erase_value(buf, value, detacher, deleter);
+                        ++erased_values;
+                    }
+                    keys.push_back(store_key_t(key));
+                }
+                return continue_bool_t::CONTINUE;
+            });
+    }
+    if (!keys.empty()) {
+        buf_write_t write(buf);
+        auto node = static_cast<leaf_node_t *>(write.get_data_write());
+        for (const store_key_t &key : keys) {
+            leaf::erase_presence(sizer, node, key.btree_key());
+        }
+    }
+    return erased_values;
+}
+
+// Erases the values in the leaf node in `buf`, and returns how many there were.  The
+// node itself is left alone.
+int erase_leaf_values(buf_lock_t *buf, const value_deleter_t *detacher,
+                      const value_deleter_t *deleter) {
+    int erased_values = 0;
+    buf_read_t read(buf);
+    auto node = static_cast<const leaf_node_t *>(read.get_data_read());
+    for (auto it = leaf::begin(*node); it != leaf::end(*node); ++it) {
+        erase_value(buf, (*it).second, detacher, deleter);
+        ++erased_values;
+    }
+    return erased_values;
+}
+
+void update_population(buf_parent_t parent, block_id_t stat_block_id,
+                       int64_t population_change) {
+    if (stat_block_id != NULL_BLOCK_ID && population_change != 0) {
+        buf_lock_t stat_block(parent, stat_block_id, access_t::write);
+        buf_write_t stat_block_write(&stat_block);
+        auto stat_block_buf = static_cast<btree_statblock_t *>(
+                stat_block_write.get_data_write(BTREE_STATBLOCK_SIZE));
+        stat_block_buf->population += population_change;
+    }
+}
+
+bool is_internal(buf_lock_t *buf) {
+    buf_read_t read(buf);
+    return node::is_internal(static_cast<const node_t *>(read.get_data_read()));
+}
+
+// A child of an internal node that overlaps the range that's being erased.
+struct erased_child_t {
+    block_id_t id;
+    // The largest key that can go in the child.
+    store_key_t right_inclusive;
+    // Whether all the keys that can go in the child lie in the range.
+    bool covered;
+};
+
+// Returns the children of the internal node in `buf` that overlap `range`, in order.
+// The node's keys lie in (`left_exclusive`, `right_inclusive`].
+std::vector<erased_child_t> get_erased_children(buf_lock_t *buf,
+                                                const store_key_t &left_exclusive,
+                                                const store_key_t &right_inclusive,
+                                                const key_range_t &range) {
+    std::vector<erased_child_t> children;
+    buf_read_t read(buf);
+    auto node = static_cast<const internal_node_t *>(read.get_data_read());
+    store_key_t child_left_exclusive = left_exclusive;
+    for (int i = 0; i < node->npairs; ++i) {
+        const btree_internal_pair *pair = internal_node::get_pair_by_index(node, i);
+        const store_key_t child_right_inclusive
+            = i == node->npairs - 1 ? right_inclusive : store_key_t(&pair->key);
+        if (!range.right.unbounded && child_left_exclusive >= range.right.key()) {
+            break;
+        }
+        if (child_right_inclusive >= range.left) {
+            // The smallest key that can go in the child.
+            store_key_t child_left = child_left_exclusive;
+            const bool covered = (!child_left.increment() || child_left >= range.left)
+                && (range.right.unbounded || child_right_inclusive < range.right.key());
+            children.push_back(
+                erased_child_t{pair->lnode, child_right_inclusive, covered});
+        }
+        child_left_exclusive = child_right_inclusive;
+    }
+    return children;
+}
+
+int get_npairs(buf_lock_t *buf) {
+    buf_read_t read(buf);
+    return static_cast<const internal_node_t *>(read.get_data_read())->npairs;
+}
+
+// Returns whether a child of the internal node in `buf` may be merged with a sibling.
+// That takes a child from the node, and merging or leveling an internal node that
+// isn't the root node needs it to have at least two.  (The root node gets replaced by
+// its last child instead.)
+bool can_merge_children(superblock_t *superblock, buf_lock_t *buf) {
+    return superblock->get_root_block_id() == buf->block_id() || get_npairs(buf) > 2;
+}
+
+// Detaches the children from `begin` on that lie entirely in the range from the
+// internal node in `buf`, and adds them to `*detached_out`.  The last of them gets the
+// keys they could hold, so it's kept, and so is the one before it if the node would
+// be left with a single child otherwise.  Returns the end of the detached children.
+std::vector<erased_child_t>::const_iterator detach_covered_children(
+        value_sizer_t *sizer, buf_lock_t *buf,
+        std::vector<erased_child_t>::const_iterator begin,
+        std::vector<erased_child_t>::const_iterator end,
+        std::vector<block_id_t> *detached_out) {
+    auto covered_end = begin;
+    while (covered_end != end && covered_end->covered) {
+        ++covered_end;
+    }
+    const int count = std::min<int>(covered_end - begin - 1, get_npairs(buf) - 2);
+    if (count <= 0) {
+        return begin;
+    }
+    buf_write_t write(buf);
+    auto node = static_cast<internal_node_t *>(write.get_data_write());
+    for (auto it = begin; it != begin + count; ++it) {
+        buf->detach_child(it->id);
+        internal_node::remove(sizer->block_size(), node, it->right_inclusive.btree_key());
+        detached_out->push_back(it->id);
+    }
+    return begin + count;
+}
+
+// Merges or levels the children of the internal node in `buf` that hold `keys`, if
+// they're underfull.  Stops if that makes one of them the root node.
+void handle_underfull_children(value_sizer_t *sizer, superblock_t *superblock,
+                               buf_lock_t *buf, const std::vector<store_key_t> &keys,
+                               const value_deleter_t *detacher) {
+    for (const store_key_t &key : keys) {
+        if (!can_merge_children(superblock, buf)) {
+            return;
+        }
+        block_id_t child_id;
+        {
+            buf_read_t read(buf);
+            child_id = internal_node::lookup(
+                static_cast<const internal_node_t *>(read.get_data_read()),
+                key.btree_key());
+        }
+        buf_lock_t child(buf, child_id, access_t::write);
+        check_and_handle_underfull(sizer, &child, buf, superblock, key.btree_key(),
+                                   detacher);
+        if (superblock->get_root_block_id() == child.block_id()) {
+            return;
+        }
+    }
+}
+
+// Erases the entries in `range` from the children of the internal node in `buf`, which
+// are leaf nodes, and returns how many of them were values.  The node's keys lie in
+// (`left_exclusive`, `right_inclusive`].
+int erase_children_in_range(value_sizer_t *sizer, superblock_t *superblock,
+                            buf_lock_t *buf, buf_lock_t *last_buf,
+                            const store_key_t &left_exclusive,
+                            const store_key_t &right_inclusive,
+                            const key_range_t &range,
+                            const value_deleter_t *detacher,
+                            const value_deleter_t *deleter,
+                            std::vector<block_id_t> *detached_out) {
+    const std::vector<erased_child_t> children
+        = get_erased_children(buf, left_exclusive, right_inclusive, range);
+
+    // The children that are covered come one after another.
+    auto covered_begin = children.cbegin();
+    while (covered_begin != children.cend() && !covered_begin->covered) {
+        ++covered_begin;
+    }
+    const auto detached_end = detach_covered_children(
+        sizer, buf, covered_begin, children.cend(), detached_out);
+
+    // The keys of the children that are left, to merge or level them below.
+    std::vector<store_key_t> keys;
+    int erased_values = 0;
+    for (auto it = children.cbegin(); it != children.cend(); ++it) {
+        if (it >= covered_begin && it < detached_end) {
+            continue;
+        }
+        buf_lock_t child(buf, it->id, access_t::write);
+        if (!it->covered) {
+            erased_values += erase_leaf_entries_in_range(
+                sizer, &child, range, detacher, deleter);
+        } else {
+            erased_values += erase_leaf_values(&child, detacher, deleter);
+            buf_write_t write(&child);
+            leaf::init(sizer, static_cast<leaf_node_t *>(write.get_data_write()));
+        }
+        keys.push_back(it->right_inclusive);
+    }
+
+    // Now that the children are erased, the node may be underfull, and so may they.
+    if (!last_buf->empty() && can_merge_children(superblock, last_buf)) {
+        check_and_handle_underfull(sizer, buf, last_buf, superblock,
+                                   range.left.btree_key(), detacher);
+        if (superblock->get_root_block_id() == buf->block_id()) {
+            last_buf->reset_buf_lock();
+        }
+    }
+    handle_underfull_children(sizer, superblock, buf, keys, detacher);
+    return erased_values;
+}
+
+continue_bool_t erase_leaves_in_range(
+        value_sizer_t *sizer,
+        superblock_t *superblock,
+        const key_range_t &range,
+        const value_deleter_t *detacher,
+        const value_deleter_t *deleter,
+        std::vector<block_id_t> *detached_out,
+        key_range_t *erased_out) {
+    if (range.is_empty()) {
+        *erased_out = range;
+        return continue_bool_t::ABORT;
+    }
+    const btree_key_t *key = range.left.btree_key();
+
+    buf_lock_t last_buf;
+    buf_lock_t buf = get_root(sizer, superblock);
+    // The bounds on the keys that can go in `last_buf`'s node and in `buf`'s node.
+    store_key_t last_left_exclusive = store_key_t::min();
+    store_key_t last_right_inclusive = store_key_t::max();
+    store_key_t left_exclusive = store_key_t::min();
+    store_key_t right_inclusive = store_key_t::max();
+    int erased_values;
+
+    // Walk down the tree to the node above the leaf that the left end of the range
+    // goes in.
+    for (;;) {
+        if (!is_internal(&buf)) {
+            // The root node is a leaf.
+            erased_values = erase_leaf_entries_in_range(
+                sizer, &buf, range, detacher, deleter);
+            break;
+        }
+
+        // Detaching children from the node, or from the one above it, may have left
+        // it underfull.  We merge it before we go further down, since nodes can only
+        // be merged with a sibling in a parent that isn't underfull.
+        if (!last_buf.empty()) {
+            if (can_merge_children(superblock, &last_buf)) {
+                check_and_handle_underfull(sizer, &buf, &last_buf, superblock, key,
+                                           detacher);
+            }
+            get_node_bounds(superblock, &buf, &last_buf, key,
+                            last_left_exclusive, last_right_inclusive,
+                            &left_exclusive, &right_inclusive);
+            if (superblock->get_root_block_id() == buf.block_id()) {
+                // Merging made `buf` the root node, and `last_buf` is the deleted
+                // old one.
+                last_buf.reset_buf_lock();
+                continue;
+            }
+        }
+
+        block_id_t child_id;
+        {
+            buf_read_t read(&buf);
+            child_id = internal_node::lookup(
+                static_cast<const internal_node_t *>(read.get_data_read()), key);
+        }
+        buf_lock_t child(&buf, child_id, access_t::write);
+        if (!is_internal(&child)) {
+            child.reset_buf_lock();
+            erased_values = erase_children_in_range(
+                sizer, superblock, &buf, &last_buf, left_exclusive, right_inclusive,
+                range, detacher, deleter, detached_out);
+            break;
+        }
+
+        // If the child that the left end of the range goes in lies entirely in the
+        // range, we detach it and the children after it that do too, except for the
+        // last of them, which then gets the left end of the range.  Going down that
+        // one, we detach all of its children but the last, and so on, until we reach
+        // the leaf nodes.  We don't detach the children after a child that we don't
+        // go down, because the leaf nodes in the one that gets their keys would keep
+        // their key prefixes until a later pass gets to them.
+        const std::vector<erased_child_t> children
+            = get_erased_children(&buf, left_exclusive, right_inclusive, range);
+        if (detach_covered_children(sizer, &buf, children.cbegin(), children.cend(),
+                                    detached_out) != children.cbegin()) {
+            child.reset_buf_lock();
+            continue;
+        }
+
+        last_buf.reset_buf_lock();
+        last_buf = std::move(buf);
+        buf = std::move(child);
+        last_left_exclusive = left_exclusive;
+        last_right_inclusive = right_inclusive;
+    }
+
+    update_population(buf_parent_t(superblock->expose_buf().txn()),
+                      superblock->get_stat_block_id(), -erased_values);
+
+    // We erased everything up to the end of `buf`'s node.
+    if (range.right.unbounded
+        ? right_inclusive == store_key_max
+        : right_inclusive >= range.right.key()) {
+        *erased_out = range;
+        return continue_bool_t::ABORT;
+    }
+    *erased_out = key_range_t(key_range_t::closed, range.left,
+                              key_range_t::closed, right_inclusive);
+    return continue_bool_t::CONTINUE;
+}
+
+void free_detached_nodes(
+        buf_parent_t parent,
+        block_id_t stat_block_id,
+        const std::vector<block_id_t> &detached,
+        const value_deleter_t *detacher,
+        const value_deleter_t *deleter) {
+    int64_t erased_values = 0;
+    std::vector<block_id_t> remaining = detached;
+    while (!remaining.empty()) {
+        buf_lock_t buf(parent, remaining.back(), access_t::write);
+        remaining.pop_back();
+        if (is_internal(&buf)) {
+            buf_read_t read(&buf);
+            auto node = static_cast<const internal_node_t *>(read.get_data_read());
+            for (int j = 0; j < node->npairs; ++j) {
+                const block_id_t child_id
+                    = internal_node::get_pair_by_index(node, j)->lnode;
+                buf.detach_child(child_id);
+                remaining.push_back(child_id);
+            }
+        } else {
+            erased_values += erase_leaf_values(&buf, detacher, deleter);
+        }
+        buf.write_acq_signal()->wait_lazily_unordered();
+        buf.mark_deleted();
+    }
+    update_population(parent, stat_block_id, -erased_values);
+}
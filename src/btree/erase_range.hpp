@@ -0,0 +1,50 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef BTREE_ERASE_RANGE_HPP_
+#define BTREE_ERASE_RANGE_HPP_
+
+#include <vector>
+
+#include "btree/keys.hpp"
+#include "btree/types.hpp"
+#include "buffer_cache/types.hpp"
+
+class superblock_t;
+class value_sizer_t;
+
+/* Erases the values and deletion entries in a part of `range` that starts at its left
+end, walking down the tree once.  Rather than erasing the entries of the nodes that
+lie entirely in `range` one at a time, it detaches those nodes from their parents and
+adds them to `*detached_out`, except for the last node of each run of them, which
+keeps the keys they could hold and gets emptied once the walk reaches it.  (Nodes keep
+at least two children, so that may keep one more.)
+`free_detached_nodes()` has to free the detached nodes afterwards, in the same
+transaction, since nothing else knows about them.  Only the leaf
+nodes at the ends of the part get read; their erased values get detached with
+`detacher` and then deleted with `deleter`.  The nodes on the way that end up
+underfull get merged or leveled with a sibling.
+
+Nothing else gets to see the erased values, so this is only useful if nothing else
+needs to know about them, such as secondary indexes.  The superblock isn't released.
+
+Sets `*erased_out` to the part of `range` that got erased.  Returns `CONTINUE` if the
+rest of `range` still needs to be erased, and `ABORT` if all of it was. */
+continue_bool_t erase_leaves_in_range(
+        value_sizer_t *sizer,
+        superblock_t *superblock,
+        const key_range_t &range,
+        const value_deleter_t *detacher,
+        const value_deleter_t *deleter,
+        std::vector<block_id_t> *detached_out,
+        key_range_t *erased_out);
+
+/* Frees the subtrees that `erase_leaves_in_range()` detached, which have their roots in
+`detached`.  The values in the leaf nodes get detached with `detacher` and then deleted
+with `deleter`, and the stat block with the id `stat_block_id` gets updated. */
+void free_detached_nodes(
+        buf_parent_t parent,
+        block_id_t stat_block_id,
+        const std::vector<block_id_t> &detached,
+        const value_deleter_t *detacher,
+        const value_deleter_t *deleter);
+
+#endif  // BTREE_ERASE_RANGE_HPP_
@@ -4,6 +4,7 @@
 #include <algorithm>
 
 #include "btree/node.hpp"
+#include "btree/search_heads.hpp"
 
 //In this tree, less than or equal takes the left-hand branch and greater than takes the right hand branch
 
@@ -22,7 +23,19 @@ uint16_t insert_pair(internal_node_t *node, block_id_t lnode, const btree_key_t
 void delete_offset(internal_node_t *node, int index);
 void insert_offset(internal_node_t *node, uint16_t offset, int index);
 void make_last_pair_special(internal_node_t *node);
+bool is_underfull(block_size_t block_size, int npairs, int pairs_size);
 bool is_equal(const btree_key_t *key1, const btree_key_t *key2);
+bool has_search_heads(const internal_node_t *node);
+const uint64_t *search_heads(const internal_node_t *node);
+void drop_search_heads(internal_node_t *node);
+void add_search_heads(internal_node_t *node);
+void ensure_search_heads(internal_node_t *node);
+int search_heads_begin(const internal_node_t *node, int npairs);
+void fit_search_heads(internal_node_t *node, int new_frontmost_offset);
+bool level_pairs(block_size_t block_size, internal_node_t *node,
+                 internal_node_t *sibling, btree_key_t *replacement_key,
+                 const internal_node_t *parent,
+                 std::vector<block_id_t> *moved_children_out);
 }  // namespace impl
 
 void init(block_size_t block_size, internal_node_t *node) {
@@ -40,6 +53,7 @@ void init(block_size_t block_size, internal_node_t *node, const internal_node_t
     node->npairs = numpairs;
     std::sort(node->pair_offsets, node->pair_offsets+node->npairs-1, internal_key_comp(node));
     rassert(get_pair_by_index(node, node->npairs-1)->key.size == 0);
+    impl::add_search_heads(node);
 }
 
 block_id_t lookup(const internal_node_t *node, const btree_key_t *key) {
@@ -61,10 +75,30 @@ bool insert(internal_node_t *node, const btree_key_t *key, block_id_t lnode, blo
     int index = get_offset_index(node, key);
     rassert(!impl::is_equal(&get_pair_by_index(node, index)->key, key),
         "tried to insert duplicate key into internal node!");
+
+    // Make room for the new key's head before the pair offsets grow into the heads.
+    if (impl::has_search_heads(node)) {
+        const int count = node->npairs - 1;
+        const int new_begin = impl::search_heads_begin(node, node->npairs + 1);
+        if (!search_heads_fit(sizeof(internal_node_t)
+                                  + (node->npairs + 1) * sizeof(*node->pair_offsets),
+                              count + 1,
+                              node->frontmost_offset - impl::pair_size_with_key(key))) {
+            impl::drop_search_heads(node);
+        } else {
+            char *const base = reinterpret_cast<char *>(node);
+            open_search_head_gap(base, impl::search_heads_begin(node, node->npairs),
+                                 new_begin, count, index);
+            reinterpret_cast<uint64_t *>(base + new_begin)[index]
+                = search_head(key->contents, key->size);
+        }
+    }
+
     const uint16_t offset = impl::insert_pair(node, lnode, key);
     impl::insert_offset(node, offset, index);
 
     get_pair_by_index(node, index + 1)->lnode = rnode;
+    impl::ensure_search_heads(node);
     return true;
 }
 
@@ -73,20 +107,48 @@ bool remove(block_size_t block_size, internal_node_t *node, const btree_key_t *k
     impl::delete_pair(node, node->pair_offsets[index]);
     impl::delete_offset(node, index);
 
+    if (impl::has_search_heads(node)) {
+        // Removing the special pair makes the key before it special, so that key
+        // loses its head instead.
+        const int count = node->npairs;
+        const int head_index = std::min(index, count - 1);
+        if (count <= 1) {
+            impl::drop_search_heads(node);
+        } else {
+            close_search_head_gap(reinterpret_cast<char *>(node),
+                                  impl::search_heads_begin(node, node->npairs + 1),
+                                  impl::search_heads_begin(node, node->npairs),
+                                  count, head_index, head_index + 1);
+        }
+    }
+
     if (index == node->npairs) {
         impl::make_last_pair_special(node);
     }
 
+    impl::ensure_search_heads(node);
     validate(block_size, node);
     return true;
 }
 
-void split(block_size_t block_size, internal_node_t *node, internal_node_t *rnode, btree_key_t *median) {
-    uint16_t total_pairs = block_size.value() - node->frontmost_offset;
-    uint16_t first_pairs = 0;
+void split(block_size_t block_size, internal_node_t *node, internal_node_t *rnode, btree_key_t *median, int left_percent) {
+    rassert(left_percent >= 50 && left_percent <= 100);
+    impl::drop_search_heads(node);
+    int total_pairs = block_size.value() - node->frontmost_offset;
+    int first_pairs = 0;
     int index = 0;
-    while (first_pairs < total_pairs/2) { // finds the median index
-        first_pairs += pair_size(get_pair_by_index(node, index));
+    // finds the median index, leaving at least the special pair for rnode.  Past the
+    // middle, we stop before rnode would become underfull, because the next write
+    // would level it with node again.
+    while (index < node->npairs - 1) {
+        const int size = pair_size(get_pair_by_index(node, index));
+        if (first_pairs >= total_pairs / 2
+            && (first_pairs >= total_pairs * left_percent / 100
+                || impl::is_underfull(block_size, node->npairs - index - 1,
+                                      total_pairs - first_pairs - size))) {
+            break;
+        }
+        first_pairs += size;
         index++;
     }
     int median_index = index;
@@ -107,6 +169,7 @@ void split(block_size_t block_size, internal_node_t *node, internal_node_t *rnod
     node->npairs = new_npairs;
     //make last pair special
     impl::make_last_pair_special(node);
+    impl::add_search_heads(node);
 
     validate(block_size, node);
     validate(block_size, rnode);
@@ -122,6 +185,7 @@ void merge(block_size_t block_size, const internal_node_t *node, internal_node_t
         (block_size.value() - node->frontmost_offset) + (block_size.value() - rnode->frontmost_offset) + key_from_parent->size < block_size.value(),
         "internal nodes too full to merge");
 
+    impl::drop_search_heads(rnode);
     memmove(rnode->pair_offsets + node->npairs, rnode->pair_offsets, rnode->npairs * sizeof(*rnode->pair_offsets));
 
     for (int i = 0; i < node->npairs-1; i++) { // the last pair is special
@@ -133,6 +197,7 @@ void merge(block_size_t block_size, const internal_node_t *node, internal_node_t
 
     const uint16_t new_npairs = rnode->npairs + node->npairs;
     rnode->npairs = new_npairs;
+    impl::add_search_heads(rnode);
 
     validate(block_size, rnode);
 }
@@ -143,6 +208,23 @@ bool level(block_size_t block_size, internal_node_t *node,
            std::vector<block_id_t> *moved_children_out) {
     validate(block_size, node);
     validate(block_size, sibling);
+    impl::drop_search_heads(node);
+    impl::drop_search_heads(sibling);
+    const bool leveled = impl::level_pairs(block_size, node, sibling, replacement_key,
+                                           parent, moved_children_out);
+    impl::add_search_heads(node);
+    impl::add_search_heads(sibling);
+    validate(block_size, node);
+    validate(block_size, sibling);
+    return leveled;
+}
+
+namespace impl {
+
+bool level_pairs(block_size_t block_size, internal_node_t *node,
+                 internal_node_t *sibling, btree_key_t *replacement_key,
+                 const internal_node_t *parent,
+                 std::vector<block_id_t> *moved_children_out) {
     if (moved_children_out != nullptr) {
         moved_children_out->reserve(sibling->npairs);
     }
@@ -233,12 +315,12 @@ bool level(block_size_t block_size, internal_node_t *node,
         impl::make_last_pair_special(sibling);
     }
 
-    validate(block_size, node);
-    validate(block_size, sibling);
     guarantee(!change_unsafe(node), "level made internal node dangerously full");
     return true;
 }
 
+}  // namespace impl
+
 int sibling(const internal_node_t *node, const btree_key_t *key, block_id_t *sib_id, store_key_t *key_in_middle_out) {
     int index = get_offset_index(node, key);
     const btree_internal_pair *sib_pair;
@@ -257,6 +339,18 @@ int sibling(const internal_node_t *node, const btree_key_t *key, block_id_t *sib
     return cmp; //equivalent to nodecmp(node, sibling)
 }
 
+void narrow_to_child(const internal_node_t *node, const btree_key_t *key,
+                     store_key_t *left_exclusive, store_key_t *right_inclusive) {
+    // The child at `index` gets the keys in (key of index - 1, key of index].
+    int index = get_offset_index(node, key);
+    if (index > 0) {
+        left_exclusive->assign(&get_pair_by_index(node, index - 1)->key);
+    }
+    if (index < node->npairs - 1) {
+        right_inclusive->assign(&get_pair_by_index(node, index)->key);
+    }
+}
+
 
 /* `is_sorted()` returns true if the given range is sorted. */
 
@@ -271,9 +365,11 @@ bool is_sorted(ForwardIterator first, ForwardIterator last,
 }
 
 void update_key(internal_node_t *node, const btree_key_t *key_to_replace, const btree_key_t *replacement_key) {
-
     const int index = get_offset_index(node, key_to_replace);
     const block_id_t tmp_lnode = get_pair_by_index(node, index)->lnode;
+    impl::fit_search_heads(node, node->frontmost_offset
+                                 + pair_size(get_pair_by_index(node, index))
+                                 - impl::pair_size_with_key(replacement_key));
     impl::delete_pair(node, node->pair_offsets[index]);
 
     guarantee(sizeof(internal_node_t) + (node->npairs) * sizeof(*node->pair_offsets) + impl::pair_size_with_key(replacement_key) < node->frontmost_offset,
@@ -285,12 +381,29 @@ void update_key(internal_node_t *node, const btree_key_t *key_to_replace, const
     rassert(is_sorted(node->pair_offsets, node->pair_offsets+node->npairs-1, internal_key_comp(node)),
             "Invalid key given to update_key: offsets no longer in sorted order");
     rassert(get_pair_by_index(node, node->npairs-1)->key.size == 0);
+    if (impl::has_search_heads(node)) {
+        rassert(index < node->npairs - 1);
+        const_cast<uint64_t *>(impl::search_heads(node))[index]
+            = search_head(replacement_key->contents, replacement_key->size);
+    } else {
+        impl::add_search_heads(node);
+    }
 }
 
 bool is_full(const internal_node_t *node) {
     return sizeof(internal_node_t) + (node->npairs + 1) * sizeof(*node->pair_offsets) + impl::pair_size_with_key_size(MAX_KEY_SIZE) >=  node->frontmost_offset;
 }
 
+int insertions_until_full(const internal_node_t *node) {
+    // Each insertion takes at most one offset and one pair with a key of the maximum
+    // size, and `is_full()` holds once there isn't room for another of them.
+    const int free_space = node->frontmost_offset - sizeof(internal_node_t)
+        - node->npairs * sizeof(*node->pair_offsets);
+    const int insertion_size = sizeof(*node->pair_offsets)
+        + impl::pair_size_with_key_size(MAX_KEY_SIZE);
+    return std::max(0, (free_space - 1) / insertion_size - 1);
+}
+
 bool change_unsafe(const internal_node_t *node) {
     return sizeof(internal_node_t) + node->npairs * sizeof(*node->pair_offsets) + MAX_KEY_SIZE >= node->frontmost_offset;
 }
@@ -307,15 +420,21 @@ void validate(DEBUG_VAR block_size_t block_size, DEBUG_VAR const internal_node_t
     rassert(is_sorted(node->pair_offsets, node->pair_offsets+node->npairs-1, internal_key_comp(node)),
         "Offsets no longer in sorted order");
     rassert(get_pair_by_index(node, node->npairs-1)->key.size == 0);
+    if (impl::has_search_heads(node)) {
+        rassert(search_heads_fit(sizeof(internal_node_t) + node->npairs * sizeof(*node->pair_offsets),
+                                 node->npairs - 1, node->frontmost_offset));
+        const uint64_t *heads = impl::search_heads(node);
+        for (int i = 0; i < node->npairs - 1; i++) {
+            const btree_key_t *key = &get_pair_by_index(node, i)->key;
+            rassert(heads[i] == search_head(key->contents, key->size));
+        }
+    }
 #endif
 }
 
 bool is_underfull(block_size_t block_size, const internal_node_t *node) {
-    return (sizeof(internal_node_t) + 1) / 2 +
-        node->npairs*sizeof(*node->pair_offsets) +
-        (block_size.value() - node->frontmost_offset) +
-        /* EPSILON TODO this epsilon is too high lower it*/
-        INTERNAL_EPSILON * 2  < block_size.value() / 2;
+    return impl::is_underfull(block_size, node->npairs,
+                              block_size.value() - node->frontmost_offset);
 }
 
 bool is_mergable(block_size_t block_size, const internal_node_t *node, const internal_node_t *sibling, const internal_node_t *parent) {
@@ -357,7 +476,14 @@ btree_internal_pair *get_pair_by_index(internal_node_t *node, int index) {
 }
 
 int get_offset_index(const internal_node_t *node, const btree_key_t *key) {
-    return std::lower_bound(node->pair_offsets, node->pair_offsets+node->npairs-1, (uint16_t) internal_key_comp::faux_offset, internal_key_comp(node, key)) - node->pair_offsets;
+    int beg = 0;
+    int end = node->npairs - 1;
+    if (impl::has_search_heads(node)) {
+        // Only the keys with the same head as `key` need a full comparison.
+        find_search_head_range(impl::search_heads(node), node->npairs - 1,
+                               search_head(key->contents, key->size), &beg, &end);
+    }
+    return std::lower_bound(node->pair_offsets+beg, node->pair_offsets+end, (uint16_t) internal_key_comp::faux_offset, internal_key_comp(node, key)) - node->pair_offsets;
 }
 
 int nodecmp(const internal_node_t *node1, const internal_node_t *node2) {
@@ -383,9 +509,9 @@ void delete_pair(internal_node_t *node, uint16_t offset) {
     const size_t shift = pair_size(pair_to_delete);
     const size_t size = offset - node->frontmost_offset;
 
-    rassert(node->magic == internal_node_t::expected_magic);
+    rassert(node->magic == internal_node_t::expected_magic || has_search_heads(node));
     memmove(reinterpret_cast<char *>(front_pair) + shift, front_pair, size);
-    rassert(node->magic == internal_node_t::expected_magic);
+    rassert(node->magic == internal_node_t::expected_magic || has_search_heads(node));
 
 
     node->frontmost_offset = node->frontmost_offset + shift;
@@ -455,11 +581,75 @@ void make_last_pair_special(internal_node_t *node) {
     delete_pair(node, old_offset);
 }
 
+// Whether a node with `npairs` pairs that take up `pairs_size` bytes is underfull.
+bool is_underfull(block_size_t block_size, int npairs, int pairs_size) {
+    return (sizeof(internal_node_t) + 1) / 2 +
+        npairs*sizeof(uint16_t) +
+        pairs_size +
+        /* EPSILON TODO this epsilon is too high lower it*/
+        INTERNAL_EPSILON * 2  < block_size.value() / 2;
+}
+
 
 bool is_equal(const btree_key_t *key1, const btree_key_t *key2) {
     return btree_key_cmp(key1, key2) == 0;
 }
 
+bool has_search_heads(const internal_node_t *node) {
+    return node->magic == internal_node_t::search_heads_magic;
+}
+
+// Where the heads start when the node has `npairs` pairs.
+int search_heads_begin(const internal_node_t *node, int npairs) {
+    return ::search_heads_begin(sizeof(internal_node_t)
+                                + npairs * sizeof(*node->pair_offsets));
+}
+
+const uint64_t *search_heads(const internal_node_t *node) {
+    return reinterpret_cast<const uint64_t *>(
+        reinterpret_cast<const char *>(node) + search_heads_begin(node, node->npairs));
+}
+
+void drop_search_heads(internal_node_t *node) {
+    node->magic = internal_node_t::expected_magic;
+}
+
+// Writes the heads of all keys but the special last one, if they fit.
+void add_search_heads(internal_node_t *node) {
+    rassert(!has_search_heads(node));
+    const int pair_offsets_end = sizeof(internal_node_t) + node->npairs * sizeof(*node->pair_offsets);
+    const int count = node->npairs - 1;
+    if (count <= 0 || !search_heads_fit(pair_offsets_end, count, node->frontmost_offset)) {
+        return;
+    }
+    uint64_t *heads = reinterpret_cast<uint64_t *>(
+        reinterpret_cast<char *>(node) + search_heads_begin(node, node->npairs));
+    for (int i = 0; i < count; i++) {
+        const btree_key_t *key = &get_pair_by_index(node, i)->key;
+        heads[i] = search_head(key->contents, key->size);
+    }
+    node->magic = internal_node_t::search_heads_magic;
+}
+
+// Gives the node search heads at the end of a modification, unless it still has
+// the ones it had before.
+void ensure_search_heads(internal_node_t *node) {
+    if (!has_search_heads(node)) {
+        add_search_heads(node);
+    }
+}
+
+// Drops the node's search heads if they wouldn't fit above
+// `new_frontmost_offset`.
+void fit_search_heads(internal_node_t *node, int new_frontmost_offset) {
+    if (has_search_heads(node)
+        && !search_heads_fit(sizeof(internal_node_t)
+                                 + node->npairs * sizeof(*node->pair_offsets),
+                             node->npairs - 1, new_frontmost_offset)) {
+        drop_search_heads(node);
+    }
+}
+
 }  // namespace impl
 
 }  // namespace internal_node
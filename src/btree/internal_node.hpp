@@ -34,15 +34,25 @@ void init(block_size_t block_size, internal_node_t *node, const internal_node_t
 block_id_t lookup(const internal_node_t *node, const btree_key_t *key);
 bool insert(internal_node_t *node, const btree_key_t *key, block_id_t lnode, block_id_t rnode);
 bool remove(block_size_t block_size, internal_node_t *node, const btree_key_t *key);
-void split(block_size_t block_size, internal_node_t *node, internal_node_t *rnode, btree_key_t *median);
+/* Moves the pairs past the first `left_percent` percent of `node`'s pairs (by size) to
+`rnode`, but no fewer than it takes for `rnode` not to be underfull.  `left_percent` is
+between 50 and 100. */
+void split(block_size_t block_size, internal_node_t *node, internal_node_t *rnode, btree_key_t *median, int left_percent);
 void merge(block_size_t block_size, const internal_node_t *node, internal_node_t *rnode, const internal_node_t *parent);
 bool level(block_size_t block_size, internal_node_t *node, internal_node_t *sibling,
            btree_key_t *replacement_key, const internal_node_t *parent,
            std::vector<block_id_t> *moved_children_out);
 int sibling(const internal_node_t *node, const btree_key_t *key, block_id_t *sib_id, store_key_t *key_in_middle_out);
+/* Narrows (`*left_exclusive`, `*right_inclusive`], which must contain the keys that
+can go in `node`, down to the keys that can go in the child that `key` goes in. */
+void narrow_to_child(const internal_node_t *node, const btree_key_t *key,
+                     store_key_t *left_exclusive, store_key_t *right_inclusive);
 void update_key(internal_node_t *node, const btree_key_t *key_to_replace, const btree_key_t *replacement_key);
 int nodecmp(const internal_node_t *node1, const internal_node_t *node2);
 bool is_full(const internal_node_t *node);
+/* Returns how many times a key of any size can be inserted into `node`, or put in
+place of a shorter key with `update_key()`, before `node` is full. */
+int insertions_until_full(const internal_node_t *node);
 bool is_underfull(block_size_t block_size, const internal_node_t *node);
 bool change_unsafe(const internal_node_t *node);
 bool is_mergable(block_size_t block_size, const internal_node_t *node, const internal_node_t *sibling, const internal_node_t *parent);
@@ -7,6 +7,8 @@
 #include <set>
 
 #include "btree/node.hpp"
+#include "btree/search_heads.hpp"
+#include "math.hpp"
 #include "repli_timestamp.hpp"
 #include "utils.hpp"
 
@@ -79,6 +81,129 @@ const int SKIP_ENTRY_RESERVED = 251;
 // itself three bytes, so it can't fit in a slot of size one or two. We don't
 // expect to actually see many entries of size one or two, but it pays to be
 // thorough.
+//
+// A prefixed leaf node stores the common prefix of all the keys it may hold
+// just once, between the header and the pair offsets, and its entries only
+// store what comes after the prefix:
+//
+// [magic][num_pairs][live_size][frontmost][tstamp_cutpoint][prefix size][prefix]([pad])[off0][off1]...
+//
+// The prefix is laid out like a btree_key_t, and the pad byte keeps the pair
+// offsets at an even offset.  Such a node has the value type's leaf magic
+// with `PREFIXED_MAGIC_BIT` set in its last byte, and its prefix is never
+// empty; a node without a prefix uses the plain format.
+//
+// The prefix isn't derived from the keys the node happens to hold, but from
+// the keys that bound the node in its parent (see `update_prefix()`), so that
+// every key that could ever be inserted into the node has it.  Splitting a
+// node only shrinks the range of keys the node can hold, so both halves keep
+// the prefix.  Merging and leveling widens the range, so the nodes involved
+// first fall back to the prefix they have in common, which is valid for the
+// union of their ranges.
+
+//
+// A leaf node may also have search heads (see btree/search_heads.hpp) of the
+// keys its entries store, which come after the pair offsets:
+//
+// [magic]...[tstamp_cutpoint]([prefix size][prefix]([pad]))[off0]...[offN-1]([pad])[head0]...[headN-1]
+//
+// Such a node has `SEARCH_HEADS_MAGIC_BIT` set in the second to last byte of
+// its magic.  Inserting or removing an entry shifts the heads along with the
+// pair offsets.  Garbage collection, changing the prefix and the entries that
+// splitting, merging and leveling move into a node drop the heads, and the
+// public function adds them back at the end if there's room.
+
+// The leaf magics of all value types are ASCII, so these bits are free.
+const uint8_t PREFIXED_MAGIC_BIT = 0x80;
+const int PREFIXED_MAGIC_BYTE = sizeof(block_magic_t::bytes) - 1;
+const uint8_t SEARCH_HEADS_MAGIC_BIT = 0x80;
+const int SEARCH_HEADS_MAGIC_BYTE = sizeof(block_magic_t::bytes) - 2;
+
+block_magic_t prefixed_magic(block_magic_t magic) {
+    magic.bytes[PREFIXED_MAGIC_BYTE] |= PREFIXED_MAGIC_BIT;
+    return magic;
+}
+
+bool is_prefixed(const leaf_node_t *node) {
+    return (node->magic.bytes[PREFIXED_MAGIC_BYTE] & PREFIXED_MAGIC_BIT) != 0;
+}
+
+bool has_search_heads(const leaf_node_t *node) {
+    return (node->magic.bytes[SEARCH_HEADS_MAGIC_BYTE] & SEARCH_HEADS_MAGIC_BIT) != 0;
+}
+
+void drop_search_heads(leaf_node_t *node) {
+    node->magic.bytes[SEARCH_HEADS_MAGIC_BYTE] &= ~SEARCH_HEADS_MAGIC_BIT;
+}
+
+bool is_leaf_magic(value_sizer_t *sizer, block_magic_t magic) {
+    magic.bytes[PREFIXED_MAGIC_BYTE] &= ~PREFIXED_MAGIC_BIT;
+    magic.bytes[SEARCH_HEADS_MAGIC_BYTE] &= ~SEARCH_HEADS_MAGIC_BIT;
+    return magic == sizer->btree_leaf_magic();
+}
+
+int prefix_area_size(int prefix_size) {
+    return prefix_size == 0
+        ? 0
+        : ceil_aligned(1 + prefix_size, static_cast<int>(sizeof(uint16_t)));
+}
+
+// Returns null if the node isn't prefixed.
+const btree_key_t *node_prefix(const leaf_node_t *node) {
+    return is_prefixed(node)
+        ? reinterpret_cast<const btree_key_t *>(node->pair_offsets)
+        : nullptr;
+}
+
+int prefix_size(const leaf_node_t *node) {
+    return is_prefixed(node) ? node_prefix(node)->size : 0;
+}
+
+// The offset at which the pair offsets begin.
+int pair_offsets_begin(const leaf_node_t *node) {
+    return offsetof(leaf_node_t, pair_offsets) + prefix_area_size(prefix_size(node));
+}
+
+const uint16_t *pair_offsets(const leaf_node_t *node) {
+    return reinterpret_cast<const uint16_t *>(
+        reinterpret_cast<const char *>(node) + pair_offsets_begin(node));
+}
+
+uint16_t *pair_offsets(leaf_node_t *node) {
+    return reinterpret_cast<uint16_t *>(
+        reinterpret_cast<char *>(node) + pair_offsets_begin(node));
+}
+
+// The offset at which the search heads begin, if the node has them.
+int search_heads_begin(const leaf_node_t *node) {
+    return ::search_heads_begin(pair_offsets_begin(node)
+                                + node->num_pairs * sizeof(uint16_t));
+}
+
+const uint64_t *search_heads(const leaf_node_t *node) {
+    rassert(has_search_heads(node));
+    return reinterpret_cast<const uint64_t *>(
+        reinterpret_cast<const char *>(node) + search_heads_begin(node));
+}
+
+bool same_prefix(const leaf_node_t *x, const leaf_node_t *y) {
+    const btree_key_t *px = node_prefix(x);
+    const btree_key_t *py = node_prefix(y);
+    if (px == nullptr || py == nullptr) {
+        return px == py;
+    }
+    return btree_key_cmp(px, py) == 0;
+}
+
+// Returns the length of the common prefix of the two keys.
+int common_prefix_size(const btree_key_t *x, const btree_key_t *y) {
+    int n = std::min(x->size, y->size);
+    int i = 0;
+    while (i < n && x->contents[i] == y->contents[i]) {
+        ++i;
+    }
+    return i;
+}
 
 
 struct entry_t;
@@ -117,6 +242,40 @@ const void *entry_value(const entry_t *p) {
     }
 }
 
+// Returns the whole key of the entry.  The key of an entry in a prefixed node
+// gets put together in `*buf`, the key of any other entry is returned in place.
+const btree_key_t *entry_full_key(const leaf_node_t *node, const entry_t *p,
+                                  store_key_t *buf) {
+    const btree_key_t *prefix = node_prefix(node);
+    if (prefix == nullptr) {
+        return entry_key(p);
+    }
+    const btree_key_t *suffix = entry_key(p);
+    rassert(prefix->size + suffix->size <= MAX_KEY_SIZE);
+    buf->set_size(prefix->size + suffix->size);
+    memcpy(buf->contents(), prefix->contents, prefix->size);
+    memcpy(buf->contents() + prefix->size, suffix->contents, suffix->size);
+    return buf->btree_key();
+}
+
+bool has_prefix(const btree_key_t *key, const btree_key_t *prefix) {
+    return key->size >= prefix->size
+        && memcmp(key->contents, prefix->contents, prefix->size) == 0;
+}
+
+// The size that `key` takes up in an entry of the node.
+int stored_key_size(const leaf_node_t *node, const btree_key_t *key) {
+    return key->full_size() - prefix_size(node);
+}
+
+// Writes `key` the way entries of the node store it.
+void write_stored_key(const leaf_node_t *node, const btree_key_t *key, char *dest) {
+    const int skip = prefix_size(node);
+    rassert(skip == 0 || has_prefix(key, node_prefix(node)));
+    *reinterpret_cast<uint8_t *>(dest) = key->size - skip;
+    memcpy(dest + 1, key->contents + skip, key->size - skip);
+}
+
 int entry_size(value_sizer_t *sizer, const entry_t *p) {
     uint8_t code = *reinterpret_cast<const uint8_t *>(p);
     switch (code) {
@@ -172,14 +331,16 @@ struct entry_iter_t {
     }
 };
 
-void strprint_entry(std::string *out, value_sizer_t *sizer, const entry_t *entry) {
+void strprint_entry(std::string *out, value_sizer_t *sizer, const leaf_node_t *node,
+                    const entry_t *entry) {
+    store_key_t buf;
     if (entry_is_live(entry)) {
-        const btree_key_t *key = entry_key(entry);
+        const btree_key_t *key = entry_full_key(node, entry, &buf);
         *out += strprintf("%.*s:", static_cast<int>(key->size), key->contents);
         *out += strprintf("[entry size=%d]", entry_size(sizer, entry));
         *out += strprintf("[value size=%d]", sizer->size(entry_value(entry)));
     } else if (entry_is_deletion(entry)) {
-        const btree_key_t *key = entry_key(entry);
+        const btree_key_t *key = entry_full_key(node, entry, &buf);
         *out += strprintf("%.*s:[deletion]", static_cast<int>(key->size), key->contents);
     } else if (entry_is_skip(entry)) {
         *out += strprintf("[skip %d]", entry_size(sizer, entry));
@@ -194,16 +355,21 @@ std::string strprint_leaf(value_sizer_t *sizer, const leaf_node_t *node) {
     out += strprintf("Leaf(magic='%4.4s', num_pairs=%u, live_size=%u, frontmost=%u, tstamp_cutpoint=%u)\n",
             node->magic.bytes, node->num_pairs, node->live_size, node->frontmost, node->tstamp_cutpoint);
 
+    if (is_prefixed(node)) {
+        const btree_key_t *prefix = node_prefix(node);
+        out += strprintf("  Prefix: %.*s\n", static_cast<int>(prefix->size), prefix->contents);
+    }
+
     out += strprintf("  Offsets:");
     for (int i = 0; i < node->num_pairs; ++i) {
-        out += strprintf(" %d", node->pair_offsets[i]);
+        out += strprintf(" %d", pair_offsets(node)[i]);
     }
     out += strprintf("\n");
 
     out += strprintf("  By Key:");
     for (int i = 0; i < node->num_pairs; ++i) {
-        out += strprintf(" %d:", node->pair_offsets[i]);
-        strprint_entry(&out, sizer, get_entry(node, node->pair_offsets[i]));
+        out += strprintf(" %d:", pair_offsets(node)[i]);
+        strprint_entry(&out, sizer, node, get_entry(node, pair_offsets(node)[i]));
     }
     out += strprintf("\n");
 
@@ -216,7 +382,7 @@ std::string strprint_leaf(value_sizer_t *sizer, const leaf_node_t *node) {
             repli_timestamp_t tstamp = get_timestamp(node, iter.offset);
             out += strprintf("[t=%" PRIu64 "]", tstamp.longtime);
         }
-        strprint_entry(&out, sizer, get_entry(node, iter.offset));
+        strprint_entry(&out, sizer, node, get_entry(node, iter.offset));
         iter.step(sizer, node);
     }
     out += strprintf("\n");
@@ -225,14 +391,16 @@ std::string strprint_leaf(value_sizer_t *sizer, const leaf_node_t *node) {
 }
 
 
-void print_entry(FILE *fp, value_sizer_t *sizer, const entry_t *entry) {
+void print_entry(FILE *fp, value_sizer_t *sizer, const leaf_node_t *node,
+                 const entry_t *entry) {
+    store_key_t buf;
     if (entry_is_live(entry)) {
-        const btree_key_t *key = entry_key(entry);
+        const btree_key_t *key = entry_full_key(node, entry, &buf);
         fprintf(fp, "%.*s:", static_cast<int>(key->size), key->contents);
         fprintf(fp, "[entry size=%d]", entry_size(sizer, entry));
         fprintf(fp, "[value size=%d]", sizer->size(entry_value(entry)));
     } else if (entry_is_deletion(entry)) {
-        const btree_key_t *key = entry_key(entry);
+        const btree_key_t *key = entry_full_key(node, entry, &buf);
         fprintf(fp, "%.*s:[deletion]", static_cast<int>(key->size), key->contents);
     } else if (entry_is_skip(entry)) {
         fprintf(fp, "[skip %d]", entry_size(sizer, entry));
@@ -247,17 +415,22 @@ void print(FILE *fp, value_sizer_t *sizer, const leaf_node_t *node) {
     fprintf(fp, "Leaf(magic='%4.4s', num_pairs=%u, live_size=%u, frontmost=%u, tstamp_cutpoint=%u)\n",
             node->magic.bytes, node->num_pairs, node->live_size, node->frontmost, node->tstamp_cutpoint);
 
+    if (is_prefixed(node)) {
+        const btree_key_t *prefix = node_prefix(node);
+        fprintf(fp, "  Prefix: %.*s\n", static_cast<int>(prefix->size), prefix->contents);
+    }
+
     fprintf(fp, "  Offsets:");
     for (int i = 0; i < node->num_pairs; ++i) {
-        fprintf(fp, " %d", node->pair_offsets[i]);
+        fprintf(fp, " %d", pair_offsets(node)[i]);
     }
     fprintf(fp, "\n");
     fflush(fp);
 
     fprintf(fp, "  By Key:");
     for (int i = 0; i < node->num_pairs; ++i) {
-        fprintf(fp, " %d:", node->pair_offsets[i]);
-        print_entry(fp, sizer, get_entry(node, node->pair_offsets[i]));
+        fprintf(fp, " %d:", pair_offsets(node)[i]);
+        print_entry(fp, sizer, node, get_entry(node, pair_offsets(node)[i]));
     }
     fprintf(fp, "\n");
 
@@ -273,7 +446,7 @@ void print(FILE *fp, value_sizer_t *sizer, const leaf_node_t *node) {
             fprintf(fp, "[t=%" PRIu64 "]", tstamp.longtime);
             fflush(fp);
         }
-        print_entry(fp, sizer, get_entry(node, iter.offset));
+        print_entry(fp, sizer, node, get_entry(node, iter.offset));
         iter.step(sizer, node);
     }
     fprintf(fp, "\n");
@@ -309,9 +482,13 @@ bool fsck(value_sizer_t *sizer, const btree_key_t *left_exclusive_or_null, const
     // is not before the end of pair_offsets
 
     // Basic sanity checks on fields' values.
-    if (failed(node->magic == sizer->btree_leaf_magic(),
+    if (failed(is_leaf_magic(sizer, node->magic),
                "bad leaf magic")
-        || failed(node->frontmost >= offsetof(leaf_node_t, pair_offsets) + node->num_pairs * sizeof(uint16_t),
+        || failed(!is_prefixed(node) || prefix_size(node) > 0,
+                  "empty key prefix")
+        || failed(prefix_size(node) <= MAX_KEY_SIZE,
+                  "key prefix is too long")
+        || failed(node->frontmost >= pair_offsets_begin(node) + node->num_pairs * sizeof(uint16_t),
                   "frontmost offset is before the end of pair_offsets")
         || failed(node->live_size <= (sizer->block_size().value() - node->frontmost) + sizeof(uint16_t) * node->num_pairs,
                   "live_size is impossibly large")
@@ -325,7 +502,7 @@ bool fsck(value_sizer_t *sizer, const btree_key_t *left_exclusive_or_null, const
 
     // sizeof(offs) is guaranteed to be less than the block_size() thanks to assertions above.
     scoped_array_t<uint16_t> offs(node->num_pairs);
-    memcpy(offs.data(), node->pair_offsets, node->num_pairs * sizeof(uint16_t));
+    memcpy(offs.data(), pair_offsets(node), node->num_pairs * sizeof(uint16_t));
 
     std::sort(offs.data(), offs.data() + node->num_pairs);
 
@@ -375,14 +552,20 @@ bool fsck(value_sizer_t *sizer, const btree_key_t *left_exclusive_or_null, const
         if (entry_is_live(ent)) {
             const void *value = entry_value(ent);
             int space = sizer->block_size().value() - (reinterpret_cast<const char *>(value) - reinterpret_cast<const char *>(node));
+            if (failed(prefix_size(node) + entry_key(ent)->size <= MAX_KEY_SIZE,
+                       "key is too long")) {
+                return false;
+            }
+            store_key_t key_buf;
+            const btree_key_t *key = entry_full_key(node, ent, &key_buf);
             if (!sizer->fits(value, space)) {
-                *msg_out = strprintf("problem with key %.*s: value does not fit\n", entry_key(ent)->size, entry_key(ent)->contents);
+                *msg_out = strprintf("problem with key %.*s: value does not fit\n", key->size, key->contents);
                 return false;
             }
 
             std::string fscker_msg;
-            if (!fscker->fsck(sizer, entry_key(ent), value, &fscker_msg)) {
-                *msg_out = strprintf("Problem with key %.*s: %s\n", entry_key(ent)->size, entry_key(ent)->contents, fscker_msg.c_str());
+            if (!fscker->fsck(sizer, key, value, &fscker_msg)) {
+                *msg_out = strprintf("Problem with key %.*s: %s\n", key->size, key->contents, fscker_msg.c_str());
                 return false;
             }
 
@@ -400,6 +583,8 @@ bool fsck(value_sizer_t *sizer, const btree_key_t *left_exclusive_or_null, const
             ++i;
         } else if (entry_is_deletion(ent)) {
             if (failed(!seen_tstamp_cutpoint, "deletion entry after tstamp_cutpoint")
+                || failed(prefix_size(node) + entry_key(ent)->size <= MAX_KEY_SIZE,
+                          "key is too long")
                 || failed(i < node->num_pairs, "missing entry offsets")
                 || failed(offset == offs[i], "missing deletion entries or entry offsets")) {
                 return false;
@@ -417,24 +602,60 @@ bool fsck(value_sizer_t *sizer, const btree_key_t *left_exclusive_or_null, const
         return false;
     }
 
+    // Every key that the bounds allow must have the prefix.
+    const btree_key_t *prefix = node_prefix(node);
+    if (prefix != nullptr) {
+        if (failed(left_exclusive_or_null == nullptr
+                   || has_prefix(left_exclusive_or_null, prefix),
+                   "key prefix doesn't match the left_exclusive key")
+            || failed(right_inclusive_or_null == nullptr
+                      || has_prefix(right_inclusive_or_null, prefix),
+                      "key prefix doesn't match the right_inclusive key")) {
+            return false;
+        }
+    }
+
     // Entries look valid, check key ordering.
 
-    const btree_key_t *last = left_exclusive_or_null;
+    store_key_t key_buf;
+    store_key_t last;
+    bool have_last = left_exclusive_or_null != nullptr;
+    if (have_last) {
+        last.assign(left_exclusive_or_null);
+    }
     for (int k = 0; k < node->num_pairs; ++k) {
-        const btree_key_t *key = entry_key(get_entry(node, node->pair_offsets[k]));
-        if (failed(last == nullptr || btree_key_cmp(last, key) < 0,
+        const btree_key_t *key
+            = entry_full_key(node, get_entry(node, pair_offsets(node)[k]), &key_buf);
+        if (failed(!have_last || btree_key_cmp(last.btree_key(), key) < 0,
                    "keys out of order")) {
             return false;
         }
-        last = key;
+        last.assign(key);
+        have_last = true;
     }
 
-    if (failed(last == nullptr || right_inclusive_or_null == nullptr
-               || btree_key_cmp(last, right_inclusive_or_null) <= 0,
+    if (failed(!have_last || right_inclusive_or_null == nullptr
+               || btree_key_cmp(last.btree_key(), right_inclusive_or_null) <= 0,
                "keys out of order (with right_inclusive key)")) {
         return false;
     }
 
+    if (has_search_heads(node)) {
+        const int offsets_end
+            = pair_offsets_begin(node) + node->num_pairs * sizeof(uint16_t);
+        if (failed(search_heads_fit(offsets_end, node->num_pairs, node->frontmost),
+                   "search heads overlap the entries")) {
+            return false;
+        }
+        for (int k = 0; k < node->num_pairs; ++k) {
+            const btree_key_t *key = entry_key(get_entry(node, pair_offsets(node)[k]));
+            if (failed(search_heads(node)[k] == search_head(key->contents, key->size),
+                       "search head doesn't match its key")) {
+                return false;
+            }
+        }
+    }
+
     return true;
 }
 
@@ -448,14 +669,27 @@ void validate(DEBUG_VAR value_sizer_t *sizer, DEBUG_VAR const leaf_node_t *node)
 #endif
 }
 
-void init(value_sizer_t *sizer, leaf_node_t *node) {
-    node->magic = sizer->btree_leaf_magic();
+// Initializes an empty node with the given prefix (which may be null or empty).
+void init(value_sizer_t *sizer, leaf_node_t *node, const btree_key_t *prefix) {
+    if (prefix != nullptr && prefix->size > 0) {
+        node->magic = prefixed_magic(sizer->btree_leaf_magic());
+        keycpy(reinterpret_cast<btree_key_t *>(node->pair_offsets), prefix);
+    } else {
+        node->magic = sizer->btree_leaf_magic();
+    }
     node->num_pairs = 0;
     node->live_size = 0;
     node->frontmost = sizer->block_size().value();
     node->tstamp_cutpoint = node->frontmost;
 }
 
+void init(value_sizer_t *sizer, leaf_node_t *node) {
+    init(sizer, node, nullptr);
+}
+
+// The space for the prefix and the pair offsets and entries.  The prefix
+// counts towards the mandatory cost of a node, so that all nodes have the same
+// free space.
 int free_space(value_sizer_t *sizer) {
     return sizer->block_size().value() - offsetof(leaf_node_t, pair_offsets);
 }
@@ -464,7 +698,7 @@ int free_space(value_sizer_t *sizer) {
 // in the closed interval [0, free_space(sizer)].  Outputs the offset
 // of the first entry for which storing a timestamp is not mandatory.
 int mandatory_cost(value_sizer_t *sizer, const leaf_node_t *node, int required_timestamps, int *tstamp_back_offset_out) {
-    int size = node->live_size;
+    int size = node->live_size + prefix_area_size(prefix_size(node));
 
     // node->live_size does not include deletion entries, deletion
     // entries' timestamps, and live entries' timestamps.  We add that
@@ -540,12 +774,17 @@ bool is_full(value_sizer_t *sizer, const leaf_node_t *node, const btree_key_t *k
     // insert.  We conservatively assume the key is not already
     // contained in the node.
 
-    size += sizeof(uint16_t) + sizeof(repli_timestamp_t) + key->full_size() + sizer->size(value);
+    size += sizeof(uint16_t) + sizeof(repli_timestamp_t) + stored_key_size(node, key) + sizer->size(value);
 
     // The node is full if we can't fit all that data within the free space.
     return size > free_space(sizer);
 }
 
+// A node is underfull if its mandatory cost is below this (see `is_underfull()`).
+int underfull_threshold(value_sizer_t *sizer) {
+    return free_space(sizer) / 2 - leaf_epsilon(sizer);
+}
+
 bool is_underfull(value_sizer_t *sizer, const leaf_node_t *node) {
 
     // An underfull node is one whose mandatory fields' cost
@@ -562,7 +801,7 @@ bool is_underfull(value_sizer_t *sizer, const leaf_node_t *node) {
     // free_space / 2 - leaf_epsilon.  We don't want an immediately
     // split node to be underfull, hence the threshold used below.
 
-    return mandatory_cost(sizer, node, MANDATORY_TIMESTAMPS) < free_space(sizer) / 2 - leaf_epsilon(sizer);
+    return mandatory_cost(sizer, node, MANDATORY_TIMESTAMPS) < underfull_threshold(sizer);
 }
 
 
@@ -586,13 +825,15 @@ void garbage_collect(
         int num_tstamped,
         int *preserved_index,
         optional<int> tstamp_cutoff_upper_bound = optional<int>()) {
+    // Deletion entries may go away, and the freed space can't be left to the heads.
+    drop_search_heads(node);
     scoped_array_t<uint16_t> indices(node->num_pairs);
 
     for (int i = 0; i < node->num_pairs; ++i) {
         indices[i] = i;
     }
 
-    std::sort(indices.data(), indices.data() + node->num_pairs, indirect_index_comparator_t(node->pair_offsets));
+    std::sort(indices.data(), indices.data() + node->num_pairs, indirect_index_comparator_t(pair_offsets(node)));
 
     int mand_offset;
     UNUSED int cost = mandatory_cost(sizer, node, num_tstamped, &mand_offset);
@@ -605,7 +846,7 @@ void garbage_collect(
     int w = sizer->block_size().value();
     int i = node->num_pairs - 1;
     for (; i >= 0; --i) {
-        int offset = node->pair_offsets[indices[i]];
+        int offset = pair_offsets(node)[indices[i]];
 
         if (offset < mand_offset) {
             break;
@@ -616,18 +857,18 @@ void garbage_collect(
             int sz = entry_size(sizer, ent);
             w -= sz;
             memmove(get_at_offset(node, w), ent, sz);
-            node->pair_offsets[indices[i]] = w;
+            pair_offsets(node)[indices[i]] = w;
         } else {
-            node->pair_offsets[indices[i]] = 0;
+            pair_offsets(node)[indices[i]] = 0;
         }
     }
 
-    // Either i < 0 or node->pair_offsets[indices[i]] < mand_offset.
+    // Either i < 0 or pair_offsets(node)[indices[i]] < mand_offset.
 
     node->tstamp_cutpoint = w;
 
     for (; i >= 0; --i) {
-        int offset = node->pair_offsets[indices[i]];
+        int offset = pair_offsets(node)[indices[i]];
         entry_t *ent = get_entry(node, offset);
         rassert(!entry_is_skip(ent));
 
@@ -637,7 +878,7 @@ void garbage_collect(
         w -= sz;
 
         memmove(get_at_offset(node, w), get_at_offset(node, offset), sz);
-        node->pair_offsets[indices[i]] = w;
+        pair_offsets(node)[indices[i]] = w;
     }
 
     node->frontmost = w;
@@ -649,8 +890,8 @@ void garbage_collect(
             *preserved_index = j;
         }
 
-        if (node->pair_offsets[k] != 0) {
-            node->pair_offsets[j] = node->pair_offsets[k];
+        if (pair_offsets(node)[k] != 0) {
+            pair_offsets(node)[j] = pair_offsets(node)[k];
 
             j += 1;
         }
@@ -692,6 +933,180 @@ void clean_entry(void *p, int sz) {
     }
 }
 
+// Gives the node search heads of its entries' stored keys, if there's room.
+void add_search_heads(leaf_node_t *node) {
+    rassert(!has_search_heads(node));
+    const int offsets_end = pair_offsets_begin(node) + node->num_pairs * sizeof(uint16_t);
+    if (!search_heads_fit(offsets_end, node->num_pairs, node->frontmost)) {
+        return;
+    }
+    uint64_t *heads = reinterpret_cast<uint64_t *>(
+        reinterpret_cast<char *>(node) + ::search_heads_begin(offsets_end));
+    for (int i = 0; i < node->num_pairs; ++i) {
+        const btree_key_t *key = entry_key(get_entry(node, pair_offsets(node)[i]));
+        heads[i] = search_head(key->contents, key->size);
+    }
+    node->magic.bytes[SEARCH_HEADS_MAGIC_BYTE] |= SEARCH_HEADS_MAGIC_BIT;
+}
+
+// Gives the node search heads at the end of a modification, unless it still has
+// the ones it had before.
+void ensure_search_heads(leaf_node_t *node) {
+    if (!has_search_heads(node)) {
+        add_search_heads(node);
+    }
+}
+
+// Drops the node's search heads if they wouldn't fit above `new_frontmost`.  This
+// has to happen before anything gets written below the current `frontmost`.
+void fit_search_heads(leaf_node_t *node, int new_frontmost) {
+    if (has_search_heads(node)
+        && !search_heads_fit(pair_offsets_begin(node)
+                                 + node->num_pairs * sizeof(uint16_t),
+                             node->num_pairs, new_frontmost)) {
+        drop_search_heads(node);
+    }
+}
+
+// Makes room in the node's search heads for an entry with the key `key` that is
+// about to go into `pair_offsets` at `index`, without rebuilding the other heads.
+// This has to happen before `pair_offsets` grows into where the heads are.  If
+// the heads wouldn't fit above `new_frontmost`, the node loses them instead.
+void insert_search_head(leaf_node_t *node, int index, const btree_key_t *key,
+                        int new_frontmost) {
+    if (!has_search_heads(node)) {
+        return;
+    }
+    const int new_offsets_end
+        = pair_offsets_begin(node) + (node->num_pairs + 1) * sizeof(uint16_t);
+    if (!search_heads_fit(new_offsets_end, node->num_pairs + 1, new_frontmost)) {
+        drop_search_heads(node);
+        return;
+    }
+    const int new_begin = ::search_heads_begin(new_offsets_end);
+    char *const base = reinterpret_cast<char *>(node);
+    open_search_head_gap(base, search_heads_begin(node), new_begin, node->num_pairs,
+                         index);
+    const int skip = prefix_size(node);
+    reinterpret_cast<uint64_t *>(base + new_begin)[index]
+        = search_head(key->contents + skip, key->size - skip);
+}
+
+// Drops the search heads of the entries `[beg, end)`, which have just been removed
+// from `pair_offsets`, and moves the other heads along with the pair offsets.
+void remove_search_heads(leaf_node_t *node, int beg, int end) {
+    if (!has_search_heads(node)) {
+        return;
+    }
+    const int old_num_pairs = node->num_pairs + (end - beg);
+    close_search_head_gap(reinterpret_cast<char *>(node),
+                          ::search_heads_begin(pair_offsets_begin(node)
+                                               + old_num_pairs * sizeof(uint16_t)),
+                          search_heads_begin(node), old_num_pairs, beg, end);
+}
+
+// Returns the mandatory cost that the node would have with a prefix of
+// `new_prefix_size` bytes, which must be a prefix of its current one.  This
+// is the space that `set_prefix()` needs.
+int cost_with_prefix_size(value_sizer_t *sizer, const leaf_node_t *node,
+                          int new_prefix_size) {
+    const int old_prefix_size = prefix_size(node);
+    rassert(new_prefix_size <= old_prefix_size);
+    int mand_offset;
+    int cost = mandatory_cost(sizer, node, MANDATORY_TIMESTAMPS, &mand_offset);
+    int num_mandatory = 0;
+    for (int i = 0; i < node->num_pairs; ++i) {
+        int offset = pair_offsets(node)[i];
+        if (offset < mand_offset || !entry_is_deletion(get_entry(node, offset))) {
+            ++num_mandatory;
+        }
+    }
+    return cost + num_mandatory * (old_prefix_size - new_prefix_size)
+        - prefix_area_size(old_prefix_size) + prefix_area_size(new_prefix_size);
+}
+
+// Rewrites the node so that its prefix is `prefix`, which may be empty.  Every
+// key in the node must have the new prefix.  If the prefix gets shorter, the
+// caller must have checked that the node will still fit, using
+// `cost_with_prefix_size()`.
+void set_prefix(value_sizer_t *sizer, leaf_node_t *node, const btree_key_t *prefix) {
+    // Afterwards the entries are packed together and the pair offsets only
+    // point at entries we have to keep.
+    garbage_collect(sizer, node, MANDATORY_TIMESTAMPS);
+
+    const int bs = sizer->block_size().value();
+    scoped_malloc_t<leaf_node_t> old_node(bs);
+    memcpy(old_node.get(), node, bs);
+    const leaf_node_t *old = old_node.get();
+    const uint16_t *old_offsets = pair_offsets(old);
+
+    scoped_array_t<uint16_t> indices(old->num_pairs);
+    for (int i = 0; i < old->num_pairs; ++i) {
+        indices[i] = i;
+    }
+    std::sort(indices.data(), indices.data() + old->num_pairs,
+              indirect_index_comparator_t(old_offsets));
+
+    init(sizer, node, prefix);
+    node->num_pairs = old->num_pairs;
+
+    // The rewritten entries keep their order, so they end up just as far from
+    // the end of the block as they take up space.
+    const int size_change = prefix_size(old) - prefix_size(node);
+    int total_size = 0;
+    for (int i = 0; i < old->num_pairs; ++i) {
+        int offset = old_offsets[indices[i]];
+        total_size += entry_size(sizer, get_entry(old, offset)) + size_change
+            + (offset < old->tstamp_cutpoint ? sizeof(repli_timestamp_t) : 0);
+    }
+    rassert(pair_offsets_begin(node) + sizeof(uint16_t) * node->num_pairs
+            <= static_cast<size_t>(bs - total_size));
+
+    int w = bs - total_size;
+    node->frontmost = w;
+    store_key_t key_buf;
+    for (int i = 0; i < old->num_pairs; ++i) {
+        int offset = old_offsets[indices[i]];
+        const entry_t *ent = get_entry(old, offset);
+        pair_offsets(node)[indices[i]] = w;
+        if (offset < old->tstamp_cutpoint) {
+            memcpy(get_at_offset(node, w), reinterpret_cast<const char *>(old) + offset,
+                   sizeof(repli_timestamp_t));
+            w += sizeof(repli_timestamp_t);
+        } else if (node->tstamp_cutpoint == bs) {
+            node->tstamp_cutpoint = w;
+        }
+
+        const btree_key_t *key = entry_full_key(old, ent, &key_buf);
+        char *dest = get_at_offset(node, w);
+        if (entry_is_deletion(ent)) {
+            *dest = static_cast<char>(DELETE_ENTRY_CODE);
+            write_stored_key(node, key, dest + 1);
+        } else {
+            rassert(entry_is_live(ent));
+            const void *value = entry_value(ent);
+            write_stored_key(node, key, dest);
+            memcpy(dest + stored_key_size(node, key), value, sizer->size(value));
+            node->live_size += sizeof(uint16_t) + entry_size(sizer, ent) + size_change;
+        }
+        w += entry_size(sizer, ent) + size_change;
+    }
+    rassert(w == bs);
+
+    validate(sizer, node);
+}
+
+// Finds the prefix that two neighboring nodes have in common.
+void common_prefix(const leaf_node_t *x, const leaf_node_t *y, store_key_t *out) {
+    const btree_key_t *px = node_prefix(x);
+    const btree_key_t *py = node_prefix(y);
+    if (px == nullptr || py == nullptr) {
+        out->set_size(0);
+    } else {
+        out->assign(common_prefix_size(px, py), px->contents);
+    }
+}
+
 // Moves entries with pair_offsets indices in the clopen range [beg,
 // end) from fro to tow.
 void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
@@ -700,6 +1115,8 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
                    std::vector<const void *> *moved_values_out) {
     rassert(is_underfull(sizer, tow));
     rassert(end >= beg);
+    // The entries are copied as they are, so they must mean the same in tow.
+    rassert(same_prefix(fro, tow));
 
     // This assertion is a bit loose.
     rassert(fro_copysize + mandatory_cost(sizer, tow, MANDATORY_TIMESTAMPS) <= free_space(sizer));
@@ -709,7 +1126,7 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
     garbage_collect(sizer, tow, MANDATORY_TIMESTAMPS, &wpoint);
 
     // Now resize and move tow's pair_offsets.
-    memmove(tow->pair_offsets + wpoint + (end - beg), tow->pair_offsets + wpoint, sizeof(uint16_t) * (tow->num_pairs - wpoint));
+    memmove(pair_offsets(tow) + wpoint + (end - beg), pair_offsets(tow) + wpoint, sizeof(uint16_t) * (tow->num_pairs - wpoint));
 
     tow->num_pairs += end - beg;
 
@@ -718,18 +1135,18 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
     // Now we're going to do something crazy.  Fill the new hole in
     // the pair offsets with the numbers in [0, end - beg).
     for (int i = 0; i < end - beg; ++i) {
-        tow->pair_offsets[wpoint + i] = i;
+        pair_offsets(tow)[wpoint + i] = i;
     }
 
     // We treat these numbers as indices into [beg, end) in fro, and
     // sort them so that we can access [beg, end) in order by
     // increasing offset.
-    std::sort(tow->pair_offsets + wpoint, tow->pair_offsets + wpoint + (end - beg), indirect_index_comparator_t(fro->pair_offsets + beg));
+    std::sort(pair_offsets(tow) + wpoint, pair_offsets(tow) + wpoint + (end - beg), indirect_index_comparator_t(pair_offsets(fro) + beg));
 
     int tow_offset = tow->frontmost;
 
     // The offset we read from (indirectly pointing to fro's [beg,
-    // end)) in tow->pair_offsets, and the offset at which we stop.
+    // end)) in pair_offsets(tow), and the offset at which we stop.
     int fro_index = wpoint;
     int fro_index_end = wpoint + (end - beg);
 
@@ -747,7 +1164,7 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
     int livesize = tow->live_size;
 
     for (int i = 0; i < wpoint; ++i) {
-        if (tow->pair_offsets[i] < tow->tstamp_cutpoint) {
+        if (pair_offsets(tow)[i] < tow->tstamp_cutpoint) {
             rassert(num_adjustable_tow_offsets < MANDATORY_TIMESTAMPS);
             adjustable_tow_offsets[num_adjustable_tow_offsets] = i;
             ++num_adjustable_tow_offsets;
@@ -755,7 +1172,7 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
     }
 
     for (int i = wpoint + (end - beg); i < tow->num_pairs; ++i) {
-        if (tow->pair_offsets[i] < tow->tstamp_cutpoint) {
+        if (pair_offsets(tow)[i] < tow->tstamp_cutpoint) {
             rassert(num_adjustable_tow_offsets < MANDATORY_TIMESTAMPS);
             adjustable_tow_offsets[num_adjustable_tow_offsets] = i;
             ++num_adjustable_tow_offsets;
@@ -771,7 +1188,7 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
             break;
         }
 
-        int fro_offset = fro->pair_offsets[beg + tow->pair_offsets[fro_index]];
+        int fro_offset = pair_offsets(fro)[beg + pair_offsets(tow)[fro_index]];
 
         if (fro_offset >= fro_mand_offset) {
             // We have no more timestamped information to push.
@@ -798,7 +1215,7 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
             // Update the pair offset in fro to be the offset in tow
             // -- we'll never use the old value again and we'll copy
             // the newer values to tow later.
-            fro->pair_offsets[beg + tow->pair_offsets[fro_index]] = wri_offset;
+            pair_offsets(fro)[beg + pair_offsets(tow)[fro_index]] = wri_offset;
 
             wri_offset += sz;
             actually_copied += sz;
@@ -812,8 +1229,8 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
             int i;
             for (i = 0; i < num_adjustable_tow_offsets; ++i) {
                 int j = adjustable_tow_offsets[i];
-                if (tow->pair_offsets[j] == tow_offset) {
-                    tow->pair_offsets[j] = wri_offset;
+                if (pair_offsets(tow)[j] == tow_offset) {
+                    pair_offsets(tow)[j] = wri_offset;
                     break;
                 }
             }
@@ -830,7 +1247,7 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
 
     // Now we have some untimestamped entries to write.
     for (; fro_index < fro_index_end; ++fro_index) {
-        int fro_offset = fro->pair_offsets[beg + tow->pair_offsets[fro_index]];
+        int fro_offset = pair_offsets(fro)[beg + pair_offsets(tow)[fro_index]];
         entry_t *ent = get_entry(fro, fro_offset);
         if (entry_is_live(ent)) {
             int sz = entry_size(sizer, ent);
@@ -838,7 +1255,7 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
             clean_entry(ent, sz);
             fro_live_size_adjustment -= sz + sizeof(uint16_t);
 
-            fro->pair_offsets[beg + tow->pair_offsets[fro_index]] = wri_offset;
+            pair_offsets(fro)[beg + pair_offsets(tow)[fro_index]] = wri_offset;
 
             wri_offset += sz;
             livesize += sz + sizeof(uint16_t);
@@ -848,7 +1265,7 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
             rassert(entry_is_deletion(ent));
 
             // This is a dead entry.  We'll need to squash this dead entry later.
-            fro->pair_offsets[beg + tow->pair_offsets[fro_index]] = 0;
+            pair_offsets(fro)[beg + pair_offsets(tow)[fro_index]] = 0;
 
             int sz = entry_size(sizer, ent);
             clean_entry(ent, sz);
@@ -872,8 +1289,8 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
             int i;
             for (i = 0; i < num_adjustable_tow_offsets; ++i) {
                 int j = adjustable_tow_offsets[i];
-                if (tow->pair_offsets[j] == tow_offset) {
-                    tow->pair_offsets[j] = wri_offset;
+                if (pair_offsets(tow)[j] == tow_offset) {
+                    pair_offsets(tow)[j] = wri_offset;
                     break;
                 }
             }
@@ -889,8 +1306,8 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
             int i;
             for (i = 0; i < num_adjustable_tow_offsets; ++i) {
                 int j = adjustable_tow_offsets[i];
-                if (tow->pair_offsets[j] == tow_offset) {
-                    tow->pair_offsets[j] = 0;
+                if (pair_offsets(tow)[j] == tow_offset) {
+                    pair_offsets(tow)[j] = 0;
                 }
             }
         }
@@ -912,10 +1329,11 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
 
     // Copy the valid tow offsets from [beg, end) to the wpoint point
     // in tow, and move fro entries.
-    memcpy(tow->pair_offsets + wpoint, fro->pair_offsets + beg,
+    memcpy(pair_offsets(tow) + wpoint, pair_offsets(fro) + beg,
            sizeof(uint16_t) * (end - beg));
-    memmove(fro->pair_offsets + beg, fro->pair_offsets + end, sizeof(uint16_t) * (fro->num_pairs - end));
+    memmove(pair_offsets(fro) + beg, pair_offsets(fro) + end, sizeof(uint16_t) * (fro->num_pairs - end));
     fro->num_pairs -= end - beg;
+    remove_search_heads(fro, beg, end);
 
     tow->frontmost = new_frontmost;
 
@@ -930,7 +1348,7 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
         moved_values_out->clear();
         moved_values_out->reserve(end - beg);
         for (int pair_idx = wpoint; pair_idx < wpoint + (end - beg); ++pair_idx) {
-            const int offset = tow->pair_offsets[pair_idx];
+            const int offset = pair_offsets(tow)[pair_idx];
             // Skip dead entries
             if (offset != 0) {
                 const entry_t *entry = get_entry(tow, offset);
@@ -947,8 +1365,8 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
         // for, and that we removed from tow, as well.
         int j, k;
         for (j = 0, k = 0; k < tow->num_pairs; ++k) {
-            if (tow->pair_offsets[k] != 0) {
-                tow->pair_offsets[j] = tow->pair_offsets[k];
+            if (pair_offsets(tow)[k] != 0) {
+                pair_offsets(tow)[j] = pair_offsets(tow)[k];
 
                 j += 1;
             }
@@ -960,20 +1378,26 @@ void move_elements(value_sizer_t *sizer, leaf_node_t *fro, int beg, int end,
     validate(sizer, tow);
 }
 
-void split(value_sizer_t *sizer, leaf_node_t *node, leaf_node_t *rnode, btree_key_t *median_out) {
-    int tstamp_back_offset;
-    int mandatory = mandatory_cost(sizer, node, MANDATORY_TIMESTAMPS, &tstamp_back_offset);
-
-    guarantee(mandatory >= free_space(sizer) - leaf_epsilon(sizer));
-
-    // We shall split the mandatory cost of this node as evenly as possible.
+// Picks the entries [*s_out, num_pairs) of `node` that a split moves to the right node,
+// which gets as close to `100 - left_percent` percent of `mandatory` as possible.  For
+// an uneven split, the right node also gets enough live entries not to be underfull,
+// because the next write to it would level it with `node` again.  Only live entries
+// count for that: `move_elements()` doesn't carry timestamps or deletion entries over
+// to an empty node.  Returns false if that leaves too little in `node`.
+bool choose_split_point(value_sizer_t *sizer, leaf_node_t *node, int mandatory,
+                        int tstamp_back_offset, int left_percent, int *s_out,
+                        int *end_rcost_out, int *num_mandatories_out) {
+    const int target_rcost = mandatory * (100 - left_percent) / 100;
+    const int min_rlive = left_percent == 50 ? 0 : underfull_threshold(sizer);
 
     int num_mandatories = 0;
     int i = node->num_pairs - 1;
     int prev_rcost = 0;
     int rcost = 0;
-    while (i >= 0 && rcost < mandatory / 2) {
-        int offset = node->pair_offsets[i];
+    int prev_rlive = 0;
+    int rlive = 0;
+    while (i >= 0 && (rcost < target_rcost || rlive < min_rlive)) {
+        int offset = pair_offsets(node)[i];
         entry_t *ent = get_entry(node, offset);
 
         // We only take mandatory entries' costs into consideration,
@@ -984,7 +1408,9 @@ void split(value_sizer_t *sizer, leaf_node_t *node, leaf_node_t *rnode, btree_ke
 
         if (entry_is_live(ent)) {
             prev_rcost = rcost;
+            prev_rlive = rlive;
             rcost += entry_size(sizer, ent) + sizeof(uint16_t) + (offset < tstamp_back_offset ? sizeof(repli_timestamp_t) : 0);
+            rlive += entry_size(sizer, ent) + sizeof(uint16_t);
 
             ++num_mandatories;
         } else {
@@ -992,6 +1418,7 @@ void split(value_sizer_t *sizer, leaf_node_t *node, leaf_node_t *rnode, btree_ke
 
             if (offset < tstamp_back_offset) {
                 prev_rcost = rcost;
+                prev_rlive = rlive;
                 rcost += entry_size(sizer, ent) + sizeof(uint16_t) + sizeof(repli_timestamp_t);
 
                 ++num_mandatories;
@@ -1005,35 +1432,75 @@ void split(value_sizer_t *sizer, leaf_node_t *node, leaf_node_t *rnode, btree_ke
     guarantee(i < node->num_pairs);
     guarantee(i > 0);
 
-    // Now prev_rcost and rcost envelope mandatory / 2.
-    guarantee(prev_rcost < mandatory / 2);
-    guarantee(rcost >= mandatory / 2, "rcost = %d, mandatory / 2 = %d, i = %d", rcost, mandatory / 2, i);
+    // Now prev_rcost and rcost envelope target_rcost (or prev_rlive and rlive
+    // envelope min_rlive).
+    guarantee(prev_rcost < target_rcost || prev_rlive < min_rlive);
+    guarantee(rcost >= target_rcost, "rcost = %d, target_rcost = %d, i = %d", rcost, target_rcost, i);
+    guarantee(rlive >= min_rlive);
+
+    // Take whichever of them is closer to the exact target (which is
+    // `mandatory * (100 - left_percent) / 100` without rounding), as long as
+    // it gives the right node enough.
+    if (prev_rlive >= min_rlive
+        && mandatory * (100 - left_percent) - 100 * prev_rcost
+           < 100 * rcost - mandatory * (100 - left_percent)) {
+        *end_rcost_out = prev_rcost;
+        *s_out = i + 2;
+        *num_mandatories_out = num_mandatories - 1;
+    } else {
+        *end_rcost_out = rcost;
+        *s_out = i + 1;
+        *num_mandatories_out = num_mandatories;
+    }
+
+    // If our math was right, the right node can't be underfull just considering
+    // the split of the mandatory costs.
+    guarantee(left_percent != 50 || *end_rcost_out >= free_space(sizer) / 2 - leaf_epsilon(sizer));
+    return mandatory - *end_rcost_out >= free_space(sizer) / 2 - leaf_epsilon(sizer);
+}
+
+void split(value_sizer_t *sizer, leaf_node_t *node, leaf_node_t *rnode, btree_key_t *median_out,
+           int left_percent) {
+    rassert(left_percent >= 50 && left_percent <= 100);
+
+    int tstamp_back_offset;
+    int mandatory = mandatory_cost(sizer, node, MANDATORY_TIMESTAMPS, &tstamp_back_offset);
+
+    guarantee(mandatory >= free_space(sizer) - leaf_epsilon(sizer));
 
     int s;
     int end_rcost;
-    if ((mandatory - prev_rcost) - prev_rcost < rcost - (mandatory - rcost)) {
-        end_rcost = prev_rcost;
-        s = i + 2;
-        --num_mandatories;
-    } else {
-        end_rcost = rcost;
-        s = i + 1;
+    int num_mandatories;
+    if (!choose_split_point(sizer, node, mandatory, tstamp_back_offset, left_percent,
+                            &s, &end_rcost, &num_mandatories)) {
+        // The node has so many deletion entries that an uneven split would leave
+        // it underfull, so we split it evenly.
+        guarantee(left_percent != 50);
+        guarantee(choose_split_point(sizer, node, mandatory, tstamp_back_offset, 50,
+                                     &s, &end_rcost, &num_mandatories));
     }
 
     // If our math was right, neither node can be underfull just
     // considering the split of the mandatory costs.
-    guarantee(end_rcost >= free_space(sizer) / 2 - leaf_epsilon(sizer));
     guarantee(mandatory - end_rcost >= free_space(sizer) / 2 - leaf_epsilon(sizer));
 
     // Now we wish to move the elements at indices [s, num_pairs) to rnode.
 
-    init(sizer, rnode);
+    // Every key that can go in either half has the node's prefix.
+    init(sizer, rnode, node_prefix(node));
 
     int node_copysize = end_rcost - num_mandatories * sizeof(uint16_t);
     move_elements(sizer, node, s, node->num_pairs, 0, rnode, node_copysize,
                   tstamp_back_offset, nullptr);
 
-    keycpy(median_out, entry_key(get_entry(node, node->pair_offsets[s - 1])));
+    store_key_t median_buf;
+    keycpy(median_out, entry_full_key(node, get_entry(node, pair_offsets(node)[s - 1]),
+                                      &median_buf));
+
+    ensure_search_heads(node);
+    add_search_heads(rnode);
+    validate(sizer, node);
+    validate(sizer, rnode);
 }
 
 void merge(value_sizer_t *sizer, leaf_node_t *left, leaf_node_t *right) {
@@ -1042,6 +1509,15 @@ void merge(value_sizer_t *sizer, leaf_node_t *left, leaf_node_t *right) {
     rassert(is_underfull(sizer, left));
     rassert(is_underfull(sizer, right));
 
+    if (!same_prefix(left, right)) {
+        // `is_mergable()` checked that both nodes stay underfull with the
+        // prefix they have in common.
+        store_key_t prefix;
+        common_prefix(left, right, &prefix);
+        set_prefix(sizer, left, prefix.btree_key());
+        set_prefix(sizer, right, prefix.btree_key());
+    }
+
     int tstamp_back_offset;
     int mandatory = mandatory_cost(sizer, left, MANDATORY_TIMESTAMPS, &tstamp_back_offset);
 
@@ -1050,27 +1526,50 @@ void merge(value_sizer_t *sizer, leaf_node_t *left, leaf_node_t *right) {
     // This includes deletion entries *before* the `tstamp_back_offset`, as well
     // as all non-deletion entries.
     for (int i = 0; i < left->num_pairs; ++i) {
-        if (left->pair_offsets[i] < tstamp_back_offset
-            || !entry_is_deletion(get_entry(left, left->pair_offsets[i]))) {
+        if (pair_offsets(left)[i] < tstamp_back_offset
+            || !entry_is_deletion(get_entry(left, pair_offsets(left)[i]))) {
             left_copysize -= sizeof(uint16_t);
         }
     }
 
     move_elements(sizer, left, 0, left->num_pairs, 0, right, left_copysize,
                   tstamp_back_offset, nullptr);
+
+    ensure_search_heads(right);
+    validate(sizer, right);
 }
 
-// We move keys out of sibling and into node.
-bool level(value_sizer_t *sizer, int nodecmp_node_with_sib,
-           leaf_node_t *node, leaf_node_t *sibling,
-           btree_key_t *replacement_key_out,
-           std::vector<const void *> *moved_values_out) {
+// We move keys out of sibling and into node.  Either node may lose its search
+// heads.
+bool level_entries(value_sizer_t *sizer, int nodecmp_node_with_sib,
+                   leaf_node_t *node, leaf_node_t *sibling,
+                   btree_key_t *replacement_key_out,
+                   std::vector<const void *> *moved_values_out) {
     rassert(node != sibling);
 
     // If sibling were underfull, we'd just merge the nodes.
     rassert(is_underfull(sizer, node));
     rassert(!is_underfull(sizer, sibling));
 
+    if (!same_prefix(node, sibling)) {
+        // The moved entries need the prefix that the nodes have in common, and so
+        // does whichever node keeps the longer prefix, because its key range
+        // widens.  We don't level if that makes node stop being underfull or
+        // sibling overflow.
+        store_key_t prefix;
+        common_prefix(node, sibling, &prefix);
+        if (cost_with_prefix_size(sizer, node, prefix.size())
+                >= underfull_threshold(sizer)
+            || cost_with_prefix_size(sizer, sibling, prefix.size())
+                > free_space(sizer)) {
+            return false;
+        }
+        set_prefix(sizer, node, prefix.btree_key());
+        set_prefix(sizer, sibling, prefix.btree_key());
+        rassert(is_underfull(sizer, node));
+        rassert(!is_underfull(sizer, sibling));
+    }
+
     // First figure out the inclusive range [beg, end] of elements we want to move
     // from sibling.
     int beg, end, *w, wstep;
@@ -1107,7 +1606,7 @@ bool level(value_sizer_t *sizer, int nodecmp_node_with_sib,
     int num_mandatories = 0;
     int prev_diff = sizer->block_size().value();  // some impossibly large value
     for (;;) {
-        int offset = sibling->pair_offsets[*w];
+        int offset = pair_offsets(sibling)[*w];
         entry_t *ent = get_entry(sibling, offset);
 
         // We only take mandatory entries' costs into consideration.
@@ -1164,17 +1663,65 @@ bool level(value_sizer_t *sizer, int nodecmp_node_with_sib,
     guarantee(node->num_pairs > 0);
     guarantee(sibling->num_pairs > 0);
 
+    store_key_t replacement_buf;
     if (nodecmp_node_with_sib < 0) {
-        keycpy(replacement_key_out, entry_key(get_entry(node, node->pair_offsets[node->num_pairs - 1])));
+        const entry_t *ent = get_entry(node, pair_offsets(node)[node->num_pairs - 1]);
+        keycpy(replacement_key_out, entry_full_key(node, ent, &replacement_buf));
     } else {
-        keycpy(replacement_key_out, entry_key(get_entry(sibling, sibling->pair_offsets[sibling->num_pairs - 1])));
+        const entry_t *ent
+            = get_entry(sibling, pair_offsets(sibling)[sibling->num_pairs - 1]);
+        keycpy(replacement_key_out, entry_full_key(sibling, ent, &replacement_buf));
     }
 
     return true;
 }
 
+bool level(value_sizer_t *sizer, int nodecmp_node_with_sib,
+           leaf_node_t *node, leaf_node_t *sibling,
+           btree_key_t *replacement_key_out,
+           std::vector<const void *> *moved_values_out) {
+    const bool leveled = level_entries(sizer, nodecmp_node_with_sib, node, sibling,
+                                       replacement_key_out, moved_values_out);
+    ensure_search_heads(node);
+    ensure_search_heads(sibling);
+    validate(sizer, node);
+    validate(sizer, sibling);
+    return leveled;
+}
+
 bool is_mergable(value_sizer_t *sizer, const leaf_node_t *node, const leaf_node_t *sibling) {
-    return is_underfull(sizer, node) && is_underfull(sizer, sibling);
+    if (!is_underfull(sizer, node) || !is_underfull(sizer, sibling)) {
+        return false;
+    }
+    if (same_prefix(node, sibling)) {
+        return true;
+    }
+    // `merge()` has to give both nodes the prefix they have in common first.
+    store_key_t prefix;
+    common_prefix(node, sibling, &prefix);
+    const int threshold = underfull_threshold(sizer);
+    return cost_with_prefix_size(sizer, node, prefix.size()) < threshold
+        && cost_with_prefix_size(sizer, sibling, prefix.size()) < threshold;
+}
+
+void update_prefix(value_sizer_t *sizer, leaf_node_t *node,
+                   const btree_key_t *left_exclusive, const btree_key_t *right_inclusive) {
+    const int old_size = prefix_size(node);
+    const int new_size = common_prefix_size(left_exclusive, right_inclusive);
+    if (new_size <= old_size) {
+        return;
+    }
+    // Every entry gets shorter by the extra prefix bytes, but the prefix itself
+    // takes up space too.
+    if (node->num_pairs * (new_size - old_size)
+            <= prefix_area_size(new_size) - prefix_area_size(old_size)) {
+        return;
+    }
+    store_key_t prefix(new_size, left_exclusive->contents);
+    // Every stored key changes, so the heads have to be rebuilt.
+    set_prefix(sizer, node, prefix.btree_key());
+    add_search_heads(node);
+    validate(sizer, node);
 }
 
 // Sets *index_out to the index for the live entry or deletion entry
@@ -1184,6 +1731,34 @@ bool find_key(const leaf_node_t *node, const btree_key_t *key, int *index_out) {
     int beg = 0;
     int end = node->num_pairs;
 
+    // In a prefixed node, we compare the key with the prefix once, and only
+    // compare the rest of it with the entries.
+    const uint8_t *contents = key->contents;
+    int size = key->size;
+    if (is_prefixed(node)) {
+        const btree_key_t *prefix = node_prefix(node);
+        int res = sized_strcmp(contents, std::min<int>(size, prefix->size),
+                               prefix->contents, prefix->size);
+        if (res == 0 && size < prefix->size) {
+            // The key is a proper prefix of the prefix.
+            res = -1;
+        }
+        if (res != 0) {
+            // The key sorts before or after every key in the node.
+            *index_out = res < 0 ? 0 : node->num_pairs;
+            return false;
+        }
+        contents += prefix->size;
+        size -= prefix->size;
+    }
+
+    // The search heads tell us which entries could be equal to the key, without
+    // looking at the entries.
+    if (has_search_heads(node)) {
+        find_search_head_range(search_heads(node), node->num_pairs,
+                               search_head(contents, size), &beg, &end);
+    }
+
     // beg == 0 or key > *(beg - 1).
     // end == num_pairs or key < *end.
 
@@ -1191,9 +1766,9 @@ bool find_key(const leaf_node_t *node, const btree_key_t *key, int *index_out) {
         // when (end - beg) > 0, (end - beg) / 2 is always less than (end - beg).  So beg <= test_point < end.
         int test_point = beg + (end - beg) / 2;
 
-        const btree_key_t *ek = entry_key(get_entry(node, node->pair_offsets[test_point]));
+        const btree_key_t *ek = entry_key(get_entry(node, pair_offsets(node)[test_point]));
 
-        int res = btree_key_cmp(key, ek);
+        int res = sized_strcmp(contents, size, ek->contents, ek->size);
 
         if (res < 0) {
             // key < *test_point.
@@ -1218,7 +1793,7 @@ bool find_key(const leaf_node_t *node, const btree_key_t *key, int *index_out) {
 bool lookup(value_sizer_t *sizer, const leaf_node_t *node, const btree_key_t *key, void *value_out) {
     int index;
     if (find_key(node, key, &index)) {
-        const entry_t *ent = get_entry(node, node->pair_offsets[index]);
+        const entry_t *ent = get_entry(node, pair_offsets(node)[index]);
         if (entry_is_live(ent)) {
             const void *val = entry_value(ent);
             memcpy(value_out, val, sizer->size(val));
@@ -1229,6 +1804,10 @@ bool lookup(value_sizer_t *sizer, const leaf_node_t *node, const btree_key_t *ke
     return false;
 }
 
+void erase_node_deletions(
+        value_sizer_t *sizer, leaf_node_t *node,
+        optional<repli_timestamp_t> min_del_timestamp);
+
 /* `insert()` and `remove()` call this to insert a new entry into the leaf node.
 
 First it removes any existing entry for `key`; then it makes room in the leaf
@@ -1288,7 +1867,7 @@ MUST_USE bool prepare_space_for_new_entry(
     bool found = find_key(node, key, &index);
 
     if (found) {
-        int offset = node->pair_offsets[index];
+        int offset = pair_offsets(node)[index];
         entry_t *ent = get_entry(node, offset);
 
         int sz = entry_size(sizer, ent);
@@ -1319,7 +1898,7 @@ MUST_USE bool prepare_space_for_new_entry(
     We check for this condition further down, and recover from it by dropping
     all existing timestamps and discarding the delete entry by returning `false`. */
 
-    if (offsetof(leaf_node_t, pair_offsets) +
+    if (pair_offsets_begin(node) +
             sizeof(uint16_t) * (node->num_pairs + (found ? 0 : 1)) +
             sizeof(repli_timestamp_t) +
             new_entry_size >
@@ -1329,8 +1908,8 @@ MUST_USE bool prepare_space_for_new_entry(
             /* We can't re-use an existing index if we're garbage collecting. */
             found = false;
             memmove(
-                node->pair_offsets + index,
-                node->pair_offsets + index + 1,
+                pair_offsets(node) + index,
+                pair_offsets(node) + index + 1,
                 sizeof(uint16_t) * (node->num_pairs - index - 1));
             --node->num_pairs;
         }
@@ -1398,7 +1977,7 @@ MUST_USE bool prepare_space_for_new_entry(
     bool drop_timestamps = false;
     if (actually_create_entry
         && !allow_after_tstamp_cutpoint
-        && offsetof(leaf_node_t, pair_offsets)
+        && pair_offsets_begin(node)
            + sizeof(uint16_t) * (node->num_pairs + (found ? 0 : 1))
            + new_entry_size
            + sizeof(repli_timestamp_t)
@@ -1413,14 +1992,15 @@ MUST_USE bool prepare_space_for_new_entry(
             a new one; close the gap in `pair_offsets`. `index` is the location
             of the open slot. */
             memmove(
-                node->pair_offsets + index,
-                node->pair_offsets + index + 1,
+                pair_offsets(node) + index,
+                pair_offsets(node) + index + 1,
                 sizeof(uint16_t) * (node->num_pairs - index - 1));
             --node->num_pairs;
+            remove_search_heads(node, index, index + 1);
         }
 
         if (drop_timestamps) {
-            erase_deletions(sizer, node, optional<repli_timestamp_t>());
+            erase_node_deletions(sizer, node, optional<repli_timestamp_t>());
         }
 
         return false;
@@ -1431,19 +2011,23 @@ MUST_USE bool prepare_space_for_new_entry(
     We didn't do this before because we weren't sure if we were actually gonna
     create a new entry or not. */
 
+    int total_space_for_new_entry = new_entry_size + (new_entry_should_have_timestamp ? sizeof(repli_timestamp_t) : 0);
+
     if (!found) {
+        insert_search_head(node, index, key,
+                           node->frontmost - total_space_for_new_entry);
         memmove(
-            node->pair_offsets + index + 1,
-            node->pair_offsets + index,
+            pair_offsets(node) + index + 1,
+            pair_offsets(node) + index,
             sizeof(uint16_t) * (node->num_pairs - index));
         ++node->num_pairs;
+    } else {
+        fit_search_heads(node, node->frontmost - total_space_for_new_entry);
     }
 
     /* Now that we know where in the leaf node to write our entry, make space if
     necessary. */
 
-    int total_space_for_new_entry = new_entry_size + (new_entry_should_have_timestamp ? sizeof(repli_timestamp_t) : 0);
-
     if (end_of_where_new_entry_should_go == node->frontmost) {
         /* This is the common case. Just like before, we check for this case
         specially and short-circuit, even though the algorithm in the `else`
@@ -1459,14 +2043,14 @@ MUST_USE bool prepare_space_for_new_entry(
         the entries */
         for (int i = 0; i < node->num_pairs; ++i) {
             if (i == index) continue;
-            if (node->pair_offsets[i] < end_of_where_new_entry_should_go) {
-                node->pair_offsets[i] -= total_space_for_new_entry;
+            if (pair_offsets(node)[i] < end_of_where_new_entry_should_go) {
+                pair_offsets(node)[i] -= total_space_for_new_entry;
             }
         }
     }
 
     node->frontmost -= total_space_for_new_entry;
-    guarantee(offsetof(leaf_node_t, pair_offsets)
+    guarantee(pair_offsets_begin(node)
               + sizeof(uint16_t) * node->num_pairs <= node->frontmost);
 
     /* Write the timestamp if we need one, and update `node->tstamp_cutpoint` if
@@ -1482,7 +2066,7 @@ MUST_USE bool prepare_space_for_new_entry(
 
     /* Record the offset in `pair_offsets` */
 
-    node->pair_offsets[index] = start_of_where_new_entry_should_go;
+    pair_offsets(node)[index] = start_of_where_new_entry_should_go;
 
     /* Fill output variable */
 
@@ -1510,20 +2094,22 @@ void insert(
     /* Make space for the entry itself */
 
     char *location_to_write_data;
+    const int key_size = stored_key_size(node, key);
     bool should_write = prepare_space_for_new_entry(sizer, node,
-        key, key->full_size() + sizer->size(value), tstamp, maximum_existing_tstamp,
+        key, key_size + sizer->size(value), tstamp, maximum_existing_tstamp,
         true,
         &location_to_write_data);
     guarantee(should_write);
 
     /* Now copy the data into the node itself */
 
-    memcpy(location_to_write_data, key, key->full_size());
-    location_to_write_data += key->full_size();
+    write_stored_key(node, key, location_to_write_data);
+    location_to_write_data += key_size;
     memcpy(location_to_write_data, value, sizer->size(value));
 
-    node->live_size += sizeof(uint16_t) + key->full_size() + sizer->size(value);
+    node->live_size += sizeof(uint16_t) + key_size + sizer->size(value);
 
+    ensure_search_heads(node);
     validate(sizer, node);
 }
 
@@ -1541,16 +2127,17 @@ void remove(
     char *location_to_write_data;
     if (prepare_space_for_new_entry(sizer, node,
             key,
-            1 + key->full_size(),   /* 1 for `DELETE_ENTRY_CODE` */
+            1 + stored_key_size(node, key),   /* 1 for `DELETE_ENTRY_CODE` */
             tstamp,
             maximum_existing_tstamp,
             false,
             &location_to_write_data)) {
         *location_to_write_data = static_cast<char>(DELETE_ENTRY_CODE);
         ++location_to_write_data;
-        memcpy(location_to_write_data, key, key->full_size());
+        write_stored_key(node, key, location_to_write_data);
     }
 
+    ensure_search_heads(node);
     validate(sizer, node);
 }
 
@@ -1559,7 +2146,7 @@ void erase_presence(value_sizer_t *sizer, leaf_node_t *node, const btree_key_t *
     int index;
     bool found = find_key(node, key, &index);
     if (found) {
-        int offset = node->pair_offsets[index];
+        int offset = pair_offsets(node)[index];
         entry_t *ent = get_entry(node, offset);
 
         int sz = entry_size(sizer, ent);
@@ -1569,8 +2156,9 @@ void erase_presence(value_sizer_t *sizer, leaf_node_t *node, const btree_key_t *
 
         clean_entry(ent, sz);
 
-        memmove(node->pair_offsets + index, node->pair_offsets + index + 1, (node->num_pairs - (index + 1)) * sizeof(uint16_t));
+        memmove(pair_offsets(node) + index, pair_offsets(node) + index + 1, (node->num_pairs - (index + 1)) * sizeof(uint16_t));
         node->num_pairs -= 1;
+        remove_search_heads(node, index, index + 1);
     }
 
     validate(sizer, node);
@@ -1596,7 +2184,9 @@ repli_timestamp_t min_deletion_timestamp(
     return earliest_so_far.next();
 }
 
-void erase_deletions(
+// Does the work of `erase_deletions()`, keeping the node's search heads in step
+// with its pair offsets.
+void erase_node_deletions(
         value_sizer_t *sizer, leaf_node_t *node,
         optional<repli_timestamp_t> min_del_timestamp) {
     int old_tstamp_cutpoint = node->tstamp_cutpoint;
@@ -1648,16 +2238,26 @@ void erase_deletions(
     a key-value pair, we need to move it forward by `sizeof(repli_timestamp_t)`. If it
     was pointing to a deletion entry that's been erased, we need to remove that entry
     from `pair_offsets`. */
+    /* The search heads get compacted in place along with `pair_offsets`, and moved
+    to where they belong afterwards, since they may move into the part of
+    `pair_offsets` that we are still reading. */
+    const bool heads = has_search_heads(node);
+    const int old_heads_begin = search_heads_begin(node);
+    uint64_t *const old_heads = reinterpret_cast<uint64_t *>(
+        reinterpret_cast<char *>(node) + old_heads_begin);
     int src = 0, dst = 0;
     int num_deleted = deletion_offsets.size();
     for (; src < node->num_pairs; ++src) {
-        uint16_t off = node->pair_offsets[src];
+        uint16_t off = pair_offsets(node)[src];
         auto it = deletion_offsets.find(off);
         if (it == deletion_offsets.end()) {
             if (off >= new_tstamp_cutpoint && off < old_tstamp_cutpoint) {
                 off += sizeof(repli_timestamp_t);
             }
-            node->pair_offsets[dst++] = off;
+            if (heads) {
+                old_heads[dst] = old_heads[src];
+            }
+            pair_offsets(node)[dst++] = off;
         } else {
             guarantee(off >= new_tstamp_cutpoint && off < old_tstamp_cutpoint);
             deletion_offsets.erase(it);
@@ -1665,11 +2265,24 @@ void erase_deletions(
     }
     guarantee(deletion_offsets.empty());
     node->num_pairs -= num_deleted;
+    if (heads) {
+        close_search_head_gap(reinterpret_cast<char *>(node), old_heads_begin,
+                              search_heads_begin(node), node->num_pairs,
+                              node->num_pairs, node->num_pairs);
+    }
 
     /* Finally, update `node->tstamp_cutpoint` */
     node->tstamp_cutpoint = new_tstamp_cutpoint;
 }
 
+void erase_deletions(
+        value_sizer_t *sizer, leaf_node_t *node,
+        optional<repli_timestamp_t> min_del_timestamp) {
+    erase_node_deletions(sizer, node, min_del_timestamp);
+    ensure_search_heads(node);
+    validate(sizer, node);
+}
+
 /* Calls `cb` on every entry in the node, whether a real entry or a deletion. The calls
 will be in order from most recent to least recent. For entries with no timestamp, the
 callback will get `min_deletion_timestamp() - 1`. */
@@ -1683,6 +2296,7 @@ continue_bool_t visit_entries(
             const void *value   /* null for deletion */
             )> &cb) {
     repli_timestamp_t earliest_so_far = maximum_existing_timestamp;
+    store_key_t key_buf;
     for (entry_iter_t iter = entry_iter_t::make(node);
             !iter.done(sizer); iter.step(sizer, node)) {
         repli_timestamp_t tstamp;
@@ -1699,7 +2313,8 @@ continue_bool_t visit_entries(
             continue;
         }
 
-        if (continue_bool_t::ABORT == cb(entry_key(ent), tstamp, entry_value(ent))) {
+        if (continue_bool_t::ABORT == cb(entry_full_key(node, ent, &key_buf), tstamp,
+                                         entry_value(ent))) {
             return continue_bool_t::ABORT;
         }
     }
@@ -1715,8 +2330,8 @@ iterator::iterator(const leaf_node_t *node, int index)
 std::pair<const btree_key_t *, const void *> iterator::operator*() const {
     guarantee(index_ < static_cast<int>(node_->num_pairs));
     guarantee(index_ >= 0);
-    const entry_t *entree = get_entry(node_, node_->pair_offsets[index_]);
-    return std::make_pair(entry_key(entree), entry_value(entree));
+    const entry_t *entree = get_entry(node_, pair_offsets(node_)[index_]);
+    return std::make_pair(entry_full_key(node_, entree, &key_buf_), entry_value(entree));
 }
 
 iterator &iterator::operator++() {
@@ -1724,7 +2339,7 @@ iterator &iterator::operator++() {
               "Trying to increment past the end of an iterator.");
     do {
         ++index_;
-    } while (index_ < node_->num_pairs && !entry_is_live(get_entry(node_, node_->pair_offsets[index_])));
+    } while (index_ < node_->num_pairs && !entry_is_live(get_entry(node_, pair_offsets(node_)[index_])));
     return *this;
 }
 
@@ -1732,7 +2347,7 @@ iterator &iterator::operator--() {
     guarantee(index_ > -1, "Trying to decrement past the beginning of an iterator.");
     do {
         --index_;
-    } while (index_ >= 0 && !entry_is_live(get_entry(node_, node_->pair_offsets[index_])));
+    } while (index_ >= 0 && !entry_is_live(get_entry(node_, pair_offsets(node_)[index_])));
     return *this;
 }
 
@@ -1795,7 +2410,7 @@ leaf::iterator inclusive_lower_bound(const btree_key_t *key, const leaf_node_t &
     int index;
     leaf::find_key(&leaf_node, key, &index);
     if (index == leaf_node.num_pairs ||
-        entry_is_live(leaf::get_entry(&leaf_node, leaf_node.pair_offsets[index]))) {
+        entry_is_live(leaf::get_entry(&leaf_node, pair_offsets(&leaf_node)[index]))) {
         return leaf_node_t::iterator(&leaf_node, index);
     } else {
         return ++leaf_node_t::iterator(&leaf_node, index);
@@ -1804,12 +2419,10 @@ leaf::iterator inclusive_lower_bound(const btree_key_t *key, const leaf_node_t &
 
 leaf::reverse_iterator exclusive_upper_bound(const btree_key_t *key, const leaf_node_t &leaf_node) {
     int index;
-    leaf::find_key(&leaf_node, key, &index);
+    bool found = leaf::find_key(&leaf_node, key, &index);
     if (index < leaf_node.num_pairs) {
-        const leaf::entry_t *entry = leaf::get_entry(&leaf_node, leaf_node.pair_offsets[index]);
-        const btree_key_t *ekey = leaf::entry_key(entry);
-        if (entry_is_live(entry) &&
-            btree_key_cmp(ekey, key) == 0) {
+        const leaf::entry_t *entry = leaf::get_entry(&leaf_node, pair_offsets(&leaf_node)[index]);
+        if (entry_is_live(entry) && found) {
             // We have to skip this entry to make the iterator exclusive,
             // hence the ++.
             return ++leaf_node_t::reverse_iterator(&leaf_node, index);
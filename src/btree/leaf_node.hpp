@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "arch/compiler.hpp"
+#include "btree/keys.hpp"
 #include "btree/types.hpp"
 #include "buffer_cache/types.hpp"
 #include "containers/optional.hpp"
@@ -40,7 +41,9 @@ ATTR_PACKED(struct leaf_node_t {
     // The first offset whose entry is not accompanied by a timestamp.
     uint16_t tstamp_cutpoint;
 
-    // The pair offsets.
+    // The pair offsets.  In a node with a key prefix, the prefix comes first
+    // and the pair offsets follow it, and in a node with search heads, the
+    // heads follow the pair offsets (see leaf_node.cc).
     uint16_t pair_offsets[];
 
     //Iteration
@@ -105,14 +108,21 @@ void validate(value_sizer_t *sizer, const leaf_node_t *node);
 
 void init(value_sizer_t *sizer, leaf_node_t *node);
 
+/* Returns true if `magic` is the magic of a leaf node for `sizer`, with or without
+a key prefix and search heads. */
+bool is_leaf_magic(value_sizer_t *sizer, block_magic_t magic);
+
 bool is_empty(const leaf_node_t *node);
 
 bool is_full(value_sizer_t *sizer, const leaf_node_t *node, const btree_key_t *key, const void *value);
 
 bool is_underfull(value_sizer_t *sizer, const leaf_node_t *node);
 
+// Moves the entries past the first `left_percent` percent of `node`'s mandatory cost
+// to `sibling`, but no fewer than it takes for `sibling` not to be underfull.
+// `left_percent` is between 50 and 100.
 void split(value_sizer_t *sizer, leaf_node_t *node, leaf_node_t *sibling,
-           btree_key_t *median_out);
+           btree_key_t *median_out, int left_percent);
 
 void merge(value_sizer_t *sizer, leaf_node_t *left, leaf_node_t *right);
 
@@ -124,6 +134,18 @@ bool level(value_sizer_t *sizer, int nodecmp_node_with_sib, leaf_node_t *node,
 
 bool is_mergable(value_sizer_t *sizer, const leaf_node_t *node, const leaf_node_t *sibling);
 
+/* Stores the prefix that every key in the range (`left_exclusive`,
+`right_inclusive`] has only once in the node, instead of in every entry, if that
+saves space.  The range must contain the node's key range; pass `store_key_t::min()`
+and `store_key_t::max()` for the ends of the tree.  Once a node has a prefix, it only
+gets shorter when the node is merged or leveled with a sibling. */
+void update_prefix(value_sizer_t *sizer, leaf_node_t *node,
+                   const btree_key_t *left_exclusive, const btree_key_t *right_inclusive);
+
+// Drops the node's search heads, so that lookups compare whole keys until a
+// modification of the node adds them back.
+void drop_search_heads(leaf_node_t *node);
+
 bool find_key(const leaf_node_t *node, const btree_key_t *key, int *index_out);
 
 bool lookup(value_sizer_t *sizer, const leaf_node_t *node, const btree_key_t *key, void *value_out);
@@ -167,7 +189,8 @@ void erase_deletions(
 
 /* Calls `cb` on every entry in the node, whether a real entry or a deletion. The calls
 will be in order from most recent to least recent. For entries with no timestamp, the
-callback will get `min_deletion_timestamp() - 1`. */
+callback will get `min_deletion_timestamp() - 1`. The key that `cb` gets is only valid
+during the call. */
 continue_bool_t visit_entries(
     value_sizer_t *sizer,
     const leaf_node_t *node,
@@ -183,6 +206,7 @@ class iterator {
 public:
     iterator();
     iterator(const leaf_node_t *node, int index);
+    // The key is only valid until the iterator is dereferenced again.
     std::pair<const btree_key_t *, const void *> operator*() const;
     iterator &operator++();
     iterator &operator--();
@@ -197,6 +221,8 @@ private:
     int cmp(const iterator &other) const;
     const leaf_node_t *node_;
     int index_;
+    // Holds the full key of a node with a key prefix.
+    mutable store_key_t key_buf_;
 };
 
 class reverse_iterator {
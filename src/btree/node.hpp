@@ -50,6 +50,9 @@ ATTR_PACKED(struct internal_node_t {
     uint16_t pair_offsets[0];
 
     static const block_magic_t expected_magic;
+    // The magic of an internal node that keeps search heads after its pair offsets
+    // (see btree/search_heads.hpp).
+    static const block_magic_t search_heads_magic;
 });
 
 // A node_t is either a btree_internal_node or a btree_leaf_node.
@@ -60,7 +63,8 @@ ATTR_PACKED(struct node_t {
 namespace node {
 
 inline bool is_internal(const node_t *node) {
-    if (node->magic == internal_node_t::expected_magic) {
+    if (node->magic == internal_node_t::expected_magic
+        || node->magic == internal_node_t::search_heads_magic) {
         return true;
     }
     return false;
@@ -77,7 +81,10 @@ bool is_mergable(value_sizer_t *sizer, const node_t *node, const node_t *sibling
 
 bool is_underfull(value_sizer_t *sizer, const node_t *node);
 
-void split(value_sizer_t *sizer, node_t *node, node_t *rnode, btree_key_t *median);
+// Moves about `100 - left_percent` percent of `node`'s contents to `rnode`, where
+// `left_percent` is between 50 and 100, but never leaves `rnode` underfull.
+void split(value_sizer_t *sizer, node_t *node, node_t *rnode, btree_key_t *median,
+           int left_percent);
 
 void merge(value_sizer_t *sizer, node_t *node, node_t *rnode, const internal_node_t *parent);
 
@@ -7,6 +7,7 @@
 #include "btree/leaf_node.hpp"
 #include "buffer_cache/alt.hpp"
 #include "buffer_cache/blob.hpp"
+#include "config/args.hpp"
 #include "containers/archive/vector_stream.hpp"
 #include "rdb_protocol/profile.hpp"
 #include "rdb_protocol/store.hpp"
@@ -63,6 +64,22 @@ void detach_all_children(const node_t *node, buf_parent_t parent,
     }
 }
 
+bool is_last_on_level(superblock_t *sb, buf_lock_t *buf, buf_lock_t *last_buf,
+                      const btree_key_t *key, const store_key_t &last_right_inclusive) {
+    // If merging made `buf` the root node, `last_buf` is the deleted old root.
+    if (last_buf->empty()
+        || (sb != nullptr && sb->get_root_block_id() == buf->block_id())) {
+        return true;
+    }
+    if (last_right_inclusive != store_key_max) {
+        return false;
+    }
+    buf_read_t read(last_buf);
+    const internal_node_t *parent
+        = static_cast<const internal_node_t *>(read.get_data_read());
+    return internal_node::get_offset_index(parent, key) == parent->npairs - 1;
+}
+
 // Split the node if necessary. If the node is a leaf_node, provide the new
 // value that will be inserted; if it's an internal node, provide NULL (we
 // split internal nodes proactively).
@@ -73,23 +90,43 @@ void check_and_handle_split(value_sizer_t *sizer,
                             buf_lock_t *last_buf,
                             superblock_t *sb,
                             const btree_key_t *key, void *new_value,
-                            const value_deleter_t *detacher) {
+                            const value_deleter_t *detacher,
+                            bool last_on_level) {
+    // The percentage of the node's contents that stays in `buf`.
+    int left_percent = 50;
     {
         buf_read_t buf_read(buf);
         const node_t *node = static_cast<const node_t *>(buf_read.get_data_read());
 
         // If the node isn't full, we don't need to split, so we're done.
+        bool key_goes_last;
         if (!node::is_internal(node)) { // This should only be called when update_needed.
             rassert(new_value);
-            if (!leaf::is_full(sizer, reinterpret_cast<const leaf_node_t *>(node),
-                               key, new_value)) {
+            const leaf_node_t *leaf_node = reinterpret_cast<const leaf_node_t *>(node);
+            if (!leaf::is_full(sizer, leaf_node, key, new_value)) {
                 return;
             }
+            int index;
+            key_goes_last = !leaf::find_key(leaf_node, key, &index)
+                && index == leaf_node->num_pairs;
         } else {
             rassert(!new_value);
-            if (!internal_node::is_full(reinterpret_cast<const internal_node_t *>(node))) {
+            const internal_node_t *internal
+                = reinterpret_cast<const internal_node_t *>(node);
+            if (!internal_node::is_full(internal)) {
                 return;
             }
+            key_goes_last
+                = internal_node::get_offset_index(internal, key) == internal->npairs - 1;
+        }
+
+        // Keys that get inserted in ascending order all go past the last key of
+        // the last node on each level.  Leave as much of the node in place as we
+        // can when such a key splits it, since no keys will come to fill it up
+        // again.  The new node still gets enough not to be underfull, so with 4KB
+        // blocks this leaves a bit over 60% of the node in place.
+        if (last_on_level && key_goes_last) {
+            left_percent = 100;
         }
     }
 
@@ -113,7 +150,7 @@ void check_and_handle_split(value_sizer_t *sizer,
         node::split(sizer,
                     static_cast<node_t *>(buf_write.get_data_write()),
                     static_cast<node_t *>(rbuf_write.get_data_write()),
-                    median);
+                    median, left_percent);
 
         // We must detach all entries that we have removed from `buf`.
         buf_read_t rbuf_read(&rbuf);
@@ -204,6 +241,7 @@ void check_and_handle_underfull(value_sizer_t *sizer,
         buf_lock_t sib_buf(last_buf, sib_node_id, access_t::write);
 
         bool node_is_mergable;
+        bool sib_is_underfull;
         {
             buf_read_t sib_buf_read(&sib_buf);
             const node_t *sib_node
@@ -212,6 +250,7 @@ void check_and_handle_underfull(value_sizer_t *sizer,
 #ifndef NDEBUG
             node::validate(sizer, sib_node);
 #endif
+            sib_is_underfull = node::is_underfull(sizer, sib_node);
 
             buf_read_t buf_read(buf);
             const node_t *const node
@@ -293,8 +332,10 @@ void check_and_handle_underfull(value_sizer_t *sizer,
                 last_buf->mark_deleted();
                 insert_root(buf->block_id(), sb);
             }
-        } else {
-            // Level.
+        } else if (!sib_is_underfull) {
+            // Level.  Two underfull leaf nodes can fail to be mergable, if the prefix
+            // they have in common is shorter than theirs, but then there's nothing to
+            // level either, and we leave them be.
             store_key_t replacement_key_buffer;
             btree_key_t *replacement_key = replacement_key_buffer.btree_key();
 
@@ -358,6 +399,52 @@ void check_and_handle_underfull(value_sizer_t *sizer,
     }
 }
 
+void get_node_bounds(superblock_t *sb, buf_lock_t *buf, buf_lock_t *last_buf,
+                     const btree_key_t *key,
+                     const store_key_t &last_left_exclusive,
+                     const store_key_t &last_right_inclusive,
+                     store_key_t *left_exclusive_out,
+                     store_key_t *right_inclusive_out) {
+    // If merging made `buf` the root node, `last_buf` is the deleted old root.
+    if (last_buf->empty()
+        || (sb != nullptr && sb->get_root_block_id() == buf->block_id())) {
+        *left_exclusive_out = store_key_t::min();
+        *right_inclusive_out = store_key_t::max();
+        return;
+    }
+    *left_exclusive_out = last_left_exclusive;
+    *right_inclusive_out = last_right_inclusive;
+    buf_read_t read(last_buf);
+    internal_node::narrow_to_child(
+        static_cast<const internal_node_t *>(read.get_data_read()), key,
+        left_exclusive_out, right_inclusive_out);
+}
+
+// Tells `batch` its limit once `find_keyvalue_location_for_write()` has found the leaf
+// node for `key`.
+void send_batch_limit(keyvalue_location_t *kv_location, const btree_key_t *key,
+                      keyvalue_location_batch_t *batch) {
+    store_key_t left_exclusive;
+    store_key_t right_inclusive;
+    get_node_bounds(kv_location->superblock, &kv_location->buf, &kv_location->last_buf,
+                    key, kv_location->last_buf_left_exclusive,
+                    kv_location->last_buf_right_inclusive,
+                    &left_exclusive, &right_inclusive);
+    if (kv_location->last_buf.empty()) {
+        // Splitting the root leaf node would give it a new parent that we'd have to
+        // acquire for the later writes.
+        batch->on_batch_limit(1, right_inclusive);
+        return;
+    }
+    // Each write splits, merges or levels the leaf node at most once, and the
+    // parent node mustn't get full before the last write.
+    buf_read_t read(&kv_location->last_buf);
+    batch->on_batch_limit(
+        1 + internal_node::insertions_until_full(
+            static_cast<const internal_node_t *>(read.get_data_read())),
+        right_inclusive);
+}
+
 /* Passing in a pass_back_superblock parameter will cause this function to
  * return the superblock after it's no longer needed (rather than releasing
  * it). Notice the superblock is not guaranteed to be returned until the
@@ -371,7 +458,8 @@ void find_keyvalue_location_for_write(
         const value_deleter_t *balancing_detacher,
         keyvalue_location_t *keyvalue_location_out,
         profile::trace_t *trace,
-        promise_t<superblock_t *> *pass_back_superblock) THROWS_NOTHING {
+        promise_t<superblock_t *> *pass_back_superblock,
+        keyvalue_location_batch_t *batch) THROWS_NOTHING {
     keyvalue_location_out->superblock = superblock;
     keyvalue_location_out->pass_back_superblock = pass_back_superblock;
 
@@ -379,6 +467,9 @@ void find_keyvalue_location_for_write(
 
     buf_lock_t last_buf;
     buf_lock_t buf;
+    // The bounds on the keys that can go in `last_buf`'s node.
+    store_key_t left_exclusive = store_key_t::min();
+    store_key_t right_inclusive = store_key_t::max();
     {
         // KSI: We can't acquire the block for write here -- we could, but it would
         // worsen the performance of the program -- sometimes we only end up using
@@ -388,6 +479,16 @@ void find_keyvalue_location_for_write(
         buf = get_root(sizer, superblock);
     }
 
+    // The height of `buf`'s node if the hint knows the root's, and how far we've come
+    // down from the root.  Splitting, merging and leveling keep the height of `buf`.
+    const block_id_t root_id = buf.block_id();
+    int height = -1;
+    if (batch != nullptr && batch->root_height_hint->root_id == root_id) {
+        height = batch->root_height_hint->height;
+    }
+    int depth = 0;
+    bool batch_limit_sent = false;
+
     // Walk down the tree to the leaf.
     for (;;) {
         {
@@ -396,13 +497,17 @@ void find_keyvalue_location_for_write(
                 break;
             }
         }
+        guarantee(height != 0, "The root height hint is wrong.");
+
         // Check if the node is overfull and proactively split it if it is (since this is
         // an internal node).
         {
             PROFILE_STARTER_IF_ENABLED(
                 trace != nullptr, "Perhaps split node.", trace);
             check_and_handle_split(
-                sizer, &buf, &last_buf, superblock, key, nullptr, balancing_detacher);
+                sizer, &buf, &last_buf, superblock, key, nullptr, balancing_detacher,
+                is_last_on_level(keyvalue_location_out->superblock, &buf, &last_buf,
+                                 key, right_inclusive));
         }
 
         // Check if the node is underfull, and merge/level if it is.
@@ -413,6 +518,18 @@ void find_keyvalue_location_for_write(
                 sizer, &buf, &last_buf, superblock, key, balancing_detacher);
         }
 
+        // Splitting, merging and leveling change the nodes' key ranges, so we
+        // only narrow the bounds down to `buf`'s node now.
+        {
+            store_key_t node_left_exclusive;
+            store_key_t node_right_inclusive;
+            get_node_bounds(keyvalue_location_out->superblock, &buf, &last_buf, key,
+                            left_exclusive, right_inclusive,
+                            &node_left_exclusive, &node_right_inclusive);
+            left_exclusive = node_left_exclusive;
+            right_inclusive = node_right_inclusive;
+        }
+
         // Release the superblock, if we've gone past the root (and haven't
         // already released it). If we're still at the root or at one of
         // its direct children, we might still want to replace the root, so
@@ -440,13 +557,34 @@ void find_keyvalue_location_for_write(
 
         // Look up and acquire the next node.
         block_id_t node_id;
+        size_t batch_limit = 0;
+        store_key_t leaf_right_inclusive;
         {
             buf_read_t read(&buf);
             auto node = static_cast<const internal_node_t *>(read.get_data_read());
             node_id = internal_node::lookup(node, key);
+            if (batch != nullptr && height == 1) {
+                store_key_t leaf_left_exclusive = left_exclusive;
+                leaf_right_inclusive = right_inclusive;
+                internal_node::narrow_to_child(node, key, &leaf_left_exclusive,
+                                               &leaf_right_inclusive);
+                batch_limit = 1 + internal_node::insertions_until_full(node);
+            }
         }
         rassert(node_id != NULL_BLOCK_ID && node_id != SUPERBLOCK_ID);
 
+        // The next node is the leaf node, so the batch's limit only depends on this
+        // one (see `send_batch_limit()`).  The caller doesn't have to wait for the
+        // leaf node to be read.
+        if (batch_limit != 0) {
+            batch->on_batch_limit(batch_limit, leaf_right_inclusive);
+            batch_limit_sent = true;
+        }
+        if (height > 0) {
+            --height;
+        }
+        ++depth;
+
         {
             PROFILE_STARTER_IF_ENABLED(
                 trace != nullptr, "Acquire a block for write.", trace);
@@ -462,6 +600,7 @@ void find_keyvalue_location_for_write(
         // We've gone down the tree and gotten to a leaf. Now look up the key.
         buf_read_t read(&buf);
         auto node = static_cast<const leaf_node_t *>(read.get_data_read());
+        guarantee(height <= 0, "The root height hint is wrong.");
         bool key_found = leaf::lookup(sizer, node, key, tmp.get());
 
         if (key_found) {
@@ -471,7 +610,57 @@ void find_keyvalue_location_for_write(
     }
 
     keyvalue_location_out->last_buf.swap(last_buf);
+    keyvalue_location_out->last_buf_left_exclusive = left_exclusive;
+    keyvalue_location_out->last_buf_right_inclusive = right_inclusive;
     keyvalue_location_out->buf.swap(buf);
+
+    if (batch != nullptr) {
+        batch->root_height_hint->root_id = root_id;
+        batch->root_height_hint->height = depth;
+        if (!batch_limit_sent) {
+            send_batch_limit(keyvalue_location_out, key, batch);
+        }
+    }
+}
+
+void move_keyvalue_location_for_write(value_sizer_t *sizer,
+                                      const btree_key_t *key,
+                                      keyvalue_location_t *kv_location) {
+    // If merging made the leaf node the root node, `last_buf` is the deleted old
+    // root, and a split would have to create a new one.
+    if (!kv_location->last_buf.empty()
+        && kv_location->superblock != nullptr
+        && kv_location->superblock->get_root_block_id()
+           == kv_location->buf.block_id()) {
+        kv_location->last_buf.reset_buf_lock();
+        kv_location->last_buf_left_exclusive = store_key_t::min();
+        kv_location->last_buf_right_inclusive = store_key_t::max();
+    }
+    rassert(btree_key_cmp(key, kv_location->last_buf_right_inclusive.btree_key()) <= 0);
+
+    if (!kv_location->last_buf.empty()) {
+        block_id_t node_id;
+        {
+            buf_read_t read(&kv_location->last_buf);
+            auto node = static_cast<const internal_node_t *>(read.get_data_read());
+            node_id = internal_node::lookup(node, key);
+        }
+        if (node_id != kv_location->buf.block_id()) {
+            kv_location->buf.reset_buf_lock();
+            kv_location->buf
+                = buf_lock_t(&kv_location->last_buf, node_id, access_t::write);
+        }
+    }
+
+    kv_location->there_originally_was_value = false;
+    kv_location->value.reset();
+    scoped_malloc_t<void> tmp(sizer->max_possible_size());
+    buf_read_t read(&kv_location->buf);
+    auto node = static_cast<const leaf_node_t *>(read.get_data_read());
+    if (leaf::lookup(sizer, node, key, tmp.get())) {
+        kv_location->there_originally_was_value = true;
+        kv_location->value = std::move(tmp);
+    }
 }
 
 void find_keyvalue_location_for_read(
@@ -553,6 +742,46 @@ void find_keyvalue_location_for_read(
     }
 }
 
+// Deeper than any tree we build.  Stops traversals of published pages that don't
+// belong to the same version of the tree (which `validate()` rejects later) from
+// going around in circles.
+const int MAX_PUBLISHED_LOOKUP_DEPTH = 64;
+
+published_lookup_result_t find_keyvalue_in_published_pages(
+        value_sizer_t *sizer,
+        const alt::published_pages_t::reader_t &reader,
+        block_id_t root_id,
+        const btree_key_t *key,
+        void *value_out) {
+    if (root_id == NULL_BLOCK_ID) {
+        return published_lookup_result_t::not_found;
+    }
+    block_id_t node_id = root_id;
+    for (int depth = 0; depth < MAX_PUBLISHED_LOOKUP_DEPTH; ++depth) {
+        block_size_t block_size = block_size_t::undefined();
+        const void *data = reader.find(node_id, &block_size);
+        if (data == nullptr || block_size.value() != sizer->block_size().value()) {
+            return published_lookup_result_t::unavailable;
+        }
+        const node_t *node = static_cast<const node_t *>(data);
+        if (node::is_internal(node)) {
+            node_id = internal_node::lookup(static_cast<const internal_node_t *>(data),
+                                            key);
+            if (node_id == NULL_BLOCK_ID || node_id == SUPERBLOCK_ID) {
+                return published_lookup_result_t::unavailable;
+            }
+        } else if (leaf::is_leaf_magic(sizer, node->magic)) {
+            return leaf::lookup(sizer, static_cast<const leaf_node_t *>(data), key,
+                                value_out)
+                ? published_lookup_result_t::found
+                : published_lookup_result_t::not_found;
+        } else {
+            return published_lookup_result_t::unavailable;
+        }
+    }
+    return published_lookup_result_t::unavailable;
+}
+
 void apply_keyvalue_change(
         value_sizer_t *sizer,
         keyvalue_location_t *kv_loc,
@@ -566,13 +795,32 @@ void apply_keyvalue_change(
     if (kv_loc->value.has()) {
         // We have a value to insert.
 
+        // Store the prefix that all keys in the leaf have only once, if that
+        // saves space.  We do this before we check for a split, since it can
+        // make room for the value.
+        {
+            store_key_t left_exclusive;
+            store_key_t right_inclusive;
+            get_node_bounds(kv_loc->superblock, &kv_loc->buf, &kv_loc->last_buf, key,
+                            kv_loc->last_buf_left_exclusive,
+                            kv_loc->last_buf_right_inclusive,
+                            &left_exclusive, &right_inclusive);
+            buf_write_t write(&kv_loc->buf);
+            leaf::update_prefix(sizer,
+                                static_cast<leaf_node_t *>(write.get_data_write()),
+                                left_exclusive.btree_key(), right_inclusive.btree_key());
+        }
+
         // Split the node if necessary, to make sure that we have room
         // for the value.  Not necessary when deleting, because the
         // node won't grow.
 
         check_and_handle_split(sizer, &kv_loc->buf, &kv_loc->last_buf,
                                kv_loc->superblock, key, kv_loc->value.get(),
-                               balancing_detacher);
+                               balancing_detacher,
+                               is_last_on_level(kv_loc->superblock, &kv_loc->buf,
+                                                &kv_loc->last_buf, key,
+                                                kv_loc->last_buf_right_inclusive));
 
         {
 #ifndef NDEBUG
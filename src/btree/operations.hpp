@@ -62,6 +62,8 @@ class keyvalue_location_t {
 public:
     keyvalue_location_t()
         : superblock(nullptr), pass_back_superblock(nullptr),
+          last_buf_left_exclusive(store_key_t::min()),
+          last_buf_right_inclusive(store_key_t::max()),
           there_originally_was_value(false), stat_block(NULL_BLOCK_ID) { }
 
     ~keyvalue_location_t() {
@@ -81,6 +83,11 @@ public:
     // The parent buf of buf, if buf is not the root node.  This is hacky.
     buf_lock_t last_buf;
 
+    // Bounds on the keys that can go in last_buf's node, which give the key prefix
+    // of the leaf node.  If buf is the root node, they are the ends of the tree.
+    store_key_t last_buf_left_exclusive;
+    store_key_t last_buf_right_inclusive;
+
     // The buf owning the leaf node which contains the value.
     buf_lock_t buf;
 
@@ -102,12 +109,29 @@ private:
 
 buf_lock_t get_root(value_sizer_t *sizer, superblock_t *sb);
 
+/* Returns true if `buf`'s node, which `key` goes in, is the last node on its level of
+the tree.  `last_right_inclusive` is the upper bound on the keys that can go in
+`last_buf`'s node. */
+bool is_last_on_level(superblock_t *sb, buf_lock_t *buf, buf_lock_t *last_buf,
+                      const btree_key_t *key, const store_key_t &last_right_inclusive);
+
+/* Finds bounds on the keys that can go in `buf`'s node, which `key` goes in, from the
+bounds on the keys that can go in `last_buf`'s node. */
+void get_node_bounds(superblock_t *sb, buf_lock_t *buf, buf_lock_t *last_buf,
+                     const btree_key_t *key,
+                     const store_key_t &last_left_exclusive,
+                     const store_key_t &last_right_inclusive,
+                     store_key_t *left_exclusive_out,
+                     store_key_t *right_inclusive_out);
+
+/* `last_on_level` must be what `is_last_on_level()` returns for `buf`. */
 void check_and_handle_split(value_sizer_t *sizer,
                             buf_lock_t *buf,
                             buf_lock_t *last_buf,
                             superblock_t *sb,
                             const btree_key_t *key, void *new_value,
-                            const value_deleter_t *detacher);
+                            const value_deleter_t *detacher,
+                            bool last_on_level);
 
 void check_and_handle_underfull(value_sizer_t *sizer,
                                 buf_lock_t *buf,
@@ -123,6 +147,37 @@ void insert_root(block_id_t root_id, superblock_t *sb);
 `get_stat_block_id()`. */
 block_id_t create_stat_block(buf_parent_t parent);
 
+/* The height of a root node that a walk down the tree went through, for the later
+walks in the same transaction.  Nodes never change their height, and the ids of
+deleted blocks don't get reused before the transaction is done, so this stays true
+after the tree gets a new root. */
+struct root_height_hint_t {
+    root_height_hint_t() : root_id(NULL_BLOCK_ID), height(0) { }
+    block_id_t root_id;
+    int height;
+};
+
+/* Lets the caller of `find_keyvalue_location_for_write()` make more writes, one after
+another, to keys in the leaf node it finds, by moving the `keyvalue_location_t` between
+them with `move_keyvalue_location_for_write()`, which doesn't walk down the tree
+again. */
+class keyvalue_location_batch_t {
+public:
+    explicit keyvalue_location_batch_t(root_height_hint_t *_root_height_hint)
+        : root_height_hint(_root_height_hint) { }
+
+    /* Gets called once with how many writes, counting the first one, can be made to
+    the leaf node, and with the largest key that goes in it.  If the hint tells that
+    the next node is the leaf node, this happens before the leaf node gets acquired,
+    so that another walk down the tree can start while the leaf node gets read. */
+    virtual void on_batch_limit(size_t limit, const store_key_t &right_inclusive) = 0;
+
+    root_height_hint_t *const root_height_hint;
+
+protected:
+    virtual ~keyvalue_location_batch_t() { }
+};
+
 /* Note that there's no guarantee that `pass_back_superblock` will have been
  * pulsed by the time `find_keyvalue_location_for_write` returns. In some cases,
  * the superblock is returned only when `*keyvalue_location_out` gets destructed. */
@@ -134,7 +189,17 @@ void find_keyvalue_location_for_write(
         const value_deleter_t *balancing_detacher,
         keyvalue_location_t *keyvalue_location_out,
         profile::trace_t *trace,
-        promise_t<superblock_t *> *pass_back_superblock = nullptr) THROWS_NOTHING;
+        promise_t<superblock_t *> *pass_back_superblock = nullptr,
+        keyvalue_location_batch_t *batch = nullptr) THROWS_NOTHING;
+
+/* Moves `kv_location` to `key`, which mustn't be less than the keys it was found or
+moved for before, and must be counted in the limit that their
+`keyvalue_location_batch_t` got.  The
+leaf node may have been split, merged or leveled by the writes since, so `key` can go
+in a sibling of it now. */
+void move_keyvalue_location_for_write(value_sizer_t *sizer,
+                                      const btree_key_t *key,
+                                      keyvalue_location_t *kv_location);
 
 void find_keyvalue_location_for_read(
         value_sizer_t *sizer,
@@ -144,6 +209,21 @@ void find_keyvalue_location_for_read(
         btree_stats_t *stats,
         profile::trace_t *trace);
 
+enum class published_lookup_result_t { found, not_found, unavailable };
+
+/* Looks the key up in the pages that the cache published for lock-free reads (see
+`alt::published_pages_t`), starting at the root block `root_id`, without acquiring any
+blocks.  Returns `unavailable` if one of the nodes on the way isn't published.  The
+value gets copied to `value_out`, which must have room for
+`sizer->max_possible_size()` bytes.  The caller must check `reader.validate()` before
+it trusts the result. */
+published_lookup_result_t find_keyvalue_in_published_pages(
+        value_sizer_t *sizer,
+        const alt::published_pages_t::reader_t &reader,
+        block_id_t root_id,
+        const btree_key_t *key,
+        void *value_out);
+
 /* `delete_mode_t` controls how `apply_keyvalue_change()` acts when `kv_loc->value` is
 empty. */
 enum class delete_mode_t {
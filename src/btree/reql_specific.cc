@@ -95,6 +95,22 @@ block_id_t real_superblock_t::get_sindex_block_id() {
     return sb_data->sindex_block;
 }
 
+bool get_published_root_block_id(
+        const alt::published_pages_t::reader_t &reader,
+        block_id_t *root_id_out) {
+    block_size_t sb_size = block_size_t::undefined();
+    const reql_btree_superblock_t *sb_data = static_cast<const reql_btree_superblock_t *>(
+        reader.find(SUPERBLOCK_ID, &sb_size));
+    if (sb_data == nullptr
+        || sb_size.value() != REQL_BTREE_SUPERBLOCK_SIZE
+        || sb_data->magic
+           != reql_btree_version_magic_t<cluster_version_t::v2_1>::value) {
+        return false;
+    }
+    *root_id_out = sb_data->root_block;
+    return true;
+}
+
 sindex_superblock_t::sindex_superblock_t(buf_lock_t &&sb_buf)
     : sb_buf_(std::move(sb_buf)) {}
 
@@ -173,7 +189,8 @@ btree_slice_t::btree_slice_t(cache_t *c, perfmon_collection_t *parent,
     : stats(parent,
             (index_type == index_type_t::SECONDARY ? "index-" : "") + identifier),
       cache_(c),
-      backfill_account_(cache()->create_cache_account(BACKFILL_CACHE_PRIORITY)) { }
+      backfill_account_(cache()->create_cache_account(BACKFILL_CACHE_PRIORITY,
+                                                      io_class_t::backfill)) { }
 
 btree_slice_t::~btree_slice_t() { }
 
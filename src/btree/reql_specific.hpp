@@ -157,6 +157,12 @@ private:
 
 
 // Metainfo functions
+/* Finds the primary B-tree's root block id in the published copy of the superblock (see
+`alt::published_pages_t`).  Returns false if the superblock isn't published. */
+bool get_published_root_block_id(
+        const alt::published_pages_t::reader_t &reader,
+        block_id_t *root_id_out);
+
 void get_superblock_metainfo(
     real_superblock_t *superblock,
     std::vector< std::pair<std::vector<char>, std::vector<char> > > *kv_pairs_out,
@@ -0,0 +1,223 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "btree/search_heads.hpp"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "errors.hpp"
+#include "math.hpp"
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(_WIN32)
+#define SEARCH_HEADS_HAS_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define SEARCH_HEADS_HAS_X86_SIMD 0
+#endif
+
+// Once a binary search has narrowed the range down to this many heads, we compare
+// `head` with all of them at once.
+const int SEARCH_HEADS_SCAN_WIDTH = 32;
+
+uint64_t search_head(const uint8_t *contents, int size) {
+    uint64_t head = 0;
+    for (int i = 0; i < static_cast<int>(sizeof(uint64_t)); ++i) {
+        head = (head << 8) | (i < size ? contents[i] : 0);
+    }
+    return head;
+}
+
+int search_heads_begin(int pair_offsets_end) {
+    return ceil_aligned(pair_offsets_end, SEARCH_HEADS_ALIGNMENT);
+}
+
+bool search_heads_fit(int pair_offsets_end, int count, int frontmost) {
+    return search_heads_begin(pair_offsets_end)
+        + count * static_cast<int>(sizeof(uint64_t)) <= frontmost;
+}
+
+void open_search_head_gap(char *node, int old_begin, int new_begin, int count,
+                          int index) {
+    rassert(0 <= index && index <= count);
+    rassert(old_begin <= new_begin);
+    // The heads are moving up, so the ones after the gap go first.
+    memmove(node + new_begin + (index + 1) * sizeof(uint64_t),
+            node + old_begin + index * sizeof(uint64_t),
+            (count - index) * sizeof(uint64_t));
+    memmove(node + new_begin, node + old_begin, index * sizeof(uint64_t));
+}
+
+void close_search_head_gap(char *node, int old_begin, int new_begin, int count,
+                           int beg, int end) {
+    rassert(0 <= beg && beg <= end && end <= count);
+    rassert(new_begin <= old_begin);
+    // The heads are moving down, so the ones before the gap go first.
+    memmove(node + new_begin, node + old_begin, beg * sizeof(uint64_t));
+    memmove(node + new_begin + beg * sizeof(uint64_t),
+            node + old_begin + end * sizeof(uint64_t),
+            (count - end) * sizeof(uint64_t));
+}
+
+// Counts the heads that are less than `head` and the heads that are less than or
+// equal to it.
+typedef void (*count_heads_fun_t)(const uint64_t *heads, int count, uint64_t head,
+                                  int *less_out, int *less_equal_out);
+
+void count_heads_scalar(const uint64_t *heads, int count, uint64_t head,
+                        int *less_out, int *less_equal_out) {
+    int less = 0;
+    int less_equal = 0;
+    for (int i = 0; i < count; ++i) {
+        less += heads[i] < head;
+        less_equal += heads[i] <= head;
+    }
+    *less_out = less;
+    *less_equal_out = less_equal;
+}
+
+#if SEARCH_HEADS_HAS_X86_SIMD
+
+// There are only signed 64-bit comparisons, so we flip the sign bits of both sides.
+const uint64_t SEARCH_HEADS_SIGN_BIT = 0x8000000000000000ull;
+
+__attribute__((target("sse4.2")))
+void count_heads_sse42(const uint64_t *heads, int count, uint64_t head,
+                       int *less_out, int *less_equal_out) {
+    const __m128i bias
+        = _mm_set1_epi64x(static_cast<int64_t>(SEARCH_HEADS_SIGN_BIT));
+    const __m128i h
+        = _mm_xor_si128(_mm_set1_epi64x(static_cast<int64_t>(head)), bias);
+    int less = 0;
+    int greater = 0;
+    int i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const __m128i v = _mm_xor_si128(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(heads + i)), bias);
+        less += __builtin_popcount(
+            _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(h, v))));
+        greater += __builtin_popcount(
+            _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(v, h))));
+    }
+    for (; i < count; ++i) {
+        less += heads[i] < head;
+        greater += heads[i] > head;
+    }
+    *less_out = less;
+    *less_equal_out = count - greater;
+}
+
+__attribute__((target("avx2")))
+void count_heads_avx2(const uint64_t *heads, int count, uint64_t head,
+                      int *less_out, int *less_equal_out) {
+    const __m256i bias
+        = _mm256_set1_epi64x(static_cast<int64_t>(SEARCH_HEADS_SIGN_BIT));
+    const __m256i h
+        = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<int64_t>(head)), bias);
+    int less = 0;
+    int greater = 0;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m256i v = _mm256_xor_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(heads + i)), bias);
+        less += __builtin_popcount(
+            _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(h, v))));
+        greater += __builtin_popcount(
+            _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(v, h))));
+    }
+    for (; i < count; ++i) {
+        less += heads[i] < head;
+        greater += heads[i] > head;
+    }
+    *less_out = less;
+    *less_equal_out = count - greater;
+}
+
+#endif  // SEARCH_HEADS_HAS_X86_SIMD
+
+bool search_heads_impl_supported(search_heads_impl_t impl) {
+    switch (impl) {
+    case search_heads_impl_t::scalar:
+        return true;
+#if SEARCH_HEADS_HAS_X86_SIMD
+    case search_heads_impl_t::sse42:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.2");
+    case search_heads_impl_t::avx2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#else
+    case search_heads_impl_t::sse42:
+    case search_heads_impl_t::avx2:
+        return false;
+#endif
+    default:
+        unreachable();
+    }
+}
+
+count_heads_fun_t get_count_heads_fun(search_heads_impl_t impl) {
+    guarantee(search_heads_impl_supported(impl));
+    switch (impl) {
+    case search_heads_impl_t::scalar:
+        return &count_heads_scalar;
+#if SEARCH_HEADS_HAS_X86_SIMD
+    case search_heads_impl_t::sse42:
+        return &count_heads_sse42;
+    case search_heads_impl_t::avx2:
+        return &count_heads_avx2;
+#else
+    case search_heads_impl_t::sse42:
+    case search_heads_impl_t::avx2:
+#endif
+    default:
+        unreachable();
+    }
+}
+
+count_heads_fun_t choose_count_heads_fun() {
+    if (search_heads_impl_supported(search_heads_impl_t::avx2)) {
+        return get_count_heads_fun(search_heads_impl_t::avx2);
+    } else if (search_heads_impl_supported(search_heads_impl_t::sse42)) {
+        return get_count_heads_fun(search_heads_impl_t::sse42);
+    } else {
+        return get_count_heads_fun(search_heads_impl_t::scalar);
+    }
+}
+
+void find_search_head_range_with_fun(count_heads_fun_t fun,
+                                     const uint64_t *heads, int count, uint64_t head,
+                                     int *begin_out, int *end_out) {
+    // Every head before lo is less than `head`, every head from hi on is greater.
+    int lo = 0;
+    int hi = count;
+    while (hi - lo > SEARCH_HEADS_SCAN_WIDTH) {
+        const int mid = lo + (hi - lo) / 2;
+        if (heads[mid] < head) {
+            lo = mid + 1;
+        } else if (heads[mid] > head) {
+            hi = mid;
+        } else {
+            *begin_out = std::lower_bound(heads + lo, heads + mid, head) - heads;
+            *end_out = std::upper_bound(heads + mid + 1, heads + hi, head) - heads;
+            return;
+        }
+    }
+    int less;
+    int less_equal;
+    fun(heads + lo, hi - lo, head, &less, &less_equal);
+    *begin_out = lo + less;
+    *end_out = lo + less_equal;
+}
+
+void find_search_head_range(const uint64_t *heads, int count, uint64_t head,
+                            int *begin_out, int *end_out) {
+    static const count_heads_fun_t fun = choose_count_heads_fun();
+    find_search_head_range_with_fun(fun, heads, count, head, begin_out, end_out);
+}
+
+void find_search_head_range_with_impl(search_heads_impl_t impl,
+                                      const uint64_t *heads, int count, uint64_t head,
+                                      int *begin_out, int *end_out) {
+    find_search_head_range_with_fun(get_count_heads_fun(impl), heads, count, head,
+                                    begin_out, end_out);
+}
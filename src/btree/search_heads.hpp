@@ -0,0 +1,67 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef BTREE_SEARCH_HEADS_HPP_
+#define BTREE_SEARCH_HEADS_HPP_
+
+#include <stdint.h>
+
+// Internal and leaf nodes may keep a "search head" of each of their keys in an array
+// right after their pair offsets.  The head of a key is its first eight bytes,
+// padded with zeros, read as a big-endian number, so that heads compare like the keys
+// do, except that different keys can have equal heads.  A search then only has to
+// look at the keys themselves for the few entries whose head is equal to the head of
+// the key it is looking for, instead of at one key in a different part of the node
+// for every step of a binary search.
+//
+// The heads are derived from the keys.  A node only has them if there is room for
+// them between the pair offsets and the pairs.  Inserting or removing a few pairs
+// shifts the heads along with the pair offsets; modifications that move most of a
+// node's pairs rebuild them.
+
+// The heads array starts at the first multiple of this after the pair offsets.
+const int SEARCH_HEADS_ALIGNMENT = sizeof(uint64_t);
+
+// Returns the head of the key with the given contents.
+uint64_t search_head(const uint8_t *contents, int size);
+
+// Returns the offset at which the heads array starts, if the pair offsets end at
+// `pair_offsets_end`.
+int search_heads_begin(int pair_offsets_end);
+
+// Returns true if the heads of `count` keys fit between the end of the pair offsets
+// and `frontmost`.
+bool search_heads_fit(int pair_offsets_end, int count, int frontmost);
+
+// Moves the `count` heads that start `old_begin` bytes into `node` so that they
+// start at `new_begin` instead, leaving a gap for a new head at `index`.  The gap
+// must fit below the node's pairs, and `new_begin` must not be less than
+// `old_begin`.
+void open_search_head_gap(char *node, int old_begin, int new_begin, int count,
+                          int index);
+
+// Moves the `count` heads that start `old_begin` bytes into `node` so that they
+// start at `new_begin` instead, dropping the heads in `[beg, end)`.  `new_begin`
+// must not be greater than `old_begin`.
+void close_search_head_gap(char *node, int old_begin, int new_begin, int count,
+                           int beg, int end);
+
+// Sets `[*begin_out, *end_out)` to the range of the sorted array `heads` whose heads
+// are equal to `head`.  Every key before that range is less than a key with head
+// `head`, and every key after it is greater.
+void find_search_head_range(const uint64_t *heads, int count, uint64_t head,
+                            int *begin_out, int *end_out);
+
+// The implementations of `find_search_head_range` that we can choose from.  They all
+// produce identical results; `find_search_head_range` picks the fastest one the CPU
+// supports the first time it's called.
+enum class search_heads_impl_t { scalar, sse42, avx2 };
+
+// Returns true if `impl` can be used on this machine.
+bool search_heads_impl_supported(search_heads_impl_t impl);
+
+// Like `find_search_head_range`, but uses the given implementation, which must be
+// supported.  This is for testing and benchmarking.
+void find_search_head_range_with_impl(search_heads_impl_t impl,
+                                      const uint64_t *heads, int count, uint64_t head,
+                                      int *begin_out, int *end_out);
+
+#endif  // BTREE_SEARCH_HEADS_HPP_
@@ -141,8 +141,12 @@ void cache_t::configure_flush_interval(flush_interval_t interval) {
         clamp_ring_length(which_cpu_shard_, interval.millis));
 }
 
-cache_account_t cache_t::create_cache_account(int priority) {
-    return page_cache_.create_cache_account(priority);
+void cache_t::configure_quota(cache_quota_t quota) {
+    page_cache_.evicter().set_quota(quota);
+}
+
+cache_account_t cache_t::create_cache_account(int priority, io_class_t io_class) {
+    return page_cache_.create_cache_account(priority, io_class);
 }
 
 alt_snapshot_node_t *
@@ -834,8 +838,20 @@ const void *buf_read_t::get_data_read(uint16_t *block_size_out) {
                        lock_->txn()->account());
     }
     page_acq_.buf_ready_signal()->wait();
-    *block_size_out = page_acq_.get_buf_size().value();
-    return page_acq_.get_buf_read();
+    const block_size_t block_size = page_acq_.get_buf_size();
+    const void *data = page_acq_.get_buf_read();
+    lock_->current_page_acq()->maybe_publish(data, block_size);
+    *block_size_out = block_size.value();
+    return data;
+}
+
+void buf_read_t::start_loading() {
+    guarantee(lock_->read_acq_signal()->is_pulsed());
+    page_t *page = lock_->get_held_page_for_read();
+    if (!page_acq_.has()) {
+        page_acq_.init(page, &lock_->cache()->page_cache_,
+                       lock_->txn()->account());
+    }
 }
 
 buf_write_t::buf_write_t(buf_lock_t *lock)
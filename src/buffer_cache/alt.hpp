@@ -55,15 +55,26 @@ public:
     // throttling systems.  TODO: Come up with a consistent priority scheme,
     // i.e. define a "default" priority etc.  TODO: As soon as we can support it, we
     // might consider supporting a mem_cap parameter.
-    cache_account_t create_cache_account(int priority);
+    cache_account_t create_cache_account(int priority, io_class_t io_class);
 
     void configure_flush_interval(flush_interval_t interval);
 
+    // The cache balancer takes the new quota into account the next time it
+    // rebalances.
+    void configure_quota(cache_quota_t quota);
+
+    // Copies of pages that other threads can read without switching to the cache's
+    // thread.  Can be used on any thread.
+    alt::published_pages_t *published_pages() {
+        return &page_cache_.evicter().published_pages();
+    }
+
 private:
     friend class txn_t;
     friend class buf_read_t;
     friend class buf_write_t;
     friend class buf_lock_t;
+    friend class cache_warm_up_t;
 
     alt_snapshot_node_t *matching_snapshot_node_or_null(
             block_id_t block_id,
@@ -333,6 +344,10 @@ public:
         return data;
     }
 
+    // Starts loading the block into memory without waiting for it, so that a later
+    // get_data_read() returns sooner.  The lock must already be read-acquired.
+    void start_loading();
+
 private:
     buf_lock_t *lock_;
     alt::page_acq_t page_acq_;
@@ -240,6 +240,33 @@ int64_t max_end_offset(max_block_size_t block_size, int levels, int maxreflen) {
     }
 }
 
+bool copy_value_from_blocks(
+        max_block_size_t block_size, const char *ref, int maxreflen,
+        const std::function<const void *(block_id_t)> &get_block,
+        std::string *data_out) {
+    const int64_t size = value_size(ref, maxreflen);
+    if (is_small(ref, maxreflen)) {
+        data_out->assign(ref + big_size_offset(maxreflen), size);
+        return true;
+    }
+    if (ref_info(block_size, ref, maxreflen).levels != 1) {
+        return false;
+    }
+    const int64_t step = leaf_size(block_size);
+    const block_id_t *ids = block_ids(ref, maxreflen);
+    data_out->clear();
+    data_out->reserve(size);
+    for (int64_t i = 0; i * step < size; ++i) {
+        const void *leaf = get_block(ids[i]);
+        if (leaf == nullptr
+            || *static_cast<const block_magic_t *>(leaf) != leaf_node_magic) {
+            return false;
+        }
+        data_out->append(leaf_node_data(leaf), std::min(step, size - i * step));
+    }
+    return true;
+}
+
 int64_t clamp(int64_t x, int64_t lo, int64_t hi) {
     return x < lo ? lo : x > hi ? hi : x;
 }
@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include <functional>
 #include <string>
 #include <vector>
 #include <utility>
@@ -140,6 +141,15 @@ const block_id_t *block_ids(const char *ref, int maxreflen);
 // Returns the char bytes of a leaf node.
 const char *leaf_node_data(const void *buf);
 
+// Copies the blob's value to `data_out` without acquiring its blocks, taking the
+// contents of each block from `get_block` instead (which returns null if it doesn't
+// have the block).  Only handles blobs that are inline or have one level of leaf
+// blocks.  Returns false if the blob is bigger than that or a block is missing.
+bool copy_value_from_blocks(
+    max_block_size_t block_size, const char *ref, int maxreflen,
+    const std::function<const void *(block_id_t)> &get_block,
+    std::string *data_out);
+
 }  // namespace blob
 
 class blob_t {
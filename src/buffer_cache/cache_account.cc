@@ -3,18 +3,21 @@
 #include "arch/types.hpp"
 
 cache_account_t::cache_account_t()
-    : thread_(-1), io_account_(nullptr) { }
+    : thread_(-1), io_account_(nullptr), io_class_(io_class_t::foreground) { }
 
 cache_account_t::cache_account_t(cache_account_t &&movee)
-    : thread_(movee.thread_), io_account_(movee.io_account_) {
+    : thread_(movee.thread_), io_account_(movee.io_account_),
+      io_class_(movee.io_class_) {
     movee.thread_ = threadnum_t(-1);
     movee.io_account_ = nullptr;
+    movee.io_class_ = io_class_t::foreground;
 }
 
 cache_account_t &cache_account_t::operator=(cache_account_t &&movee) {
     cache_account_t tmp(std::move(movee));
     std::swap(thread_, tmp.thread_);
     std::swap(io_account_, tmp.io_account_);
+    std::swap(io_class_, tmp.io_class_);
     return *this;
 }
 
@@ -26,8 +29,9 @@ void cache_account_t::init(threadnum_t thread, file_account_t *io_account) {
 }
 
 
-cache_account_t::cache_account_t(threadnum_t thread, file_account_t *io_account)
-    : thread_(thread), io_account_(io_account) {
+cache_account_t::cache_account_t(threadnum_t thread, file_account_t *io_account,
+                                 io_class_t io_class)
+    : thread_(thread), io_account_(io_account), io_class_(io_class) {
     rassert(io_account != nullptr);
 }
 
@@ -1,6 +1,7 @@
 #ifndef BUFFER_CACHE_CACHE_ACCOUNT_HPP_
 #define BUFFER_CACHE_CACHE_ACCOUNT_HPP_
 
+#include "arch/types.hpp"
 #include "threading.hpp"
 
 class file_account_t;
@@ -19,17 +20,26 @@ public:
     file_account_t *get() const {
         return io_account_;
     }
+
+    // Pages that get loaded on behalf of a background account (backfills, sindex
+    // post-construction) never get promoted out of the eviction policy's probation
+    // segment, so they don't push the working set out of the cache.
+    io_class_t io_class() const {
+        return io_class_;
+    }
 private:
     friend class alt::page_cache_t;
     // Takes ownership of the file_account_t pointee.
     void init(threadnum_t thread, file_account_t *io_account);
-    cache_account_t(threadnum_t thread, file_account_t *io_account);
+    cache_account_t(threadnum_t thread, file_account_t *io_account,
+                    io_class_t io_class);
     void reset();
 
     // I hate having this thread_ variable.  The file_account_t does need to be
     // destroyed on the right thread, though.
     threadnum_t thread_;
     file_account_t *io_account_;
+    io_class_t io_class_;
     DISABLE_COPYING(cache_account_t);
 };
 
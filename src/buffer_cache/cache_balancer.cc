@@ -6,6 +6,7 @@
 #include "buffer_cache/evicter.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "concurrency/pmap.hpp"
+#include "serializer/buf_slab.hpp"
 
 const uint64_t alt_cache_balancer_t::rebalance_check_interval_ms = 20;
 const uint64_t alt_cache_balancer_t::rebalance_access_count_threshold = 100;
@@ -13,6 +14,15 @@ const int64_t alt_cache_balancer_t::rebalance_timeout_ms = 500;
 
 const double alt_cache_balancer_t::read_ahead_proportion = 0.9;
 
+// A cache's claim on memory is the bytes it loaded, weighted by its priority.  The
+// priority is clamped, so that the product can't get anywhere near overflowing when
+// it's converted back to an integer.
+static double weighted_bytes_loaded(int64_t bytes_loaded, const cache_quota_t &quota) {
+    const double priority
+        = std::min(std::max(quota.priority, 0.0), MAX_CACHE_PRIORITY);
+    return static_cast<double>(std::max<int64_t>(0, bytes_loaded)) * priority;
+}
+
 alt_cache_balancer_t::cache_data_t::cache_data_t(alt::evicter_t *_evicter) :
     evicter(_evicter),
     new_size(0),
@@ -21,11 +31,18 @@ alt_cache_balancer_t::cache_data_t::cache_data_t(alt::evicter_t *_evicter) :
     evictable_disk_backed_size(evicter->evictable_disk_backed_size()),
     evictable_unbacked_size(evicter->evictable_unbacked_size()),
     bytes_loaded(evicter->get_bytes_loaded()),
-    access_count(evicter->access_count()) { }
+    access_count(evicter->access_count()),
+    quota(evicter->quota()) { }
 
 alt_cache_balancer_t::alt_cache_balancer_t(
-        clone_ptr_t<watchable_t<uint64_t> > _total_cache_size_watchable) :
+        clone_ptr_t<watchable_t<uint64_t> > _total_cache_size_watchable,
+        cache_eviction_policy_t _eviction_policy,
+        uint32_t _compressed_tier_percent,
+        uint32_t _lock_free_reads_percent) :
     total_cache_size_watchable(_total_cache_size_watchable),
+    eviction_policy_(_eviction_policy),
+    compressed_tier_percent_(_compressed_tier_percent),
+    lock_free_reads_percent_(_lock_free_reads_percent),
     rebalance_timer(make_scoped<repeating_timer_t>(rebalance_check_interval_ms, this)),
     rebalance_timer_state(rebalance_timer_state_t::normal),
     last_rebalance_time{0},
@@ -106,6 +123,12 @@ void alt_cache_balancer_t::rebalance_blocking(UNUSED signal_t *interruptor) {
     guarantee(total_cache_size_watchable->get() <=
         static_cast<uint64_t>(std::numeric_limits<intptr_t>::max()));
 
+    // Slab memory that no buffer uses right now still counts against the cache size,
+    // or the process would end up using a lot more memory than configured.  We only
+    // let it take up to half of the cache size, though, since the slab allocator never
+    // gives memory back after the cache size got lowered.
+    total_cache_size -= std::min(buf_slab_idle_bytes(), total_cache_size / 2);
+
     const size_t num_threads = per_thread_data.size();
     scoped_array_t<std::vector<cache_data_t> > cache_data(num_threads);
     scoped_array_t<bool> zero_access_counts(num_threads);
@@ -121,11 +144,17 @@ void alt_cache_balancer_t::rebalance_blocking(UNUSED signal_t *interruptor) {
     size_t total_evicters = 0;
     uint64_t total_bytes_loaded = 0;
     uint64_t total_access_count = 0;
+    // The bytes loaded, weighted by the priorities of the caches that loaded them
+    double total_weighted_bytes_loaded = 0;
     for (size_t i = 0; i < num_threads; ++i) {
         total_evicters += cache_data[i].size();
         all_zero_access_counts &= zero_access_counts[i];
         for (size_t j = 0; j < cache_data[i].size(); ++j) {
-            total_bytes_loaded += std::max<int64_t>(0, cache_data[i][j].bytes_loaded);
+            const int64_t bytes_loaded
+                = std::max<int64_t>(0, cache_data[i][j].bytes_loaded);
+            total_bytes_loaded += bytes_loaded;
+            total_weighted_bytes_loaded
+                += weighted_bytes_loaded(bytes_loaded, cache_data[i][j].quota);
             total_access_count += cache_data[i][j].access_count;
         }
     }
@@ -163,9 +192,10 @@ void alt_cache_balancer_t::rebalance_blocking(UNUSED signal_t *interruptor) {
                 if (total_cache_size > 0) {
                     double temp = data->old_size;
                     temp /= static_cast<double>(total_cache_size);
-                    temp *= static_cast<double>(total_bytes_loaded);
+                    temp *= total_weighted_bytes_loaded;
 
-                    int64_t new_size = std::max<int64_t>(0, data->bytes_loaded);
+                    int64_t new_size = static_cast<int64_t>(
+                        weighted_bytes_loaded(data->bytes_loaded, data->quota));
                     new_size -= static_cast<int64_t>(temp);
                     new_size += data->old_size;
                     new_size = std::max<int64_t>(new_size, 0);
@@ -244,6 +274,8 @@ void alt_cache_balancer_t::rebalance_blocking(UNUSED signal_t *interruptor) {
 
         }
 
+        apply_quotas(total_cache_size, &cache_data);
+
         // Send new cache sizes to each thread
         pmap(num_threads,
              std::bind(&alt_cache_balancer_t::apply_rebalance_to_thread,
@@ -262,6 +294,29 @@ void alt_cache_balancer_t::rebalance_blocking(UNUSED signal_t *interruptor) {
     }
 }
 
+void alt_cache_balancer_t::apply_quotas(
+        uint64_t total_cache_size,
+        scoped_array_t<std::vector<cache_data_t> > *cache_data) {
+    std::vector<cache_quota_t> quotas;
+    std::vector<uint64_t> sizes;
+    for (size_t i = 0; i < cache_data->size(); ++i) {
+        for (const cache_data_t &data : (*cache_data)[i]) {
+            quotas.push_back(data.quota);
+            sizes.push_back(data.new_size);
+        }
+    }
+
+    apply_cache_quotas(quotas, total_cache_size, &sizes);
+
+    size_t k = 0;
+    for (size_t i = 0; i < cache_data->size(); ++i) {
+        for (cache_data_t &data : (*cache_data)[i]) {
+            data.new_size = sizes[k];
+            ++k;
+        }
+    }
+}
+
 void alt_cache_balancer_t::collect_stats_from_thread(
         int index,
         scoped_array_t<std::vector<cache_data_t> > *data_out,
@@ -304,3 +359,57 @@ void alt_cache_balancer_t::apply_rebalance_to_thread(int index,
     }
 }
 
+void apply_cache_quotas(const std::vector<cache_quota_t> &quotas,
+                        uint64_t total_size,
+                        std::vector<uint64_t> *sizes) {
+    guarantee(quotas.size() == sizes->size());
+
+    int64_t extra_bytes = total_size;
+    for (size_t i = 0; i < sizes->size(); ++i) {
+        uint64_t *size = &(*sizes)[i];
+        *size = std::min(std::max(*size, quotas[i].min_bytes), quotas[i].max_bytes);
+        extra_bytes -= *size;
+    }
+
+    while (extra_bytes != 0) {
+        const bool growing = extra_bytes > 0;
+        auto room = [&](size_t i) -> uint64_t {
+            return growing
+                ? quotas[i].max_bytes - (*sizes)[i]
+                : (*sizes)[i] - quotas[i].min_bytes;
+        };
+
+        double total_priority = 0;
+        for (size_t i = 0; i < sizes->size(); ++i) {
+            if (room(i) > 0) {
+                total_priority += quotas[i].priority;
+            }
+        }
+        if (total_priority == 0) {
+            // Every cache is at its bound.
+            break;
+        }
+
+        // `remaining` is what's left to hand out (or take back) in this pass, as a
+        // positive number.
+        const uint64_t to_move = growing ? extra_bytes : -extra_bytes;
+        uint64_t remaining = to_move;
+        for (size_t i = 0; i < sizes->size() && remaining > 0; ++i) {
+            if (room(i) == 0) {
+                continue;
+            }
+            uint64_t delta = to_move * (quotas[i].priority / total_priority);
+            delta = std::max<uint64_t>(delta, 1);
+            delta = std::min(delta, remaining);
+            delta = std::min(delta, room(i));
+            if (growing) {
+                (*sizes)[i] += delta;
+            } else {
+                (*sizes)[i] -= delta;
+            }
+            remaining -= delta;
+        }
+        const int64_t moved = to_move - remaining;
+        extra_bytes += growing ? -moved : moved;
+    }
+}
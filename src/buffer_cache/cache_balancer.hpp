@@ -10,6 +10,7 @@
 
 #include "threading.hpp"
 #include "arch/timing.hpp"
+#include "buffer_cache/types.hpp"
 #include "concurrency/pump_coro.hpp"
 #include "concurrency/watchable.hpp"
 #include "containers/scoped.hpp"
@@ -30,6 +31,17 @@ public:
     // Tells caches whether to start read ahead initially
     virtual bool read_ahead_ok_at_start() const = 0;
 
+    // The replacement policy the caches should use
+    virtual cache_eviction_policy_t eviction_policy() const = 0;
+
+    // The share of each cache's memory limit, in percent, that may hold compressed
+    // copies of evicted pages.  Zero disables the compressed tier.
+    virtual uint32_t compressed_tier_percent() const = 0;
+
+    // The share of each cache's memory limit, in percent, that may hold copies of
+    // pages published for lock-free reads from other threads.  Zero disables them.
+    virtual uint32_t lock_free_reads_percent() const = 0;
+
     // Returns a pointer to a boolean for the given thread number (which must be the
     // current thread) which, when set to true, means you should notify the balancer
     // that it should wake up.  Stuff outside the balancer should only set it from
@@ -55,8 +67,16 @@ protected:
 // Dummy balancer that does nothing but provide the initial size of a cache
 class dummy_cache_balancer_t final : public cache_balancer_t {
 public:
-    explicit dummy_cache_balancer_t(uint64_t _base_mem_per_store)
+    explicit dummy_cache_balancer_t(
+            uint64_t _base_mem_per_store,
+            cache_eviction_policy_t _eviction_policy
+                = cache_eviction_policy_t::sampled_lru,
+            uint32_t _compressed_tier_percent = 0,
+            uint32_t _lock_free_reads_percent = 0)
         : base_mem_per_store_(_base_mem_per_store),
+          eviction_policy_(_eviction_policy),
+          compressed_tier_percent_(_compressed_tier_percent),
+          lock_free_reads_percent_(_lock_free_reads_percent),
           notify_activity_boolean_(false) { }
     ~dummy_cache_balancer_t() { }
 
@@ -68,6 +88,18 @@ public:
         return false;
     }
 
+    cache_eviction_policy_t eviction_policy() const final {
+        return eviction_policy_;
+    }
+
+    uint32_t compressed_tier_percent() const final {
+        return compressed_tier_percent_;
+    }
+
+    uint32_t lock_free_reads_percent() const final {
+        return lock_free_reads_percent_;
+    }
+
     bool *notify_activity_boolean(threadnum_t) final {
         return &notify_activity_boolean_;
     }
@@ -79,6 +111,9 @@ private:
     void remove_evicter(alt::evicter_t *) { }
 
     uint64_t base_mem_per_store_;
+    cache_eviction_policy_t eviction_policy_;
+    uint32_t compressed_tier_percent_;
+    uint32_t lock_free_reads_percent_;
 
     bool notify_activity_boolean_;
 
@@ -90,7 +125,10 @@ class alt_cache_balancer_t final :
     public repeating_timer_callback_t {
 public:
     explicit alt_cache_balancer_t(
-        clone_ptr_t<watchable_t<uint64_t> > _total_cache_size_watchable);
+        clone_ptr_t<watchable_t<uint64_t> > _total_cache_size_watchable,
+        cache_eviction_policy_t _eviction_policy,
+        uint32_t _compressed_tier_percent,
+        uint32_t _lock_free_reads_percent);
     ~alt_cache_balancer_t();
 
     uint64_t base_mem_per_store() const final {
@@ -101,6 +139,18 @@ public:
         return true;
     }
 
+    cache_eviction_policy_t eviction_policy() const final {
+        return eviction_policy_;
+    }
+
+    uint32_t compressed_tier_percent() const final {
+        return compressed_tier_percent_;
+    }
+
+    uint32_t lock_free_reads_percent() const final {
+        return lock_free_reads_percent_;
+    }
+
     bool *notify_activity_boolean(threadnum_t thread) final;
 
     void wake_up_activity_happened() final;
@@ -149,8 +199,14 @@ private:
 
         int64_t bytes_loaded;
         uint64_t access_count;
+
+        cache_quota_t quota;
     };
 
+    // Makes the new sizes respect the caches' quotas.
+    static void apply_quotas(uint64_t total_cache_size,
+                             scoped_array_t<std::vector<cache_data_t> > *cache_data);
+
     // Helper function to collect stats from each thread so we don't need
     //  atomic variables slowing down normal operations
     void collect_stats_from_thread(int index,
@@ -162,6 +218,9 @@ private:
                                    bool new_read_ahead_ok);
 
     clone_ptr_t<watchable_t<uint64_t> > total_cache_size_watchable;
+    const cache_eviction_policy_t eviction_policy_;
+    const uint32_t compressed_tier_percent_;
+    const uint32_t lock_free_reads_percent_;
     scoped_ptr_t<repeating_timer_t> rebalance_timer;
     enum class rebalance_timer_state_t {
         // Normal operating condition: there is a timer, and it'll ping soon.  Can
@@ -206,4 +265,13 @@ private:
     DISABLE_COPYING(alt_cache_balancer_t);
 };
 
+// Clamps each of `sizes` into the bounds of the corresponding quota, then hands the
+// bytes that this freed up to the caches that can still grow (or takes the bytes that
+// it cost from the caches that can still shrink), in proportion to their priorities,
+// until the sizes add up to `total_size` again.  If the minimums add up to more than
+// `total_size`, the sizes add up to more than that.
+void apply_cache_quotas(const std::vector<cache_quota_t> &quotas,
+                        uint64_t total_size,
+                        std::vector<uint64_t> *sizes);
+
 #endif  // BUFFER_CACHE_CACHE_BALANCER_HPP_
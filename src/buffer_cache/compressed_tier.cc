@@ -0,0 +1,158 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "buffer_cache/compressed_tier.hpp"
+
+#ifdef HAS_LZ4
+#include <lz4.h>
+#endif
+
+#include <algorithm>
+
+namespace alt {
+
+// A rough guess at what the hash map node and the queue entry of a copy take up,
+// on top of the `entry_t` itself.
+const uint64_t COMPRESSED_TIER_ENTRY_OVERHEAD = 64;
+
+// How many stale queue entries we tolerate regardless of the number of copies.
+const size_t COMPRESSED_TIER_QUEUE_SLACK = 64;
+
+compressed_page_tier_t::compressed_page_tier_t()
+    : capacity_(0),
+      size_(0),
+      uncompressed_bytes_(0),
+      compressed_bytes_(0),
+      hits_(0),
+      misses_(0),
+      sequence_counter_(0) { }
+
+compressed_page_tier_t::~compressed_page_tier_t() { }
+
+uint64_t compressed_page_tier_t::entry_usage(const entry_t &entry) {
+    return entry.compressed_size + sizeof(entry_t) + COMPRESSED_TIER_ENTRY_OVERHEAD;
+}
+
+void compressed_page_tier_t::set_capacity(uint64_t capacity) {
+    capacity_ = capacity;
+    trim();
+}
+
+void compressed_page_tier_t::add(block_id_t block_id,
+                                 const counted_t<block_token_t> &token,
+                                 const buf_ptr_t &buf) {
+    if (capacity_ == 0) {
+        return;
+    }
+    rassert(token.has());
+    const block_size_t block_size = buf.block_size();
+    const int max_compressed_size
+        = block_size.value() * MAX_COMPRESSED_PERCENT / 100;
+    scratch_.resize(std::max<size_t>(scratch_.size(), max_compressed_size));
+#ifdef HAS_LZ4
+    const int compressed_size = LZ4_compress_default(
+        buf.ser_buffer()->cache_data, scratch_.data(), block_size.value(),
+        max_compressed_size);
+#else
+    // Without LZ4, no page is worth keeping.
+    const int compressed_size = 0;
+#endif
+
+    auto it = entries_.find(block_id);
+    if (it != entries_.end()) {
+        remove(it);
+    }
+    if (compressed_size <= 0) {
+        // The page doesn't compress well enough to be worth keeping.
+        return;
+    }
+
+    entry_t *entry = &entries_[block_id];
+    entry->token = token;
+    entry->block_size = block_size;
+    entry->ser_header = buf.ser_buffer()->ser_header;
+    entry->data = scoped_malloc_t<char>(scratch_.data(), compressed_size);
+    entry->compressed_size = compressed_size;
+    entry->sequence = ++sequence_counter_;
+    queue_.push_back(std::make_pair(block_id, entry->sequence));
+
+    size_ += entry_usage(*entry);
+    uncompressed_bytes_ += block_size.value();
+    compressed_bytes_ += compressed_size;
+    trim();
+}
+
+counted_t<block_token_t> compressed_page_tier_t::kept_token(block_id_t block_id) const {
+    auto it = entries_.find(block_id);
+    return it == entries_.end() ? counted_t<block_token_t>() : it->second.token;
+}
+
+buf_ptr_t compressed_page_tier_t::take(block_id_t block_id,
+                                       const counted_t<block_token_t> &kept_token) {
+    auto it = entries_.find(block_id);
+    if (it == entries_.end() || it->second.token.get() != kept_token.get()) {
+        // The copy got dropped, or replaced by a newer one, while the caller was
+        // away on the serializer's thread.
+        ++misses_;
+        return buf_ptr_t();
+    }
+    ++hits_;
+
+    const entry_t &entry = it->second;
+    buf_ptr_t buf = buf_ptr_t::alloc_uninitialized(entry.block_size);
+    buf.ser_buffer()->ser_header = entry.ser_header;
+#ifdef HAS_LZ4
+    const int decompressed_size = LZ4_decompress_safe(
+        entry.data.get(), buf.ser_buffer()->cache_data, entry.compressed_size,
+        entry.block_size.value());
+#else
+    const int decompressed_size = 0;
+    unreachable();
+#endif
+    guarantee(decompressed_size == entry.block_size.value(),
+              "Corrupted page in the compressed cache tier (block id %" PRIu64 ").",
+              block_id);
+    buf.fill_padding_zero();
+    remove(it);
+    trim();
+    return buf;
+}
+
+void compressed_page_tier_t::drop(block_id_t block_id,
+                                  const counted_t<block_token_t> &kept_token) {
+    ++misses_;
+    auto it = entries_.find(block_id);
+    if (it != entries_.end() && it->second.token.get() == kept_token.get()) {
+        remove(it);
+    }
+}
+
+void compressed_page_tier_t::remove(entry_map_t::iterator it) {
+    size_ -= entry_usage(it->second);
+    uncompressed_bytes_ -= it->second.block_size.value();
+    compressed_bytes_ -= it->second.compressed_size;
+    entries_.erase(it);
+}
+
+void compressed_page_tier_t::trim() {
+    while (size_ > capacity_) {
+        guarantee(!queue_.empty());
+        auto it = entries_.find(queue_.front().first);
+        if (it != entries_.end() && it->second.sequence == queue_.front().second) {
+            remove(it);
+        }
+        queue_.pop_front();
+    }
+    // Copies that got taken or replaced leave stale entries behind in the queue.
+    // Once they outnumber the live ones, we rebuild the queue without them.
+    if (queue_.size() > 2 * entries_.size() + COMPRESSED_TIER_QUEUE_SLACK) {
+        std::deque<std::pair<block_id_t, uint64_t> > live;
+        for (const auto &pair : queue_) {
+            auto it = entries_.find(pair.first);
+            if (it != entries_.end() && it->second.sequence == pair.second) {
+                live.push_back(pair);
+            }
+        }
+        queue_ = std::move(live);
+    }
+}
+
+}  // namespace alt
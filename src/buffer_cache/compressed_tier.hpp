@@ -0,0 +1,111 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef BUFFER_CACHE_COMPRESSED_TIER_HPP_
+#define BUFFER_CACHE_COMPRESSED_TIER_HPP_
+
+#include <stdint.h>
+
+#include <deque>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "buffer_cache/types.hpp"
+#include "containers/counted.hpp"
+#include "containers/scoped.hpp"
+#include "serializer/buf_ptr.hpp"
+#include "serializer/types.hpp"
+
+namespace alt {
+
+// A second cache tier that keeps LZ4-compressed copies of clean pages after the
+// evicter drops them from memory.  Loading a page that is still in here costs a
+// decompression instead of a serializer read.
+//
+// Each copy is keyed by its block id and keeps the block token it was loaded with.
+// A copy only gets used if the page is being loaded from the same place on disk, so
+// a block that got written in the meantime never gets its old contents back.  Copies
+// are dropped in the order they were added once the tier goes over capacity.  Pages
+// that don't compress to at most `MAX_COMPRESSED_PERCENT` percent of their size are
+// not kept at all.
+class compressed_page_tier_t {
+public:
+    static const uint64_t MAX_COMPRESSED_PERCENT = 75;
+
+    compressed_page_tier_t();
+    ~compressed_page_tier_t();
+
+    // Drops copies until the tier fits.  A capacity of zero disables the tier.
+    void set_capacity(uint64_t capacity);
+    uint64_t capacity() const { return capacity_; }
+
+    // The memory the copies and their bookkeeping take up.
+    uint64_t size() const { return size_; }
+    uint64_t num_pages() const { return entries_.size(); }
+    // The sizes of the pages held, before and after compression.
+    uint64_t uncompressed_bytes() const { return uncompressed_bytes_; }
+    uint64_t compressed_bytes() const { return compressed_bytes_; }
+
+    // Loads that found, or didn't find, a usable copy in the tier.
+    uint64_t hits() const { return hits_; }
+    uint64_t misses() const { return misses_; }
+
+    // Keeps a compressed copy of `buf`, which is the content of the block that
+    // `token` refers to, if it compresses well enough.
+    void add(block_id_t block_id,
+             const counted_t<block_token_t> &token,
+             const buf_ptr_t &buf);
+
+    // Returns the token the copy of the block was kept with, or an empty token if
+    // there's no copy.  The copy might be stale: the serializer hands out a new token
+    // for every index read, so the caller has to compare the token's offset with the
+    // block's current one on the serializer's thread.
+    counted_t<block_token_t> kept_token(block_id_t block_id) const;
+
+    // Removes the copy of the block and returns it decompressed, if it's still the
+    // one that was kept with `kept_token`.  Returns an empty `buf_ptr_t` otherwise.
+    buf_ptr_t take(block_id_t block_id, const counted_t<block_token_t> &kept_token);
+
+    // Drops the copy of the block that was kept with `kept_token`, which turned out
+    // to be stale.
+    void drop(block_id_t block_id, const counted_t<block_token_t> &kept_token);
+
+private:
+    struct entry_t {
+        entry_t()
+            : block_size(block_size_t::undefined()), compressed_size(0), sequence(0) { }
+        counted_t<block_token_t> token;
+        block_size_t block_size;
+        ls_buf_data_t ser_header;
+        scoped_malloc_t<char> data;
+        uint32_t compressed_size;
+        uint64_t sequence;
+    };
+
+    typedef std::unordered_map<block_id_t, entry_t> entry_map_t;
+
+    static uint64_t entry_usage(const entry_t &entry);
+    void remove(entry_map_t::iterator it);
+    void trim();
+
+    uint64_t capacity_;
+    uint64_t size_;
+    uint64_t uncompressed_bytes_;
+    uint64_t compressed_bytes_;
+    uint64_t hits_;
+    uint64_t misses_;
+
+    entry_map_t entries_;
+    // The copies in the order they were added, with a sequence number like the
+    // evicter's ghost list, so that stale queue entries can be skipped.
+    std::deque<std::pair<block_id_t, uint64_t> > queue_;
+    uint64_t sequence_counter_;
+
+    // Where pages get compressed before we know how big the copy will be.
+    std::vector<char> scratch_;
+
+    DISABLE_COPYING(compressed_page_tier_t);
+};
+
+}  // namespace alt
+
+#endif  // BUFFER_CACHE_COMPRESSED_TIER_HPP_
@@ -2,22 +2,36 @@
 
 #include "arch/runtime/coroutines.hpp"
 #include "buffer_cache/alt.hpp"
+#include "buffer_cache/cache_account.hpp"
 #include "buffer_cache/page.hpp"
 #include "buffer_cache/page_cache.hpp"
 #include "buffer_cache/cache_balancer.hpp"
 
 namespace alt {
 
+// Under the 2Q policy, probation may take up this share of the memory limit before
+// we start evicting from it ahead of the protected segment.
+const uint64_t TWO_Q_PROBATION_SHARE_DIVISOR = 4;
+
 evicter_t::evicter_t()
     : initialized_(false),
       page_cache_(nullptr),
       balancer_(nullptr),
       balancer_notify_activity_boolean_(nullptr),
       throttler_(nullptr),
+      quota_(default_cache_quota()),
+      eviction_policy_(cache_eviction_policy_t::sampled_lru),
+      compressed_tier_percent_(0),
+      lock_free_reads_percent_(0),
       bytes_loaded_counter_(0),
       access_count_counter_(0),
       access_time_counter_(INITIAL_ACCESS_TIME),
       evict_if_necessary_active_(false),
+      ghost_sequence_counter_(0),
+      page_hits_(0),
+      page_misses_(0),
+      pages_evicted_(0),
+      eviction_nanos_(0),
       last_force_flush_time_(ticks_t{0}) { }
 
 evicter_t::~evicter_t() {
@@ -37,6 +51,13 @@ void evicter_t::initialize(page_cache_t *page_cache,
     initialized_ = true;  // Can you really say this class is 'initialized_'?
     page_cache_ = page_cache;
     memory_limit_ = balancer->base_mem_per_store();
+    eviction_policy_ = balancer->eviction_policy();
+    compressed_tier_percent_ = balancer->compressed_tier_percent();
+    guarantee(compressed_tier_percent_ <= MAX_COMPRESSED_TIER_PERCENT);
+    compressed_tier_.set_capacity(memory_limit_ * compressed_tier_percent_ / 100);
+    lock_free_reads_percent_ = balancer->lock_free_reads_percent();
+    guarantee(lock_free_reads_percent_ <= MAX_LOCK_FREE_READS_PERCENT);
+    published_pages_.set_capacity(memory_limit_ * lock_free_reads_percent_ / 100);
     page_cache_ = page_cache;
     throttler_ = throttler;
     balancer_ = balancer;
@@ -60,6 +81,9 @@ void evicter_t::update_memory_limit(uint64_t new_memory_limit,
     bytes_loaded_counter_ -= bytes_loaded_accounted_for;
     access_count_counter_ -= access_count_accounted_for;
     memory_limit_ = new_memory_limit;
+    compressed_tier_.set_capacity(memory_limit_ * compressed_tier_percent_ / 100);
+    published_pages_.set_capacity(memory_limit_ * lock_free_reads_percent_ / 100);
+    trim_ghosts();
     evict_if_necessary();
 
     throttler_->inform_memory_limit_change(memory_limit_,
@@ -72,6 +96,16 @@ void wake_up_balancer(cache_balancer_t *balancer,
     balancer->wake_up_activity_happened();
 }
 
+void evicter_t::set_quota(cache_quota_t quota) {
+    guarantee_initialized();
+    guarantee(quota.min_bytes <= quota.max_bytes);
+    guarantee(quota.priority > 0);
+    quota_ = quota;
+    coro_t::spawn_sometime(std::bind(&wake_up_balancer,
+                                     balancer_,
+                                     drainer_.lock()));
+}
+
 void evicter_t::notify_bytes_loading(int64_t in_memory_buf_change) {
     guarantee_initialized();
     bytes_loaded_counter_ += in_memory_buf_change;
@@ -96,15 +130,18 @@ void evicter_t::catch_up_deferred_load(page_t *page) {
     notify_bytes_loading(page->hypothetical_memory_usage(page_cache_));
 }
 
-void evicter_t::add_not_yet_loaded(page_t *page) {
+void evicter_t::add_not_yet_loaded(page_t *page, cache_account_t *account) {
     guarantee_initialized();
+    maybe_protect_loading_page(page, account);
     unevictable_.add(page, page->hypothetical_memory_usage(page_cache_));
     evict_if_necessary();
     notify_bytes_loading(page->hypothetical_memory_usage(page_cache_));
 }
 
-void evicter_t::reloading_page(page_t *page) {
+void evicter_t::reloading_page(page_t *page, cache_account_t *account) {
     guarantee_initialized();
+    rassert(unevictable_.has_page(page));
+    maybe_protect_loading_page(page, account);
     notify_bytes_loading(page->hypothetical_memory_usage(page_cache_));
 }
 
@@ -138,6 +175,7 @@ void evicter_t::move_unevictable_to_evictable(page_t *page) {
     unevictable_.remove(page, page->hypothetical_memory_usage(page_cache_));
     eviction_bag_t *new_bag = correct_eviction_category(page);
     rassert(new_bag == &evictable_disk_backed_
+            || new_bag == &evictable_protected_
             || new_bag == &evictable_unbacked_);
     new_bag->add(page, page->hypothetical_memory_usage(page_cache_));
     evict_if_necessary();
@@ -160,7 +198,7 @@ eviction_bag_t *evicter_t::correct_eviction_category(page_t *page) {
     } else if (!page->is_loaded()) {
         return &evicted_;
     } else if (page->is_disk_backed()) {
-        return &evictable_disk_backed_;
+        return page->is_protected() ? &evictable_protected_ : &evictable_disk_backed_;
     } else {
         return &evictable_unbacked_;
     }
@@ -177,7 +215,79 @@ uint64_t evicter_t::in_memory_size() const {
     guarantee_initialized();
     return unevictable_.size()
         + evictable_disk_backed_.size()
-        + evictable_unbacked_.size();
+        + evictable_protected_.size()
+        + evictable_unbacked_.size()
+        + compressed_tier_.size()
+        + published_pages_.size();
+}
+
+void evicter_t::maybe_protect_loading_page(page_t *page, cache_account_t *account) {
+    if (eviction_policy_ != cache_eviction_policy_t::two_q || page->is_protected_) {
+        return;
+    }
+    auto it = ghost_index_.find(page->block_id());
+    if (it == ghost_index_.end()) {
+        return;
+    }
+    // Background accounts don't get to promote pages, but they don't consume the
+    // ghost entry either, so a foreground access shortly after still counts.
+    if (account != nullptr && account->io_class() != io_class_t::foreground) {
+        return;
+    }
+    ghost_index_.erase(it);
+    page->is_protected_ = true;
+}
+
+uint64_t evicter_t::ghost_capacity() const {
+    // 2Q works well with a ghost list that covers about half as many pages as
+    // there's room for in memory.
+    return memory_limit_ / page_cache_->max_block_size().ser_value() / 2;
+}
+
+void evicter_t::add_ghost(block_id_t block_id) {
+    const uint64_t sequence = ++ghost_sequence_counter_;
+    ghost_index_[block_id] = sequence;
+    ghost_queue_.push_back(std::make_pair(block_id, sequence));
+    trim_ghosts();
+}
+
+void evicter_t::trim_ghosts() {
+    const uint64_t capacity = ghost_capacity();
+    while (!ghost_queue_.empty()
+           && (ghost_index_.size() > capacity || ghost_queue_.size() > 2 * capacity)) {
+        auto it = ghost_index_.find(ghost_queue_.front().first);
+        if (it != ghost_index_.end() && it->second == ghost_queue_.front().second) {
+            ghost_index_.erase(it);
+        }
+        ghost_queue_.pop_front();
+    }
+}
+
+bool evicter_t::select_page_to_evict(eviction_bag_t **bag_out, page_t **page_out) {
+    if (eviction_policy_ == cache_eviction_policy_t::sampled_lru) {
+        *bag_out = &evictable_disk_backed_;
+        return eviction_bag_t::select_oldish(
+            &evictable_disk_backed_, access_time_counter_, page_out);
+    }
+
+    // Pages on probation go first, as long as there's a fair number of them.  That
+    // keeps pages that only get touched once (as by large scans) from pushing the
+    // pages that get used over and over out of the cache.
+    eviction_bag_t *first = &evictable_protected_;
+    eviction_bag_t *second = &evictable_disk_backed_;
+    if (evictable_disk_backed_.size() > memory_limit_ / TWO_Q_PROBATION_SHARE_DIVISOR
+        || evictable_protected_.size() == 0) {
+        std::swap(first, second);
+    }
+    if (eviction_bag_t::select_oldish(first, access_time_counter_, page_out)) {
+        *bag_out = first;
+        return true;
+    } else if (eviction_bag_t::select_oldish(second, access_time_counter_, page_out)) {
+        *bag_out = second;
+        return true;
+    } else {
+        return false;
+    }
 }
 
 void evicter_t::evict_if_necessary() THROWS_NOTHING {
@@ -195,15 +305,28 @@ void evicter_t::evict_if_necessary() THROWS_NOTHING {
     // currently being written for the purpose of eviction.
 
     evict_if_necessary_active_ = true;
-    page_t *page;
-    while (in_memory_size() > memory_limit_
-           && eviction_bag_t::select_oldish(
-                &evictable_disk_backed_, access_time_counter_, &page)) {
-        uint32_t mem_usage = page->hypothetical_memory_usage(page_cache_);
-        evictable_disk_backed_.remove(page, mem_usage);
-        evicted_.add(page, mem_usage);
-        page->evict_self(page_cache_);
-        page_cache_->consider_evicting_current_page(page->block_id());
+    if (in_memory_size() > memory_limit_) {
+        const ticks_t start = get_ticks();
+        eviction_bag_t *bag;
+        page_t *page;
+        while (in_memory_size() > memory_limit_
+               && select_page_to_evict(&bag, &page)) {
+            uint32_t mem_usage = page->hypothetical_memory_usage(page_cache_);
+            bag->remove(page, mem_usage);
+            if (bag == &evictable_disk_backed_
+                && eviction_policy_ == cache_eviction_policy_t::two_q) {
+                add_ghost(page->block_id());
+            }
+            page->is_protected_ = false;
+            // The page is clean, so the compressed copy can stand in for a read of
+            // the block as long as the page keeps the same block token.
+            compressed_tier_.add(page->block_id(), page->block_token(), page->buf_);
+            evicted_.add(page, mem_usage);
+            page->evict_self(page_cache_);
+            page_cache_->consider_evicting_current_page(page->block_id());
+            ++pages_evicted_;
+        }
+        eviction_nanos_ += get_ticks().nanos - start.nanos;
     }
 
     if (in_memory_size() > memory_limit_) {
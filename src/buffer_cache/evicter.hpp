@@ -3,15 +3,22 @@
 
 #include <stdint.h>
 
+#include <deque>
 #include <functional>
+#include <unordered_map>
+#include <utility>
 
+#include "buffer_cache/compressed_tier.hpp"
 #include "buffer_cache/eviction_bag.hpp"
+#include "buffer_cache/published_pages.hpp"
+#include "buffer_cache/types.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/cache_line_padded.hpp"
 #include "concurrency/pubsub.hpp"
 #include "threading.hpp"
 #include "time.hpp"
 
+class cache_account_t;
 class cache_balancer_t;
 class alt_txn_throttler_t;
 
@@ -21,7 +28,7 @@ class page_cache_t;
 
 class evicter_t : public home_thread_mixin_debug_only_t {
 public:
-    void add_not_yet_loaded(page_t *page);
+    void add_not_yet_loaded(page_t *page, cache_account_t *account);
     void add_deferred_loaded(page_t *page);
     void catch_up_deferred_load(page_t *page);
     void add_to_evictable_unbacked(page_t *page);
@@ -33,7 +40,14 @@ public:
     eviction_bag_t *correct_eviction_category(page_t *page);
     eviction_bag_t *evicted_category() { return &evicted_; }
     void remove_page(page_t *page);
-    void reloading_page(page_t *page);
+    void reloading_page(page_t *page, cache_account_t *account);
+
+    // Counts an access to a page for the hit and miss stats, `hit` being whether the
+    // page was in memory.
+    void note_page_access(bool hit) {
+        guarantee_initialized();
+        ++(hit ? page_hits_ : page_misses_);
+    }
 
     // Evicter will be unusable until initialize is called
     evicter_t();
@@ -47,10 +61,22 @@ public:
                              uint64_t access_count_accounted_for,
                              bool read_ahead_ok);
 
+    // Sets the bounds and the weight that the balancer applies to the memory limit,
+    // and wakes the balancer up so that it applies them soon.
+    void set_quota(cache_quota_t quota);
+    cache_quota_t quota() const {
+        guarantee_initialized();
+        return quota_;
+    }
+
     uint64_t next_access_time() {
         guarantee_initialized();
         return ++access_time_counter_;
     }
+    uint64_t current_access_time() const {
+        guarantee_initialized();
+        return access_time_counter_;
+    }
 
     uint64_t memory_limit() const {
         guarantee_initialized();
@@ -66,7 +92,7 @@ public:
     }
     uint64_t evictable_disk_backed_size() const {
         guarantee_initialized();
-        return evictable_disk_backed_.size();
+        return evictable_disk_backed_.size() + evictable_protected_.size();
     }
     uint64_t evictable_unbacked_size() const {
         guarantee_initialized();
@@ -78,6 +104,42 @@ public:
         return bytes_loaded_counter_;
     }
 
+    cache_eviction_policy_t eviction_policy() const {
+        guarantee_initialized();
+        return eviction_policy_;
+    }
+    uint64_t page_hits() const {
+        guarantee_initialized();
+        return page_hits_;
+    }
+    uint64_t page_misses() const {
+        guarantee_initialized();
+        return page_misses_;
+    }
+    // How many pages got evicted, and how long the loop that evicted them took.
+    uint64_t pages_evicted() const {
+        guarantee_initialized();
+        return pages_evicted_;
+    }
+    uint64_t eviction_nanos() const {
+        guarantee_initialized();
+        return eviction_nanos_;
+    }
+
+    // Page loads check here before going to the serializer.
+    compressed_page_tier_t &compressed_tier() {
+        guarantee_initialized();
+        return compressed_tier_;
+    }
+    const compressed_page_tier_t &compressed_tier() const {
+        guarantee_initialized();
+        return compressed_tier_;
+    }
+
+    // Copies of pages that other threads can read without switching to this one.
+    // Unlike the rest of the evicter, this can be used before `initialize()` and on
+    // any thread, as far as `published_pages_t` allows.
+    published_pages_t &published_pages() { return published_pages_; }
 
     uint64_t in_memory_size() const;
 
@@ -99,6 +161,20 @@ private:
     // Evicts any evictable pages until under the memory limit
     void evict_if_necessary() THROWS_NOTHING;
 
+    // Picks the next page to evict, and the bag it's in.
+    bool select_page_to_evict(eviction_bag_t **bag_out, page_t **page_out);
+
+    // Promotes the page to the protected segment if the 2Q policy evicted it from
+    // probation recently, unless it's being loaded on behalf of a background
+    // account.
+    void maybe_protect_loading_page(page_t *page, cache_account_t *account);
+
+    // The ghost list (2Q's "A1out") remembers the block ids of pages recently
+    // evicted from probation.
+    void add_ghost(block_id_t block_id);
+    void trim_ghosts();
+    uint64_t ghost_capacity() const;
+
     bool initialized_;
     page_cache_t *page_cache_;
     cache_balancer_t *balancer_;
@@ -107,6 +183,15 @@ private:
     alt_txn_throttler_t *throttler_;
 
     uint64_t memory_limit_;
+    cache_quota_t quota_;
+
+    cache_eviction_policy_t eviction_policy_;
+
+    // The share of `memory_limit_`, in percent, that the compressed tier may use.
+    uint32_t compressed_tier_percent_;
+
+    // The share of `memory_limit_`, in percent, that published pages may use.
+    uint32_t lock_free_reads_percent_;
 
     // These are updated every time a page is loaded, created, or destroyed, and
     // cleared when cache memory limits are re-evaluated.  This value can go
@@ -126,6 +211,30 @@ private:
     eviction_bag_t evictable_disk_backed_;
     eviction_bag_t evictable_unbacked_;
     eviction_bag_t evicted_;
+    // Under `cache_eviction_policy_t::two_q`, disk backed pages that got promoted
+    // out of probation (which is `evictable_disk_backed_`) live here instead.
+    eviction_bag_t evictable_protected_;
+
+    // The ghost list, in the order the pages were evicted.  Each entry carries a
+    // sequence number so that stale entries (of block ids that got evicted again, or
+    // loaded again) can be told apart from the ones in `ghost_index_`.
+    std::deque<std::pair<block_id_t, uint64_t> > ghost_queue_;
+    std::unordered_map<block_id_t, uint64_t> ghost_index_;
+    uint64_t ghost_sequence_counter_;
+
+    // Page accesses that found the page in memory, or had to wait for it to load.
+    uint64_t page_hits_;
+    uint64_t page_misses_;
+
+    uint64_t pages_evicted_;
+    uint64_t eviction_nanos_;
+
+    // Compressed copies of clean pages that got evicted.  Its size counts towards
+    // `in_memory_size()`.
+    compressed_page_tier_t compressed_tier_;
+
+    // Its size counts towards `in_memory_size()` as well.
+    published_pages_t published_pages_;
 
     ticks_t last_force_flush_time_;
 
@@ -1,6 +1,7 @@
 #include "buffer_cache/page.hpp"
 
 #include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/numa.hpp"
 #include "buffer_cache/page_cache.hpp"
 #include "serializer/serializer.hpp"
 
@@ -52,10 +53,59 @@ private:
 static const uint64_t READ_AHEAD_ACCESS_TIME = evicter_t::INITIAL_ACCESS_TIME - 1;
 
 
+// Tells whether the copy that the evicter's compressed tier kept with `kept_token`
+// holds the version of the block that `block_token` refers to.  The serializer hands
+// out a new token for every index read, so we compare where the tokens point on disk.
+// Called on the serializer's thread, because that's where the GC moves blocks around.
+bool compressed_copy_is_current(const counted_t<block_token_t> &kept_token,
+                                const counted_t<block_token_t> &block_token) {
+    return kept_token.has() && kept_token->offset() == block_token->offset();
+}
+
+// Finishes loading the block that `block_token` refers to.  `buf` holds what got read
+// from the serializer, unless the copy kept in the compressed tier with `kept_token` is
+// current, in which case `buf` is empty and we take the copy instead (or read the block
+// after all, if the copy got dropped in the meantime).  A stale copy gets dropped.
+// Called (and returns) on the page cache's thread.
+buf_ptr_t finish_load_from_compressed_tier(page_cache_t *page_cache,
+                                           block_id_t block_id,
+                                           const counted_t<block_token_t> &kept_token,
+                                           const counted_t<block_token_t> &block_token,
+                                           cache_account_t *account,
+                                           buf_ptr_t buf) {
+    compressed_page_tier_t *const tier = &page_cache->evicter().compressed_tier();
+    if (buf.has()) {
+        if (kept_token.has()) {
+            tier->drop(block_id, kept_token);
+        }
+        return buf;
+    }
+    buf = tier->take(block_id, kept_token);
+    if (!buf.has()) {
+        serializer_t *const serializer = page_cache->serializer();
+        on_thread_t th(serializer->home_thread());
+        buf = page_cache->read_batcher()->block_read(block_token, account->get());
+    }
+    return buf;
+}
+
+// In NUMA mode, the serializer's thread can be on another node than the page cache,
+// and the buffers it reads come from its own node's memory.  We copy those over to
+// our node, because a page gets read many more times than it gets loaded.  Called on
+// the page cache's thread.
+buf_ptr_t move_to_current_numa_node(buf_ptr_t buf) {
+    const int numa_node = get_current_numa_node();
+    if (numa_node != -1 && buf_slab_numa_node(buf.ser_buffer()) != numa_node) {
+        return buf_ptr_t::alloc_copy(buf);
+    }
+    return buf;
+}
+
 page_t::page_t(block_id_t _block_id, page_cache_t *page_cache)
     : block_id_(_block_id),
       loader_(nullptr),
       access_time_(page_cache->evicter().next_access_time()),
+      is_protected_(false),
       snapshot_refcount_(0) {
     page_cache->evicter().add_deferred_loaded(this);
 
@@ -70,8 +120,9 @@ page_t::page_t(block_id_t _block_id, page_cache_t *page_cache,
     : block_id_(_block_id),
       loader_(nullptr),
       access_time_(page_cache->evicter().next_access_time()),
+      is_protected_(false),
       snapshot_refcount_(0) {
-    page_cache->evicter().add_not_yet_loaded(this);
+    page_cache->evicter().add_not_yet_loaded(this, account);
 
     coro_t::spawn_now_dangerously(std::bind(&page_t::load_with_block_id,
                                             this,
@@ -86,6 +137,7 @@ page_t::page_t(block_id_t _block_id, buf_ptr_t buf,
       loader_(nullptr),
       buf_(std::move(buf)),
       access_time_(page_cache->evicter().next_access_time()),
+      is_protected_(false),
       snapshot_refcount_(0) {
     rassert(buf_.has());
     page_cache->evicter().add_to_evictable_unbacked(this);
@@ -100,6 +152,7 @@ page_t::page_t(block_id_t _block_id,
       buf_(std::move(buf)),
       block_token_(_block_token),
       access_time_(READ_AHEAD_ACCESS_TIME),
+      is_protected_(false),
       snapshot_refcount_(0) {
     rassert(buf_.has());
     page_cache->evicter().add_to_evictable_disk_backed(this);
@@ -109,8 +162,9 @@ page_t::page_t(page_t *copyee, page_cache_t *page_cache, cache_account_t *accoun
     : block_id_(copyee->block_id_),
       loader_(nullptr),
       access_time_(page_cache->evicter().next_access_time()),
+      is_protected_(copyee->is_protected_),
       snapshot_refcount_(0) {
-    page_cache->evicter().add_not_yet_loaded(this);
+    page_cache->evicter().add_not_yet_loaded(this, account);
     coro_t::spawn_now_dangerously(std::bind(&page_t::load_from_copyee,
                                             this,
                                             copyee,
@@ -184,7 +238,7 @@ void page_t::finish_load_with_block_id(page_t *page, page_cache_t *page_cache,
     rassert(block_token.has());
     {
         usage_adjuster_t adjuster(page_cache, page);
-        page->buf_ = std::move(buf);
+        page->buf_ = move_to_current_numa_node(std::move(buf));
         page->block_token_ = std::move(block_token);
         page->loader_ = nullptr;
     }
@@ -261,6 +315,11 @@ void page_t::catch_up_with_deferred_load(
     // Before blocking, tell the evicter to put us in the right category.
     page_cache->evicter().catch_up_deferred_load(page);
 
+    // We only learn the block token on the serializer thread, so if there's a
+    // compressed copy of the block, we check there whether it's current.
+    const counted_t<block_token_t> kept_token
+        = page_cache->evicter().compressed_tier().kept_token(page->block_id());
+
     buf_ptr_t buf;
     {
         serializer_t *const serializer = page_cache->serializer();
@@ -271,9 +330,14 @@ void page_t::catch_up_with_deferred_load(
         on_thread_t th(serializer->home_thread());
         // Now finish what the rest of load_with_block_id would do.
         rassert(block_token_ptr->token.has());
-        buf = serializer->block_read(block_token_ptr->token,
-                                     account->get());
+        if (!compressed_copy_is_current(kept_token, block_token_ptr->token)) {
+            buf = page_cache->read_batcher()->block_read(block_token_ptr->token,
+                                                         account->get());
+        }
     }
+    buf = finish_load_from_compressed_tier(page_cache, page->block_id(), kept_token,
+                                           block_token_ptr->token, account,
+                                           std::move(buf));
 
     ASSERT_FINITE_CORO_WAITING;
     if (our_loader.abandon_page()) {
@@ -349,14 +413,21 @@ void page_t::load_with_block_id(page_t *page, block_id_t block_id,
     buf_ptr_t buf;
     counted_t<block_token_t> block_token;
 
+    const counted_t<block_token_t> kept_token
+        = page_cache->evicter().compressed_tier().kept_token(block_id);
+
     {
         serializer_t *const serializer = page_cache->serializer();
         on_thread_t th(serializer->home_thread());
         block_token = serializer->index_read(block_id);
         rassert(block_token.has());
-        buf = serializer->block_read(block_token,
-                                     account->get());
+        if (!compressed_copy_is_current(kept_token, block_token)) {
+            buf = page_cache->read_batcher()->block_read(block_token,
+                                                         account->get());
+        }
     }
+    buf = finish_load_from_compressed_tier(page_cache, block_id, kept_token,
+                                           block_token, account, std::move(buf));
 
     ASSERT_FINITE_CORO_WAITING;
     if (loader.abandon_page()) {
@@ -415,6 +486,7 @@ void page_t::add_waiter(page_acq_t *acq, cache_account_t *account) {
         = acq->page_cache()->evicter().correct_eviction_category(this);
     waiters_.push_front(acq);
     acq->page_cache()->evicter().change_to_correct_eviction_bag(old_bag, this);
+    acq->page_cache()->evicter().note_page_access(buf_.has());
     if (buf_.has()) {
         acq->buf_ready_signal_.pulse();
     } else if (loader_ != nullptr) {
@@ -438,21 +510,25 @@ void page_t::load_using_block_token(page_t *page, page_cache_t *page_cache,
     rassert(page->loader_ == nullptr);
     page->loader_ = &loader;
 
-    page_cache->evicter().reloading_page(page);
+    page_cache->evicter().reloading_page(page, account);
 
     auto_drainer_t::lock_t lock = page_cache->drainer_lock();
 
     counted_t<block_token_t> block_token = page->block_token_;
     rassert(block_token.has());
 
+    // The page kept its block token, which is the one a compressed copy of the page
+    // got kept with if it's current.
+    const counted_t<block_token_t> kept_token
+        = page_cache->evicter().compressed_tier().kept_token(page->block_id());
     buf_ptr_t buf;
-    {
+    if (kept_token.get() != block_token.get()) {
         serializer_t *const serializer = page_cache->serializer();
-
         on_thread_t th(serializer->home_thread());
-        buf = serializer->block_read(block_token,
-                                     account->get());
+        buf = page_cache->read_batcher()->block_read(block_token, account->get());
     }
+    buf = finish_load_from_compressed_tier(page_cache, page->block_id(), kept_token,
+                                           block_token, account, std::move(buf));
 
     ASSERT_FINITE_CORO_WAITING;
     if (loader.abandon_page()) {
@@ -464,7 +540,7 @@ void page_t::load_using_block_token(page_t *page, page_cache_t *page_cache,
     block_token.reset();
     {
         usage_adjuster_t adjuster(page_cache, page);
-        page->buf_ = std::move(buf);
+        page->buf_ = move_to_current_numa_node(std::move(buf));
         page->loader_ = nullptr;
     }
 
@@ -503,6 +579,8 @@ uint32_t page_t::hypothetical_memory_usage(page_cache_t *page_cache) const {
     // Account for page_txn_t overhead a bit...
     base_size += sizeof(current_page_dirtier_t)
         + sizeof(std::pair<block_id_t, block_change_t>) + 24;
+    // The aligned block size is exactly the size of the buf's slot in the slab
+    // allocator.
     if (buf_.has()) {
         return base_size + buf_.aligned_block_size();
     } else if (block_token_.has()) {
@@ -14,6 +14,7 @@ namespace alt {
 
 class page_cache_t;
 class page_acq_t;
+class evicter_t;
 
 class page_loader_t;
 class deferred_page_loader_t;
@@ -65,6 +66,7 @@ public:
     bool has_waiters() const { return !waiters_.empty(); }
     bool is_loaded() const { return buf_.has(); }
     bool is_disk_backed() const { return block_token_.has(); }
+    bool is_protected() const { return is_protected_; }
 
     void evict_self(page_cache_t *page_cache);
 
@@ -83,6 +85,7 @@ public:
 private:
     friend class page_ptr_t;
     friend class deferred_page_loader_t;
+    friend class evicter_t;
     static bool loader_is_loading(page_loader_t *loader);
     void add_snapshotter();
     void remove_snapshotter(page_cache_t *page_cache);
@@ -132,6 +135,11 @@ private:
 
     uint64_t access_time_;
 
+    // Whether the eviction policy has promoted the page out of its probation
+    // segment.  Only ever set under `cache_eviction_policy_t::two_q`, and reset when
+    // the page gets evicted.
+    bool is_protected_;
+
     // How many page_ptr_t's point at this page, expecting nothing to modify it,
     // other than themselves.
     size_t snapshot_refcount_;
@@ -146,11 +154,12 @@ private:
     // if loader_ is non-null:  unevictable_
     // else if waiters_ is non-empty: unevictable_
     // else if buf_ is null: evicted_ (and block_token_ is non-null)
+    // else if block_token_ is non-null and is_protected_: evictable_protected_
     // else if block_token_ is non-null: evictable_disk_backed_
     // else: evictable_unbacked_ (buf_ is non-null, block_token_ is null)
     //
-    // So, when loader_, waiters_, buf_, or block_token_ is touched, we might
-    // need to change this page's eviction bag.
+    // So, when loader_, waiters_, buf_, block_token_, or is_protected_ is touched, we
+    // might need to change this page's eviction bag.
     //
     // The logic above is implemented in evicter_t::correct_eviction_category.
     backindex_bag_index_t eviction_index_;
@@ -11,6 +11,7 @@
 #include "arch/runtime/runtime_utils.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/new_mutex.hpp"
+#include "concurrency/pmap.hpp"
 #include "buffer_cache/cache_balancer.hpp"
 #include "do_on_thread.hpp"
 #include "serializer/serializer.hpp"
@@ -98,7 +99,7 @@ void page_read_ahead_cb_t::offer_read_ahead_buf(
     buf_ptr_t local_buf = std::move(*buf);
 
     block_size_t block_size = block_size_t::undefined();
-    scoped_device_block_aligned_ptr_t<ser_buffer_t> ptr;
+    scoped_buf_slab_ptr_t<ser_buffer_t> ptr;
     local_buf.release(&block_size, &ptr);
 
     // We're going to reconstruct the buf_ptr_t on the other side of this do_on_thread
@@ -111,7 +112,7 @@ void page_read_ahead_cb_t::offer_read_ahead_buf(
                  std::bind(&page_cache_t::add_read_ahead_buf,
                            page_cache_,
                            block_id,
-                           copyable_unique_t<scoped_device_block_aligned_ptr_t<ser_buffer_t> >(std::move(ptr)),
+                           copyable_unique_t<scoped_buf_slab_ptr_t<ser_buffer_t> >(std::move(ptr)),
                            token));
 }
 
@@ -129,6 +130,81 @@ void page_read_ahead_cb_t::destroy_self() {
     delete this;
 }
 
+struct page_read_batcher_t::pending_read_t {
+    counted_t<block_token_t> token;
+    file_account_t *io_account;
+    buf_ptr_t buf;
+    cond_t done;
+};
+
+page_read_batcher_t::page_read_batcher_t(serializer_t *serializer)
+    : serializer_(serializer), read_pending_spawned_(false) { }
+
+page_read_batcher_t::~page_read_batcher_t() {
+    assert_thread();
+    drainer_.drain();
+    rassert(pending_reads_.empty());
+}
+
+buf_ptr_t page_read_batcher_t::block_read(const counted_t<block_token_t> &token,
+                                          file_account_t *io_account) {
+    assert_thread();
+    pending_read_t read;
+    read.token = token;
+    read.io_account = io_account;
+    pending_reads_.push_back(&read);
+
+    // Other reads can join the batch until `read_pending` gets to run.
+    if (!read_pending_spawned_) {
+        read_pending_spawned_ = true;
+        coro_t::spawn_sometime(std::bind(&page_read_batcher_t::read_pending,
+                                         this, drainer_.lock()));
+    }
+
+    read.done.wait();
+    return std::move(read.buf);
+}
+
+void page_read_batcher_t::read_pending(auto_drainer_t::lock_t) {
+    assert_thread();
+    read_pending_spawned_ = false;
+    std::vector<pending_read_t *> reads;
+    reads.swap(pending_reads_);
+
+    // Group the reads by I/O account, since every `block_reads` call uses one.
+    std::map<file_account_t *, std::vector<pending_read_t *> > reads_by_account;
+    for (pending_read_t *read : reads) {
+        reads_by_account[read->io_account].push_back(read);
+    }
+    std::vector<std::vector<pending_read_t *> > batches;
+    batches.reserve(reads_by_account.size());
+    for (auto &pair : reads_by_account) {
+        batches.push_back(std::move(pair.second));
+    }
+
+    pmap(batches.size(), [&](int64_t i) {
+        const std::vector<pending_read_t *> &batch = batches[i];
+        if (batch.size() == 1) {
+            batch[0]->buf = serializer_->block_read(batch[0]->token,
+                                                    batch[0]->io_account);
+            batch[0]->done.pulse();
+            return;
+        }
+
+        std::vector<counted_t<block_token_t> > tokens;
+        tokens.reserve(batch.size());
+        for (pending_read_t *read : batch) {
+            tokens.push_back(read->token);
+        }
+        std::vector<buf_ptr_t> bufs
+            = serializer_->block_reads(tokens, batch[0]->io_account);
+        for (size_t j = 0; j < batch.size(); ++j) {
+            batch[j]->buf = std::move(bufs[j]);
+            batch[j]->done.pulse();
+        }
+    });
+}
+
 void page_cache_t::consider_evicting_current_page(block_id_t block_id) {
     ASSERT_NO_CORO_WAITING;
     // We can't do anything until read-ahead is done, because it uses the existence
@@ -160,7 +236,7 @@ block_version_t page_cache_t::gen_block_version() {
 
 
 void page_cache_t::add_read_ahead_buf(block_id_t block_id,
-                                      scoped_device_block_aligned_ptr_t<ser_buffer_t> ptr,
+                                      scoped_buf_slab_ptr_t<ser_buffer_t> ptr,
                                       const counted_t<block_token_t> &token) {
     assert_thread();
 
@@ -232,6 +308,70 @@ void page_cache_t::read_ahead_cb_is_destroyed() {
     read_ahead_cb_existence_.reset();
 }
 
+std::vector<block_id_t> page_cache_t::hot_block_ids() {
+    assert_thread();
+    ASSERT_NO_CORO_WAITING;
+
+    // Access times can roll over, so we order the pages by how long ago they were
+    // accessed instead.
+    const uint64_t now = evicter_.current_access_time();
+    std::vector<std::pair<uint64_t, block_id_t> > pages;
+    pages.reserve(current_pages_.size());
+    for (const auto &pair : current_pages_) {
+        const current_page_t *cp = pair.second;
+        if (is_aux_block_id(pair.first) || cp->is_deleted() || !cp->page_.has()) {
+            continue;
+        }
+        const page_t *page = cp->page_.get_page_for_read();
+        if (page->is_loaded()) {
+            pages.push_back(std::make_pair(now - page->access_time(), pair.first));
+        }
+    }
+    std::sort(pages.begin(), pages.end());
+
+    std::vector<block_id_t> ret;
+    ret.reserve(pages.size());
+    for (const auto &pair : pages) {
+        ret.push_back(pair.second);
+    }
+    return ret;
+}
+
+bool page_cache_t::load_block_for_warm_up(block_id_t block_id,
+                                          cache_account_t *account) {
+    assert_thread();
+    if (is_aux_block_id(block_id)
+        || recency_for_block_id(block_id) == repli_timestamp_t::invalid) {
+        return false;
+    }
+
+    auto page_it = current_pages_.find(block_id);
+    if (page_it != current_pages_.end()) {
+        const current_page_t *cp = page_it->second;
+        if (cp->is_deleted()) {
+            return false;
+        }
+        if (cp->page_.has()) {
+            const page_t *page = cp->page_.get_page_for_read();
+            if (page->is_loaded() || page->is_loading()) {
+                return true;
+            }
+        }
+    }
+
+    current_page_acq_t acq(this, block_id, read_access_t::read);
+    acq.read_acq_signal()->wait();
+    // A write transaction that was ahead of us might have deleted the block.  Our
+    // acquisition keeps the current_page_t alive.
+    if (current_pages_.at(block_id)->is_deleted()) {
+        return false;
+    }
+    page_acq_t page_acq;
+    page_acq.init(acq.current_page_for_read(account), this, account);
+    page_acq.buf_ready_signal()->wait();
+    return true;
+}
+
 class page_cache_index_write_sink_t {
 public:
     // When sink is acquired, we get in line for mutex_ right away and release the
@@ -266,6 +406,7 @@ page_cache_t::page_cache_t(serializer_t *_serializer,
         default_reads_account_.init(_serializer->home_thread(),
                                     _serializer->make_io_account(CACHE_READS_IO_PRIORITY));
         index_write_sink_.init(new page_cache_index_write_sink_t);
+        read_batcher_.init(new page_read_batcher_t(_serializer));
         recencies_ = _serializer->get_all_recencies();
     }
 
@@ -310,6 +451,7 @@ page_cache_t::~page_cache_t() {
         // time.
         default_reads_account_.reset();
         index_write_sink_.reset();
+        read_batcher_.reset();
     }
 }
 
@@ -440,7 +582,7 @@ current_page_t *page_cache_t::internal_page_for_new_chosen(block_id_t block_id)
     return inserted_page.first->second;
 }
 
-cache_account_t page_cache_t::create_cache_account(int priority) {
+cache_account_t page_cache_t::create_cache_account(int priority, io_class_t io_class) {
     // We assume that a priority of 100 means that the transaction should have the
     // same priority as all the non-accounted transactions together. Not sure if this
     // makes sense.
@@ -459,10 +601,11 @@ cache_account_t page_cache_t::create_cache_account(int priority) {
         // what the file account API is right now, deep in the I/O layer.
         on_thread_t thread_switcher(serializer_->home_thread());
         io_account = serializer_->make_io_account(io_priority,
-                                                  outstanding_requests_limit);
+                                                  outstanding_requests_limit,
+                                                  io_class);
     }
 
-    return cache_account_t(serializer_->home_thread(), io_account);
+    return cache_account_t(serializer_->home_thread(), io_account, io_class);
 }
 
 
@@ -514,6 +657,7 @@ void current_page_acq_t::init(page_txn_t *txn,
         dirtied_page_ = false;
         touched_page_ = false;
 
+        page_cache_->evicter().published_pages().unpublish_for_write(block_id_);
         the_txn_->add_acquirer(this);
         current_page_->add_acquirer(this);
     }
@@ -532,6 +676,7 @@ void current_page_acq_t::init(page_txn_t *txn,
     dirtied_page_ = false;
     touched_page_ = false;
 
+    page_cache_->evicter().published_pages().unpublish_for_write(block_id_);
     the_txn_->add_acquirer(this);
     current_page_->add_acquirer(this);
 }
@@ -598,6 +743,27 @@ void current_page_acq_t::declare_snapshotted() {
     }
 }
 
+void current_page_acq_t::maybe_publish(const void *data, block_size_t block_size) {
+    assert_thread();
+    published_pages_t *published_pages = &page_cache_->evicter().published_pages();
+    if (published_pages->capacity() == 0
+        || access_ != access_t::read
+        || declared_snapshotted_
+        || current_page_ == nullptr) {
+        return;
+    }
+    // A write acquirer unpublished the block when it showed up.  It mustn't get
+    // published again before the write acquirer is done with it.
+    for (current_page_acq_t *acq = current_page_->acquirers_.head();
+         acq != nullptr;
+         acq = current_page_->acquirers_.next(acq)) {
+        if (acq->access_ == access_t::write) {
+            return;
+        }
+    }
+    published_pages->publish(block_id_, data, block_size);
+}
+
 signal_t *current_page_acq_t::read_acq_signal() {
     assert_thread();
     return &read_cond_;
@@ -1516,7 +1682,23 @@ flush_prep_t page_cache_t::prep_flush_changes(
     flush_prep_t prep;
     prep.reserve(changes.size());
 
+    // We write the blocks in the order of their ids.  The free list hands out new ids
+    // in increasing order, so blocks that were created together (like the nodes of a
+    // subtree that grew through a run of inserts) end up next to each other on disk.
+    // That keeps them in the same extents for read-ahead, and lets those extents turn
+    // into garbage together when the blocks get rewritten.
+    std::vector<std::unordered_map<block_id_t, block_change_t>::const_iterator> sorted;
+    sorted.reserve(changes.size());
     for (auto it = changes.begin(); it != changes.end(); ++it) {
+        sorted.push_back(it);
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](const std::unordered_map<block_id_t, block_change_t>::const_iterator &x,
+                 const std::unordered_map<block_id_t, block_change_t>::const_iterator &y) {
+                  return x->first < y->first;
+              });
+
+    for (const auto &it : sorted) {
         if (it->second.modified) {
             if (!it->second.page.has()) {
                 // The block is deleted.
@@ -1580,8 +1762,22 @@ void vec_move_append(std::vector<T> *onto, std::vector<T> &&from) {
     }
 }
 
-size_t decent_sized_write(const std::vector<buf_write_info_t> &write_infos, size_t pos) {
-    const size_t bound = 4 * MEGABYTE;
+// How much we try to hand to the serializer in one `block_writes` call.  The
+// serializer writes each call sequentially, and other page caches sharing it can only
+// get their blocks in between two calls.  So we use the largest whole number of extents
+// that fits in `WRITE_BACK_CHUNK_TARGET` (or one extent, if they're bigger than
+// that): a flush then shares at most two extents with the writes of other caches per
+// chunk, no matter how the extent size is configured.
+const uint64_t WRITE_BACK_CHUNK_TARGET = 4 * MEGABYTE;
+
+size_t write_back_chunk_bytes(uint64_t extent_size) {
+    rassert(extent_size > 0);
+    return std::max<uint64_t>(1, WRITE_BACK_CHUNK_TARGET / extent_size) * extent_size;
+}
+
+size_t decent_sized_write(const std::vector<buf_write_info_t> &write_infos,
+                          size_t pos,
+                          size_t bound) {
     const size_t n = write_infos.size();
     size_t acc = 0;
     while (pos < n) {
@@ -1609,6 +1805,8 @@ std::vector<counted_t<block_token_t>> page_cache_t::do_write_blocks(
         ticks_t soft_deadline) {
 
     size_t pos = 0;
+    const size_t chunk_bytes
+        = write_back_chunk_bytes(page_cache->serializer_->extent_size());
 
     std::vector<counted_t<block_token_t> > tokens;
 
@@ -1617,7 +1815,7 @@ std::vector<counted_t<block_token_t>> page_cache_t::do_write_blocks(
 
         ticks_t before = get_ticks();
 
-        size_t end_pos = decent_sized_write(write_infos, pos);
+        size_t end_pos = decent_sized_write(write_infos, pos, chunk_bytes);
 
         iocallback_cond_t blocks_written_cb;
         std::vector<counted_t<block_token_t> > tmp
@@ -9,6 +9,7 @@
 #include <utility>
 #include <vector>
 
+#include "arch/types.hpp"
 #include "buffer_cache/block_version.hpp"
 #include "buffer_cache/cache_account.hpp"
 #include "buffer_cache/evicter.hpp"
@@ -241,6 +242,11 @@ public:
 
     void mark_deleted();
 
+    // Publishes a copy of `data`, the page we read, for lock-free reads from other
+    // threads.  Does nothing unless we're a read acquirer that sees the current
+    // version of the block and no write acquirer is waiting for it.
+    void maybe_publish(const void *data, block_size_t block_size);
+
     block_version_t block_version() const {
         assert_thread();
         return block_version_;
@@ -329,6 +335,33 @@ private:
     DISABLE_COPYING(page_read_ahead_cb_t);
 };
 
+// This object lives on the serializer thread.  Page loads that reach the serializer
+// thread at about the same time (such as those of the children of a node, during a
+// range scan or a backfill) get passed to the serializer as a single `block_reads`
+// call, so that blocks which are next to each other on disk get read together.
+class page_read_batcher_t : public home_thread_mixin_t {
+public:
+    explicit page_read_batcher_t(serializer_t *serializer);
+    ~page_read_batcher_t();
+
+    // Like `serializer_t::block_read`.  Blocks the coroutine.
+    buf_ptr_t block_read(const counted_t<block_token_t> &token,
+                         file_account_t *io_account);
+
+private:
+    struct pending_read_t;
+
+    void read_pending(auto_drainer_t::lock_t lock);
+
+    serializer_t *const serializer_;
+    std::vector<pending_read_t *> pending_reads_;
+    bool read_pending_spawned_;
+
+    auto_drainer_t drainer_;
+
+    DISABLE_COPYING(page_read_batcher_t);
+};
+
 class throttler_acq_t {
 public:
     explicit throttler_acq_t(write_durability_t durability,
@@ -466,7 +499,7 @@ public:
 
     max_block_size_t max_block_size() const { return max_block_size_; }
 
-    cache_account_t create_cache_account(int priority);
+    cache_account_t create_cache_account(int priority, io_class_t io_class);
 
     cache_account_t *default_reads_account() {
         return &default_reads_account_;
@@ -482,10 +515,21 @@ public:
 
     void have_read_ahead_cb_destroyed();
 
+    // Returns the ids of the blocks that are loaded in memory, most recently accessed
+    // first.  Used by `cache_warm_up_t` to record the cache's hot set.
+    std::vector<block_id_t> hot_block_ids();
+
+    // Loads the block into memory using `account`, unless it's in memory (or being
+    // loaded) already, and waits until it's loaded.  Returns false if the block
+    // doesn't exist.
+    bool load_block_for_warm_up(block_id_t block_id, cache_account_t *account);
+
     evicter_t &evicter() { return evicter_; }
 
     auto_drainer_t::lock_t drainer_lock() { return drainer_->lock(); }
     serializer_t *serializer() { return serializer_; }
+    // Must only be used on the serializer thread.
+    page_read_batcher_t *read_batcher() { return read_batcher_.get(); }
 
 private:
     void help_take_snapshotted_dirtied_page(
@@ -493,7 +537,7 @@ private:
 
     friend class page_read_ahead_cb_t;
     void add_read_ahead_buf(block_id_t block_id,
-                            scoped_device_block_aligned_ptr_t<ser_buffer_t> ptr,
+                            scoped_buf_slab_ptr_t<ser_buffer_t> ptr,
                             const counted_t<block_token_t> &token);
 
     void read_ahead_cb_is_destroyed();
@@ -614,6 +658,9 @@ private:
 
     scoped_ptr_t<page_cache_index_write_sink_t> index_write_sink_;
 
+    // Lives on the serializer thread, like index_write_sink_.
+    scoped_ptr_t<page_read_batcher_t> read_batcher_;
+
     serializer_t *serializer_;
     segmented_vector_t<repli_timestamp_t> recencies_;
 
@@ -0,0 +1,288 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "buffer_cache/published_pages.hpp"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "arch/runtime/runtime.hpp"
+
+namespace alt {
+
+// A reader slot holds this while the thread has no reader.
+const uint64_t NO_READER_EPOCH = UINT64_MAX;
+
+const size_t PUBLISHED_PAGES_INITIAL_BUCKETS = 64;
+
+// We only go looking for retired copies that can be freed once there's this many.
+const size_t PUBLISHED_PAGES_RECLAIM_BATCH = 32;
+
+// How many stale queue entries we tolerate regardless of the number of copies.
+const size_t PUBLISHED_PAGES_QUEUE_SLACK = 64;
+
+struct published_pages_t::node_t {
+    node_t(block_id_t _block_id, buf_ptr_t &&_buf, uint64_t _sequence)
+        : block_id(_block_id), next(nullptr), buf(std::move(_buf)),
+          sequence(_sequence) { }
+
+    const block_id_t block_id;
+    std::atomic<node_t *> next;
+    const buf_ptr_t buf;
+    const uint64_t sequence;
+};
+
+struct published_pages_t::table_t {
+    explicit table_t(size_t _num_buckets)
+        : num_buckets(_num_buckets), buckets(_num_buckets) {
+        for (size_t i = 0; i < num_buckets; ++i) {
+            buckets[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    const size_t num_buckets;
+    scoped_array_t<std::atomic<node_t *> > buckets;
+};
+
+// What a published copy takes up, with a rough guess at the node and queue entry.
+uint64_t published_copy_usage(const buf_ptr_t &buf) {
+    return buf.aligned_block_size() + 64;
+}
+
+published_pages_t::published_pages_t()
+    : capacity_(0),
+      enabled_(false),
+      size_(0),
+      count_(0),
+      table_(new table_t(PUBLISHED_PAGES_INITIAL_BUCKETS)),
+      sequence_counter_(0),
+      write_sequence_(0),
+      epoch_(0),
+      reader_epochs_(get_num_threads()),
+      lookups_answered_(0),
+      lookups_missed_(0) {
+    for (size_t i = 0; i < reader_epochs_.size(); ++i) {
+        reader_epochs_[i].value.store(NO_READER_EPOCH, std::memory_order_relaxed);
+    }
+}
+
+published_pages_t::~published_pages_t() {
+    assert_thread();
+    for (size_t i = 0; i < reader_epochs_.size(); ++i) {
+        guarantee(reader_epochs_[i].value.load() == NO_READER_EPOCH);
+    }
+    for (const retired_t &retired : retired_) {
+        delete retired.node;
+        delete retired.table;
+    }
+    table_t *table = table_.load();
+    for (size_t i = 0; i < table->num_buckets; ++i) {
+        node_t *node = table->buckets[i].load();
+        while (node != nullptr) {
+            node_t *next = node->next.load();
+            delete node;
+            node = next;
+        }
+    }
+    delete table;
+}
+
+published_pages_t::reader_t::reader_t(published_pages_t *parent)
+    : parent_(parent),
+      epoch_slot_(&parent->reader_epochs_[get_thread_id().threadnum].value)
+#ifndef NDEBUG
+      , no_coro_waiting_(__FILE__, __LINE__)
+#endif
+{
+    rassert(epoch_slot_->load(std::memory_order_relaxed) == NO_READER_EPOCH,
+            "Nested published_pages_t::reader_t");
+    // Announce the reader before looking at anything, so that nothing it can see
+    // gets freed underneath it.  The fence pairs with the one in `reclaim()`.
+    epoch_slot_->store(parent_->epoch_.load(), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    write_sequence_ = parent_->write_sequence_.load(std::memory_order_acquire);
+}
+
+published_pages_t::reader_t::~reader_t() {
+    epoch_slot_->store(NO_READER_EPOCH, std::memory_order_release);
+}
+
+const void *published_pages_t::reader_t::find(block_id_t block_id,
+                                              block_size_t *block_size_out) const {
+    const table_t *table = parent_->table_.load(std::memory_order_acquire);
+    const node_t *node
+        = table->buckets[bucket_of(block_id, table->num_buckets)].load(
+            std::memory_order_acquire);
+    for (; node != nullptr; node = node->next.load(std::memory_order_acquire)) {
+        if (node->block_id == block_id) {
+            *block_size_out = node->buf.block_size();
+            return node->buf.cache_data();
+        }
+    }
+    return nullptr;
+}
+
+bool published_pages_t::reader_t::validate() const {
+    return parent_->write_sequence_.load(std::memory_order_acquire)
+        == write_sequence_;
+}
+
+size_t published_pages_t::bucket_of(block_id_t block_id, size_t num_buckets) {
+    // `num_buckets` is a power of two, and block ids tend to be dense, so we mix
+    // the bits a little.
+    return ((block_id * 0x9E3779B97F4A7C15ull) >> 16) & (num_buckets - 1);
+}
+
+published_pages_t::node_t *published_pages_t::find_on_home_thread(
+        block_id_t block_id) const {
+    const table_t *table = table_.load(std::memory_order_relaxed);
+    node_t *node = table->buckets[bucket_of(block_id, table->num_buckets)].load(
+        std::memory_order_relaxed);
+    while (node != nullptr && node->block_id != block_id) {
+        node = node->next.load(std::memory_order_relaxed);
+    }
+    return node;
+}
+
+void published_pages_t::set_capacity(uint64_t capacity) {
+    assert_thread();
+    capacity_ = capacity;
+    enabled_.store(capacity != 0, std::memory_order_relaxed);
+    trim();
+}
+
+bool published_pages_t::is_published(block_id_t block_id) const {
+    assert_thread();
+    return find_on_home_thread(block_id) != nullptr;
+}
+
+void published_pages_t::publish(block_id_t block_id,
+                                const void *cache_data,
+                                block_size_t block_size) {
+    assert_thread();
+    if (capacity_ == 0 || find_on_home_thread(block_id) != nullptr) {
+        return;
+    }
+    buf_ptr_t buf = buf_ptr_t::alloc_uninitialized(block_size);
+    memcpy(buf.cache_data(), cache_data, block_size.value());
+    buf.fill_padding_zero();
+    const uint64_t usage = published_copy_usage(buf);
+    if (usage > capacity_) {
+        return;
+    }
+
+    node_t *node = new node_t(block_id, std::move(buf), ++sequence_counter_);
+    table_t *table = table_.load(std::memory_order_relaxed);
+    std::atomic<node_t *> *bucket
+        = &table->buckets[bucket_of(block_id, table->num_buckets)];
+    node->next.store(bucket->load(std::memory_order_relaxed),
+                     std::memory_order_relaxed);
+    bucket->store(node, std::memory_order_release);
+
+    ++count_;
+    size_ += usage;
+    queue_.push_back(std::make_pair(block_id, node->sequence));
+    if (count_ > table->num_buckets) {
+        grow();
+    }
+    trim();
+}
+
+void published_pages_t::unpublish_for_write(block_id_t block_id) {
+    assert_thread();
+    if (capacity_ == 0) {
+        return;
+    }
+    unlink(block_id, 0);
+    // Only after the copy is unlinked, so that a reader that sees the new write
+    // sequence can't find the copy anymore.
+    write_sequence_.fetch_add(1);
+}
+
+// Unlinks the block's copy, if it has one, and if `sequence` is zero or matches it.
+void published_pages_t::unlink(block_id_t block_id, uint64_t sequence) {
+    table_t *table = table_.load(std::memory_order_relaxed);
+    std::atomic<node_t *> *link
+        = &table->buckets[bucket_of(block_id, table->num_buckets)];
+    node_t *node = link->load(std::memory_order_relaxed);
+    while (node != nullptr && node->block_id != block_id) {
+        link = &node->next;
+        node = link->load(std::memory_order_relaxed);
+    }
+    if (node == nullptr || (sequence != 0 && node->sequence != sequence)) {
+        return;
+    }
+    // Readers that are at `node` right now can still follow its `next` pointer.
+    link->store(node->next.load(std::memory_order_relaxed), std::memory_order_release);
+    --count_;
+    size_ -= published_copy_usage(node->buf);
+    retire(node, nullptr);
+}
+
+void published_pages_t::grow() {
+    // We move the nodes into the new table's chains, which changes their `next`
+    // pointers under the feet of readers that are walking the old table.  Such a
+    // reader can jump to a chain of the new table and miss the block it's looking
+    // for, but that only makes it fall back to the normal read path.
+    table_t *old_table = table_.load(std::memory_order_relaxed);
+    table_t *new_table = new table_t(old_table->num_buckets * 2);
+    for (size_t i = 0; i < old_table->num_buckets; ++i) {
+        node_t *node = old_table->buckets[i].load(std::memory_order_relaxed);
+        while (node != nullptr) {
+            node_t *next = node->next.load(std::memory_order_relaxed);
+            std::atomic<node_t *> *bucket
+                = &new_table->buckets[bucket_of(node->block_id,
+                                                new_table->num_buckets)];
+            node->next.store(bucket->load(std::memory_order_relaxed),
+                             std::memory_order_release);
+            bucket->store(node, std::memory_order_release);
+            node = next;
+        }
+    }
+    table_.store(new_table, std::memory_order_release);
+    retire(nullptr, old_table);
+}
+
+void published_pages_t::trim() {
+    while (size_ > capacity_) {
+        guarantee(!queue_.empty());
+        unlink(queue_.front().first, queue_.front().second);
+        queue_.pop_front();
+    }
+    if (queue_.size() > 2 * count_ + PUBLISHED_PAGES_QUEUE_SLACK) {
+        std::deque<std::pair<block_id_t, uint64_t> > live;
+        for (const auto &pair : queue_) {
+            const node_t *node = find_on_home_thread(pair.first);
+            if (node != nullptr && node->sequence == pair.second) {
+                live.push_back(pair);
+            }
+        }
+        queue_ = std::move(live);
+    }
+}
+
+void published_pages_t::retire(node_t *node, table_t *table) {
+    // Readers that start after the increment can't see what we just unlinked.
+    retired_.push_back(retired_t{epoch_.fetch_add(1), node, table});
+    if (retired_.size() >= PUBLISHED_PAGES_RECLAIM_BATCH) {
+        reclaim();
+    }
+}
+
+void published_pages_t::reclaim() {
+    // Pairs with the fence in the `reader_t` constructor: either we see the reader's
+    // epoch, or the reader sees that the copies were unlinked.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t oldest_reader_epoch = NO_READER_EPOCH;
+    for (size_t i = 0; i < reader_epochs_.size(); ++i) {
+        oldest_reader_epoch = std::min(
+            oldest_reader_epoch,
+            reader_epochs_[i].value.load(std::memory_order_relaxed));
+    }
+    while (!retired_.empty() && retired_.front().epoch < oldest_reader_epoch) {
+        delete retired_.front().node;
+        delete retired_.front().table;
+        retired_.pop_front();
+    }
+}
+
+}  // namespace alt
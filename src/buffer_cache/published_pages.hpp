@@ -0,0 +1,161 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef BUFFER_CACHE_PUBLISHED_PAGES_HPP_
+#define BUFFER_CACHE_PUBLISHED_PAGES_HPP_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <deque>
+#include <utility>
+
+#include "arch/runtime/runtime_utils.hpp"
+#include "concurrency/cache_line_padded.hpp"
+#include "containers/scoped.hpp"
+#include "serializer/buf_ptr.hpp"
+#include "serializer/types.hpp"
+#include "threading.hpp"
+
+namespace alt {
+
+// Copies of pages that threads other than the cache's home thread can read without
+// taking any locks or switching threads.
+//
+// The home thread publishes a copy of a page when a read acquirer gets the page
+// and no write acquirer is waiting for it, and unpublishes the copy as soon as a
+// write acquirer for the block shows up.  So a published copy always has the
+// current contents of its block.  Readers look copies up inside a `reader_t`, on
+// any thread of the thread pool.  Unpublished copies are freed once no reader that
+// could have seen them is left (epoch-based reclamation), so readers must not block
+// while they hold a `reader_t`.
+//
+// A reader that looks at several pages (such as a btree traversal) must check
+// `reader_t::validate()` after it's done.  It returns false if any block got write
+// acquired since the reader started, in which case the pages the reader saw
+// might not belong to the same version of the tree.
+class published_pages_t : public home_thread_mixin_debug_only_t {
+public:
+    published_pages_t();
+    ~published_pages_t();
+
+    class reader_t {
+    public:
+        explicit reader_t(published_pages_t *parent);
+        ~reader_t();
+
+        // Returns the cache data of the block's published copy, or null if the block
+        // isn't published.
+        const void *find(block_id_t block_id, block_size_t *block_size_out) const;
+
+        // Returns true if no block got write acquired since the reader started.
+        MUST_USE bool validate() const;
+
+    private:
+        published_pages_t *const parent_;
+        std::atomic<uint64_t> *const epoch_slot_;
+        uint64_t write_sequence_;
+#ifndef NDEBUG
+        assert_no_coro_waiting_t no_coro_waiting_;
+#endif
+
+        DISABLE_COPYING(reader_t);
+    };
+
+    // The memory that published copies may use.  Zero disables publishing.
+    void set_capacity(uint64_t capacity);
+    // Whether publishing is enabled.  Can be called on any thread, so that readers
+    // don't bother looking for copies when there can't be any.
+    bool enabled() const {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+    uint64_t capacity() const {
+        assert_thread();
+        return capacity_;
+    }
+    // The memory the published copies use right now.
+    uint64_t size() const {
+        assert_thread();
+        return size_;
+    }
+    uint64_t num_pages() const {
+        assert_thread();
+        return count_;
+    }
+    // Unlinked copies that can't be freed yet, because readers might still be
+    // looking at them.
+    size_t num_retired() const {
+        assert_thread();
+        return retired_.size();
+    }
+
+    bool is_published(block_id_t block_id) const;
+
+    // Publishes a copy of the block, if there is room.  The caller makes sure that
+    // `cache_data` is the block's current contents and that nobody is waiting to
+    // write acquire it.
+    void publish(block_id_t block_id, const void *cache_data, block_size_t block_size);
+
+    // Called when the block gets write acquired, before it can change.
+    void unpublish_for_write(block_id_t block_id);
+
+    // Counts a lookup that readers could (or couldn't) answer from published copies.
+    // Can be called on any thread.
+    void note_lookup(bool answered) {
+        (answered ? lookups_answered_ : lookups_missed_).fetch_add(
+            1, std::memory_order_relaxed);
+    }
+    uint64_t lookups_answered() const {
+        return lookups_answered_.load(std::memory_order_relaxed);
+    }
+    uint64_t lookups_missed() const {
+        return lookups_missed_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct node_t;
+    struct table_t;
+    struct retired_t {
+        uint64_t epoch;
+        node_t *node;
+        table_t *table;
+    };
+
+    static size_t bucket_of(block_id_t block_id, size_t num_buckets);
+    node_t *find_on_home_thread(block_id_t block_id) const;
+    void unlink(block_id_t block_id, uint64_t sequence);
+    void grow();
+    void trim();
+    void retire(node_t *node, table_t *table);
+    void reclaim();
+
+    uint64_t capacity_;
+    std::atomic<bool> enabled_;
+    uint64_t size_;
+    size_t count_;
+
+    std::atomic<table_t *> table_;
+
+    // The published copies in the order they got published, so that we can drop the
+    // oldest ones when we're over capacity.  Stale entries are told apart by their
+    // sequence numbers, as in the evicter's ghost list.
+    std::deque<std::pair<block_id_t, uint64_t> > queue_;
+    uint64_t sequence_counter_;
+
+    // Incremented every time a block gets write acquired.
+    std::atomic<uint64_t> write_sequence_;
+
+    // The reclamation epoch, and the epoch each thread's current reader (if any)
+    // started in.
+    std::atomic<uint64_t> epoch_;
+    scoped_array_t<cache_line_padded_t<std::atomic<uint64_t> > > reader_epochs_;
+    // Unlinked copies and replaced tables that readers might still be looking at.
+    std::deque<retired_t> retired_;
+
+    std::atomic<uint64_t> lookups_answered_;
+    std::atomic<uint64_t> lookups_missed_;
+
+    DISABLE_COPYING(published_pages_t);
+};
+
+}  // namespace alt
+
+#endif  // BUFFER_CACHE_PUBLISHED_PAGES_HPP_
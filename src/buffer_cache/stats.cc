@@ -1,6 +1,7 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "buffer_cache/stats.hpp"
 
+#include "buffer_cache/types.hpp"
 #include "perfmon/perfmon.hpp"
 
 alt_cache_stats_t::alt_cache_stats_t(alt::page_cache_t *_page_cache,
@@ -8,13 +9,26 @@ alt_cache_stats_t::alt_cache_stats_t(alt::page_cache_t *_page_cache,
     page_cache(_page_cache),
     cache_collection(),
     cache_membership(parent, &cache_collection, "cache"),
-    in_use_bytes(this),
+    in_use_bytes(this, &alt::evicter_t::in_memory_size),
     in_use_bytes_membership(&cache_collection,
                             &in_use_bytes, "in_use_bytes"),
+    limit_bytes(this, &alt::evicter_t::memory_limit),
+    limit_bytes_membership(&cache_collection,
+                           &limit_bytes, "limit_bytes"),
+    eviction(this),
+    eviction_membership(&cache_collection, &eviction, "eviction"),
+    compressed_tier(this),
+    compressed_tier_membership(&cache_collection, &compressed_tier,
+                               "compressed_tier"),
+    published_pages(this),
+    published_pages_membership(&cache_collection, &published_pages,
+                               "published_pages"),
     cache_collection_membership(&cache_collection) { }
 
-alt_cache_stats_t::perfmon_value_t::perfmon_value_t(alt_cache_stats_t *_parent) :
-    parent(_parent) { }
+alt_cache_stats_t::perfmon_value_t::perfmon_value_t(
+        alt_cache_stats_t *_parent,
+        uint64_t (alt::evicter_t::*_getter)() const) :
+    parent(_parent), getter(_getter) { }
 
 void *alt_cache_stats_t::perfmon_value_t::begin_stats() {
     return new uint64_t;
@@ -23,7 +37,7 @@ void *alt_cache_stats_t::perfmon_value_t::begin_stats() {
 void alt_cache_stats_t::perfmon_value_t::visit_stats(void *ptr) {
     if (get_thread_id() == parent->home_thread()) {
         uint64_t *value = reinterpret_cast<uint64_t *>(ptr);
-        *value = parent->page_cache->evicter().in_memory_size();
+        *value = (parent->page_cache->evicter().*getter)();
     }
 }
 
@@ -33,3 +47,164 @@ ql::datum_t alt_cache_stats_t::perfmon_value_t::end_stats(void *ptr) {
     delete value;
     return res;
 }
+
+struct alt_cache_stats_t::eviction_stats_t::value_t {
+    value_t()
+        : policy(cache_eviction_policy_t::sampled_lru), hits(0), misses(0),
+          pages_evicted(0), eviction_nanos(0) { }
+    cache_eviction_policy_t policy;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t pages_evicted;
+    uint64_t eviction_nanos;
+};
+
+alt_cache_stats_t::eviction_stats_t::eviction_stats_t(alt_cache_stats_t *_parent) :
+    parent(_parent) { }
+
+void *alt_cache_stats_t::eviction_stats_t::begin_stats() {
+    return new value_t;
+}
+
+void alt_cache_stats_t::eviction_stats_t::visit_stats(void *ptr) {
+    if (get_thread_id() == parent->home_thread()) {
+        value_t *value = reinterpret_cast<value_t *>(ptr);
+        const alt::evicter_t &evicter = parent->page_cache->evicter();
+        value->policy = evicter.eviction_policy();
+        value->hits = evicter.page_hits();
+        value->misses = evicter.page_misses();
+        value->pages_evicted = evicter.pages_evicted();
+        value->eviction_nanos = evicter.eviction_nanos();
+    }
+}
+
+ql::datum_t alt_cache_stats_t::eviction_stats_t::end_stats(void *ptr) {
+    value_t *value = reinterpret_cast<value_t *>(ptr);
+    ql::datum_object_builder_t builder;
+    builder.overwrite("policy",
+                      ql::datum_t(cache_eviction_policy_name(value->policy)));
+    builder.overwrite("hits", ql::datum_t(static_cast<double>(value->hits)));
+    builder.overwrite("misses", ql::datum_t(static_cast<double>(value->misses)));
+    const uint64_t accesses = value->hits + value->misses;
+    if (accesses > 0) {
+        builder.overwrite("hit_ratio", ql::datum_t(
+            static_cast<double>(value->hits) / accesses));
+        builder.overwrite("miss_ratio", ql::datum_t(
+            static_cast<double>(value->misses) / accesses));
+    } else {
+        builder.overwrite("hit_ratio", ql::datum_t::null());
+        builder.overwrite("miss_ratio", ql::datum_t::null());
+    }
+    builder.overwrite("pages_evicted",
+                      ql::datum_t(static_cast<double>(value->pages_evicted)));
+    builder.overwrite("eviction_secs", ql::datum_t(
+        static_cast<double>(value->eviction_nanos) / BILLION));
+    delete value;
+    return std::move(builder).to_datum();
+}
+
+struct alt_cache_stats_t::compressed_tier_stats_t::value_t {
+    value_t()
+        : capacity_bytes(0), in_use_bytes(0), pages(0), uncompressed_bytes(0),
+          compressed_bytes(0), hits(0), misses(0) { }
+    uint64_t capacity_bytes;
+    uint64_t in_use_bytes;
+    uint64_t pages;
+    uint64_t uncompressed_bytes;
+    uint64_t compressed_bytes;
+    uint64_t hits;
+    uint64_t misses;
+};
+
+alt_cache_stats_t::compressed_tier_stats_t::compressed_tier_stats_t(
+        alt_cache_stats_t *_parent) :
+    parent(_parent) { }
+
+void *alt_cache_stats_t::compressed_tier_stats_t::begin_stats() {
+    return new value_t;
+}
+
+void alt_cache_stats_t::compressed_tier_stats_t::visit_stats(void *ptr) {
+    if (get_thread_id() == parent->home_thread()) {
+        value_t *value = reinterpret_cast<value_t *>(ptr);
+        const alt::compressed_page_tier_t &tier
+            = parent->page_cache->evicter().compressed_tier();
+        value->capacity_bytes = tier.capacity();
+        value->in_use_bytes = tier.size();
+        value->pages = tier.num_pages();
+        value->uncompressed_bytes = tier.uncompressed_bytes();
+        value->compressed_bytes = tier.compressed_bytes();
+        value->hits = tier.hits();
+        value->misses = tier.misses();
+    }
+}
+
+ql::datum_t alt_cache_stats_t::compressed_tier_stats_t::end_stats(void *ptr) {
+    value_t *value = reinterpret_cast<value_t *>(ptr);
+    ql::datum_object_builder_t builder;
+    builder.overwrite("capacity_bytes",
+                      ql::datum_t(static_cast<double>(value->capacity_bytes)));
+    builder.overwrite("in_use_bytes",
+                      ql::datum_t(static_cast<double>(value->in_use_bytes)));
+    builder.overwrite("pages", ql::datum_t(static_cast<double>(value->pages)));
+    builder.overwrite("hits", ql::datum_t(static_cast<double>(value->hits)));
+    builder.overwrite("misses", ql::datum_t(static_cast<double>(value->misses)));
+    const uint64_t lookups = value->hits + value->misses;
+    builder.overwrite("hit_ratio", lookups > 0
+        ? ql::datum_t(static_cast<double>(value->hits) / lookups)
+        : ql::datum_t::null());
+    builder.overwrite("compression_ratio", value->compressed_bytes > 0
+        ? ql::datum_t(static_cast<double>(value->uncompressed_bytes)
+                      / value->compressed_bytes)
+        : ql::datum_t::null());
+    delete value;
+    return std::move(builder).to_datum();
+}
+
+struct alt_cache_stats_t::published_pages_stats_t::value_t {
+    value_t()
+        : capacity_bytes(0), in_use_bytes(0), pages(0), lookups_answered(0),
+          lookups_missed(0) { }
+    uint64_t capacity_bytes;
+    uint64_t in_use_bytes;
+    uint64_t pages;
+    uint64_t lookups_answered;
+    uint64_t lookups_missed;
+};
+
+alt_cache_stats_t::published_pages_stats_t::published_pages_stats_t(
+        alt_cache_stats_t *_parent) :
+    parent(_parent) { }
+
+void *alt_cache_stats_t::published_pages_stats_t::begin_stats() {
+    return new value_t;
+}
+
+void alt_cache_stats_t::published_pages_stats_t::visit_stats(void *ptr) {
+    if (get_thread_id() == parent->home_thread()) {
+        value_t *value = reinterpret_cast<value_t *>(ptr);
+        const alt::published_pages_t &published_pages
+            = parent->page_cache->evicter().published_pages();
+        value->capacity_bytes = published_pages.capacity();
+        value->in_use_bytes = published_pages.size();
+        value->pages = published_pages.num_pages();
+        value->lookups_answered = published_pages.lookups_answered();
+        value->lookups_missed = published_pages.lookups_missed();
+    }
+}
+
+ql::datum_t alt_cache_stats_t::published_pages_stats_t::end_stats(void *ptr) {
+    value_t *value = reinterpret_cast<value_t *>(ptr);
+    ql::datum_object_builder_t builder;
+    builder.overwrite("capacity_bytes",
+                      ql::datum_t(static_cast<double>(value->capacity_bytes)));
+    builder.overwrite("in_use_bytes",
+                      ql::datum_t(static_cast<double>(value->in_use_bytes)));
+    builder.overwrite("pages", ql::datum_t(static_cast<double>(value->pages)));
+    builder.overwrite("lookups_answered",
+                      ql::datum_t(static_cast<double>(value->lookups_answered)));
+    builder.overwrite("lookups_missed",
+                      ql::datum_t(static_cast<double>(value->lookups_missed)));
+    delete value;
+    return std::move(builder).to_datum();
+}
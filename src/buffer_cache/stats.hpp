@@ -15,19 +15,71 @@ public:
     perfmon_collection_t cache_collection;
     perfmon_membership_t cache_membership;
 
+    // Reports a value that `getter` reads from the evicter.
     class perfmon_value_t : public perfmon_t {
     public:
-        explicit perfmon_value_t(alt_cache_stats_t *_parent);
+        perfmon_value_t(alt_cache_stats_t *_parent,
+                        uint64_t (alt::evicter_t::*_getter)() const);
         void *begin_stats();
         void visit_stats(void *);
         ql::datum_t end_stats(void *);
     private:
         alt_cache_stats_t *parent;
+        uint64_t (alt::evicter_t::*getter)() const;
         DISABLE_COPYING(perfmon_value_t);
     };
     perfmon_value_t in_use_bytes;
     perfmon_membership_t in_use_bytes_membership;
+    // The memory limit that the cache balancer gave the cache.
+    perfmon_value_t limit_bytes;
+    perfmon_membership_t limit_bytes_membership;
 
+    // Reports the eviction policy along with its page hit and miss ratios.
+    class eviction_stats_t : public perfmon_t {
+    public:
+        explicit eviction_stats_t(alt_cache_stats_t *_parent);
+        void *begin_stats();
+        void visit_stats(void *);
+        ql::datum_t end_stats(void *);
+    private:
+        struct value_t;
+        alt_cache_stats_t *parent;
+        DISABLE_COPYING(eviction_stats_t);
+    };
+    eviction_stats_t eviction;
+    perfmon_membership_t eviction_membership;
+
+    // Reports the size of the compressed page tier, its hit ratio and how well the
+    // pages in it compress.
+    class compressed_tier_stats_t : public perfmon_t {
+    public:
+        explicit compressed_tier_stats_t(alt_cache_stats_t *_parent);
+        void *begin_stats();
+        void visit_stats(void *);
+        ql::datum_t end_stats(void *);
+    private:
+        struct value_t;
+        alt_cache_stats_t *parent;
+        DISABLE_COPYING(compressed_tier_stats_t);
+    };
+    compressed_tier_stats_t compressed_tier;
+    perfmon_membership_t compressed_tier_membership;
+
+    // Reports how much memory the pages published for lock-free reads use, and how
+    // many point reads they could answer.
+    class published_pages_stats_t : public perfmon_t {
+    public:
+        explicit published_pages_stats_t(alt_cache_stats_t *_parent);
+        void *begin_stats();
+        void visit_stats(void *);
+        ql::datum_t end_stats(void *);
+    private:
+        struct value_t;
+        alt_cache_stats_t *parent;
+        DISABLE_COPYING(published_pages_stats_t);
+    };
+    published_pages_stats_t published_pages;
+    perfmon_membership_t published_pages_membership;
 
     perfmon_multi_membership_t cache_collection_membership;
 };
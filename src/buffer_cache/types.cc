@@ -8,3 +8,11 @@ void debug_print(printf_buffer_t *buf, block_magic_t magic) {
     debug_print_quoted_string(buf, reinterpret_cast<uint8_t *>(bytes), sizeof(magic.bytes));
     buf->appendf("}");
 }
+
+const char *cache_eviction_policy_name(cache_eviction_policy_t policy) {
+    switch (policy) {
+    case cache_eviction_policy_t::sampled_lru: return "sampled_lru";
+    case cache_eviction_policy_t::two_q: return "2q";
+    default: unreachable();
+    }
+}
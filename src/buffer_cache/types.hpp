@@ -22,6 +22,40 @@ struct flush_interval_t {
     int64_t millis;
 };
 
+#define UNLIMITED_CACHE_QUOTA UINT64_MAX
+#define DEFAULT_CACHE_PRIORITY 1.0
+// Priorities above this get rejected when a table is configured.
+#define MAX_CACHE_PRIORITY 1000.0
+
+// Bounds on a cache's memory limit, and how much weight the cache balancer gives the
+// cache's demand for memory when it divides up the total cache size.  `max_bytes` is
+// `UNLIMITED_CACHE_QUOTA` if the balancer may hand the cache as much as it wants.
+struct cache_quota_t {
+    uint64_t min_bytes;
+    uint64_t max_bytes;
+    double priority;
+};
+
+inline cache_quota_t default_cache_quota() {
+    return cache_quota_t{0, UNLIMITED_CACHE_QUOTA, DEFAULT_CACHE_PRIORITY};
+}
+
+// How the page cache picks pages to evict.  `sampled_lru` evicts the least recently
+// used of a random sample of pages.  `two_q` is a scan-resistant 2Q policy: pages
+// enter a probation segment and only get promoted to the protected segment if
+// they're loaded again shortly after having been evicted from probation.
+enum class cache_eviction_policy_t { sampled_lru, two_q };
+
+const char *cache_eviction_policy_name(cache_eviction_policy_t policy);
+
+// The compressed page tier may take up at most this share (in percent) of a cache's
+// memory limit, so that there's always room left for uncompressed pages.
+const uint32_t MAX_COMPRESSED_TIER_PERCENT = 75;
+
+// Copies of pages published for lock-free reads may take up at most this share (in
+// percent) of a cache's memory limit.
+const uint32_t MAX_LOCK_FREE_READS_PERCENT = 25;
+
 typedef uint32_t block_magic_comparison_t;
 
 struct block_magic_t {
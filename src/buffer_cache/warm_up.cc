@@ -0,0 +1,248 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "buffer_cache/warm_up.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/thread_pool.hpp"
+#include "buffer_cache/alt.hpp"
+#include "concurrency/pmap.hpp"
+#include "config/args.hpp"
+#include "logger.hpp"
+#include "paths.hpp"
+#include "serializer/checksum.hpp"
+#include "serializer/serializer.hpp"
+#include "utils.hpp"
+
+// How often we write the hot set manifest.
+const int64_t CACHE_HOT_SET_WRITE_INTERVAL_MS = 5 * 60 * 1000;
+
+// How long we wait after startup before warming up, so that the cache balancer gets to
+// hand out memory to the new cache first.
+const int64_t CACHE_WARM_UP_DELAY_MS = 1000;
+
+// How many blocks we load at a time.  They are adjacent on disk, so the read batcher
+// can usually coalesce them into a few large reads.
+const size_t CACHE_WARM_UP_BATCH_SIZE = 64;
+
+// We stop warming up once this share of the cache's memory limit is in use, so that
+// we don't end up evicting the blocks we just loaded.
+const double CACHE_WARM_UP_MAX_FILL = 0.9;
+
+static const char HOT_SET_MAGIC[8] = {'h', 'o', 't', 's', 'e', 't', '0', '1'};
+
+ATTR_PACKED(struct hot_set_header_t {
+    char magic[sizeof(HOT_SET_MAGIC)];
+    uint64_t num_block_ids;
+    // The checksum of the block ids that follow the header.
+    serializer_checksum block_ids_checksum;
+});
+
+CT_ASSERT(sizeof(block_id_t) % serializer_checksum::word_size == 0);
+
+cache_warm_up_t::cache_warm_up_t(cache_t *cache, const std::string &hot_set_path)
+    : cache_(cache),
+      hot_set_path_(hot_set_path),
+      is_warming_up_(true),
+      start_time_(current_microtime()),
+      blocks_loaded_(0),
+      blocks_total_(0),
+      may_write_hot_set_(false),
+      is_writing_hot_set_(false) {
+    cache_->assert_thread();
+    coro_t::spawn_sometime(
+        std::bind(&cache_warm_up_t::warm_up, this, drainer_.lock()));
+    write_timer_.init(new repeating_timer_t(CACHE_HOT_SET_WRITE_INTERVAL_MS,
+        [this]() {
+            auto_drainer_t::lock_t keepalive = drainer_.lock();
+            coro_t::spawn_sometime([this, keepalive]() { write_hot_set(); });
+        }));
+}
+
+cache_warm_up_t::~cache_warm_up_t() {
+    assert_thread();
+    write_timer_.reset();
+    drainer_.drain();
+    // Record the hot set one last time, so that the next run starts out with the
+    // blocks that were hot just now.
+    write_hot_set();
+}
+
+bool cache_warm_up_t::get_progress(microtime_t *start_time_out,
+                                   uint64_t *blocks_loaded_out,
+                                   uint64_t *blocks_total_out) const {
+    assert_thread();
+    if (!is_warming_up_) {
+        return false;
+    }
+    *start_time_out = start_time_;
+    *blocks_loaded_out = blocks_loaded_;
+    *blocks_total_out = blocks_total_;
+    return true;
+}
+
+void cache_warm_up_t::warm_up(auto_drainer_t::lock_t keepalive) {
+    assert_thread();
+    std::vector<block_id_t> block_ids;
+    bool has_hot_set = false;
+    thread_pool_t::run_in_blocker_pool([&]() {
+        has_hot_set = read_hot_set_manifest(hot_set_path_, &block_ids);
+    });
+
+    try {
+        if (has_hot_set && !block_ids.empty()) {
+            nap(CACHE_WARM_UP_DELAY_MS, keepalive.get_drain_signal());
+            alt::page_cache_t *page_cache = &cache_->page_cache_;
+
+            // The manifest lists the most recently used blocks first.  We only load
+            // as many as the cache can hold.
+            const uint64_t max_blocks = page_cache->evicter().memory_limit()
+                / page_cache->max_block_size().ser_value();
+            if (block_ids.size() > max_blocks) {
+                block_ids.resize(max_blocks);
+            }
+            sort_by_offset(&block_ids);
+            blocks_total_ = block_ids.size();
+
+            cache_account_t account = cache_->create_cache_account(
+                CACHE_WARM_UP_CACHE_PRIORITY, io_class_t::backfill);
+            for (size_t i = 0; i < block_ids.size(); i += CACHE_WARM_UP_BATCH_SIZE) {
+                if (cache_is_full()) {
+                    break;
+                }
+                const size_t end
+                    = std::min(block_ids.size(), i + CACHE_WARM_UP_BATCH_SIZE);
+                pmap(static_cast<int64_t>(i), static_cast<int64_t>(end),
+                     [&](int64_t j) {
+                         UNUSED bool loaded = page_cache->load_block_for_warm_up(
+                             block_ids[j], &account);
+                     });
+                blocks_loaded_ = end;
+                if (keepalive.get_drain_signal()->is_pulsed()) {
+                    throw interrupted_exc_t();
+                }
+            }
+        }
+        may_write_hot_set_ = true;
+    } catch (const interrupted_exc_t &) {
+        // We're shutting down.  The previous hot set stays in place.
+    }
+    is_warming_up_ = false;
+}
+
+void cache_warm_up_t::sort_by_offset(std::vector<block_id_t> *block_ids) {
+    serializer_t *serializer = cache_->page_cache_.serializer();
+    std::vector<std::pair<int64_t, block_id_t> > offsets;
+    offsets.reserve(block_ids->size());
+    {
+        on_thread_t thread_switcher(serializer->home_thread());
+        for (block_id_t block_id : *block_ids) {
+            counted_t<block_token_t> token = serializer->index_read(block_id);
+            if (token.has()) {
+                offsets.push_back(std::make_pair(token->offset(), block_id));
+            }
+        }
+    }
+    std::sort(offsets.begin(), offsets.end());
+
+    block_ids->clear();
+    for (const auto &pair : offsets) {
+        block_ids->push_back(pair.second);
+    }
+}
+
+bool cache_warm_up_t::cache_is_full() {
+    alt::evicter_t &evicter = cache_->page_cache_.evicter();
+    return evicter.in_memory_size()
+        >= evicter.memory_limit() * CACHE_WARM_UP_MAX_FILL;
+}
+
+void cache_warm_up_t::write_hot_set() {
+    assert_thread();
+    if (!may_write_hot_set_ || is_writing_hot_set_) {
+        return;
+    }
+    is_writing_hot_set_ = true;
+    std::vector<block_id_t> block_ids = cache_->page_cache_.hot_block_ids();
+    thread_pool_t::run_in_blocker_pool([&]() {
+        UNUSED bool written = write_hot_set_manifest(hot_set_path_, block_ids);
+    });
+    is_writing_hot_set_ = false;
+}
+
+bool write_hot_set_manifest(const std::string &path,
+                            const std::vector<block_id_t> &block_ids) {
+    hot_set_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, HOT_SET_MAGIC, sizeof(HOT_SET_MAGIC));
+    header.num_block_ids = block_ids.size();
+    header.block_ids_checksum = compute_checksum(
+        block_ids.data(),
+        block_ids.size() * sizeof(block_id_t) / serializer_checksum::word_size);
+
+    const std::string temporary_path = path + ".tmp";
+    FILE *file = fopen(temporary_path.c_str(), "wb");
+    if (file == nullptr) {
+        logWRN("Could not create hot set file %s: %s",
+               temporary_path.c_str(), errno_string(get_errno()).c_str());
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && (block_ids.empty()
+                || fwrite(block_ids.data(), sizeof(block_id_t), block_ids.size(), file)
+                   == block_ids.size());
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) {
+        logWRN("Could not write hot set file %s: %s",
+               temporary_path.c_str(), errno_string(get_errno()).c_str());
+        UNUSED int res = remove(temporary_path.c_str());
+        return false;
+    }
+
+    // The manifest is only a hint, so unlike with LBA snapshots we don't bother to
+    // fsync it.  A torn manifest fails its checksum.
+    if (rename(temporary_path.c_str(), path.c_str()) != 0) {
+        logWRN("Could not rename hot set file %s to %s: %s",
+               temporary_path.c_str(), path.c_str(),
+               errno_string(get_errno()).c_str());
+        UNUSED int res = remove(temporary_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool read_hot_set_manifest(const std::string &path,
+                           std::vector<block_id_t> *block_ids_out) {
+    std::string contents;
+    if (!blocking_read_file(path.c_str(), &contents)
+        || contents.size() < sizeof(hot_set_header_t)) {
+        return false;
+    }
+
+    hot_set_header_t header;
+    memcpy(&header, contents.data(), sizeof(header));
+    const size_t size = contents.size() - sizeof(header);
+    if (memcmp(header.magic, HOT_SET_MAGIC, sizeof(HOT_SET_MAGIC)) != 0
+        || size % sizeof(block_id_t) != 0
+        || size / sizeof(block_id_t) != header.num_block_ids) {
+        logINF("Ignoring invalid hot set file %s", path.c_str());
+        return false;
+    }
+
+    std::vector<block_id_t> block_ids(header.num_block_ids);
+    if (size > 0) {
+        memcpy(block_ids.data(), contents.data() + sizeof(header), size);
+    }
+    const serializer_checksum checksum = compute_checksum(
+        block_ids.data(), size / serializer_checksum::word_size);
+    if (checksum.value != header.block_ids_checksum.value) {
+        logINF("Ignoring invalid hot set file %s", path.c_str());
+        return false;
+    }
+    *block_ids_out = std::move(block_ids);
+    return true;
+}
@@ -0,0 +1,83 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef BUFFER_CACHE_WARM_UP_HPP_
+#define BUFFER_CACHE_WARM_UP_HPP_
+
+#include <string>
+#include <vector>
+
+#include "arch/timing.hpp"
+#include "concurrency/auto_drainer.hpp"
+#include "containers/scoped.hpp"
+#include "serializer/types.hpp"
+#include "threading.hpp"
+#include "time.hpp"
+
+class cache_t;
+
+/* `cache_warm_up_t` keeps a cache from starting out cold after a restart.
+
+While the server runs, it periodically writes the cache's "hot set" to a manifest file
+next to the table file: the ids of the blocks that are in memory, most recently used
+first.  When it gets constructed, it reads the manifest left behind by the previous
+run and loads those blocks back into the cache in the background.  It takes as many
+of the most recently used blocks as fit into the cache, and loads them in the order of
+their offsets on disk, many at a time, so that the page cache's read batcher can
+coalesce them into large reads.  Loading uses a low priority, background I/O account,
+and stops early once the cache is nearly full. */
+class cache_warm_up_t : public home_thread_mixin_t {
+public:
+    cache_warm_up_t(cache_t *cache, const std::string &hot_set_path);
+    ~cache_warm_up_t();
+
+    /* Returns false if the cache isn't warming up (anymore).  Otherwise returns true,
+    along with when the warm-up started and how many of the blocks that it is going to
+    load it has loaded so far. */
+    bool get_progress(microtime_t *start_time_out,
+                      uint64_t *blocks_loaded_out,
+                      uint64_t *blocks_total_out) const;
+
+private:
+    void warm_up(auto_drainer_t::lock_t keepalive);
+
+    // Sorts the block ids by their current offsets on disk, dropping the ones that
+    // don't exist anymore.
+    void sort_by_offset(std::vector<block_id_t> *block_ids);
+
+    bool cache_is_full();
+
+    void write_hot_set();
+
+    cache_t *const cache_;
+    const std::string hot_set_path_;
+
+    bool is_warming_up_;
+    microtime_t start_time_;
+    uint64_t blocks_loaded_;
+    uint64_t blocks_total_;
+
+    // We only write the hot set once the warm-up is done, so that restarting again
+    // before it's done doesn't throw away the rest of the previous hot set.
+    bool may_write_hot_set_;
+    bool is_writing_hot_set_;
+
+    auto_drainer_t drainer_;
+    scoped_ptr_t<repeating_timer_t> write_timer_;
+
+    DISABLE_COPYING(cache_warm_up_t);
+};
+
+/* These block, so they should be run in the blocker pool. */
+
+/* Writes `block_ids` to a hot set manifest at `path`, replacing the existing one.  The
+write is atomic: the manifest gets written to a temporary file first which is then
+renamed.  Returns false (after logging a warning) if the manifest couldn't be
+written. */
+bool write_hot_set_manifest(const std::string &path,
+                            const std::vector<block_id_t> &block_ids);
+
+/* Reads the hot set manifest at `path` into `block_ids_out`.  Returns false if there is
+no manifest, or if it's corrupted. */
+bool read_hot_set_manifest(const std::string &path,
+                           std::vector<block_id_t> *block_ids_out);
+
+#endif  // BUFFER_CACHE_WARM_UP_HPP_
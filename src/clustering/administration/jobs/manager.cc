@@ -17,6 +17,12 @@ const uuid_u jobs_manager_t::base_sindex_id =
 const uuid_u jobs_manager_t::base_disk_compaction_id =
     str_to_uuid("b8766ece-d15c-4f96-bee5-c0edacf10c9c");
 
+const uuid_u jobs_manager_t::base_disk_defragmentation_id =
+    str_to_uuid("3c5f0e9a-27d4-4b61-9e8f-d0a46b1c7e52");
+
+const uuid_u jobs_manager_t::base_cache_warm_up_id =
+    str_to_uuid("9b2d47e1-5a0c-4f83-b6e9-71c3d8a0f415");
+
 const uuid_u jobs_manager_t::base_backfill_id =
     str_to_uuid("a5e1b38d-c712-42d7-ab4c-f177a3fb0d20");
 
@@ -53,6 +59,8 @@ void jobs_manager_t::on_get_job_reports(
     std::vector<disk_compaction_job_report_t> disk_compaction_job_reports;
     std::vector<index_construction_job_report_t> index_construction_job_reports;
     std::vector<backfill_job_report_t> backfill_job_reports;
+    std::vector<disk_defragmentation_job_report_t> disk_defragmentation_job_reports;
+    std::vector<cache_warm_up_job_report_t> cache_warm_up_job_reports;
 
     if (drainer.is_draining()) {
         // We're shutting down, send an empty reponse since we can't acquire a `drainer`
@@ -63,7 +71,9 @@ void jobs_manager_t::on_get_job_reports(
              query_job_reports,
              disk_compaction_job_reports,
              index_construction_job_reports,
-             backfill_job_reports);
+             backfill_job_reports,
+             disk_defragmentation_job_reports,
+             cache_warm_up_job_reports);
         return;
     }
 
@@ -119,6 +129,28 @@ void jobs_manager_t::on_get_job_reports(
             server_id);
     }
 
+    if (table_persistence_interface != nullptr) {
+        std::string base_str = uuid_to_str(server_id.get_uuid());
+        for (const auto &pair : table_persistence_interface->get_defrag_progress()) {
+            disk_defragmentation_job_reports.emplace_back(
+                uuid_u::from_hash(
+                    base_disk_defragmentation_id, base_str + uuid_to_str(pair.first)),
+                time - std::min(pair.second.first, time),
+                server_id,
+                pair.first,
+                pair.second.second);
+        }
+        for (const auto &pair : table_persistence_interface->get_warm_up_progress()) {
+            cache_warm_up_job_reports.emplace_back(
+                uuid_u::from_hash(
+                    base_cache_warm_up_id, base_str + uuid_to_str(pair.first)),
+                time - std::min(pair.second.first, time),
+                server_id,
+                pair.first,
+                pair.second.second);
+        }
+    }
+
     try {
         multi_table_manager->visit_tables(interruptor, access_t::read,
         [&](const namespace_id_t &table_id,
@@ -178,7 +210,9 @@ void jobs_manager_t::on_get_job_reports(
              query_job_reports,
              disk_compaction_job_reports,
              index_construction_job_reports,
-             backfill_job_reports);
+             backfill_job_reports,
+             disk_defragmentation_job_reports,
+             cache_warm_up_job_reports);
     } catch (const interrupted_exc_t &) {
         // Do nothing
     }
@@ -37,6 +37,8 @@ private:
 
     static const uuid_u base_sindex_id;
     static const uuid_u base_disk_compaction_id;
+    static const uuid_u base_disk_defragmentation_id;
+    static const uuid_u base_cache_warm_up_id;
     static const uuid_u base_backfill_id;
 
     void on_get_job_reports(
@@ -45,6 +45,98 @@ bool disk_compaction_job_report_t::info_derived(
 RDB_IMPL_SERIALIZABLE_4_FOR_CLUSTER(
     disk_compaction_job_report_t, type, id, duration, servers);
 
+disk_defragmentation_job_report_t::disk_defragmentation_job_report_t()
+    : job_report_base_t<disk_defragmentation_job_report_t>() { }
+
+disk_defragmentation_job_report_t::disk_defragmentation_job_report_t(
+        uuid_u const &_id,
+        double _duration,
+        server_id_t const &_server_id,
+        namespace_id_t const &_table,
+        double _progress)
+    : job_report_base_t<disk_defragmentation_job_report_t>(
+        "disk_defragmentation", _id, _duration, _server_id),
+      table(_table),
+      progress(_progress) { }
+
+void disk_defragmentation_job_report_t::merge_derived(
+        disk_defragmentation_job_report_t const &) { }
+
+bool disk_defragmentation_job_report_t::info_derived(
+        admin_identifier_format_t identifier_format,
+        UNUSED server_config_client_t *server_config_client,
+        table_meta_client_t *table_meta_client,
+        cluster_semilattice_metadata_t const &metadata,
+        ql::datum_object_builder_t *info_builder_out) const {
+    ql::datum_t table_name_or_uuid;
+    ql::datum_t db_name_or_uuid;
+    if (!convert_table_id_to_datums(
+            table,
+            identifier_format,
+            metadata,
+            table_meta_client,
+            &table_name_or_uuid,
+            nullptr,
+            &db_name_or_uuid,
+            nullptr)) {
+        return false;
+    }
+    info_builder_out->overwrite("table", table_name_or_uuid);
+    info_builder_out->overwrite("db", db_name_or_uuid);
+    info_builder_out->overwrite("progress", ql::datum_t(progress));
+
+    return true;
+}
+
+RDB_IMPL_SERIALIZABLE_6_FOR_CLUSTER(
+    disk_defragmentation_job_report_t, type, id, duration, servers, table, progress);
+
+cache_warm_up_job_report_t::cache_warm_up_job_report_t()
+    : job_report_base_t<cache_warm_up_job_report_t>() { }
+
+cache_warm_up_job_report_t::cache_warm_up_job_report_t(
+        uuid_u const &_id,
+        double _duration,
+        server_id_t const &_server_id,
+        namespace_id_t const &_table,
+        double _progress)
+    : job_report_base_t<cache_warm_up_job_report_t>(
+        "cache_warm_up", _id, _duration, _server_id),
+      table(_table),
+      progress(_progress) { }
+
+void cache_warm_up_job_report_t::merge_derived(
+        cache_warm_up_job_report_t const &) { }
+
+bool cache_warm_up_job_report_t::info_derived(
+        admin_identifier_format_t identifier_format,
+        UNUSED server_config_client_t *server_config_client,
+        table_meta_client_t *table_meta_client,
+        cluster_semilattice_metadata_t const &metadata,
+        ql::datum_object_builder_t *info_builder_out) const {
+    ql::datum_t table_name_or_uuid;
+    ql::datum_t db_name_or_uuid;
+    if (!convert_table_id_to_datums(
+            table,
+            identifier_format,
+            metadata,
+            table_meta_client,
+            &table_name_or_uuid,
+            nullptr,
+            &db_name_or_uuid,
+            nullptr)) {
+        return false;
+    }
+    info_builder_out->overwrite("table", table_name_or_uuid);
+    info_builder_out->overwrite("db", db_name_or_uuid);
+    info_builder_out->overwrite("progress", ql::datum_t(progress));
+
+    return true;
+}
+
+RDB_IMPL_SERIALIZABLE_6_FOR_CLUSTER(
+    cache_warm_up_job_report_t, type, id, duration, servers, table, progress);
+
 backfill_job_report_t::backfill_job_report_t()
     : job_report_base_t<backfill_job_report_t>() { }
 
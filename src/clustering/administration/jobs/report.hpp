@@ -100,6 +100,56 @@ public:
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(disk_compaction_job_report_t);
 
+class disk_defragmentation_job_report_t
+    : public job_report_base_t<disk_defragmentation_job_report_t> {
+public:
+    disk_defragmentation_job_report_t();
+    disk_defragmentation_job_report_t(
+            uuid_u const &id,
+            double duration,
+            server_id_t const &server_id,
+            namespace_id_t const &table,
+            double progress);
+
+    void merge_derived(disk_defragmentation_job_report_t const &job_report);
+
+    bool info_derived(
+            admin_identifier_format_t identifier_format,
+            server_config_client_t *server_config_client,
+            table_meta_client_t *table_meta_client,
+            cluster_semilattice_metadata_t const &metadata,
+            ql::datum_object_builder_t *info_builder_out) const;
+
+    namespace_id_t table;
+    double progress;
+};
+RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(disk_defragmentation_job_report_t);
+
+class cache_warm_up_job_report_t
+    : public job_report_base_t<cache_warm_up_job_report_t> {
+public:
+    cache_warm_up_job_report_t();
+    cache_warm_up_job_report_t(
+            uuid_u const &id,
+            double duration,
+            server_id_t const &server_id,
+            namespace_id_t const &table,
+            double progress);
+
+    void merge_derived(cache_warm_up_job_report_t const &job_report);
+
+    bool info_derived(
+            admin_identifier_format_t identifier_format,
+            server_config_client_t *server_config_client,
+            table_meta_client_t *table_meta_client,
+            cluster_semilattice_metadata_t const &metadata,
+            ql::datum_object_builder_t *info_builder_out) const;
+
+    namespace_id_t table;
+    double progress;
+};
+RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(cache_warm_up_job_report_t);
+
 class index_construction_job_report_t
     : public job_report_base_t<index_construction_job_report_t> {
 public:
@@ -162,7 +212,9 @@ public:
     typedef mailbox_t<std::vector<query_job_report_t>,
                       std::vector<disk_compaction_job_report_t>,
                       std::vector<index_construction_job_report_t>,
-                      std::vector<backfill_job_report_t>> return_mailbox_t;
+                      std::vector<backfill_job_report_t>,
+                      std::vector<disk_defragmentation_job_report_t>,
+                      std::vector<cache_warm_up_job_report_t>> return_mailbox_t;
     typedef mailbox_t<return_mailbox_t::address_t> get_job_reports_mailbox_t;
     typedef mailbox_t<uuid_u, auth::user_context_t> job_interrupt_mailbox_t;
 
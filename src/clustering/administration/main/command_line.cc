@@ -1045,6 +1045,7 @@ void run_rethinkdb_create(const base_path_t &base_path,
                           optional<uint64_t> total_cache_size,
                           const file_direct_io_mode_t direct_io_mode,
                           const int max_concurrent_io_requests,
+                          const file_io_backend_t io_backend,
                           bool *const result_out) {
     server_id_t our_server_id = server_id_t::generate_server_id();
 
@@ -1058,7 +1059,8 @@ void run_rethinkdb_create(const base_path_t &base_path,
     server_config.config.cache_size_bytes = total_cache_size;
     server_config.version = 1;
 
-    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests);
+    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests, io_backend);
+    perfmon_membership_t io_perfmon_membership(&get_global_perfmon_collection(), io_backender.get_stats(), "io");
 
     perfmon_collection_t metadata_perfmon_collection;
     perfmon_membership_t metadata_perfmon_membership(&get_global_perfmon_collection(), &metadata_perfmon_collection, "metadata");
@@ -1139,6 +1141,7 @@ void run_rethinkdb_serve(const base_path_t &base_path,
                          const std::string &initial_password,
                          const file_direct_io_mode_t direct_io_mode,
                          const int max_concurrent_io_requests,
+                         const file_io_backend_t io_backend,
                          const optional<optional<uint64_t> >
                             &total_cache_size,
                          const server_id_t *our_server_id,
@@ -1156,7 +1159,8 @@ void run_rethinkdb_serve(const base_path_t &base_path,
 
     logNTC("Loading data from directory %s\n", base_path.path().c_str());
 
-    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests);
+    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests, io_backend);
+    perfmon_membership_t io_perfmon_membership(&get_global_perfmon_collection(), io_backender.get_stats(), "io");
 
     perfmon_collection_t metadata_perfmon_collection;
     perfmon_membership_t metadata_perfmon_membership(&get_global_perfmon_collection(), &metadata_perfmon_collection, "metadata");
@@ -1284,6 +1288,7 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
                              const std::string &initial_password,
                              const file_direct_io_mode_t direct_io_mode,
                              const int max_concurrent_io_requests,
+                             const file_io_backend_t io_backend,
                              const optional<optional<uint64_t> >
                                 &total_cache_size,
                              const bool new_directory,
@@ -1292,7 +1297,7 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
                              bool *const result_out) {
     if (!new_directory) {
         run_rethinkdb_serve(base_path, serve_info, initial_password, direct_io_mode,
-                            max_concurrent_io_requests, total_cache_size,
+                            max_concurrent_io_requests, io_backend, total_cache_size,
                             nullptr, nullptr, nullptr, data_directory_lock,
                             result_out);
     } else {
@@ -1328,7 +1333,7 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
         server_config.version = 1;
 
         run_rethinkdb_serve(base_path, serve_info, initial_password, direct_io_mode,
-                            max_concurrent_io_requests,
+                            max_concurrent_io_requests, io_backend,
                             optional<optional<uint64_t> >(),
                             &our_server_id, &server_config, &cluster_metadata,
                             data_directory_lock, result_out);
@@ -1407,6 +1412,46 @@ options::help_section_t get_file_options(std::vector<options::option_t> *options
                                              strprintf("%d", DEFAULT_MAX_CONCURRENT_IO_REQUESTS)));
     help.add("--io-threads n",
              "how many simultaneous I/O operations can happen at the same time");
+    options_out->push_back(options::option_t(options::names_t("--io-backend"),
+                                             options::OPTIONAL,
+                                             "pool"));
+    help.add("--io-backend pool|io_uring",
+             "perform disk I/O using a thread pool or using io_uring (Linux only, "
+             "falls back to the thread pool if unavailable)");
+    options_out->push_back(options::option_t(options::names_t("--gc-policy"),
+                                             options::OPTIONAL,
+                                             "greedy"));
+    help.add("--gc-policy greedy|cost-benefit",
+             "how the garbage collector of table files picks extents to compact: the "
+             "ones with the most garbage, or the ones with the best ratio of freed "
+             "space and age to copying cost");
+    options_out->push_back(options::option_t(options::names_t("--gc-separate-cold-data"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--gc-separate-cold-data",
+             "write data moved by the garbage collector to different extents than "
+             "newly written data");
+    options_out->push_back(options::option_t(options::names_t("--group-commit-window"),
+                                             options::OPTIONAL,
+                                             "0"));
+    help.add("--group-commit-window ms",
+             "how long to wait for more writes to a table before committing them "
+             "together with a single disk sync");
+    options_out->push_back(options::option_t(options::names_t("--group-commit-max-bytes"),
+                                             options::OPTIONAL,
+                                             "0"));
+    help.add("--group-commit-max-bytes n",
+             "commit a group of writes without waiting any longer once it covers this "
+             "many bytes (0 for no limit)");
+    options_out->push_back(options::option_t(options::names_t("--lba-snapshot"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--lba-snapshot",
+             "save the block index of each table file on clean shutdown, so that "
+             "tables become ready faster on the next start");
+    options_out->push_back(options::option_t(options::names_t("--defrag"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--defrag",
+             "move data towards the start of table files that have a lot of free "
+             "space, so that the files can shrink");
 #ifndef _WIN32
     // TODO WINDOWS: accept this option, but error out if it is passed
     options_out->push_back(options::option_t(options::names_t("--direct-io"),
@@ -1417,6 +1462,27 @@ options::help_section_t get_file_options(std::vector<options::option_t> *options
                                              options::OPTIONAL));
     help.add("--cache-size mb", "total cache size (in megabytes) for the process. Can "
         "be 'auto'.");
+    options_out->push_back(options::option_t(options::names_t("--cache-eviction-policy"),
+                                             options::OPTIONAL,
+                                             "sampled-lru"));
+    help.add("--cache-eviction-policy sampled-lru|2q",
+             "how the cache picks pages to evict: approximately least recently used, "
+             "or a scan-resistant policy that keeps large scans and backfills from "
+             "pushing the working set out of the cache");
+    options_out->push_back(options::option_t(options::names_t("--cache-compressed-tier"),
+                                             options::OPTIONAL,
+                                             "0"));
+    help.add("--cache-compressed-tier percent",
+             "share of the cache (in percent, at most 75) that keeps LZ4 compressed "
+             "copies of evicted pages, so that reading them again doesn't "
+             "need to go to disk. 0 disables the compressed tier");
+    options_out->push_back(options::option_t(options::names_t("--cache-lock-free-reads"),
+                                             options::OPTIONAL,
+                                             "0"));
+    help.add("--cache-lock-free-reads percent",
+             "share of the cache (in percent, at most 25) that keeps copies of "
+             "pages that point reads can use without acquiring any locks. "
+             "0 disables lock-free reads");
     return help;
 }
 
@@ -1633,6 +1699,11 @@ options::help_section_t get_cpu_options(std::vector<options::option_t> *options_
                                              options::OPTIONAL,
                                              strprintf("%d", get_cpu_count())));
     help.add("-c [ --cores ] n", "the number of cores to use");
+    options_out->push_back(options::option_t(options::names_t("--numa"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--numa",
+             "pin threads to cores by NUMA node, and keep each table shard's "
+             "threads and cache memory on one node");
     return help;
 }
 
@@ -1887,6 +1958,112 @@ MUST_USE bool parse_io_threads_option(const std::map<std::string, options::value
     return true;
 }
 
+MUST_USE bool parse_io_backend_option(const std::map<std::string, options::values_t> &opts,
+                                      file_io_backend_t *io_backend_out) {
+    const std::string io_backend = get_single_option(opts, "--io-backend");
+    if (io_backend == "pool") {
+        *io_backend_out = file_io_backend_t::pool;
+    } else if (io_backend == "io_uring") {
+        *io_backend_out = file_io_backend_t::uring;
+    } else {
+        fprintf(stderr, "ERROR: io-backend must be either 'pool' or 'io_uring'\n");
+        return false;
+    }
+    return true;
+}
+
+MUST_USE bool parse_serializer_config_options(
+        const std::map<std::string, options::values_t> &opts,
+        log_serializer_dynamic_config_t *serializer_config_out) {
+    const std::string gc_policy = get_single_option(opts, "--gc-policy");
+    if (gc_policy == "greedy") {
+        serializer_config_out->gc_policy = gc_policy_t::greedy;
+    } else if (gc_policy == "cost-benefit") {
+        serializer_config_out->gc_policy = gc_policy_t::cost_benefit;
+    } else {
+        fprintf(stderr,
+                "ERROR: gc-policy must be either 'greedy' or 'cost-benefit'\n");
+        return false;
+    }
+
+    serializer_config_out->gc_separate_cold_data
+        = exists_option(opts, "--gc-separate-cold-data");
+    serializer_config_out->lba_snapshot = exists_option(opts, "--lba-snapshot");
+    serializer_config_out->defrag = exists_option(opts, "--defrag");
+
+    const int group_commit_window = get_single_int(opts, "--group-commit-window");
+    if (group_commit_window < 0 || group_commit_window > MAX_GROUP_COMMIT_WINDOW_MS) {
+        fprintf(stderr, "ERROR: group-commit-window must be between 0 and %d\n",
+                MAX_GROUP_COMMIT_WINDOW_MS);
+        return false;
+    }
+    serializer_config_out->group_commit_window_ms = group_commit_window;
+
+    const std::string group_commit_max_bytes
+        = get_single_option(opts, "--group-commit-max-bytes");
+    if (!strtou64_strict(group_commit_max_bytes, 10,
+                         &serializer_config_out->group_commit_max_bytes)) {
+        fprintf(stderr,
+                "ERROR: group-commit-max-bytes must be a non-negative integer\n");
+        return false;
+    }
+    return true;
+}
+
+MUST_USE bool parse_cache_eviction_policy_option(
+        const std::map<std::string, options::values_t> &opts,
+        cache_eviction_policy_t *eviction_policy_out) {
+    const std::string eviction_policy
+        = get_single_option(opts, "--cache-eviction-policy");
+    if (eviction_policy == "sampled-lru") {
+        *eviction_policy_out = cache_eviction_policy_t::sampled_lru;
+    } else if (eviction_policy == "2q") {
+        *eviction_policy_out = cache_eviction_policy_t::two_q;
+    } else {
+        fprintf(stderr,
+                "ERROR: cache-eviction-policy must be either 'sampled-lru' or '2q'\n");
+        return false;
+    }
+    return true;
+}
+
+MUST_USE bool parse_cache_compressed_tier_option(
+        const std::map<std::string, options::values_t> &opts,
+        uint32_t *compressed_tier_percent_out) {
+    const int compressed_tier_percent
+        = get_single_int(opts, "--cache-compressed-tier");
+    if (compressed_tier_percent < 0
+        || compressed_tier_percent > static_cast<int>(MAX_COMPRESSED_TIER_PERCENT)) {
+        fprintf(stderr, "ERROR: cache-compressed-tier must be between 0 and %" PRIu32
+                "\n", MAX_COMPRESSED_TIER_PERCENT);
+        return false;
+    }
+#ifndef HAS_LZ4
+    if (compressed_tier_percent != 0) {
+        fprintf(stderr, "ERROR: this build of RethinkDB doesn't support "
+                "cache-compressed-tier, because it was built without LZ4\n");
+        return false;
+    }
+#endif
+    *compressed_tier_percent_out = compressed_tier_percent;
+    return true;
+}
+
+MUST_USE bool parse_cache_lock_free_reads_option(
+        const std::map<std::string, options::values_t> &opts,
+        uint32_t *lock_free_reads_percent_out) {
+    const int lock_free_reads_percent
+        = get_single_int(opts, "--cache-lock-free-reads");
+    if (lock_free_reads_percent < 0
+        || lock_free_reads_percent > static_cast<int>(MAX_LOCK_FREE_READS_PERCENT)) {
+        fprintf(stderr, "ERROR: cache-lock-free-reads must be between 0 and %" PRIu32
+                "\n", MAX_LOCK_FREE_READS_PERCENT);
+        return false;
+    }
+    *lock_free_reads_percent_out = lock_free_reads_percent;
+    return true;
+}
+
 update_check_t parse_update_checking_option(const std::map<std::string, options::values_t> &opts) {
     return exists_option(opts, "--no-update-check")
         ? update_check_t::do_not_perform
@@ -1929,6 +2106,11 @@ int main_rethinkdb_create(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        file_io_backend_t io_backend;
+        if (!parse_io_backend_option(opts, &io_backend)) {
+            return EXIT_FAILURE;
+        }
+
         const int num_workers = get_cpu_count();
 
         bool is_new_directory = false;
@@ -1958,6 +2140,7 @@ int main_rethinkdb_create(int argc, char *argv[]) {
                                      total_cache_size,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend,
                                      &result),
                            num_workers);
 
@@ -2057,6 +2240,31 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        file_io_backend_t io_backend;
+        if (!parse_io_backend_option(opts, &io_backend)) {
+            return EXIT_FAILURE;
+        }
+
+        log_serializer_dynamic_config_t serializer_config;
+        if (!parse_serializer_config_options(opts, &serializer_config)) {
+            return EXIT_FAILURE;
+        }
+
+        cache_eviction_policy_t cache_eviction_policy;
+        if (!parse_cache_eviction_policy_option(opts, &cache_eviction_policy)) {
+            return EXIT_FAILURE;
+        }
+
+        uint32_t cache_compressed_tier_percent;
+        if (!parse_cache_compressed_tier_option(opts, &cache_compressed_tier_percent)) {
+            return EXIT_FAILURE;
+        }
+
+        uint32_t cache_lock_free_reads_percent;
+        if (!parse_cache_lock_free_reads_option(opts, &cache_lock_free_reads_percent)) {
+            return EXIT_FAILURE;
+        }
+
         update_check_t do_update_checking = parse_update_checking_option(opts);
 
         optional<optional<uint64_t> > total_cache_size =
@@ -2107,7 +2315,11 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
                                 std::vector<std::string>(argv, argv + argc),
                                 join_delay_secs.value_or(0),
                                 node_reconnect_timeout_secs.value_or(cluster_defaults::reconnect_timeout),
-                                tls_configs);
+                                tls_configs,
+                                serializer_config,
+                                cache_eviction_policy,
+                                cache_compressed_tier_percent,
+                                cache_lock_free_reads_percent);
 
         const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
 
@@ -2118,13 +2330,15 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
                                      initial_password,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend,
                                      total_cache_size,
                                      static_cast<server_id_t*>(nullptr),
                                      static_cast<server_config_versioned_t *>(nullptr),
                                      static_cast<cluster_semilattice_metadata_t*>(nullptr),
                                      &data_directory_lock,
                                      &result),
-                           num_workers);
+                           num_workers,
+                           exists_option(opts, "--numa"));
         return result ? EXIT_SUCCESS : EXIT_FAILURE;
     } catch (const options::named_error_t &ex) {
         output_named_error(ex, help);
@@ -2210,7 +2424,11 @@ int main_rethinkdb_proxy(int argc, char *argv[]) {
                                 std::vector<std::string>(argv, argv + argc),
                                 join_delay_secs.value_or(0),
                                 node_reconnect_timeout_secs.value_or(cluster_defaults::reconnect_timeout),
-                                tls_configs);
+                                tls_configs,
+                                log_serializer_dynamic_config_t(),
+                                cache_eviction_policy_t::sampled_lru,
+                                0,
+                                0);
 
         bool result;
         run_in_thread_pool(
@@ -2328,6 +2546,31 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        file_io_backend_t io_backend;
+        if (!parse_io_backend_option(opts, &io_backend)) {
+            return EXIT_FAILURE;
+        }
+
+        log_serializer_dynamic_config_t serializer_config;
+        if (!parse_serializer_config_options(opts, &serializer_config)) {
+            return EXIT_FAILURE;
+        }
+
+        cache_eviction_policy_t cache_eviction_policy;
+        if (!parse_cache_eviction_policy_option(opts, &cache_eviction_policy)) {
+            return EXIT_FAILURE;
+        }
+
+        uint32_t cache_compressed_tier_percent;
+        if (!parse_cache_compressed_tier_option(opts, &cache_compressed_tier_percent)) {
+            return EXIT_FAILURE;
+        }
+
+        uint32_t cache_lock_free_reads_percent;
+        if (!parse_cache_lock_free_reads_option(opts, &cache_lock_free_reads_percent)) {
+            return EXIT_FAILURE;
+        }
+
         update_check_t do_update_checking = parse_update_checking_option(opts);
 
         optional<int> join_delay_secs = parse_join_delay_secs_option(opts);
@@ -2400,7 +2643,11 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
                                 std::vector<std::string>(argv, argv + argc),
                                 join_delay_secs.value_or(0),
                                 node_reconnect_timeout_secs.value_or(cluster_defaults::reconnect_timeout),
-                                tls_configs);
+                                tls_configs,
+                                serializer_config,
+                                cache_eviction_policy,
+                                cache_compressed_tier_percent,
+                                cache_lock_free_reads_percent);
 
         const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
 
@@ -2412,12 +2659,14 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
                                      initial_password,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend,
                                      total_cache_size,
                                      is_new_directory,
                                      &serve_info,
                                      &data_directory_lock,
                                      &result),
-                           num_workers);
+                           num_workers,
+                           exists_option(opts, "--numa"));
 
         return result ? EXIT_SUCCESS : EXIT_FAILURE;
     } catch (const options::named_error_t &ex) {
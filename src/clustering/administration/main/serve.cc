@@ -6,6 +6,7 @@
 #include "arch/arch.hpp"
 #include "arch/io/network.hpp"
 #include "arch/os_signal.hpp"
+#include "arch/runtime/numa.hpp"
 #include "buffer_cache/cache_balancer.hpp"
 #include "clustering/administration/artificial_reql_cluster_interface.hpp"
 #include "clustering/administration/http/server.hpp"
@@ -304,14 +305,18 @@ bool do_serve(io_backender_t *io_backender,
             scoped_ptr_t<multi_table_manager_t> multi_table_manager;
             if (i_am_a_server) {
                 cache_balancer.init(new alt_cache_balancer_t(
-                    server_config_server->get_actual_cache_size_bytes()));
+                    server_config_server->get_actual_cache_size_bytes(),
+                    serve_info.cache_eviction_policy,
+                    serve_info.cache_compressed_tier_percent,
+                    serve_info.cache_lock_free_reads_percent));
                 table_persistence_interface.init(
                     new real_table_persistence_interface_t(
                         io_backender,
                         cache_balancer.get(),
                         base_path,
                         &rdb_ctx,
-                        metadata_file));
+                        metadata_file,
+                        serve_info.serializer_config));
                 multi_table_manager.init(new multi_table_manager_t(
                     server_id,
                     &mailbox_manager,
@@ -441,6 +446,11 @@ bool do_serve(io_backender_t *io_backender,
                     memory_checker->get_memory_issue_tracker()));
             }
 
+            if (numa_mode_enabled()) {
+                logNTC("Threads are pinned to the cores of %d NUMA nodes\n",
+                       get_num_numa_nodes());
+            }
+
             proc_directory_metadata_t initial_proc_directory {
                 RETHINKDB_VERSION_STR,
                 current_microtime(),
@@ -454,7 +464,8 @@ bool do_serve(io_backender_t *io_backender,
                     ? optional<uint16_t>()
                     : optional<uint16_t>(serve_info.ports.http_port),
                 connectivity_cluster_run->get_canonical_addresses(),
-                serve_info.argv };
+                serve_info.argv,
+                get_numa_placement() };
             cluster_directory_metadata_t initial_directory(
                 server_id,
                 connectivity_cluster.get_me(),
@@ -13,6 +13,8 @@
 #include "clustering/administration/main/version_check.hpp"
 #include "arch/address.hpp"
 #include "arch/io/openssl.hpp"
+#include "buffer_cache/types.hpp"
+#include "serializer/log/config.hpp"
 
 class os_signal_cond_t;
 
@@ -119,7 +121,11 @@ public:
                  std::vector<std::string> &&_argv,
                  const int _join_delay_secs,
                  const int _node_reconnect_timeout_secs,
-                 tls_configs_t _tls_configs) :
+                 tls_configs_t _tls_configs,
+                 const log_serializer_dynamic_config_t &_serializer_config,
+                 cache_eviction_policy_t _cache_eviction_policy,
+                 uint32_t _cache_compressed_tier_percent,
+                 uint32_t _cache_lock_free_reads_percent) :
         joins(std::move(_joins)),
         reql_http_proxy(std::move(_reql_http_proxy)),
         web_assets(std::move(_web_assets)),
@@ -128,7 +134,11 @@ public:
         config_file(_config_file),
         argv(std::move(_argv)),
         join_delay_secs(_join_delay_secs),
-        node_reconnect_timeout_secs(_node_reconnect_timeout_secs)
+        node_reconnect_timeout_secs(_node_reconnect_timeout_secs),
+        serializer_config(_serializer_config),
+        cache_eviction_policy(_cache_eviction_policy),
+        cache_compressed_tier_percent(_cache_compressed_tier_percent),
+        cache_lock_free_reads_percent(_cache_lock_free_reads_percent)
     {
         tls_configs = _tls_configs;
     }
@@ -150,6 +160,17 @@ public:
     int join_delay_secs;
     int node_reconnect_timeout_secs;
     tls_configs_t tls_configs;
+    /* The configuration of the serializers of table files, i.e. compression and
+    garbage collection settings. */
+    log_serializer_dynamic_config_t serializer_config;
+    /* The replacement policy of the table caches. */
+    cache_eviction_policy_t cache_eviction_policy;
+    /* The share of each table cache, in percent, that may hold compressed copies of
+    evicted pages. */
+    uint32_t cache_compressed_tier_percent;
+    /* The share of each table cache, in percent, that may hold copies of pages
+    published for lock-free reads. */
+    uint32_t cache_lock_free_reads_percent;
 };
 
 /* This has been factored out from `command_line.hpp` because it takes a very
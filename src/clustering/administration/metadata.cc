@@ -21,7 +21,9 @@ RDB_IMPL_SERIALIZABLE_1_SINCE_v2_1(heartbeat_semilattice_metadata_t, heartbeat_t
 RDB_IMPL_SEMILATTICE_JOINABLE_1(heartbeat_semilattice_metadata_t, heartbeat_timeout);
 RDB_IMPL_EQUALITY_COMPARABLE_1(heartbeat_semilattice_metadata_t, heartbeat_timeout);
 
-RDB_IMPL_SERIALIZABLE_9_FOR_CLUSTER(proc_directory_metadata_t,
+RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(numa_node_placement_t, os_node, cpus, threads);
+
+RDB_IMPL_SERIALIZABLE_10_FOR_CLUSTER(proc_directory_metadata_t,
     version,
     time_started,
     pid,
@@ -30,7 +32,8 @@ RDB_IMPL_SERIALIZABLE_9_FOR_CLUSTER(proc_directory_metadata_t,
     reql_port,
     http_admin_port,
     canonical_addresses,
-    argv);
+    argv,
+    numa_nodes);
 
 RDB_IMPL_SERIALIZABLE_12_FOR_CLUSTER(cluster_directory_metadata_t,
      server_id,
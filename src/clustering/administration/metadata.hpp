@@ -18,6 +18,7 @@
 #include "containers/optional.hpp"
 #include "clustering/table_manager/table_metadata.hpp"
 #include "arch/address.hpp"
+#include "arch/runtime/numa.hpp"
 #include "rpc/connectivity/peer_id.hpp"
 #include "rpc/semilattice/joins/macros.hpp"
 #include "rpc/semilattice/joins/versioned.hpp"
@@ -110,8 +111,11 @@ public:
     optional<uint16_t> http_admin_port;
     std::set<host_and_port_t> canonical_addresses;
     std::vector<std::string> argv;
+    /* The NUMA nodes the server placed its threads on, empty if NUMA mode is off */
+    std::vector<numa_node_placement_t> numa_nodes;
 };
 
+RDB_DECLARE_SERIALIZABLE(numa_node_placement_t);
 RDB_DECLARE_SERIALIZABLE(proc_directory_metadata_t);
 
 class cluster_directory_metadata_t {
@@ -302,6 +302,8 @@ void migrate_table(const server_id_t &this_server_id,
                 ::write_ack_config_t::SINGLE : ::write_ack_config_t::MAJORITY;
     config.config.durability = old_config.config.durability;
     config.config.user_data = default_user_data();
+    config.config.cache = default_table_cache_config();
+    config.config.compression = block_compression_t::none;
     config.shard_scheme.split_points = old_config.shard_scheme.split_points;
 
     // Scan the servers in the old shard config - need to remove deleted and nil servers
@@ -562,7 +564,8 @@ void migrate_cluster_metadata_to_v2_1(io_backender_t *io_backender,
                       case cluster_version_t::v2_2:
                       case cluster_version_t::v2_3:
                       case cluster_version_t::v2_4:
-                      case cluster_version_t::v2_5_is_latest:
+                      case cluster_version_t::v2_5:
+                      case cluster_version_t::v2_6_is_latest:
                       default:
                         unreachable();
                       }
@@ -583,7 +586,8 @@ void migrate_cluster_metadata_to_v2_1(io_backender_t *io_backender,
                       case cluster_version_t::v2_2:
                       case cluster_version_t::v2_3:
                       case cluster_version_t::v2_4:
-                      case cluster_version_t::v2_5_is_latest:
+                      case cluster_version_t::v2_5:
+                      case cluster_version_t::v2_6_is_latest:
                       default:
                         unreachable();
                       }
@@ -659,7 +663,8 @@ void migrate_auth_metadata_to_v2_1(io_backender_t *io_backender,
                       case cluster_version_t::v2_2:
                       case cluster_version_t::v2_3:
                       case cluster_version_t::v2_4:
-                      case cluster_version_t::v2_5_is_latest:
+                      case cluster_version_t::v2_5:
+                      case cluster_version_t::v2_6_is_latest:
                       default:
                           unreachable();
                       }
@@ -681,7 +686,8 @@ void migrate_auth_metadata_to_v2_1(io_backender_t *io_backender,
                       case cluster_version_t::v2_2:
                       case cluster_version_t::v2_3:
                       case cluster_version_t::v2_4:
-                      case cluster_version_t::v2_5_is_latest:
+                      case cluster_version_t::v2_5:
+                      case cluster_version_t::v2_6_is_latest:
                       default:
                           unreachable();
                       }
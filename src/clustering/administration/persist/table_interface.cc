@@ -4,6 +4,8 @@
 #include <algorithm>
 #include <array>
 
+#include "arch/runtime/numa.hpp"
+#include "buffer_cache/warm_up.hpp"
 #include "clustering/administration/persist/branch_history_manager.hpp"
 #include "clustering/administration/persist/file_keys.hpp"
 #include "clustering/administration/persist/raft_storage_interface.hpp"
@@ -13,6 +15,7 @@
 #include "serializer/log/log_serializer.hpp"
 #include "serializer/merger.hpp"
 #include "serializer/translator.hpp"
+#include "time.hpp"
 
 class real_multistore_ptr_t :
     public multistore_ptr_t {
@@ -23,6 +26,7 @@ public:
             scoped_ptr_t<real_branch_history_manager_t> &&bhm,
             const base_path_t &base_path,
             io_backender_t *io_backender,
+            const log_serializer_dynamic_config_t &serializer_config,
             cache_balancer_t *cache_balancer,
             rdb_context_t *rdb_context,
             perfmon_collection_t *perfmon_collection_serializers,
@@ -32,6 +36,7 @@ public:
                 namespace_id_t, std::pair<real_multistore_ptr_t *, auto_drainer_t::lock_t>
             > *real_multistores) :
         branch_history_manager(std::move(bhm)),
+        log_serializer(nullptr),
         serializer_thread_allocation(std::move(serializer_thread)),
         store_thread_allocations(std::move(store_threads)),
         map_insertion_sentry(
@@ -47,6 +52,7 @@ public:
         // TODO: We should use N slices on M serializers, not N slices
         // on 1 serializer.
 
+        const ticks_t start_ticks = get_ticks();
         int res = access(path.permanent_path().c_str(), R_OK | W_OK);
         bool create = (res != 0);
 
@@ -62,13 +68,20 @@ public:
         // TODO: Could we handle failure when loading the serializer?  Right
         // now, we don't.
 
-        scoped_ptr_t<serializer_t> inner_serializer(new log_serializer_t(
-            log_serializer_t::dynamic_config_t(),
+        log_serializer = new log_serializer_t(
+            serializer_config,
             &file_opener,
-            perfmon_collection_serializers));
+            perfmon_collection_serializers);
+        scoped_ptr_t<serializer_t> inner_serializer(log_serializer);
+        const ticks_t serializer_ready_ticks = get_ticks();
+        merger_group_commit_config_t group_commit_config;
+        group_commit_config.window_ms = serializer_config.group_commit_window_ms;
+        group_commit_config.max_batch_bytes = serializer_config.group_commit_max_bytes;
         serializer.init(new merger_serializer_t(
             std::move(inner_serializer),
-            MERGER_SERIALIZER_MAX_ACTIVE_WRITES));
+            MERGER_SERIALIZER_MAX_ACTIVE_WRITES,
+            group_commit_config,
+            perfmon_collection_serializers));
 
         std::vector<serializer_t *> ptrs;
         ptrs.push_back(serializer.get());
@@ -112,10 +125,20 @@ public:
                     write_durability_t::HARD,
                     &non_interruptor);
             }
+
+            warm_ups[ix].init(
+                new cache_warm_up_t(stores[ix]->cache.get(), path.hot_set_path(ix)));
         });
 
         if (create) {
             file_opener.move_serializer_file_to_permanent_location();
+        } else {
+            const ticks_t ready_ticks = get_ticks();
+            logINF("Loaded table %s in %.3f seconds (%.3f seconds to open its file).",
+                   uuid_to_str(table_id).c_str(),
+                   ticks_to_secs(ticks_t{ready_ticks.nanos - start_ticks.nanos}),
+                   ticks_to_secs(
+                       ticks_t{serializer_ready_ticks.nanos - start_ticks.nanos}));
         }
     }
 
@@ -127,6 +150,7 @@ public:
         pmap(CPU_SHARDING_FACTOR, [this](int ix) {
             if (stores[ix].has()) {
                 on_thread_t thread_switcher(stores[ix]->home_thread());
+                warm_ups[ix].reset();
                 stores[ix].reset();
             }
         });
@@ -155,6 +179,11 @@ public:
         return stores[i].get();
     }
 
+    void set_block_compression(block_compression_t method) {
+        on_thread_t thread_switcher(log_serializer->home_thread());
+        log_serializer->set_block_compression(method);
+    }
+
     bool is_gc_active() {
         rassert(!drainer.is_draining());
         if (serializer.has()) {
@@ -164,11 +193,47 @@ public:
         }
     }
 
+    /* Returns false if none of the stores' caches are warming up.  Otherwise returns
+    true, along with when the earliest warm-up started and how far along they are
+    together. */
+    bool get_warm_up_progress(microtime_t *start_time_out, double *progress_out) {
+        rassert(!drainer.is_draining());
+        bool warming_up = false;
+        uint64_t blocks_loaded = 0;
+        uint64_t blocks_total = 0;
+        for (size_t ix = 0; ix < CPU_SHARDING_FACTOR; ++ix) {
+            if (!warm_ups[ix].has()) {
+                continue;
+            }
+            on_thread_t thread_switcher(warm_ups[ix]->home_thread());
+            microtime_t start_time;
+            uint64_t loaded;
+            uint64_t total;
+            if (warm_ups[ix]->get_progress(&start_time, &loaded, &total)) {
+                *start_time_out = warming_up
+                    ? std::min(*start_time_out, start_time)
+                    : start_time;
+                warming_up = true;
+                blocks_loaded += loaded;
+                blocks_total += total;
+            }
+        }
+        if (warming_up) {
+            *progress_out = blocks_total == 0
+                ? 0.0
+                : static_cast<double>(blocks_loaded) / blocks_total;
+        }
+        return warming_up;
+    }
+
 private:
     scoped_ptr_t<real_branch_history_manager_t> branch_history_manager;
+    /* `log_serializer` is owned by the `merger_serializer_t` in `serializer`. */
+    log_serializer_t *log_serializer;
     scoped_ptr_t<serializer_t> serializer;
     scoped_ptr_t<serializer_multiplexer_t> multiplexer;
     scoped_ptr_t<store_t> stores[CPU_SHARDING_FACTOR];
+    scoped_ptr_t<cache_warm_up_t> warm_ups[CPU_SHARDING_FACTOR];
 
     scoped_ptr_t<thread_allocation_t> serializer_thread_allocation;
     std::vector<scoped_ptr_t<thread_allocation_t> > store_thread_allocations;
@@ -287,7 +352,14 @@ void real_table_persistence_interface_t::load_multistore(
         new thread_allocation_t(&thread_allocator));
     std::vector<scoped_ptr_t<thread_allocation_t> > store_threads;
     for (size_t i = 0; i < CPU_SHARDING_FACTOR; ++i) {
-        store_threads.emplace_back(new thread_allocation_t(&thread_allocator));
+        // In NUMA mode, each CPU shard stays on one node, and the shards are split
+        // evenly among the nodes.  The store's cache lives on its thread, so its
+        // pages get allocated from the node's memory.
+        const int numa_node = numa_mode_enabled()
+            ? static_cast<int>(i * get_num_numa_nodes() / CPU_SHARDING_FACTOR)
+            : -1;
+        store_threads.emplace_back(
+            new thread_allocation_t(&thread_allocator, numa_node));
     }
 
     multistore_ptr_out->init(new real_multistore_ptr_t(
@@ -296,6 +368,7 @@ void real_table_persistence_interface_t::load_multistore(
         std::move(bhm),
         base_path,
         io_backender,
+        serializer_config,
         cache_balancer,
         rdb_context,
         perfmon_collection_serializers,
@@ -323,9 +396,23 @@ void real_table_persistence_interface_t::destroy_multistore(
 
     std::string filepath = file_name_for(table_id).permanent_path();
     logNTC("Removing file %s\n", filepath.c_str());
-    const int res = ::unlink(filepath.c_str());
+    int res = ::unlink(filepath.c_str());
     guarantee_err(res == 0 || get_errno() == ENOENT,
                   "unlink failed for file %s", filepath.c_str());
+
+    // The serializer might have left an LBA snapshot behind when it shut down.
+    std::string snapshot_path = file_name_for(table_id).lba_snapshot_path();
+    res = ::unlink(snapshot_path.c_str());
+    guarantee_err(res == 0 || get_errno() == ENOENT,
+                  "unlink failed for file %s", snapshot_path.c_str());
+
+    // So might the caches, with their hot sets.
+    for (size_t ix = 0; ix < CPU_SHARDING_FACTOR; ++ix) {
+        std::string hot_set_path = file_name_for(table_id).hot_set_path(ix);
+        res = ::unlink(hot_set_path.c_str());
+        guarantee_err(res == 0 || get_errno() == ENOENT,
+                      "unlink failed for file %s", hot_set_path.c_str());
+    }
 }
 
 serializer_filepath_t real_table_persistence_interface_t::file_name_for(
@@ -362,3 +449,61 @@ bool real_table_persistence_interface_t::is_gc_active() const {
 
     return false;
 }
+
+std::map<namespace_id_t, std::pair<microtime_t, double> >
+real_table_persistence_interface_t::get_defrag_progress() const {
+    std::map<namespace_id_t, std::pair<microtime_t, double> > progress;
+    for (int thread = 0; thread < get_num_db_threads(); ++thread) {
+        std::map<namespace_id_t, std::pair<serializer_t *, auto_drainer_t::lock_t> >
+            serializers_copy;
+
+        // As in `is_gc_active()`, we hold on to the `auto_drainer_t::lock_t`.
+        for (auto real_multistore : real_multistores) {
+            serializer_t *serializer =
+                real_multistore.second.first->get_serializer();
+            if (serializer == nullptr ||
+                    serializer->home_thread() != threadnum_t(thread)) {
+                continue;
+            }
+            serializers_copy.insert(std::make_pair(
+                real_multistore.first,
+                std::make_pair(serializer, real_multistore.second.second)));
+        }
+
+        {
+            on_thread_t on_thread((threadnum_t(thread)));
+            for (auto const &pair : serializers_copy) {
+                microtime_t start_time;
+                double table_progress;
+                if (pair.second.first->get_defrag_progress(
+                        &start_time, &table_progress)) {
+                    progress.insert(std::make_pair(
+                        pair.first, std::make_pair(start_time, table_progress)));
+                }
+            }
+        }
+    }
+
+    return progress;
+}
+
+std::map<namespace_id_t, std::pair<microtime_t, double> >
+real_table_persistence_interface_t::get_warm_up_progress() const {
+    std::map<namespace_id_t, std::pair<microtime_t, double> > progress;
+
+    // As in `is_gc_active()`, we hold on to the `auto_drainer_t::lock_t`s.  We need a
+    // copy anyway, since `real_multistores` can change while we switch threads.
+    std::map<
+        namespace_id_t, std::pair<real_multistore_ptr_t *, auto_drainer_t::lock_t>
+    > real_multistores_copy = real_multistores;
+    for (auto const &pair : real_multistores_copy) {
+        microtime_t start_time;
+        double table_progress;
+        if (pair.second.first->get_warm_up_progress(&start_time, &table_progress)) {
+            progress.insert(std::make_pair(
+                pair.first, std::make_pair(start_time, table_progress)));
+        }
+    }
+
+    return progress;
+}
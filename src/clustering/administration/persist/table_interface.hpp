@@ -5,6 +5,7 @@
 #include "clustering/administration/perfmon_collection_repo.hpp"
 #include "clustering/administration/persist/raft_storage_interface.hpp"
 #include "clustering/table_manager/table_metadata.hpp"
+#include "serializer/log/config.hpp"
 
 class cache_balancer_t;
 class metadata_file_t;
@@ -19,12 +20,14 @@ public:
             cache_balancer_t *_cache_balancer,
             const base_path_t &_base_path,
             rdb_context_t *_rdb_context,
-            metadata_file_t *_metadata_file) :
+            metadata_file_t *_metadata_file,
+            const log_serializer_dynamic_config_t &_serializer_config) :
         io_backender(_io_backender),
         cache_balancer(_cache_balancer),
         base_path(_base_path),
         rdb_context(_rdb_context),
         metadata_file(_metadata_file),
+        serializer_config(_serializer_config),
         /* We assign threads from the lowest thread number upwards. This is to reduce
         the potential for conflicting with cluster connection threads, which are
         assigned from the highest thread number downwards. */
@@ -72,6 +75,16 @@ public:
 
     bool is_gc_active() const;
 
+    /* Returns the start time and progress of every table file that is currently being
+    defragmented, see `serializer_t::get_defrag_progress()`. */
+    std::map<namespace_id_t, std::pair<microtime_t, double> >
+    get_defrag_progress() const;
+
+    /* Returns the start time and progress of every table whose caches are being
+    warmed up after a restart, see `cache_warm_up_t`. */
+    std::map<namespace_id_t, std::pair<microtime_t, double> >
+    get_warm_up_progress() const;
+
 private:
     serializer_filepath_t file_name_for(const namespace_id_t &table_id);
     threadnum_t pick_thread();
@@ -81,6 +94,7 @@ private:
     base_path_t const base_path;
     rdb_context_t * const rdb_context;
     metadata_file_t * const metadata_file;
+    log_serializer_dynamic_config_t const serializer_config;
 
     std::map<
         namespace_id_t, std::pair<real_multistore_ptr_t *, auto_drainer_t::lock_t>
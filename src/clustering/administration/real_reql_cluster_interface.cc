@@ -335,6 +335,8 @@ bool real_reql_cluster_interface_t::table_create(
         config.config.write_ack_config = write_ack_config_t::MAJORITY;
         config.config.durability = durability;
         config.config.user_data = default_user_data();
+        config.config.cache = default_table_cache_config();
+        config.config.compression = block_compression_t::none;
 
         table_id = generate_uuid();
         m_table_meta_client->create(table_id, config, &interruptor_on_home);
@@ -691,6 +693,8 @@ void real_reql_cluster_interface_t::reconfigure_internal(
     new_config.config.write_ack_config = old_config.config.write_ack_config;
     new_config.config.durability = old_config.config.durability;
     new_config.config.user_data = old_config.config.user_data;
+    new_config.config.cache = old_config.config.cache;
+    new_config.config.compression = old_config.config.compression;
 
     calculate_split_points_intelligently(
         table_id,
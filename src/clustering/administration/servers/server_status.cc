@@ -17,6 +17,16 @@ ql::datum_t convert_host_and_port_to_datum(const host_and_port_t &x) {
     return std::move(builder).to_datum();
 }
 
+ql::datum_t convert_numa_node_to_datum(const numa_node_placement_t &node) {
+    std::function<ql::datum_t(const int32_t &)> convert_number =
+        [](const int32_t &number) { return ql::datum_t(static_cast<double>(number)); };
+    ql::datum_object_builder_t builder;
+    builder.overwrite("node", ql::datum_t(static_cast<double>(node.os_node)));
+    builder.overwrite("cpus", convert_vector_to_datum(convert_number, node.cpus));
+    builder.overwrite("threads", convert_vector_to_datum(convert_number, node.threads));
+    return std::move(builder).to_datum();
+}
+
 server_status_artificial_table_backend_t::server_status_artificial_table_backend_t(
         rdb_context_t *rdb_context,
         lifetime_t<name_resolver_t const &> name_resolver,
@@ -72,6 +82,11 @@ bool server_status_artificial_table_backend_t::format_row(
             metadata.proc.argv));
     proc_builder.overwrite("cache_size_mb", ql::datum_t(
         static_cast<double>(metadata.actual_cache_size_bytes) / MEGABYTE));
+    proc_builder.overwrite("numa", metadata.proc.numa_nodes.empty()
+        ? ql::datum_t::null()
+        : convert_vector_to_datum<numa_node_placement_t>(
+            &convert_numa_node_to_datum,
+            metadata.proc.numa_nodes));
     builder.overwrite("process", std::move(proc_builder).to_datum());
 
     ASSERT_NO_CORO_WAITING;
@@ -39,10 +39,11 @@ parsed_stats_t::server_stats_t::server_stats_t() :
 parsed_stats_t::table_stats_t::table_stats_t() :
     read_docs_per_sec(0), read_docs_total(0),
     written_docs_per_sec(0), written_docs_total(0),
-    in_use_bytes(0), metadata_bytes(0), data_bytes(0),
+    in_use_bytes(0), limit_bytes(0), metadata_bytes(0), data_bytes(0),
     garbage_bytes(0), preallocated_bytes(0),
     read_bytes_per_sec(0), read_bytes_total(0),
-    written_bytes_per_sec(0), written_bytes_total(0) { }
+    written_bytes_per_sec(0), written_bytes_total(0),
+    lba_index_memory_bytes(0) { }
 
 parsed_stats_t::parsed_stats_t(const std::vector<ql::datum_t> &stats) {
     for (auto const &s : stats) {
@@ -125,6 +126,8 @@ void parsed_stats_t::store_shard_values(const ql::datum_t &shard_perf,
                 } else if (key == "cache") {
                     add_perfmon_value(sub_pair.second, "in_use_bytes",
                                       &stats_out->in_use_bytes);
+                    add_perfmon_value(sub_pair.second, "limit_bytes",
+                                      &stats_out->limit_bytes);
                 }
             }
         }
@@ -142,6 +145,8 @@ void parsed_stats_t::store_serializer_values(const ql::datum_t &ser_perf,
                         &stats_out->written_bytes_per_sec);
     store_perfmon_value(ser_perf, "serializer_written_bytes_total",
                         &stats_out->written_bytes_total);
+    store_perfmon_value(ser_perf, "serializer_lba_index_memory_bytes",
+                        &stats_out->lba_index_memory_bytes);
 
     store_perfmon_value(ser_perf, "serializer_data_extents",
                         &stats_out->data_bytes);
@@ -552,6 +557,7 @@ bool table_server_stats_request_t::to_datum(const parsed_stats_t &stats,
 
         ql::datum_object_builder_t se_cache_builder;
         ADD_STAT(se_cache_builder, table_stats, in_use_bytes);
+        ADD_STAT(se_cache_builder, table_stats, limit_bytes);
 
         ql::datum_object_builder_t se_disk_space_builder;
         ADD_STAT(se_disk_space_builder, table_stats, metadata_bytes);
@@ -564,6 +570,7 @@ bool table_server_stats_request_t::to_datum(const parsed_stats_t &stats,
         ADD_STAT(se_disk_builder, table_stats, read_bytes_total);
         ADD_STAT(se_disk_builder, table_stats, written_bytes_per_sec);
         ADD_STAT(se_disk_builder, table_stats, written_bytes_total);
+        ADD_STAT(se_disk_builder, table_stats, lba_index_memory_bytes);
         se_disk_builder.overwrite("space_usage", std::move(se_disk_space_builder).to_datum());
 
         ql::datum_object_builder_t se_builder;
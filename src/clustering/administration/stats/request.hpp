@@ -28,6 +28,7 @@ public:
         double written_docs_per_sec;
         double written_docs_total;
         double in_use_bytes;
+        double limit_bytes;
         double metadata_bytes;
         double data_bytes;
         double garbage_bytes;
@@ -36,6 +37,7 @@ public:
         double read_bytes_total;
         double written_bytes_per_sec;
         double written_bytes_total;
+        double lba_index_memory_bytes;
     };
 
     struct server_stats_t {
@@ -1,12 +1,15 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "clustering/administration/tables/table_config.hpp"
 
+#include <limits>
+
 #include "clustering/administration/datum_adapter.hpp"
 #include "clustering/administration/metadata.hpp"
 #include "clustering/administration/tables/generate_config.hpp"
 #include "clustering/administration/tables/split_points.hpp"
 #include "clustering/table_manager/table_meta_client.hpp"
 #include "concurrency/cross_thread_signal.hpp"
+#include "config/args.hpp"
 #include "containers/archive/string_stream.hpp"
 #include "rdb_protocol/terms/write_hook.hpp"
 
@@ -227,6 +230,35 @@ bool convert_durability_from_datum(
     return true;
 }
 
+ql::datum_t convert_block_compression_to_datum(
+        block_compression_t compression) {
+    switch (compression) {
+        case block_compression_t::none:
+            return ql::datum_t("none");
+        case block_compression_t::lz4:
+            return ql::datum_t("lz4");
+        default:
+            unreachable();
+    }
+}
+
+bool convert_block_compression_from_datum(
+        const ql::datum_t &datum,
+        block_compression_t *compression_out,
+        admin_err_t *error_out) {
+    if (datum == ql::datum_t("none")) {
+        *compression_out = block_compression_t::none;
+    } else if (datum == ql::datum_t("lz4")) {
+        *compression_out = block_compression_t::lz4;
+    } else {
+        *error_out = admin_err_t{
+            "Expected \"none\" or \"lz4\", got: " + datum.print(),
+            query_state_t::FAILED};
+        return false;
+    }
+    return true;
+}
+
 struct convert_flush_interval_visitor_t : public boost::static_visitor<ql::datum_t> {
     ql::datum_t operator()(flush_interval_default_t) const {
         return ql::datum_t("default");
@@ -275,6 +307,107 @@ bool convert_flush_interval_from_datum(
     return true;
 }
 
+ql::datum_t convert_table_cache_config_to_datum(const table_cache_config_t &cache) {
+    ql::datum_object_builder_t builder;
+    builder.overwrite("min_size_mb",
+        ql::datum_t(static_cast<double>(cache.min_size) / MEGABYTE));
+    if (static_cast<bool>(cache.max_size)) {
+        builder.overwrite("max_size_mb",
+            ql::datum_t(static_cast<double>(*cache.max_size) / MEGABYTE));
+    } else {
+        builder.overwrite("max_size_mb", ql::datum_t::null());
+    }
+    builder.overwrite("priority", ql::datum_t(cache.priority));
+    return std::move(builder).to_datum();
+}
+
+bool convert_cache_size_from_datum(
+        const ql::datum_t &datum,
+        uint64_t *size_out,
+        admin_err_t *error_out) {
+    if (datum.get_type() != ql::datum_t::R_NUM) {
+        *error_out = admin_err_t{
+            "Expected a number, got: " + datum.print(),
+            query_state_t::FAILED};
+        return false;
+    }
+    double size_mb = datum.as_num();
+    if (size_mb < 0) {
+        *error_out = admin_err_t{
+            "Cache size cannot be negative.",
+            query_state_t::FAILED};
+        return false;
+    }
+    if (size_mb * MEGABYTE > static_cast<double>(std::numeric_limits<int64_t>::max())) {
+        *error_out = admin_err_t{
+            "Value is too big.",
+            query_state_t::FAILED};
+        return false;
+    }
+    *size_out = size_mb * MEGABYTE;
+    return true;
+}
+
+/* All fields are optional, so that `{cache: {max_size_mb: 100}}` works when creating a
+table.  Once the table exists, updates get merged into the existing object anyway. */
+bool convert_table_cache_config_from_datum(
+        const ql::datum_t &datum,
+        table_cache_config_t *cache_out,
+        admin_err_t *error_out) {
+    converter_from_datum_object_t converter;
+    if (!converter.init(datum, error_out)) {
+        return false;
+    }
+    *cache_out = default_table_cache_config();
+
+    ql::datum_t min_size_datum;
+    converter.get_optional("min_size_mb", &min_size_datum);
+    if (min_size_datum.has()) {
+        if (!convert_cache_size_from_datum(
+                min_size_datum, &cache_out->min_size, error_out)) {
+            error_out->msg = "In `min_size_mb`: " + error_out->msg;
+            return false;
+        }
+    }
+
+    ql::datum_t max_size_datum;
+    converter.get_optional("max_size_mb", &max_size_datum);
+    if (max_size_datum.has() && max_size_datum.get_type() != ql::datum_t::R_NULL) {
+        uint64_t max_size;
+        if (!convert_cache_size_from_datum(max_size_datum, &max_size, error_out)) {
+            error_out->msg = "In `max_size_mb`: " + error_out->msg;
+            return false;
+        }
+        cache_out->max_size.set(max_size);
+    }
+
+    ql::datum_t priority_datum;
+    converter.get_optional("priority", &priority_datum);
+    if (priority_datum.has()) {
+        if (priority_datum.get_type() != ql::datum_t::R_NUM
+                || !(priority_datum.as_num() > 0)
+                || priority_datum.as_num() > MAX_CACHE_PRIORITY) {
+            *error_out = admin_err_t{
+                strprintf("In `priority`: Expected a positive number no greater "
+                          "than %g, got: ", MAX_CACHE_PRIORITY)
+                    + priority_datum.print(),
+                query_state_t::FAILED};
+            return false;
+        }
+        cache_out->priority = priority_datum.as_num();
+    }
+
+    if (static_cast<bool>(cache_out->max_size)
+            && *cache_out->max_size < cache_out->min_size) {
+        *error_out = admin_err_t{
+            "`max_size_mb` cannot be smaller than `min_size_mb`.",
+            query_state_t::FAILED};
+        return false;
+    }
+
+    return converter.check_no_extra_keys(error_out);
+}
+
 ql::datum_t convert_table_config_shard_to_datum(
         const table_config_t::shard_t &shard,
         admin_identifier_format_t identifier_format,
@@ -461,6 +594,9 @@ ql::datum_t convert_table_config_to_datum(
     builder.overwrite("flush_interval",
         convert_flush_interval_to_datum(config.flush_interval));
     builder.overwrite("data", config.user_data.datum);
+    builder.overwrite("cache", convert_table_cache_config_to_datum(config.cache));
+    builder.overwrite("compression",
+        convert_block_compression_to_datum(config.compression));
     return std::move(builder).to_datum();
 }
 
@@ -703,6 +839,34 @@ bool convert_table_config_and_name_from_datum(
         config_out->user_data = default_user_data();
     }
 
+    if (existed_before || converter.has("cache")) {
+        ql::datum_t cache_datum;
+        if (!converter.get("cache", &cache_datum, error_out)) {
+            return false;
+        }
+        if (!convert_table_cache_config_from_datum(
+                cache_datum, &config_out->cache, error_out)) {
+            error_out->msg = "In `cache`: " + error_out->msg;
+            return false;
+        }
+    } else {
+        config_out->cache = default_table_cache_config();
+    }
+
+    if (existed_before || converter.has("compression")) {
+        ql::datum_t compression_datum;
+        if (!converter.get("compression", &compression_datum, error_out)) {
+            return false;
+        }
+        if (!convert_block_compression_from_datum(
+                compression_datum, &config_out->compression, error_out)) {
+            error_out->msg = "In `compression`: " + error_out->msg;
+            return false;
+        }
+    } else {
+        config_out->compression = block_compression_t::none;
+    }
+
     if (!converter.check_no_extra_keys(error_out)) {
         return false;
     }
@@ -141,6 +141,15 @@ flush_interval_config_t default_flush_interval_config() {
     return flush_interval_config_t{flush_interval_default_t{}};
 }
 
+table_cache_config_t default_table_cache_config() {
+    return table_cache_config_t{0, r_nullopt, DEFAULT_CACHE_PRIORITY};
+}
+
+RDB_IMPL_SERIALIZABLE_3_SINCE_v2_6(table_cache_config_t,
+    min_size, max_size, priority);
+RDB_IMPL_EQUALITY_COMPARABLE_3(table_cache_config_t,
+    min_size, max_size, priority);
+
 RDB_MAKE_SERIALIZABLE_1(user_data_t, datum);
 
 RDB_IMPL_EQUALITY_COMPARABLE_1(user_data_t, datum);
@@ -181,6 +190,8 @@ archive_result_t deserialize_table_config_pre_v2_4(
     tc->durability = std::move(durability);
     tc->flush_interval = default_flush_interval_config();
     tc->user_data = default_user_data();
+    tc->cache = default_table_cache_config();
+    tc->compression = block_compression_t::none;
 
     return res;
 }
@@ -221,7 +232,60 @@ archive_result_t deserialize_table_config_v2_4(
                          std::move(write_ack_config),
                          std::move(durability),
                          default_flush_interval_config(),
-                         default_user_data()};
+                         default_user_data(),
+                         default_table_cache_config(),
+                         block_compression_t::none};
+
+    return res;
+}
+
+archive_result_t deserialize_table_config_v2_5(
+    read_stream_t *s, table_config_t *tc) {
+    const cluster_version_t W = cluster_version_t::v2_5;
+    archive_result_t res;
+
+    table_basic_config_t basic;
+    res = deserialize<W>(s, &basic);
+    if (bad(res)) { return res; }
+
+    std::vector<table_config_t::shard_t> shards;
+    res = deserialize<W>(s, &shards);
+    if (bad(res)) { return res; }
+
+    optional<write_hook_config_t> write_hook;
+    res = deserialize<W>(s, &write_hook);
+    if (bad(res)) { return res; }
+
+    std::map<std::string, sindex_config_t> sindexes;
+    res = deserialize<W>(s, &sindexes);
+    if (bad(res)) { return res; }
+
+    write_ack_config_t write_ack_config;
+    res = deserialize<W>(s, &write_ack_config);
+    if (bad(res)) { return res; }
+
+    write_durability_t durability;
+    res = deserialize<W>(s, &durability);
+    if (bad(res)) { return res; }
+
+    flush_interval_config_t flush_interval;
+    res = deserialize<W>(s, &flush_interval);
+    if (bad(res)) { return res; }
+
+    user_data_t user_data;
+    res = deserialize<W>(s, &user_data);
+    if (bad(res)) { return res; }
+
+    *tc = table_config_t{std::move(basic),
+                         std::move(shards),
+                         std::move(sindexes),
+                         std::move(write_hook),
+                         std::move(write_ack_config),
+                         std::move(durability),
+                         std::move(flush_interval),
+                         std::move(user_data),
+                         default_table_cache_config(),
+                         block_compression_t::none};
 
     return res;
 }
@@ -250,13 +314,19 @@ archive_result_t deserialize<cluster_version_t::v2_4>(
     return deserialize_table_config_v2_4(s, tc);
 }
 
-RDB_IMPL_SERIALIZABLE_8_SINCE_v2_5(table_config_t,
+template <>
+archive_result_t deserialize<cluster_version_t::v2_5>(
+    read_stream_t *s, table_config_t *tc) {
+    return deserialize_table_config_v2_5(s, tc);
+}
+
+RDB_IMPL_SERIALIZABLE_10_SINCE_v2_6(table_config_t,
     basic, shards, write_hook, sindexes, write_ack_config, durability,
-    flush_interval, user_data);
+    flush_interval, user_data, cache, compression);
 
-RDB_IMPL_EQUALITY_COMPARABLE_8(table_config_t,
+RDB_IMPL_EQUALITY_COMPARABLE_10(table_config_t,
     basic, shards, write_hook, sindexes, write_ack_config, durability,
-    flush_interval, user_data);
+    flush_interval, user_data, cache, compression);
 
 RDB_IMPL_SERIALIZABLE_1_SINCE_v1_16(table_shard_scheme_t, split_points);
 RDB_IMPL_EQUALITY_COMPARABLE_1(table_shard_scheme_t, split_points);
@@ -323,3 +393,13 @@ flush_interval_t get_flush_interval(const table_config_t &config) {
         get_flush_interval_visitor_t{},
         config.flush_interval.variant);
 }
+
+cache_quota_t get_cache_quota(const table_config_t &config) {
+    rassert(config.cache.priority > 0);
+    return cache_quota_t{
+        config.cache.min_size,
+        static_cast<bool>(config.cache.max_size)
+            ? *config.cache.max_size
+            : UNLIMITED_CACHE_QUOTA,
+        config.cache.priority};
+}
@@ -17,6 +17,7 @@
 #include "rdb_protocol/protocol.hpp"
 #include "rpc/semilattice/joins/macros.hpp"
 #include "rpc/serialize_macros.hpp"
+#include "serializer/log/config.hpp"   // for `block_compression_t`
 
 /* This is the metadata for a single table. */
 
@@ -73,6 +74,23 @@ public:
 
 user_data_t default_user_data();
 
+/* `table_cache_config_t` is how much of the cache the table gets on each server that
+hosts it.  `min_size` is guaranteed to the table even if other tables need the memory
+more; the table never gets more than `max_size`, if there is one.  Within those bounds,
+the cache balancer weighs the table's demand for memory by `priority`, which is
+positive and at most `MAX_CACHE_PRIORITY`. */
+class table_cache_config_t {
+public:
+    uint64_t min_size;
+    optional<uint64_t> max_size;
+    double priority;
+};
+
+table_cache_config_t default_table_cache_config();
+
+RDB_DECLARE_SERIALIZABLE(table_cache_config_t);
+RDB_DECLARE_EQUALITY_COMPARABLE(table_cache_config_t);
+
 /* `table_config_t` describes the complete contents of the `rethinkdb.table_config`
 artificial table. */
 
@@ -96,6 +114,9 @@ public:
     write_durability_t durability;
     flush_interval_config_t flush_interval;
     user_data_t user_data;  // has user-exposed name "data"
+    table_cache_config_t cache;
+    /* How the table's data blocks are compressed when they get written to disk. */
+    block_compression_t compression;
 };
 
 RDB_DECLARE_EQUALITY_COMPARABLE(table_config_t);
@@ -105,6 +126,10 @@ RDB_DECLARE_EQUALITY_COMPARABLE(table_config_t::shard_t);
 
 flush_interval_t get_flush_interval(const table_config_t &);
 
+/* Returns the cache quota of the whole table on one server. The caller has to split it
+up between the table's CPU shards. */
+cache_quota_t get_cache_quota(const table_config_t &);
+
 class table_shard_scheme_t {
 public:
     std::vector<store_key_t> split_points;
@@ -39,6 +39,12 @@ void replica_t::do_read(
     // Wait until all writes that the read needs to see have completed.
     end_enforcer.wait_all_before(min_timestamp, interruptor);
 
+    // Point reads of pages that nobody is writing to can usually be answered from
+    // the copies the cache published, without contending for the superblock.
+    if (store->read_lock_free(read, response_out)) {
+        return;
+    }
+
     // Leave the token empty. We're enforcing ordering ourselves through `end_enforcer`.
     read_token_t read_token;
 
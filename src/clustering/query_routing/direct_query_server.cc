@@ -32,6 +32,16 @@ void direct_query_server_t::on_read(
         return;
     }
 
+    /* Outdated reads don't care about ordering, so point reads can be
+    answered from the pages the cache published for lock-free reads. */
+    {
+        read_response_t response;
+        if (svs->read_lock_free(read, &response)) {
+            send(mailbox_manager, cont, response);
+            return;
+        }
+    }
+
     try {
         /* Leave the token empty. We're not actually interested in ordering here. */
         read_token_t token;
@@ -5,6 +5,7 @@
 #include "clustering/immediate_consistency/history.hpp"
 #include "protocol_api.hpp"
 #include "region/region.hpp"
+#include "serializer/log/config.hpp"
 
 class store_t;
 
@@ -41,6 +42,10 @@ public:
     it can create and destroy sindexes on them. The `table_contract` code should never
     use it, and some unit tests will return `nullptr` from here. */
     virtual store_t *get_underlying_store(size_t i) = 0;
+
+    /* Changes how the table's data blocks get compressed from now on. All the CPU
+    shards share one serializer, so this is a property of the whole bundle. */
+    virtual void set_block_compression(block_compression_t method) = 0;
 };
 
 #endif /* CLUSTERING_TABLE_CONTRACT_CPU_SHARDING_HPP_ */
@@ -0,0 +1,42 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved
+#include "clustering/table_manager/block_compression_manager.hpp"
+
+#include "logger.hpp"
+#include "serializer/log/block_compression.hpp"
+
+block_compression_manager_t::block_compression_manager_t(
+        multistore_ptr_t *multistore_,
+        const clone_ptr_t<watchable_t<table_config_t> > &table_config_) :
+    multistore(multistore_), table_config(table_config_),
+    update_pumper([this](signal_t *interruptor) { update_blocking(interruptor); }),
+    table_config_subs([this]() { update_pumper.notify(); })
+{
+    watchable_t<table_config_t>::freeze_t freeze(table_config);
+    table_config_subs.reset(table_config, &freeze);
+    update_pumper.notify();
+}
+
+void block_compression_manager_t::update_blocking(UNUSED signal_t *interruptor) {
+    block_compression_t method;
+    std::string table_name;
+    table_config->apply_read([&](const table_config_t *config) {
+        method = config->compression;
+        table_name = config->basic.name.str();
+    });
+
+    if (static_cast<bool>(last_configured) && *last_configured == method) {
+        return;
+    }
+    last_configured.set(method);
+
+    if (!block_compression_supported(method)) {
+        /* Other servers might support the method, so the config itself is fine. We
+        just can't follow it here. */
+        logWRN("Table `%s` is configured to compress its data, but this build of "
+               "RethinkDB doesn't support the compression method. Its data will be "
+               "stored uncompressed on this server.", table_name.c_str());
+        method = block_compression_t::none;
+    }
+
+    multistore->set_block_compression(method);
+}
@@ -0,0 +1,41 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_TABLE_MANAGER_BLOCK_COMPRESSION_MANAGER_HPP_
+#define CLUSTERING_TABLE_MANAGER_BLOCK_COMPRESSION_MANAGER_HPP_
+
+#include "clustering/table_contract/cpu_sharding.hpp"
+#include "clustering/administration/tables/table_metadata.hpp"
+#include "concurrency/pump_coro.hpp"
+#include "concurrency/watchable.hpp"
+
+/* The `block_compression_manager_t` is responsible for reading the `compression`
+setting from the `table_config_t` and passing it on to the table's serializer. Blocks
+that were written before the setting changed stay as they are until they get rewritten
+(or moved by the garbage collector, which copies them verbatim). */
+
+class block_compression_manager_t {
+public:
+    block_compression_manager_t(
+        multistore_ptr_t *multistore,
+        const clone_ptr_t<watchable_t<table_config_t> > &table_config);
+
+private:
+    void update_blocking(signal_t *interruptor);
+
+    multistore_ptr_t *const multistore;
+    clone_ptr_t<watchable_t<table_config_t> > const table_config;
+
+    /* The last setting we saw, so that we don't touch the serializer (or warn again)
+    when some other part of the config changes. */
+    optional<block_compression_t> last_configured;
+
+    /* Destructor order matters: The `table_config_subs` must be destroyed before the
+    `update_pumper` because it calls `update_pumper.notify()`. But `update_pumper` must
+    be destroyed before the other variables because it runs `update_blocking()`, which
+    accesses the other variables. */
+    pump_coro_t update_pumper;
+
+    watchable_t<table_config_t>::subscription_t table_config_subs;
+};
+
+#endif /* CLUSTERING_TABLE_MANAGER_BLOCK_COMPRESSION_MANAGER_HPP_ */
+
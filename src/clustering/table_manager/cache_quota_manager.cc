@@ -0,0 +1,38 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved
+#include "clustering/table_manager/cache_quota_manager.hpp"
+
+#include "concurrency/cross_thread_signal.hpp"
+#include "rdb_protocol/store.hpp"
+
+cache_quota_manager_t::cache_quota_manager_t(
+        multistore_ptr_t *multistore_,
+        const clone_ptr_t<watchable_t<table_config_t> > &table_config_) :
+    multistore(multistore_), table_config(table_config_),
+    update_pumper([this](signal_t *interruptor) { update_blocking(interruptor); }),
+    table_config_subs([this]() { update_pumper.notify(); })
+{
+    watchable_t<table_config_t>::freeze_t freeze(table_config);
+    table_config_subs.reset(table_config, &freeze);
+    update_pumper.notify();
+}
+
+void cache_quota_manager_t::update_blocking(signal_t *interruptor) {
+    cache_quota_t quota;
+    table_config->apply_read([&](const table_config_t *config) {
+        quota = get_cache_quota(*config);
+    });
+
+    cache_quota_t shard_quota = quota;
+    shard_quota.min_bytes = quota.min_bytes / CPU_SHARDING_FACTOR;
+    if (quota.max_bytes != UNLIMITED_CACHE_QUOTA) {
+        shard_quota.max_bytes = quota.max_bytes / CPU_SHARDING_FACTOR;
+    }
+
+    for (size_t i = 0; i < CPU_SHARDING_FACTOR; ++i) {
+        store_t *store = multistore->get_underlying_store(i);
+        cross_thread_signal_t ct_interruptor(interruptor, store->home_thread());
+        on_thread_t thread_switcher(store->home_thread());
+
+        store->configure_cache_quota(shard_quota);
+    }
+}
@@ -66,6 +66,10 @@
 // 0 = minimal priority
 #define SINDEX_POST_CONSTRUCTION_CACHE_PRIORITY   5
 
+// The cache priority to use for loading the hot set back into the cache after a
+// restart (see `cache_warm_up_t`).  It has the same meaning as above.
+#define CACHE_WARM_UP_CACHE_PRIORITY              5
+
 // Size of the buffer used to perform IO operations (in bytes).
 #define IO_BUFFER_SIZE                            (4 * KILOBYTE)
 
@@ -92,6 +96,9 @@
 // small values of this variable.
 #define MERGER_SERIALIZER_MAX_ACTIVE_WRITES       1
 
+// The longest group commit window (--group-commit-window) that we accept, in ms
+#define MAX_GROUP_COMMIT_WINDOW_MS                1000
+
 // I/O priority of block writes in the merger_serializer_t
 #define MERGER_BLOCK_WRITE_IO_PRIORITY            64
 
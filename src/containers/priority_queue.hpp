@@ -54,6 +54,9 @@ public:
     void remove(entry_t *);
     T pop();
     void update(int);
+    /* Restores the heap order after the result of `Less` changed for many entries at
+     * once, in linear time */
+    void rebuild();
 public:
     void validate();
 
@@ -50,6 +50,15 @@ public:
     std::string permanent_path() const { return permanent_path_; }
     std::string temporary_path() const { return temporary_path_; }
 
+    // Where the serializer keeps a snapshot of the file's LBA index between restarts.
+    std::string lba_snapshot_path() const { return permanent_path_ + ".lba_snapshot"; }
+
+    // Where the cache of the given CPU shard keeps its hot set manifest, see
+    // `cache_warm_up_t`.
+    std::string hot_set_path(size_t shard) const {
+        return permanent_path_ + ".hot_set_" + std::to_string(shard);
+    }
+
 private:
     friend serializer_filepath_t unittest::manual_serializer_filepath(const std::string& permanent_path,
                                                                       const std::string& temporary_path);
@@ -103,6 +103,61 @@ void rdb_get(const store_key_t &store_key, btree_slice_t *slice,
     }
 }
 
+bool rdb_get_from_published_pages(const store_key_t &store_key, cache_t *cache,
+                                  point_read_response_t *response) {
+    alt::published_pages_t *published_pages = cache->published_pages();
+    if (!published_pages->enabled()) {
+        return false;
+    }
+    const max_block_size_t block_size = cache->max_block_size();
+    rdb_value_sizer_t sizer(block_size);
+    scoped_malloc_t<void> value(sizer.max_possible_size());
+    std::string serialized_value;
+    published_lookup_result_t result;
+    {
+        alt::published_pages_t::reader_t reader(published_pages);
+        block_id_t root_id;
+        if (!get_published_root_block_id(reader, &root_id)) {
+            published_pages->note_lookup(false);
+            return false;
+        }
+        result = find_keyvalue_in_published_pages(
+            &sizer, reader, root_id, store_key.btree_key(), value.get());
+        if (result == published_lookup_result_t::found) {
+            const bool copied = blob::copy_value_from_blocks(
+                block_size,
+                static_cast<rdb_value_t *>(value.get())->value_ref(),
+                blob::btree_maxreflen,
+                [&](block_id_t block_id) -> const void * {
+                    block_size_t leaf_size = block_size_t::undefined();
+                    const void *leaf = reader.find(block_id, &leaf_size);
+                    return leaf != nullptr && leaf_size.value() == block_size.value()
+                        ? leaf
+                        : nullptr;
+                },
+                &serialized_value);
+            if (!copied) {
+                result = published_lookup_result_t::unavailable;
+            }
+        }
+        if (result == published_lookup_result_t::unavailable || !reader.validate()) {
+            published_pages->note_lookup(false);
+            return false;
+        }
+    }
+    published_pages->note_lookup(true);
+
+    if (result == published_lookup_result_t::not_found) {
+        response->data = ql::datum_t::null();
+    } else {
+        buffer_read_stream_t read_stream(serialized_value.data(),
+                                         serialized_value.size());
+        archive_result_t res = datum_deserialize(&read_stream, &response->data);
+        guarantee_deserialization(res, "rdb value");
+    }
+    return true;
+}
+
 void kv_location_delete(keyvalue_location_t *kv_location,
                         const store_key_t &key,
                         repli_timestamp_t timestamp,
@@ -206,38 +261,29 @@ kv_location_set(keyvalue_location_t *kv_location,
     return ql::serialization_result_t::SUCCESS;
 }
 
-batched_replace_response_t rdb_replace_and_return_superblock(
-    const btree_loc_info_t &info,
+// Replaces the row at `key`, which `kv_location` has been found or moved for.
+batched_replace_response_t rdb_replace_at_location(
+    const btree_info_t &btree,
+    const store_key_t &key,
+    keyvalue_location_t *kv_location,
     const btree_point_replacer_t *replacer,
     const deletion_context_t *deletion_context,
-    promise_t<superblock_t *> *superblock_promise,
-    rdb_modification_info_t *mod_info_out,
-    profile::trace_t *trace) {
+    rdb_modification_info_t *mod_info_out) {
     const return_changes_t return_changes = replacer->should_return_changes();
-    const datum_string_t &primary_key = info.btree->primary_key;
-    const store_key_t &key = *info.key;
+    const datum_string_t &primary_key = btree.primary_key;
 
     try {
-        keyvalue_location_t kv_location;
-        rdb_value_sizer_t sizer(info.superblock->cache()->max_block_size());
-        find_keyvalue_location_for_write(&sizer, info.superblock,
-                                         info.key->btree_key(),
-                                         info.btree->timestamp,
-                                         deletion_context->balancing_detacher(),
-                                         &kv_location,
-                                         trace,
-                                         superblock_promise);
-        info.btree->slice->stats.pm_keys_set.record();
-        info.btree->slice->stats.pm_total_keys_set += 1;
+        btree.slice->stats.pm_keys_set.record();
+        btree.slice->stats.pm_total_keys_set += 1;
 
         ql::datum_t old_val;
-        if (!kv_location.value.has()) {
+        if (!kv_location->value.has()) {
             // If there's no entry with this key, pass NULL to the function.
             old_val = ql::datum_t::null();
         } else {
             // Otherwise pass the entry with this key to the function.
-            old_val = get_data(kv_location.value_as<rdb_value_t>(),
-                               buf_parent_t(&kv_location.buf));
+            old_val = get_data(kv_location->value_as<rdb_value_t>(),
+                               buf_parent_t(&kv_location->buf));
             guarantee(old_val.get_field(primary_key, ql::NOTHROW).has());
         }
         guarantee(old_val.has());
@@ -261,14 +307,14 @@ batched_replace_response_t rdb_replace_and_return_superblock(
 
             /* Now that the change has passed validation, write it to disk */
             if (new_val.get_type() == ql::datum_t::R_NULL) {
-                kv_location_delete(&kv_location, *info.key, info.btree->timestamp,
+                kv_location_delete(kv_location, key, btree.timestamp,
                                    deletion_context, delete_mode_t::REGULAR_QUERY,
                                    mod_info_out);
             } else {
                 r_sanity_check(new_val.get_field(primary_key, ql::NOTHROW).has());
                 ql::serialization_result_t res =
-                    kv_location_set(&kv_location, *info.key, new_val,
-                                    info.btree->timestamp, deletion_context,
+                    kv_location_set(kv_location, key, new_val,
+                                    btree.timestamp, deletion_context,
                                     mod_info_out);
                 if (res & ql::serialization_result_t::ARRAY_TOO_BIG) {
                     rfail_typed_target(&new_val, "Array too large for disk writes "
@@ -386,14 +432,70 @@ private:
     const size_t index;
 };
 
-void do_a_replace_from_batched_replace(
+/* Takes the keys after `keys[begin]` that go in the same leaf node as it.  We only
+take them while they don't go down, so that the rows get replaced, and their
+modifications reported, in the same order as if we did them one at a time.  Either
+`do_replaces_from_batched_replace()` or `rdb_batched_replace()`, which waits for
+`batch_end_promise`, still hold the superblock, so it's not too late to get in line for
+their stamps. */
+class batched_replace_batch_t : public keyvalue_location_batch_t {
+public:
+    batched_replace_batch_t(root_height_hint_t *_root_height_hint,
+                            const std::vector<store_key_t> *_keys,
+                            size_t _begin,
+                            promise_t<size_t> *_batch_end_promise,
+                            rdb_modification_report_cb_t *_mod_cb,
+                            std::vector<rwlock_in_line_t> *_stamp_spots)
+        : keyvalue_location_batch_t(_root_height_hint),
+          keys(_keys),
+          begin(_begin),
+          end(_begin + 1),
+          batch_end_promise(_batch_end_promise),
+          mod_cb(_mod_cb),
+          stamp_spots(_stamp_spots) { }
+
+    void on_batch_limit(size_t limit, const store_key_t &right_inclusive) {
+        limit = std::min(keys->size(), begin + limit);
+        while (end < limit
+               && (*keys)[end - 1] <= (*keys)[end]
+               && (*keys)[end] <= right_inclusive) {
+            stamp_spots->push_back(mod_cb->get_in_line_for_cfeed_stamp());
+            ++end;
+        }
+        batch_end_promise->pulse(end);
+    }
+
+    size_t get_end() const { return end; }
+
+private:
+    const std::vector<store_key_t> *const keys;
+    const size_t begin;
+    size_t end;
+    promise_t<size_t> *const batch_end_promise;
+    rdb_modification_report_cb_t *const mod_cb;
+    std::vector<rwlock_in_line_t> *const stamp_spots;
+
+    DISABLE_COPYING(batched_replace_batch_t);
+};
+
+/* Replaces the rows at `keys[begin]` and at the keys right after it that go in the
+same leaf node, as long as they come in ascending order, moving from one to the next
+without walking down the tree again.  Pulses `batch_end_promise` with the index past
+the last of them before it lets go of the superblock, and before it acquires the leaf
+node when `root_height_hint` tells that the walk is about to get to it. */
+void do_replaces_from_batched_replace(
     auto_drainer_t::lock_t,
     fifo_enforcer_sink_t *batched_replaces_fifo_sink,
     const fifo_enforcer_write_token_t &batched_replaces_fifo_token,
-    const btree_loc_info_t &info,
-    const one_replace_t one_replace,
+    const btree_info_t *btree,
+    real_superblock_t *superblock,
+    const std::vector<store_key_t> *keys,
+    size_t begin,
+    const btree_batched_replacer_t *replacer,
     const ql::configured_limits_t &limits,
     promise_t<superblock_t *> *superblock_promise,
+    promise_t<size_t> *batch_end_promise,
+    root_height_hint_t *root_height_hint,
     rdb_modification_report_cb_t *mod_cb,
     bool update_pkey_cfeeds,
     batched_replace_response_t *stats_out,
@@ -404,23 +506,47 @@ void do_a_replace_from_batched_replace(
         batched_replaces_fifo_sink, batched_replaces_fifo_token);
     // We need to get in line for this while still holding the superblock so
     // that stamp read operations can't queue-skip.
-    info.superblock->get()->write_acq_signal()->wait_lazily_unordered();
-    rwlock_in_line_t stamp_spot = mod_cb->get_in_line_for_cfeed_stamp();
+    superblock->get()->write_acq_signal()->wait_lazily_unordered();
+    std::vector<rwlock_in_line_t> stamp_spots;
+    stamp_spots.push_back(mod_cb->get_in_line_for_cfeed_stamp());
 
     rdb_live_deletion_context_t deletion_context;
-    rdb_modification_report_t mod_report(*info.key);
-    ql::datum_t res = rdb_replace_and_return_superblock(
-        info, &one_replace, &deletion_context, superblock_promise, &mod_report.info,
-        trace);
-    *stats_out = (*stats_out).merge(res, ql::stats_merge, limits, conditions);
+    std::vector<rdb_modification_report_t> mod_reports;
+    {
+        keyvalue_location_t kv_location;
+        rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
+        batched_replace_batch_t batch(root_height_hint, keys, begin,
+                                      batch_end_promise, mod_cb, &stamp_spots);
+        find_keyvalue_location_for_write(&sizer, superblock, (*keys)[begin].btree_key(),
+                                         btree->timestamp,
+                                         deletion_context.balancing_detacher(),
+                                         &kv_location, trace, superblock_promise,
+                                         &batch);
+        const size_t end = batch.get_end();
+
+        mod_reports.reserve(end - begin);
+        for (size_t i = begin; i < end; ++i) {
+            if (i != begin) {
+                move_keyvalue_location_for_write(&sizer, (*keys)[i].btree_key(),
+                                                 &kv_location);
+            }
+            mod_reports.push_back(rdb_modification_report_t((*keys)[i]));
+            one_replace_t one_replace(replacer, i);
+            ql::datum_t res = rdb_replace_at_location(
+                *btree, (*keys)[i], &kv_location, &one_replace, &deletion_context,
+                &mod_reports.back().info);
+            *stats_out = (*stats_out).merge(res, ql::stats_merge, limits, conditions);
+        }
+    }
 
     // We wait to make sure we acquire `acq` in the same order we were
     // originally called.
     exiter.wait();
-    new_mutex_in_line_t sindex_spot = mod_cb->get_in_line_for_sindex();
-
-    mod_cb->on_mod_report(
-        mod_report, update_pkey_cfeeds, &sindex_spot, &stamp_spot);
+    for (size_t i = 0; i < mod_reports.size(); ++i) {
+        new_mutex_in_line_t sindex_spot = mod_cb->get_in_line_for_sindex();
+        mod_cb->on_mod_report(
+            mod_reports[i], update_pkey_cfeeds, &sindex_spot, &stamp_spots[i]);
+    }
 }
 
 batched_replace_response_t rdb_batched_replace(
@@ -466,25 +592,35 @@ batched_replace_response_t rdb_batched_replace(
         // write operations depending on the presence of limit changefeeds.
         scoped_ptr_t<real_superblock_t> current_superblock(superblock->release());
         bool update_pkey_cfeeds = sindex_cb->has_pkey_cfeeds(keys);
+        // Shared by the walks down the tree, so that they can tell when they're about
+        // to get to a leaf node.
+        root_height_hint_t root_height_hint;
         {
             auto_drainer_t drainer;
-            for (size_t i = 0; i < keys.size(); ++i) {
+            for (size_t i = 0; i < keys.size();) {
                 promise_t<superblock_t *> superblock_promise;
+                promise_t<size_t> batch_end_promise;
                 coro_queue.push(
                     std::bind(
-                        &do_a_replace_from_batched_replace,
+                        &do_replaces_from_batched_replace,
                         auto_drainer_t::lock_t(&drainer),
                         &sink,
                         source.enter_write(),
-                        btree_loc_info_t(&info, current_superblock.release(), &keys[i]),
-                        one_replace_t(replacer, i),
+                        &info,
+                        current_superblock.release(),
+                        &keys,
+                        i,
+                        replacer,
                         limits,
                         &superblock_promise,
+                        &batch_end_promise,
+                        &root_height_hint,
                         sindex_cb,
                         update_pkey_cfeeds,
                         &stats,
                         trace,
                         &conditions));
+                i = batch_end_promise.wait();
                 current_superblock.init(
                     static_cast<real_superblock_t *>(superblock_promise.wait()));
             }
@@ -1660,7 +1796,8 @@ void deserialize_sindex_info(
     case cluster_version_t::v2_2:
     case cluster_version_t::v2_3:
     case cluster_version_t::v2_4:
-    case cluster_version_t::v2_5_is_latest:
+    case cluster_version_t::v2_5:
+    case cluster_version_t::v2_6_is_latest:
         success = deserialize_reql_version(
                 &read_stream,
                 &info_out->mapping_version_info.original_reql_version,
@@ -1698,7 +1835,8 @@ void deserialize_sindex_info(
     case cluster_version_t::v2_2: // fallthru
     case cluster_version_t::v2_3: // fallthru
     case cluster_version_t::v2_4: // fallthru
-    case cluster_version_t::v2_5_is_latest:
+    case cluster_version_t::v2_5: // fallthru
+    case cluster_version_t::v2_6_is_latest:
         success = deserialize_for_version(cluster_version, &read_stream, &info_out->geo);
         throw_if_bad_deserialization(success, "sindex description");
         break;
@@ -2256,7 +2394,8 @@ void post_construct_secondary_index_range(
         interruptor);
 
     cache_account
-        = txn->cache()->create_cache_account(SINDEX_POST_CONSTRUCTION_CACHE_PRIORITY);
+        = txn->cache()->create_cache_account(SINDEX_POST_CONSTRUCTION_CACHE_PRIORITY,
+                                             io_class_t::backfill);
     txn->set_account(&cache_account);
 
     continue_bool_t cont = btree_concurrent_traversal(
@@ -64,6 +64,14 @@ void rdb_get(
     point_read_response_t *response,
     profile::trace_t *trace);
 
+/* Like `rdb_get()`, but only looks at the pages the cache published for lock-free
+reads, so that it can be called on any thread and never blocks.  Returns false if the
+pages it needs aren't published, or a write got in the way. */
+bool rdb_get_from_published_pages(
+    const store_key_t &key,
+    cache_t *cache,
+    point_read_response_t *response);
+
 struct btree_info_t {
     btree_info_t(btree_slice_t *_slice,
                  repli_timestamp_t _timestamp,
@@ -77,20 +85,6 @@ struct btree_info_t {
     const datum_string_t primary_key;
 };
 
-struct btree_loc_info_t {
-    btree_loc_info_t(const btree_info_t *_btree,
-                     real_superblock_t *_superblock,
-                     const store_key_t *_key)
-        : btree(_btree), superblock(_superblock), key(_key) {
-        guarantee(btree != NULL);
-        guarantee(superblock != NULL);
-        guarantee(key != NULL);
-    }
-    const btree_info_t *const btree;
-    real_superblock_t *const superblock;
-    const store_key_t *const key;
-};
-
 struct btree_batched_replacer_t {
     virtual ~btree_batched_replacer_t() { }
     virtual ql::datum_t replace(
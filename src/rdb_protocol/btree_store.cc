@@ -5,6 +5,7 @@
 
 #include "arch/runtime/coroutines.hpp"
 #include "btree/depth_first_traversal.hpp"
+#include "btree/erase_range.hpp"
 #include "btree/leaf_node.hpp"
 #include "btree/node.hpp"
 #include "btree/operations.hpp"
@@ -203,6 +204,21 @@ void store_t::read(
     protocol_read(_read, response, superblock.get(), interruptor);
 }
 
+bool store_t::read_lock_free(const read_t &_read, read_response_t *response) {
+    const point_read_t *point_read = boost::get<point_read_t>(&_read.read);
+    if (point_read == nullptr || _read.profile == profile_bool_t::PROFILE) {
+        return false;
+    }
+    point_read_response_t res;
+    if (!rdb_get_from_published_pages(point_read->key, cache.get(), &res)) {
+        return false;
+    }
+    response->response = std::move(res);
+    response->n_shards = 1;
+    response->event_log.push_back(profile::stop_t());
+    return true;
+}
+
 void store_t::write(
         DEBUG_ONLY(const metainfo_checker_t& metainfo_checker, )
         const region_map_t<binary_blob_t>& new_metainfo,
@@ -253,11 +269,18 @@ void store_t::reset_data(
     // Erase the data in small chunks
     always_true_key_tester_t key_tester;
     const uint64_t max_erased_per_pass = 100;
+    key_range_t remaining_range = subregion.inner;
     for (continue_bool_t done_erasing = continue_bool_t::CONTINUE;
          done_erasing == continue_bool_t::CONTINUE;) {
         scoped_ptr_t<txn_t> txn;
         scoped_ptr_t<real_superblock_t> superblock;
 
+        // `rdb_erase_small_range()` changes a leaf node for each of up to
+        // `max_erased_per_pass` rows.  `erase_leaves_in_range()` changes fewer: the
+        // nodes on one path down the tree, the leaf nodes at the ends of the part it
+        // erases, and the siblings they get merged or leveled with.  The nodes it
+        // detaches get freed in this transaction too, after it lets go of the
+        // superblock.
         const int expected_change_count = 2 + max_erased_per_pass;
         write_token_t token;
         new_write_token(&token);
@@ -279,21 +302,50 @@ void store_t::reset_data(
         rdb_live_deletion_context_t deletion_context;
         std::vector<rdb_modification_report_t> mod_reports;
         key_range_t deleted_range;
-        done_erasing = rdb_erase_small_range(btree.get(),
-                                             &key_tester,
-                                             subregion.inner,
-                                             superblock.get(),
-                                             &deletion_context,
-                                             &non_interruptor,
-                                             max_erased_per_pass,
-                                             &mod_reports,
-                                             &deleted_range);
+        std::vector<block_id_t> detached_nodes;
+        std::map<sindex_name_t, secondary_index_t> sindexes;
+        get_secondary_indexes(&sindex_block, &sindexes);
+        if (sindexes.empty()) {
+            // Nothing needs to know which rows we erase, so instead of erasing them
+            // one at a time, we detach the subtrees that only hold rows in the range,
+            // and free them below.
+            rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
+            done_erasing = erase_leaves_in_range(&sizer,
+                                                 superblock.get(),
+                                                 remaining_range,
+                                                 deletion_context.in_tree_deleter(),
+                                                 deletion_context.post_deleter(),
+                                                 &detached_nodes,
+                                                 &deleted_range);
+        } else {
+            done_erasing = rdb_erase_small_range(btree.get(),
+                                                 &key_tester,
+                                                 remaining_range,
+                                                 superblock.get(),
+                                                 &deletion_context,
+                                                 &non_interruptor,
+                                                 max_erased_per_pass,
+                                                 &mod_reports,
+                                                 &deleted_range);
+        }
+        if (done_erasing == continue_bool_t::CONTINUE) {
+            remaining_range.left = deleted_range.right.key();
+        }
 
         region_t deleted_region(subregion.beg, subregion.end, deleted_range);
         metainfo->update(superblock.get(),
                          region_map_t<binary_blob_t>(deleted_region, zero_metainfo));
 
+        const block_id_t stat_block_id = superblock->get_stat_block_id();
         superblock.reset();
+        /* We free the detached nodes in the same transaction that detached them. Nothing
+        on disk knows about them, so if we crashed before freeing them, they would stay
+        allocated for good. */
+        free_detached_nodes(buf_parent_t(txn.get()),
+                            stat_block_id,
+                            detached_nodes,
+                            deletion_context.in_tree_deleter(),
+                            deletion_context.post_deleter());
         if (!mod_reports.empty()) {
             update_sindexes(txn.get(), &sindex_block, mod_reports, true);
         }
@@ -492,6 +544,10 @@ void store_t::configure_flush_interval(flush_interval_t interval) {
     cache->configure_flush_interval(interval);
 }
 
+void store_t::configure_cache_quota(cache_quota_t quota) {
+    cache->configure_quota(quota);
+}
+
 new_mutex_in_line_t store_t::get_in_line_for_sindex_queue(buf_lock_t *sindex_block) {
     assert_thread();
     // The line for the sindex queue is there to guarantee that we push things to
@@ -134,6 +134,9 @@ public:
             signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t);
 
+    // Only handles unprofiled point reads.
+    bool read_lock_free(const read_t &read, read_response_t *response);
+
     void write(
             DEBUG_ONLY(const metainfo_checker_t& metainfo_checker, )
             const region_map_t<binary_blob_t>& new_metainfo,
@@ -200,6 +203,7 @@ public:
             THROWS_ONLY(interrupted_exc_t);
 
     void configure_flush_interval(flush_interval_t interval);
+    void configure_cache_quota(cache_quota_t quota);
 
     new_mutex_in_line_t get_in_line_for_sindex_queue(buf_lock_t *sindex_block);
     rwlock_in_line_t get_in_line_for_cfeed_stamp(access_t access);
@@ -243,9 +243,15 @@ archive_result_t deserialize<cluster_version_t::v2_4>(
 }
 
 template <>
-archive_result_t deserialize<cluster_version_t::v2_5_is_latest>(
+archive_result_t deserialize<cluster_version_t::v2_5>(
         read_stream_t *s, wire_func_t *wf) {
-    return deserialize_wire_func<cluster_version_t::v2_5_is_latest>(s, wf);
+    return deserialize_wire_func<cluster_version_t::v2_5>(s, wf);
+}
+
+template <>
+archive_result_t deserialize<cluster_version_t::v2_6_is_latest>(
+        read_stream_t *s, wire_func_t *wf) {
+    return deserialize_wire_func<cluster_version_t::v2_6_is_latest>(s, wf);
 }
 
 template <cluster_version_t W>
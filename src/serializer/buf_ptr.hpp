@@ -6,10 +6,12 @@
 #include "containers/scoped.hpp"
 #include "errors.hpp"
 #include "math.hpp"
+#include "serializer/buf_slab.hpp"
 #include "serializer/types.hpp"
 
 // Memory-aligned bufs.  This type also keeps the unused part of the buf (up to the
-// DEVICE_BLOCK_SIZE multiple) zeroed out.
+// DEVICE_BLOCK_SIZE multiple) zeroed out.  The memory comes from the slab allocator in
+// serializer/buf_slab.hpp.
 
 // Note: This wastes 4 bytes of space on a 64-bit system.  (Arguably, it wastes more
 // than that given that block sizes could be 16 bits and pointers are really 48
@@ -24,7 +26,7 @@ public:
     }
 
     buf_ptr_t(block_size_t size,
-              scoped_device_block_aligned_ptr_t<ser_buffer_t> _ser_buffer)
+              scoped_buf_slab_ptr_t<ser_buffer_t> _ser_buffer)
         : block_size_(size),
           ser_buffer_(std::move(_ser_buffer)) {
         guarantee(block_size_.ser_value() != 0);
@@ -80,7 +82,7 @@ public:
     }
 
     void release(block_size_t *block_size_out,
-                 scoped_device_block_aligned_ptr_t<ser_buffer_t> *ser_buffer_out) {
+                 scoped_buf_slab_ptr_t<ser_buffer_t> *ser_buffer_out) {
         buf_ptr_t tmp(std::move(*this));
         *block_size_out = tmp.block_size_;
         *ser_buffer_out = std::move(tmp.ser_buffer_);
@@ -113,7 +115,7 @@ private:
     // more efficiently write the buffer to disk.
     block_size_t block_size_;
     // The buffer, or empty if this buf_ptr_t is empty.
-    scoped_device_block_aligned_ptr_t<ser_buffer_t> ser_buffer_;
+    scoped_buf_slab_ptr_t<ser_buffer_t> ser_buffer_;
 
     DISABLE_COPYING(buf_ptr_t);
 };
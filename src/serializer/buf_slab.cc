@@ -0,0 +1,368 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "serializer/buf_slab.hpp"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "arch/runtime/numa.hpp"
+#include "arch/spinlock.hpp"
+#include "errors.hpp"
+#include "math.hpp"
+#include "memory_utils.hpp"
+#include "thread_local.hpp"
+
+#ifndef VALGRIND
+
+namespace {
+
+const size_t NUM_SIZE_CLASSES = BUF_SLAB_MAX_BUF_SIZE / DEVICE_BLOCK_SIZE;
+
+// Threads move free buffers to and from the depot in batches of about this many bytes.
+const size_t BATCH_BYTES = 128 * KILOBYTE;
+
+size_t size_class_of(size_t size) {
+    return ceil_divide(size, DEVICE_BLOCK_SIZE) - 1;
+}
+
+size_t slot_size_of(size_t size_class) {
+    return (size_class + 1) * DEVICE_BLOCK_SIZE;
+}
+
+size_t batch_length_of(size_t size_class) {
+    return std::max<size_t>(1, BATCH_BYTES / slot_size_of(size_class));
+}
+
+// Lives in the first slot of every slab.
+struct slab_header_t {
+    size_t size_class;
+    // The depot the slab belongs to (see `get_depot()`).
+    int numa_node;
+};
+
+// A free buffer stores the pointer to the next one in its first bytes.
+struct free_buf_t {
+    free_buf_t *next;
+};
+
+struct free_list_t {
+    free_buf_t *head;
+    size_t length;
+};
+
+struct thread_cache_t {
+    explicit thread_cache_t(int _numa_node) : numa_node(_numa_node), in_use_bytes(0) {
+        for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+            free_lists[i] = free_list_t{nullptr, 0};
+        }
+    }
+
+    // The depot the thread takes buffers from.
+    const int numa_node;
+
+    // Only holds buffers from slabs of `numa_node`.
+    free_list_t free_lists[NUM_SIZE_CLASSES];
+
+    // Buffers this thread freed that belong to other nodes' depots, indexed by node
+    // and size class.  Only gets allocated in NUMA mode, on the first such buffer.
+    std::vector<free_list_t> remote_free_lists;
+
+    // Only the thread that owns the cache writes this, but `get_buf_slab_stats()`
+    // reads it from other threads.  It goes negative on threads that free more
+    // buffers than they allocate.
+    std::atomic<int64_t> in_use_bytes;
+};
+
+class depot_t {
+public:
+    explicit depot_t(int _numa_node)
+        : numa_node(_numa_node), reserved_bytes(0), huge_page_slabs(0),
+          hugetlb_failed(false) {
+        for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+            carve_next[i] = nullptr;
+            carve_end[i] = nullptr;
+        }
+    }
+
+    void register_thread_cache(thread_cache_t *cache) {
+        spinlock_acq_t acq(&lock);
+        thread_caches.push_back(cache);
+    }
+
+    // Fills the empty `*list` with a batch of free buffers of the given size class.
+    void take_batch(size_t size_class, free_list_t *list) {
+        rassert(list->length == 0);
+        spinlock_acq_t acq(&lock);
+        std::vector<free_buf_t *> *class_batches = &batches[size_class];
+        if (!class_batches->empty()) {
+            list->head = class_batches->back();
+            list->length = batch_length_of(size_class);
+            class_batches->pop_back();
+            return;
+        }
+
+        const size_t slot_size = slot_size_of(size_class);
+        const size_t batch_length = batch_length_of(size_class);
+        while (list->length < batch_length) {
+            if (carve_next[size_class] == nullptr
+                || carve_next[size_class] + slot_size > carve_end[size_class]) {
+                char *slab = map_slab();
+                slab_header_t *header = reinterpret_cast<slab_header_t *>(slab);
+                header->size_class = size_class;
+                header->numa_node = numa_node;
+                carve_next[size_class] = slab + slot_size;
+                carve_end[size_class] = slab + BUF_SLAB_SIZE;
+            }
+            free_buf_t *buf = reinterpret_cast<free_buf_t *>(carve_next[size_class]);
+            carve_next[size_class] += slot_size;
+            buf->next = list->head;
+            list->head = buf;
+            ++list->length;
+        }
+    }
+
+    // Moves a batch of buffers from the front of `*list` into the depot.
+    void give_batch(size_t size_class, free_list_t *list) {
+        const size_t batch_length = batch_length_of(size_class);
+        rassert(list->length >= batch_length);
+        free_buf_t *batch = list->head;
+        free_buf_t *last = batch;
+        for (size_t i = 1; i < batch_length; ++i) {
+            last = last->next;
+        }
+        list->head = last->next;
+        list->length -= batch_length;
+        last->next = nullptr;
+
+        spinlock_acq_t acq(&lock);
+        batches[size_class].push_back(batch);
+    }
+
+    // Adds the depot's slabs and the buffers its threads use to the stats.  The
+    // in-use bytes can go negative for a single depot, because threads free other
+    // nodes' buffers.
+    void add_stats(buf_slab_stats_t *stats, int64_t *in_use_bytes) {
+        spinlock_acq_t acq(&lock);
+        for (thread_cache_t *cache : thread_caches) {
+            *in_use_bytes += cache->in_use_bytes.load(std::memory_order_relaxed);
+        }
+        stats->reserved_bytes += reserved_bytes;
+        stats->huge_page_slabs += huge_page_slabs;
+    }
+
+private:
+    // Returns a new `BUF_SLAB_SIZE`-aligned slab.  Must be called under `lock`.
+    char *map_slab() {
+        void *slab;
+#ifdef _WIN32
+        slab = raw_malloc_aligned(BUF_SLAB_SIZE, BUF_SLAB_SIZE);
+#else
+        slab = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        // Most systems don't have any huge pages reserved, so we only try this until
+        // it fails once.
+        if (!hugetlb_failed) {
+            slab = mmap(nullptr, BUF_SLAB_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (slab == MAP_FAILED) {
+                hugetlb_failed = true;
+            } else {
+                ++huge_page_slabs;
+            }
+        }
+#endif
+        if (slab == MAP_FAILED) {
+            // Map twice the size so that we can cut an aligned slab out of it.
+            char *region = static_cast<char *>(
+                mmap(nullptr, 2 * BUF_SLAB_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+            if (region == MAP_FAILED) {
+                crash_oom();
+            }
+            char *aligned = reinterpret_cast<char *>(ceil_aligned(
+                reinterpret_cast<uintptr_t>(region), BUF_SLAB_SIZE));
+            if (aligned != region) {
+                guarantee_err(munmap(region, aligned - region) == 0, "munmap failed");
+            }
+            char *aligned_end = aligned + BUF_SLAB_SIZE;
+            char *region_end = region + 2 * BUF_SLAB_SIZE;
+            if (aligned_end != region_end) {
+                guarantee_err(munmap(aligned_end, region_end - aligned_end) == 0,
+                              "munmap failed");
+            }
+#ifdef MADV_HUGEPAGE
+            // This can fail if transparent huge pages are disabled, which is fine.
+            UNUSED int res = madvise(aligned, BUF_SLAB_SIZE, MADV_HUGEPAGE);
+#endif
+            slab = aligned;
+        }
+#endif  // _WIN32
+        if (numa_mode_enabled()) {
+            prefer_numa_node_for_memory(slab, BUF_SLAB_SIZE, numa_node);
+        }
+        reserved_bytes += BUF_SLAB_SIZE;
+        return static_cast<char *>(slab);
+    }
+
+    const int numa_node;
+
+    spinlock_t lock;
+
+    // Full batches of free buffers, per size class.
+    std::vector<free_buf_t *> batches[NUM_SIZE_CLASSES];
+
+    // The part of the newest slab of each size class that hasn't been handed out yet.
+    char *carve_next[NUM_SIZE_CLASSES];
+    char *carve_end[NUM_SIZE_CLASSES];
+
+    std::vector<thread_cache_t *> thread_caches;
+
+    uint64_t reserved_bytes;
+    uint64_t huge_page_slabs;
+    bool hugetlb_failed;
+};
+
+depot_t **make_depots() {
+    depot_t **depots = new depot_t *[MAX_NUMA_NODES];
+    for (int i = 0; i < MAX_NUMA_NODES; ++i) {
+        depots[i] = new depot_t(i);
+    }
+    return depots;
+}
+
+// There's a depot per NUMA node, so that threads only ever get buffers from their
+// own node's memory.  Outside of NUMA mode, and for threads that aren't on a node,
+// there's only depot 0.  The depots live as long as the process, because buffers
+// can get freed during static destruction.
+depot_t *get_depot(int numa_node) {
+    static depot_t **depots = make_depots();
+    rassert(numa_node >= 0 && numa_node < MAX_NUMA_NODES);
+    return depots[numa_node];
+}
+
+TLS_with_init(thread_cache_t *, buf_slab_thread_cache, nullptr);
+
+// Thread caches don't get destroyed either, since the depot keeps pointers to them.
+thread_cache_t *get_thread_cache() {
+    thread_cache_t *cache = TLS_get_buf_slab_thread_cache();
+    if (cache == nullptr) {
+        cache = new thread_cache_t(std::max(0, get_current_numa_node()));
+        get_depot(cache->numa_node)->register_thread_cache(cache);
+        TLS_set_buf_slab_thread_cache(cache);
+    }
+    return cache;
+}
+
+}  // namespace
+
+void *buf_slab_alloc(size_t size) {
+    guarantee(size > 0 && size <= BUF_SLAB_MAX_BUF_SIZE,
+              "Bad slab buffer size: %zu", size);
+    const size_t size_class = size_class_of(size);
+    thread_cache_t *cache = get_thread_cache();
+    free_list_t *list = &cache->free_lists[size_class];
+    if (list->length == 0) {
+        get_depot(cache->numa_node)->take_batch(size_class, list);
+    }
+    free_buf_t *buf = list->head;
+    list->head = buf->next;
+    --list->length;
+    cache->in_use_bytes.store(
+        cache->in_use_bytes.load(std::memory_order_relaxed) + slot_size_of(size_class),
+        std::memory_order_relaxed);
+    return buf;
+}
+
+void buf_slab_free(void *ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    const slab_header_t *header = reinterpret_cast<const slab_header_t *>(
+        floor_aligned(reinterpret_cast<uintptr_t>(ptr), BUF_SLAB_SIZE));
+    const size_t size_class = header->size_class;
+    rassert(size_class < NUM_SIZE_CLASSES);
+    thread_cache_t *cache = get_thread_cache();
+    free_buf_t *buf = static_cast<free_buf_t *>(ptr);
+    if (header->numa_node == cache->numa_node) {
+        free_list_t *list = &cache->free_lists[size_class];
+        buf->next = list->head;
+        list->head = buf;
+        ++list->length;
+        if (list->length >= 2 * batch_length_of(size_class)) {
+            get_depot(cache->numa_node)->give_batch(size_class, list);
+        }
+    } else {
+        // Happens in NUMA mode when a page cache frees a buffer the serializer of
+        // another node allocated.  We hand such buffers back to their own node.
+        if (cache->remote_free_lists.empty()) {
+            cache->remote_free_lists.resize(MAX_NUMA_NODES * NUM_SIZE_CLASSES,
+                                            free_list_t{nullptr, 0});
+        }
+        free_list_t *list
+            = &cache->remote_free_lists[header->numa_node * NUM_SIZE_CLASSES
+                                        + size_class];
+        buf->next = list->head;
+        list->head = buf;
+        ++list->length;
+        if (list->length >= batch_length_of(size_class)) {
+            get_depot(header->numa_node)->give_batch(size_class, list);
+        }
+    }
+    cache->in_use_bytes.store(
+        cache->in_use_bytes.load(std::memory_order_relaxed)
+            - static_cast<int64_t>(slot_size_of(size_class)),
+        std::memory_order_relaxed);
+}
+
+buf_slab_stats_t get_buf_slab_stats() {
+    buf_slab_stats_t stats{0, 0, 0};
+    int64_t in_use_bytes = 0;
+    for (int i = 0; i < MAX_NUMA_NODES; ++i) {
+        get_depot(i)->add_stats(&stats, &in_use_bytes);
+    }
+    stats.in_use_bytes = std::max<int64_t>(0, in_use_bytes);
+    return stats;
+}
+
+int buf_slab_numa_node(const void *ptr) {
+    if (!numa_mode_enabled()) {
+        return -1;
+    }
+    const slab_header_t *header = reinterpret_cast<const slab_header_t *>(
+        floor_aligned(reinterpret_cast<uintptr_t>(ptr), BUF_SLAB_SIZE));
+    return header->numa_node;
+}
+
+#else  // VALGRIND
+
+// Under Valgrind we want every buffer to be its own allocation, so that memcheck can
+// tell us about out-of-bounds accesses and leaks.
+
+void *buf_slab_alloc(size_t size) {
+    guarantee(size > 0 && size <= BUF_SLAB_MAX_BUF_SIZE,
+              "Bad slab buffer size: %zu", size);
+    return raw_malloc_aligned(size, DEVICE_BLOCK_SIZE);
+}
+
+void buf_slab_free(void *ptr) {
+    raw_free_aligned(ptr);
+}
+
+buf_slab_stats_t get_buf_slab_stats() {
+    return buf_slab_stats_t{0, 0, 0};
+}
+
+int buf_slab_numa_node(const void *) {
+    return -1;
+}
+
+#endif  // VALGRIND
+
+uint64_t buf_slab_idle_bytes() {
+    buf_slab_stats_t stats = get_buf_slab_stats();
+    return stats.reserved_bytes - std::min(stats.reserved_bytes, stats.in_use_bytes);
+}
@@ -0,0 +1,67 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_BUF_SLAB_HPP_
+#define SERIALIZER_BUF_SLAB_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config/args.hpp"
+#include "containers/scoped.hpp"
+
+/* The buffers of `buf_ptr_t`s come from a slab allocator rather than from
+`posix_memalign`.  With millions of 4K pages in the cache, `malloc` fragments badly and
+the process ends up using a lot more memory than the cache size.
+
+Buffers come in size classes that are multiples of `DEVICE_BLOCK_SIZE`, up to
+`BUF_SLAB_MAX_BUF_SIZE`.  Each size class is carved out of 2MB slabs that are backed by
+huge pages where the system has them reserved, and otherwise get `madvise`d to use
+transparent huge pages.  The first slot of every slab holds a header that says which
+size class the slab belongs to, so freeing a buffer only needs its pointer.
+
+Every thread keeps a free list per size class.  A thread whose free list gets long
+hands a batch of buffers to a shared depot, and a thread whose free list is empty takes
+a batch from the depot before carving new buffers out of a slab.  That matters because
+the serializer allocates most buffers on its own thread and the page caches free them
+on theirs.
+
+In NUMA mode (see arch/runtime/numa.hpp) there is a depot per node, whose slabs come
+from the node's memory, and threads only allocate from their own node's depot.  Buffers
+freed on another node go back to the depot they came from.
+
+Slabs are never returned to the OS.  Freed buffers get reused by the next loads, and
+the cache balancer counts the idle ones against the total cache size (see
+`buf_slab_idle_bytes()`). */
+
+#define BUF_SLAB_SIZE (2 * MEGABYTE)
+#define BUF_SLAB_MAX_BUF_SIZE (64 * KILOBYTE)
+
+/* Returns a `DEVICE_BLOCK_SIZE`-aligned buffer of at least `size` bytes, which must be
+at most `BUF_SLAB_MAX_BUF_SIZE`.  The contents are uninitialized. */
+void *buf_slab_alloc(size_t size);
+
+/* Frees a buffer that `buf_slab_alloc()` returned, on any thread.  `ptr` may be null. */
+void buf_slab_free(void *ptr);
+
+struct buf_slab_stats_t {
+    // The bytes in all the slabs that were mapped from the OS.
+    uint64_t reserved_bytes;
+    // The bytes in buffers that were allocated and not freed yet.
+    uint64_t in_use_bytes;
+    // How many of the slabs are backed by explicitly reserved huge pages.
+    uint64_t huge_page_slabs;
+};
+
+buf_slab_stats_t get_buf_slab_stats();
+
+/* The NUMA node (an index into `get_numa_placement()`) whose memory the buffer is in,
+or -1 outside of NUMA mode. */
+int buf_slab_numa_node(const void *ptr);
+
+/* The bytes of slab memory that no buffer uses right now. */
+uint64_t buf_slab_idle_bytes();
+
+// A type for pointers to buffers from the slab allocator
+template <class T>
+TEMPLATE_ALIAS(scoped_buf_slab_ptr_t, scoped_alloc_t<T, buf_slab_alloc, buf_slab_free>);
+
+#endif  // SERIALIZER_BUF_SLAB_HPP_
@@ -1,8 +1,19 @@
 #include "serializer/checksum.hpp"
 
+#include <algorithm>
+
+#include "errors.hpp"
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(_WIN32)
+#define CHECKSUM_HAS_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define CHECKSUM_HAS_X86_SIMD 0
+#endif
+
 // The return value of this function or its behavior can't be changed -- the on-disk
 // format obviously requires a specific checksum algorithm.
-serializer_checksum compute_checksum(const void *word32s, size_t wordcount) {
+serializer_checksum compute_checksum_scalar(const void *word32s, size_t wordcount) {
     const uint32_t *p = static_cast<const uint32_t *>(word32s);
 
     // This is the Fletcher-64 algorithm, applied to the input whose words are xored with
@@ -30,7 +41,7 @@ serializer_checksum compute_checksum(const void *word32s, size_t wordcount) {
     // We go through a minor shenanigan here to handle very large buffers.
     for (;;) {
         // 0xFFFFul is low enough that a and b can't overflow.
-        const size_t n = wordcount & 0xFFFFul;
+        const size_t n = std::min<size_t>(wordcount, 0xFFFFul);
 
         // At this point, a and b are <= 0x1_FFFF_FFFE and non-zero.
 
@@ -60,6 +71,208 @@ serializer_checksum compute_checksum(const void *word32s, size_t wordcount) {
     return serializer_checksum{(b << 32) | a};
 }
 
+#if CHECKSUM_HAS_X86_SIMD
+
+// The vectorized implementations compute exactly the same function as
+// `compute_checksum_scalar`, but they keep A and B as residues modulo 2**32 - 1 in
+// [0, 2**32 - 2] and only map them to the non-zero on-disk representation at the end.
+// (Every residue class has exactly one representative in [1, 2**32 - 1], which is what
+// the scalar version's folding produces.)
+//
+// Each lane of the vector accumulates its own sum S_j of the words it sees, and a sum
+// of running sums P_j.  For a block of n = lanes * iterations words x_i that starts
+// with (A, B), the scalar loop would produce
+//   A' = A + sum(x_i)
+//   B' = B + n * A + sum((n - i) * x_i)
+// and with i = t * lanes + j, sum((n - i) * x_i) = lanes * sum(P_j) - sum(j * S_j).
+
+const uint64_t CHECKSUM_MODULUS = 0xFFFFFFFFull;
+
+// Limits how many vectors we add up before reducing, so that the 64-bit running sums
+// of running sums can't overflow.
+const size_t CHECKSUM_SIMD_BLOCK_ITERATIONS = 16384;
+
+// Reduces x modulo 2**32 - 1.
+inline uint64_t checksum_residue(uint64_t x) {
+    x = (x & 0xFFFFFFFFull) + (x >> 32);
+    x = (x & 0xFFFFFFFFull) + (x >> 32);
+    return x == CHECKSUM_MODULUS ? 0 : x;
+}
+
+inline void checksum_combine_block(const uint64_t *lane_sums,
+                                   const uint64_t *lane_running_sums,
+                                   size_t lanes, size_t iterations,
+                                   uint64_t *a, uint64_t *b) {
+    uint64_t sum = 0;
+    uint64_t running_sum = 0;
+    uint64_t weighted = 0;
+    for (size_t j = 0; j < lanes; ++j) {
+        const uint64_t s = checksum_residue(lane_sums[j]);
+        sum += s;
+        running_sum += checksum_residue(lane_running_sums[j]);
+        weighted += j * s;
+    }
+    const uint64_t n = lanes * iterations;
+    *b = checksum_residue(*b + n * *a + lanes * checksum_residue(running_sum)
+                          + (CHECKSUM_MODULUS - checksum_residue(weighted)));
+    *a = checksum_residue(*a + sum);
+}
+
+inline serializer_checksum checksum_finish(const uint32_t *p, size_t wordcount,
+                                           uint64_t a, uint64_t b) {
+    // Fewer than one vector's worth of words is left.
+    for (size_t i = 0; i < wordcount; ++i) {
+        a += static_cast<uint64_t>(p[i] ^ 1);
+        b += a;
+    }
+    a = checksum_residue(a);
+    b = checksum_residue(b);
+    return serializer_checksum{((b == 0 ? CHECKSUM_MODULUS : b) << 32)
+                               | (a == 0 ? CHECKSUM_MODULUS : a)};
+}
+
+__attribute__((target("sse4.2")))
+serializer_checksum compute_checksum_sse42(const void *word32s, size_t wordcount) {
+    const uint32_t *p = static_cast<const uint32_t *>(word32s);
+    const size_t lanes = 4;
+    const __m128i xorer = _mm_set1_epi32(1);
+
+    uint64_t a = 0;
+    uint64_t b = 0;
+    while (wordcount >= lanes) {
+        const size_t iterations
+            = std::min(wordcount / lanes, CHECKSUM_SIMD_BLOCK_ITERATIONS);
+        __m128i s_lo = _mm_setzero_si128();
+        __m128i s_hi = _mm_setzero_si128();
+        __m128i r_lo = _mm_setzero_si128();
+        __m128i r_hi = _mm_setzero_si128();
+        for (size_t t = 0; t < iterations; ++t) {
+            __m128i v = _mm_xor_si128(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + t * lanes)),
+                xorer);
+            s_lo = _mm_add_epi64(s_lo, _mm_cvtepu32_epi64(v));
+            s_hi = _mm_add_epi64(s_hi, _mm_cvtepu32_epi64(_mm_srli_si128(v, 8)));
+            r_lo = _mm_add_epi64(r_lo, s_lo);
+            r_hi = _mm_add_epi64(r_hi, s_hi);
+        }
+        uint64_t sums[4];
+        uint64_t running_sums[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(sums), s_lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(sums + 2), s_hi);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(running_sums), r_lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(running_sums + 2), r_hi);
+        checksum_combine_block(sums, running_sums, lanes, iterations, &a, &b);
+
+        p += iterations * lanes;
+        wordcount -= iterations * lanes;
+    }
+    return checksum_finish(p, wordcount, a, b);
+}
+
+__attribute__((target("avx2")))
+serializer_checksum compute_checksum_avx2(const void *word32s, size_t wordcount) {
+    const uint32_t *p = static_cast<const uint32_t *>(word32s);
+    const size_t lanes = 8;
+    const __m256i xorer = _mm256_set1_epi32(1);
+
+    uint64_t a = 0;
+    uint64_t b = 0;
+    while (wordcount >= lanes) {
+        const size_t iterations
+            = std::min(wordcount / lanes, CHECKSUM_SIMD_BLOCK_ITERATIONS);
+        __m256i s_lo = _mm256_setzero_si256();
+        __m256i s_hi = _mm256_setzero_si256();
+        __m256i r_lo = _mm256_setzero_si256();
+        __m256i r_hi = _mm256_setzero_si256();
+        for (size_t t = 0; t < iterations; ++t) {
+            __m256i v = _mm256_xor_si256(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + t * lanes)),
+                xorer);
+            s_lo = _mm256_add_epi64(
+                s_lo, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(v)));
+            s_hi = _mm256_add_epi64(
+                s_hi, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(v, 1)));
+            r_lo = _mm256_add_epi64(r_lo, s_lo);
+            r_hi = _mm256_add_epi64(r_hi, s_hi);
+        }
+        uint64_t sums[8];
+        uint64_t running_sums[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(sums), s_lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(sums + 4), s_hi);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(running_sums), r_lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(running_sums + 4), r_hi);
+        checksum_combine_block(sums, running_sums, lanes, iterations, &a, &b);
+
+        p += iterations * lanes;
+        wordcount -= iterations * lanes;
+    }
+    return checksum_finish(p, wordcount, a, b);
+}
+
+#endif  // CHECKSUM_HAS_X86_SIMD
+
+bool checksum_impl_supported(checksum_impl_t impl) {
+    switch (impl) {
+    case checksum_impl_t::scalar:
+        return true;
+#if CHECKSUM_HAS_X86_SIMD
+    case checksum_impl_t::sse42:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.2");
+    case checksum_impl_t::avx2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#else
+    case checksum_impl_t::sse42:
+    case checksum_impl_t::avx2:
+        return false;
+#endif
+    default:
+        unreachable();
+    }
+}
+
+typedef serializer_checksum (*checksum_fun_t)(const void *, size_t);
+
+checksum_fun_t get_checksum_fun(checksum_impl_t impl) {
+    guarantee(checksum_impl_supported(impl));
+    switch (impl) {
+    case checksum_impl_t::scalar:
+        return &compute_checksum_scalar;
+#if CHECKSUM_HAS_X86_SIMD
+    case checksum_impl_t::sse42:
+        return &compute_checksum_sse42;
+    case checksum_impl_t::avx2:
+        return &compute_checksum_avx2;
+#else
+    case checksum_impl_t::sse42:
+    case checksum_impl_t::avx2:
+#endif
+    default:
+        unreachable();
+    }
+}
+
+checksum_fun_t choose_checksum_fun() {
+    if (checksum_impl_supported(checksum_impl_t::avx2)) {
+        return get_checksum_fun(checksum_impl_t::avx2);
+    } else if (checksum_impl_supported(checksum_impl_t::sse42)) {
+        return get_checksum_fun(checksum_impl_t::sse42);
+    } else {
+        return get_checksum_fun(checksum_impl_t::scalar);
+    }
+}
+
+serializer_checksum compute_checksum(const void *word32s, size_t wordcount) {
+    static const checksum_fun_t fun = choose_checksum_fun();
+    return fun(word32s, wordcount);
+}
+
+serializer_checksum compute_checksum_with_impl(checksum_impl_t impl,
+                                               const void *word32s, size_t wordcount) {
+    return get_checksum_fun(impl)(word32s, wordcount);
+}
+
 serializer_checksum compute_checksum_concat(serializer_checksum left,
                                             serializer_checksum right,
                                             uint64_t right_wordcount) {
@@ -22,6 +22,19 @@ ATTR_PACKED(struct serializer_checksum {
 // The checksum is never zero.
 serializer_checksum compute_checksum(const void *word32s, size_t wordcount);
 
+// The implementations of `compute_checksum` that we can choose from.  They all produce
+// identical results; `compute_checksum` picks the fastest one the CPU supports the
+// first time it's called.
+enum class checksum_impl_t { scalar, sse42, avx2 };
+
+// Returns true if `impl` can be used on this machine.
+bool checksum_impl_supported(checksum_impl_t impl);
+
+// Like `compute_checksum`, but uses the given implementation, which must be supported.
+// This is for testing and benchmarking.
+serializer_checksum compute_checksum_with_impl(checksum_impl_t impl,
+                                               const void *word32s, size_t wordcount);
+
 // Combines checksums into the checksum of the concatenated buffer.  Given two buffers,
 // s, and t, serializer_checksum_concat(serializer_checksum(s), serializer_checksum(t),
 // t.wordcount) computes serializer_checksum(concat(s, t)).
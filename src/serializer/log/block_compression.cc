@@ -0,0 +1,113 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "serializer/log/block_compression.hpp"
+
+#ifdef HAS_LZ4
+#include <lz4.h>
+#endif
+
+#include "math.hpp"
+
+bool block_compression_supported(block_compression_t method) {
+    switch (method) {
+    case block_compression_t::none:
+        return true;
+    case block_compression_t::lz4:
+#ifdef HAS_LZ4
+        return true;
+#else
+        return false;
+#endif
+    default:
+        unreachable();
+    }
+}
+
+#ifdef HAS_LZ4
+
+bool compress_block(block_compression_t method,
+                    const ser_buffer_t *buf,
+                    block_size_t block_size,
+                    buf_ptr_t *compressed_out) {
+    guarantee(method == block_compression_t::lz4);
+
+    const size_t header_size
+        = sizeof(ls_buf_data_t) + sizeof(ls_compressed_block_header_t);
+    const size_t aligned_size = buf_ptr_t::compute_aligned_block_size(block_size);
+    // A compressed block has to save at least one device block, or there is no
+    // point in storing it compressed.
+    if (aligned_size < DEVICE_BLOCK_SIZE + header_size + 1) {
+        return false;
+    }
+    const size_t max_compressed_size = aligned_size - DEVICE_BLOCK_SIZE - header_size;
+
+    buf_ptr_t compressed = buf_ptr_t::alloc_uninitialized(block_size);
+    ser_buffer_t *out = compressed.ser_buffer();
+    ls_compressed_block_header_t *header
+        = reinterpret_cast<ls_compressed_block_header_t *>(out->cache_data);
+    char *const payload = out->cache_data + sizeof(ls_compressed_block_header_t);
+
+    const int compressed_size = LZ4_compress_default(
+        buf->cache_data, payload, block_size.value(), max_compressed_size);
+    if (compressed_size <= 0) {
+        // The block doesn't compress well enough.
+        return false;
+    }
+
+    out->ser_header = buf->ser_header;
+    header->codec = COMPRESSED_BLOCK_CODEC_LZ4;
+    memset(header->padding, 0, sizeof(header->padding));
+    header->compressed_size = compressed_size;
+
+    compressed.resize_fill_zero(
+        block_size_t::unsafe_make(header_size + compressed_size));
+    compressed.fill_padding_zero();
+    rassert(compressed.aligned_block_size() < aligned_size);
+
+    *compressed_out = std::move(compressed);
+    return true;
+}
+
+buf_ptr_t decompress_block(const buf_ptr_t &compressed, block_size_t block_size) {
+    const ser_buffer_t *in = compressed.ser_buffer();
+    const ls_compressed_block_header_t *header
+        = reinterpret_cast<const ls_compressed_block_header_t *>(in->cache_data);
+    const char *const payload = in->cache_data + sizeof(ls_compressed_block_header_t);
+
+    guarantee(compressed.block_size().ser_value()
+              == sizeof(ls_buf_data_t) + sizeof(ls_compressed_block_header_t)
+                 + header->compressed_size,
+              "Compressed block has an invalid size (block id %" PRIu64 ").",
+              in->ser_header.block_id);
+    guarantee(header->codec == COMPRESSED_BLOCK_CODEC_LZ4,
+              "Compressed block uses unknown codec %" PRIu8 " (block id %" PRIu64 ").",
+              header->codec, in->ser_header.block_id);
+
+    buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
+    ret.ser_buffer()->ser_header = in->ser_header;
+    const int decompressed_size = LZ4_decompress_safe(
+        payload, ret.ser_buffer()->cache_data, header->compressed_size,
+        block_size.value());
+    guarantee(decompressed_size == block_size.value(),
+              "Corrupted compressed block (block id %" PRIu64 ").",
+              in->ser_header.block_id);
+    ret.fill_padding_zero();
+    return ret;
+}
+
+#else  // HAS_LZ4
+
+bool compress_block(UNUSED block_compression_t method,
+                    UNUSED const ser_buffer_t *buf,
+                    UNUSED block_size_t block_size,
+                    UNUSED buf_ptr_t *compressed_out) {
+    // Without LZ4, every block gets written uncompressed.
+    return false;
+}
+
+buf_ptr_t decompress_block(const buf_ptr_t &compressed,
+                           UNUSED block_size_t block_size) {
+    crash("Block %" PRIu64 " is compressed, but this build of RethinkDB doesn't "
+          "support LZ4.", compressed.ser_buffer()->ser_header.block_id);
+}
+
+#endif  // HAS_LZ4
@@ -0,0 +1,45 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_LOG_BLOCK_COMPRESSION_HPP_
+#define SERIALIZER_LOG_BLOCK_COMPRESSION_HPP_
+
+#include "arch/compiler.hpp"
+#include "serializer/buf_ptr.hpp"
+#include "serializer/log/config.hpp"
+#include "serializer/types.hpp"
+
+/* Blocks can be stored compressed on disk.  A compressed block keeps the usual
+`ls_buf_data_t` header (the GC relies on finding the block id there), followed by a
+`ls_compressed_block_header_t` and the compressed contents of the block's
+`cache_data`.
+
+Whether a block is compressed is not recorded in the block itself, but in the LBA:
+a compressed block's LBA entry has a non-zero `uncompressed_ser_block_size`, and its
+`ser_block_size` is the size of the compressed block on disk. */
+
+ATTR_PACKED(struct ls_compressed_block_header_t {
+    // One of the `COMPRESSED_BLOCK_CODEC_*` values below.
+    uint8_t codec;
+    uint8_t padding[3];
+    // The number of bytes of compressed data that follow this header.
+    uint32_t compressed_size;
+});
+
+static const uint8_t COMPRESSED_BLOCK_CODEC_LZ4 = 1;
+
+/* Returns false if RethinkDB was built without the library that `method` needs. */
+bool block_compression_supported(block_compression_t method);
+
+/* Compresses the block in `buf` using `method`.  Returns false if the compressed
+block wouldn't take up fewer DEVICE_BLOCK_SIZE units on disk than the uncompressed
+one, in which case the block should be written uncompressed.  The `ser_header` of
+`buf` is copied over to `*compressed_out`. */
+bool compress_block(block_compression_t method,
+                    const ser_buffer_t *buf,
+                    block_size_t block_size,
+                    buf_ptr_t *compressed_out);
+
+/* Decompresses a block that was compressed by `compress_block`.  `block_size` is
+the size that the block had before it got compressed. */
+buf_ptr_t decompress_block(const buf_ptr_t &compressed, block_size_t block_size);
+
+#endif  // SERIALIZER_LOG_BLOCK_COMPRESSION_HPP_
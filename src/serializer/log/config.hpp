@@ -9,6 +9,20 @@
 #include "serializer/types.hpp"
 #include "rpc/serialize_macros.hpp"
 
+/* How blocks are compressed before they get written to disk. Blocks that were
+written with compression remain readable no matter what this is set to. */
+enum class block_compression_t { none, lz4 };
+
+ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(block_compression_t, int8_t,
+                                      block_compression_t::none,
+                                      block_compression_t::lz4);
+
+/* How the garbage collector picks the next extent to collect. `greedy` always picks
+the extent with the most garbage. `cost_benefit` weighs the space that collecting an
+extent frees against the cost of moving its live blocks, and favors extents that
+haven't been written to in a long time (as in the LFS paper). */
+enum class gc_policy_t { greedy, cost_benefit };
+
 /* Configuration for the serializer that can change from run to run */
 
 struct log_serializer_dynamic_config_t {
@@ -17,6 +31,13 @@ struct log_serializer_dynamic_config_t {
         // This is probably too low, thanks to status quo bias (the status quo having
         // been to never compute checksums).
         checksum_threshold = 65536;
+        block_compression = block_compression_t::none;
+        gc_policy = gc_policy_t::greedy;
+        gc_separate_cold_data = false;
+        lba_snapshot = false;
+        defrag = false;
+        group_commit_window_ms = 0;
+        group_commit_max_bytes = 0;
     }
 
     /* Enable reading more data than requested to let the cache warmup more quickly
@@ -26,6 +47,29 @@ struct log_serializer_dynamic_config_t {
        writing the serializer superblock.  Designed to make single-document writes
        fast. */
     uint32_t checksum_threshold;
+    /* The method used to compress newly written blocks, until the table's config
+       overrides it through `log_serializer_t::set_block_compression()`. */
+    block_compression_t block_compression;
+    /* How the garbage collector picks the extents it collects. */
+    gc_policy_t gc_policy;
+    /* If true, blocks that get moved by the garbage collector are written to
+       different extents than newly written blocks. Blocks that survived a GC round
+       tend to change rarely, so this keeps them from getting mixed up with (and
+       moved again along with) frequently changing ones. */
+    bool gc_separate_cold_data;
+    /* If true, the serializer writes a snapshot of its LBA index next to its file
+       when it shuts down cleanly, so that the next start-up doesn't have to read
+       the LBA from disk. */
+    bool lba_snapshot;
+    /* If true, the serializer moves data from the end of its file towards the
+       start when a lot of the file is free space, so that the file can shrink. */
+    bool defrag;
+    /* Used by the merger_serializer_t on top of the log serializer: index writes
+       that arrive within this many milliseconds get committed together with a
+       single metablock write, unless their blocks add up to more than
+       `group_commit_max_bytes` (if that isn't 0). */
+    int64_t group_commit_window_ms;
+    uint64_t group_commit_max_bytes;
 };
 
 /* This is equivalent to log_serializer_static_config_t below, but is an on-disk
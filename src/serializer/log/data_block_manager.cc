@@ -8,17 +8,27 @@
 
 #include "arch/arch.hpp"
 #include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
 #include "concurrency/mutex.hpp"
 #include "concurrency/new_mutex.hpp"
+#include "concurrency/pmap.hpp"
 #include "errors.hpp"
 #include "perfmon/perfmon.hpp"
 #include "serializer/buf_ptr.hpp"
+#include "serializer/log/block_compression.hpp"
 #include "serializer/log/log_serializer.hpp"
 #include "stl_utils.hpp"
 
 // Max amount of bytes which can be read ahead in one i/o transaction (if enabled)
 const int64_t APPROXIMATE_READ_AHEAD_SIZE = 32 * DEFAULT_BTREE_BLOCK_SIZE;
 
+// `read_many()` reads blocks that are at most this many bytes apart on disk with a
+// single read, and throws away the data in between.
+const int64_t MAX_COALESCED_READ_GAP = 4 * DEFAULT_BTREE_BLOCK_SIZE;
+
+// The largest read that `read_many()` turns several block reads into.
+const int64_t MAX_COALESCED_READ_SIZE = 256 * DEFAULT_BTREE_BLOCK_SIZE;
+
 /*****************
  * GC Parameters *
  *****************/
@@ -51,6 +61,23 @@ const size_t GC_YOUNG_EXTENT_MAX_SIZE = 50;
 // What's the definition of a "young" extent in microseconds?
 const kiloticks_t GC_YOUNG_EXTENT_TIMELIMIT = { 50000 };
 
+// How often (in microseconds) the `cost_benefit` GC policy updates the time it
+// computes extent ages relative to.
+const kiloticks_t GC_POLICY_CLOCK_INTERVAL = { 1000000 };
+
+/*****************************
+ * Defragmentation Parameters *
+ *****************************/
+
+// Defragmentation starts once at least this many extents of the file are free, and
+// they make up at least DEFRAG_START_FREE_RATIO of the file.
+const size_t DEFRAG_MIN_FREE_EXTENTS = 16;
+constexpr double DEFRAG_START_FREE_RATIO = 0.2;
+
+// How long (in milliseconds) defragmentation pauses after moving an extent, so that
+// it doesn't compete too much with other I/O.
+const int64_t DEFRAG_PAUSE_MS = 20;
+
 
 // Identifies an extent, the time we started writing to the
 // extent, whether it's the extent we're currently writing to, and
@@ -312,6 +339,28 @@ public:
         block_infos.shrink_to_fit();
     }
 
+    // The GC collects the old extent with the highest priority first.
+    double gc_priority() const {
+        switch (parent->gc_policy()) {
+        case gc_policy_t::greedy:
+            return garbage_bytes();
+        case gc_policy_t::cost_benefit: {
+            // This is the benefit-to-cost ratio from the LFS paper, (1 - u) * age /
+            // (1 + u), where u is the fraction of the extent that is still live.
+            // Collecting the extent frees (1 - u) of it, at the cost of reading the
+            // extent and writing u of it back.  We add 1 to the age so that extents
+            // of the same age still get ordered by their garbage.
+            const double extent_size = parent->static_config->extent_size();
+            const double live_ratio = 1.0 - garbage_bytes() / extent_size;
+            const int64_t age = std::max<int64_t>(
+                0, parent->gc_policy_clock.micros - timestamp.micros);
+            return (1.0 - live_ratio) * (age + 1) / (1.0 + live_ratio);
+        }
+        default:
+            unreachable();
+        }
+    }
+
 private:
     // Private because we cannot guarantee that our stats remain consistent if somebody
     // gets a non-const iterator.
@@ -402,6 +451,13 @@ data_block_manager_t::data_block_manager_t(
     : stats(_stats), shutdown_callback(nullptr), state(state_unstarted),
       gc_enabled(true), static_config(_static_config), extent_manager(em),
       serializer(_serializer),
+      active_extent(nullptr),
+      cold_active_extent(nullptr),
+      gc_policy_clock(get_kiloticks()),
+      defrag_state(nullptr),
+      defrag_start_time(0),
+      defrag_extents_moved(0),
+      defrag_extents_total(0),
       gc_index_write_pumper(std::bind(
           &data_block_manager_t::flush_gc_index_writes, this, std::placeholders::_1)),
       /* The capacity of the gc_index_write_semaphore will be scaled
@@ -453,8 +509,12 @@ void data_block_manager_t::start_existing(
         const dbm_metablock_mixin_t *last_metablock) {
     guarantee(state == state_unstarted);
     dbfile = file;
-    gc_io_account_nice.init(new file_account_t(file, GC_IO_PRIORITY_NICE));
-    gc_io_account_high.init(new file_account_t(file, GC_IO_PRIORITY_HIGH));
+    gc_io_account_nice.init(new file_account_t(file, GC_IO_PRIORITY_NICE,
+                                               UNLIMITED_OUTSTANDING_REQUESTS,
+                                               io_class_t::gc));
+    gc_io_account_high.init(new file_account_t(file, GC_IO_PRIORITY_HIGH,
+                                               UNLIMITED_OUTSTANDING_REQUESTS,
+                                               io_class_t::gc));
 
     /* Reconstruct the active data block extents from the metablock. */
     const int64_t offset = last_metablock->active_extent;
@@ -663,16 +723,24 @@ public:
                     continue;
                 }
 
-                const block_size_t block_size
+                const block_size_t disk_block_size
                     = block_size_t::unsafe_make(info.ser_block_size);
-                buf_ptr_t buf = buf_ptr_t::alloc_uninitialized(block_size);
+                buf_ptr_t buf = buf_ptr_t::alloc_uninitialized(disk_block_size);
                 memcpy(buf.ser_buffer(), current_buf, info.ser_block_size);
                 buf.fill_padding_zero();
                 guarantee(info.ser_block_size <= *(lower_it + 1) - *lower_it);
 
+                block_size_t block_size = disk_block_size;
+                if (info.uncompressed_ser_block_size != 0) {
+                    block_size = block_size_t::unsafe_make(
+                        info.uncompressed_ser_block_size);
+                    buf = decompress_block(buf, block_size);
+                }
+
                 counted_t<block_token_t> token
                     = parent->serializer->generate_block_token(current_offset,
-                                                               block_size);
+                                                               block_size,
+                                                               disk_block_size);
 
                 parent->serializer->offer_buf_to_read_ahead_callbacks(
                         block_id,
@@ -736,17 +804,108 @@ buf_ptr_t data_block_manager_t::read(int64_t off_in, block_size_t block_size,
     }
 }
 
-// Sets maybe_checksum_out if one was computed, or sets it to zero otherwise.
+std::vector<buf_ptr_t> data_block_manager_t::read_many(
+        const std::vector<int64_t> &offsets,
+        const std::vector<block_size_t> &block_sizes,
+        file_account_t *io_account) {
+    guarantee(state == state_ready);
+    guarantee(offsets.size() == block_sizes.size());
+
+    // A range of the file that we read with one `co_read`, and the blocks in it.
+    struct coalesced_read_t {
+        int64_t begin;
+        int64_t end;
+        std::vector<size_t> blocks;
+    };
+
+    // Blocks in extents that we would read ahead from go through `read()`, so that
+    // the read-ahead buffers still get offered to the cache.
+    std::vector<size_t> single_reads;
+    std::vector<size_t> sorted;
+    sorted.reserve(offsets.size());
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        if (should_perform_read_ahead(offsets[i])) {
+            single_reads.push_back(i);
+        } else {
+            sorted.push_back(i);
+        }
+    }
+    std::sort(sorted.begin(), sorted.end(), [&](size_t x, size_t y) {
+        return offsets[x] < offsets[y];
+    });
+
+    std::vector<coalesced_read_t> coalesced_reads;
+    for (size_t i : sorted) {
+        const int64_t begin = floor_aligned(offsets[i], DEVICE_BLOCK_SIZE);
+        const int64_t end = ceil_aligned(offsets[i] + block_sizes[i].ser_value(),
+                                         DEVICE_BLOCK_SIZE);
+        if (!coalesced_reads.empty()
+            && begin <= coalesced_reads.back().end + MAX_COALESCED_READ_GAP
+            && end - coalesced_reads.back().begin <= MAX_COALESCED_READ_SIZE) {
+            coalesced_read_t *last = &coalesced_reads.back();
+            last->end = std::max(last->end, end);
+            last->blocks.push_back(i);
+        } else {
+            coalesced_reads.push_back(coalesced_read_t{begin, end, {i}});
+        }
+    }
+
+    std::vector<buf_ptr_t> ret(offsets.size());
+    for (const coalesced_read_t &coalesced : coalesced_reads) {
+        if (coalesced.blocks.size() == 1) {
+            single_reads.push_back(coalesced.blocks[0]);
+        }
+    }
+    pmap(coalesced_reads.size() + single_reads.size(), [&](int64_t n) {
+        if (static_cast<size_t>(n) >= coalesced_reads.size()) {
+            const size_t i = single_reads[n - coalesced_reads.size()];
+            ret[i] = read(offsets[i], block_sizes[i], io_account);
+            return;
+        }
+        const coalesced_read_t &coalesced = coalesced_reads[n];
+        if (coalesced.blocks.size() == 1) {
+            // Already in `single_reads`.
+            return;
+        }
+
+        const int64_t length = coalesced.end - coalesced.begin;
+        scoped_device_block_aligned_ptr_t<char> buf(length);
+        co_read(dbfile, coalesced.begin, length, buf.get(), io_account);
+        stats->bytes_read(length);
+        stats->pm_serializer_coalesced_block_reads += coalesced.blocks.size();
+
+        for (size_t i : coalesced.blocks) {
+            buf_ptr_t block = buf_ptr_t::alloc_uninitialized(block_sizes[i]);
+            memcpy(block.ser_buffer(), buf.get() + (offsets[i] - coalesced.begin),
+                   block_sizes[i].ser_value());
+            block.fill_padding_zero();
+            ret[i] = std::move(block);
+        }
+    });
+    return ret;
+}
+
 std::vector<counted_t<block_token_t>>
 data_block_manager_t::many_writes(const buf_write_info_t *writes,
                                   size_t writes_count,
                                   file_account_t *io_account,
                                   iocallback_t *cb) {
+    return many_writes_to(&active_extent, writes, writes_count, io_account, cb);
+}
+
+// Sets maybe_checksum_out if one was computed, or sets it to zero otherwise.
+std::vector<counted_t<block_token_t>>
+data_block_manager_t::many_writes_to(gc_entry_t **target_extent,
+                                     const buf_write_info_t *writes,
+                                     size_t writes_count,
+                                     file_account_t *io_account,
+                                     iocallback_t *cb) {
     // These tokens are grouped by extent.  You can do a contiguous write in each
     // extent.
     uint64_t cumulative_aligned_size;
     std::vector<std::vector<counted_t<block_token_t>>> token_groups
-        = gimme_some_new_offsets(writes, writes_count, &cumulative_aligned_size);
+        = gimme_some_new_offsets(target_extent, writes, writes_count,
+                                 &cumulative_aligned_size);
     const bool wants_checksum
         = cumulative_aligned_size <= serializer->dynamic_config.checksum_threshold;
 
@@ -1023,6 +1182,102 @@ void data_block_manager_t::start_gc() {
     gc_index_write_semaphore.set_capacity(std::max<int64_t>(1, active_gcs.size()));
 }
 
+bool data_block_manager_t::do_we_want_to_defrag() const {
+    if (!gc_enabled || !serializer->dynamic_config.defrag || defrag_state != nullptr) {
+        return false;
+    }
+    const size_t free_extents = extent_manager->held_extents();
+    return free_extents >= DEFRAG_MIN_FREE_EXTENTS
+        && free_extents >= DEFRAG_START_FREE_RATIO * extent_manager->num_extents()
+        && pick_defrag_extent() != nullptr;
+}
+
+void data_block_manager_t::start_defrag() {
+    if (state != state_ready || defrag_state != nullptr) {
+        return;
+    }
+
+    defrag_start_time = current_microtime();
+    defrag_extents_moved = 0;
+    defrag_extents_total = count_defrag_extents();
+
+    defrag_state = new gc_state_t();
+    active_gcs.push_back(defrag_state);
+    gc_index_write_semaphore.set_capacity(std::max<int64_t>(1, active_gcs.size()));
+    coro_t::spawn_sometime(std::bind(&data_block_manager_t::run_defrag, this,
+                                     defrag_state));
+}
+
+bool data_block_manager_t::get_defrag_progress(microtime_t *start_time_out,
+                                               double *progress_out) const {
+    if (defrag_state == nullptr) {
+        return false;
+    }
+    *start_time_out = defrag_start_time;
+    // More extents can become eligible while we're running.
+    *progress_out = defrag_extents_total <= defrag_extents_moved
+        ? 1.0
+        : static_cast<double>(defrag_extents_moved) / defrag_extents_total;
+    return true;
+}
+
+gc_entry_t *data_block_manager_t::pick_defrag_extent() const {
+    const int64_t first_free = extent_manager->first_free_extent();
+    if (first_free == NULL_OFFSET) {
+        return nullptr;
+    }
+    const uint64_t first_free_id = static_config->extent_index(first_free);
+    for (uint64_t extent_id = extent_manager->num_extents();
+         extent_id > first_free_id + 1;
+         --extent_id) {
+        // Extents that aren't old yet (or that belong to the LBA or the metablock)
+        // are left where they are.
+        gc_entry_t *entry = entries.get(extent_id - 1);
+        if (entry != nullptr && entry->state == gc_entry_t::state_old) {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+int64_t data_block_manager_t::count_defrag_extents() const {
+    const uint64_t num_extents = extent_manager->num_extents();
+    const uint64_t compact_end = num_extents - extent_manager->held_extents();
+    int64_t count = 0;
+    for (uint64_t extent_id = compact_end; extent_id < num_extents; ++extent_id) {
+        gc_entry_t *entry = entries.get(extent_id);
+        if (entry != nullptr && entry->state == gc_entry_t::state_old) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void data_block_manager_t::run_defrag(gc_state_t *gc_state) {
+    guarantee(gc_state == defrag_state);
+    while (state == state_ready && gc_enabled) {
+        gc_entry_t *victim = pick_defrag_extent();
+        if (victim == nullptr) {
+            break;
+        }
+        gc_one_extent(gc_state, victim);
+        ++defrag_extents_moved;
+
+        if (state != state_ready) {
+            break;
+        }
+        nap(DEFRAG_PAUSE_MS);
+    }
+
+    defrag_state = nullptr;
+    active_gcs.remove(gc_state);
+    gc_index_write_semaphore.set_capacity(std::max<int64_t>(1, active_gcs.size()));
+    delete gc_state;
+    if (state == state_shutting_down && active_gcs.empty()) {
+        actually_shutdown();
+    }
+}
+
 struct block_write_cond_t : public cond_t, public iocallback_t {
     void on_io_complete() {
         pulse();
@@ -1052,7 +1307,7 @@ void data_block_manager_t::run_gc(gc_state_t *gc_state) {
     delete gc_state;
 }
 
-void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
+void data_block_manager_t::gc_one_extent(gc_state_t *gc_state, gc_entry_t *victim) {
     // A buffer for blocks we're transferring.
     scoped_device_block_aligned_ptr_t<char> gc_blocks;
     size_t total_bytes_read = 0;
@@ -1084,12 +1339,23 @@ void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
     {
         ASSERT_NO_CORO_WAITING;
 
-        ++stats->pm_serializer_data_extents_gced;
+        if (victim == nullptr) {
+            ++stats->pm_serializer_data_extents_gced;
+        } else {
+            ++stats->pm_serializer_data_extents_defragged;
+        }
 
         /* grab the entry */
+        maybe_advance_gc_policy_clock();
         guarantee (!gc_pq.empty());
         guarantee(gc_state->current_entry == nullptr);
-        gc_state->current_entry = gc_pq.pop();
+        if (victim == nullptr) {
+            gc_state->current_entry = gc_pq.pop();
+        } else {
+            guarantee(victim->state == gc_entry_t::state_old);
+            gc_pq.remove(victim->our_pq_entry);
+            gc_state->current_entry = victim;
+        }
         gc_state->current_entry->our_pq_entry = nullptr;
 
         guarantee(gc_state->current_entry->state == gc_entry_t::state_old);
@@ -1205,6 +1471,12 @@ void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
                     gc_state->current_entry->block_size(i)));
             }
             guarantee(gc_writes.size() == num_writes);
+
+            const uint32_t moved_bytes = static_config->extent_size()
+                - gc_state->current_entry->garbage_bytes();
+            stats->pm_serializer_gc_bytes_moved += moved_bytes;
+            stats->pm_serializer_gc_bytes_freed
+                += static_config->extent_size() - moved_bytes;
         }
         write_gcs(
             std::move(gc_writes),
@@ -1264,6 +1536,7 @@ void data_block_manager_t::write_gcs(
         for (size_t i = 0; i < writes.size(); ++i) {
             old_block_tokens.push_back(
                     serializer->generate_block_token(writes[i].old_offset,
+                                                     writes[i].block_size,
                                                      writes[i].block_size));
 
             the_writes.push_back(buf_write_info_t(writes[i].buf,
@@ -1271,9 +1544,14 @@ void data_block_manager_t::write_gcs(
                                                   writes[i].buf->ser_header.block_id));
         }
 
-        new_block_tokens = many_writes(the_writes.data(), the_writes.size(),
-                                       choose_gc_io_account(),
-                                       &block_write_cond);
+        gc_entry_t **const target_extent
+            = serializer->dynamic_config.gc_separate_cold_data
+            ? &cold_active_extent
+            : &active_extent;
+        new_block_tokens = many_writes_to(target_extent,
+                                          the_writes.data(), the_writes.size(),
+                                          choose_gc_io_account(),
+                                          &block_write_cond);
 
         guarantee(new_block_tokens.size() == writes.size());
     }
@@ -1337,6 +1615,19 @@ void data_block_manager_t::flush_gc_index_writes(signal_t *) {
                 if (iw.gc_state->current_entry->block_referenced_by_index(block_index)) {
                     block_id_t block_id = write.buf->ser_header.block_id;
 
+                    // The GC copies compressed blocks as they are.  The new token
+                    // must report the uncompressed size though, or the index write
+                    // would forget that the block is compressed.
+                    const index_block_info_t info
+                        = serializer->lba_index->get_block_info(block_id);
+                    guarantee(info.offset.has_value()
+                              && info.offset.get_value() == write.old_offset);
+                    if (info.uncompressed_ser_block_size != 0) {
+                        iw.new_block_tokens[i]->block_size_
+                            = block_size_t::unsafe_make(
+                                info.uncompressed_ser_block_size);
+                    }
+
                     index_write_ops.push_back(
                         index_write_op_t(block_id,
                             make_optional(iw.new_block_tokens[i])));
@@ -1425,6 +1716,12 @@ void data_block_manager_t::actually_shutdown() {
         active_extent = nullptr;
     }
 
+    if (cold_active_extent != nullptr) {
+        UNUSED int64_t extent = cold_active_extent->extent_ref.release();
+        delete cold_active_extent;
+        cold_active_extent = nullptr;
+    }
+
     while (gc_entry_t *entry = young_extent_queue.head()) {
         young_extent_queue.remove(entry);
         UNUSED int64_t extent = entry->extent_ref.release();
@@ -1445,19 +1742,23 @@ void data_block_manager_t::actually_shutdown() {
 // Outputs how many bytes would get written, so we can use that info to decide later
 // whether to checksum the blocks (which'll let us save an fdatasync)
 std::vector<std::vector<counted_t<block_token_t>>>
-data_block_manager_t::gimme_some_new_offsets(const buf_write_info_t *writes,
+data_block_manager_t::gimme_some_new_offsets(gc_entry_t **target_extent,
+                                             const buf_write_info_t *writes,
                                              size_t writes_count,
                                              uint64_t *cumulative_aligned_size_out) {
     ASSERT_NO_CORO_WAITING;
+    rassert(target_extent == &active_extent || target_extent == &cold_active_extent);
+
+    gc_entry_t *extent = *target_extent;
 
     // Start a new extent if necessary.
-    if (active_extent == nullptr) {
-        active_extent = new gc_entry_t(this);
+    if (extent == nullptr) {
+        extent = new gc_entry_t(this);
         ++stats->pm_serializer_data_extents_allocated;
     }
 
 
-    guarantee(active_extent->state == gc_entry_t::state_active);
+    guarantee(extent->state == gc_entry_t::state_active);
 
     std::vector<std::vector<counted_t<block_token_t>>> ret;
     uint64_t cumulative_aligned_size = 0;
@@ -1468,26 +1769,25 @@ data_block_manager_t::gimme_some_new_offsets(const buf_write_info_t *writes,
         uint32_t relative_offset = valgrind_undefined<uint32_t>(UINT32_MAX);
         unsigned int block_index = valgrind_undefined<unsigned int>(UINT_MAX);
         cumulative_aligned_size += gc_entry_t::aligned_value(block_size);
-        if (!active_extent->new_offset(block_size,
-                                       &relative_offset, &block_index)) {
-            // Move the active_extent gc_entry_t to the young extent queue (if it's
-            // not already empty), and make a new gc_entry_t.
-            if (active_extent->num_live_blocks() == 0) {
-                gc_entry_t *old_active_extent = active_extent;
-                active_extent = new gc_entry_t(this);
-                destroy_entry(old_active_extent);
+        if (!extent->new_offset(block_size, &relative_offset, &block_index)) {
+            // Move the full gc_entry_t to the young extent queue (if it's not
+            // already empty), and make a new gc_entry_t.
+            if (extent->num_live_blocks() == 0) {
+                gc_entry_t *old_extent = extent;
+                extent = new gc_entry_t(this);
+                destroy_entry(old_extent);
             } else {
-                active_extent->state = gc_entry_t::state_young;
-                active_extent->shrink_to_fit();
-                young_extent_queue.push_back(active_extent);
+                extent->state = gc_entry_t::state_young;
+                extent->shrink_to_fit();
+                young_extent_queue.push_back(extent);
                 mark_unyoung_entries();
-                active_extent = new gc_entry_t(this);
+                extent = new gc_entry_t(this);
             }
 
             ++stats->pm_serializer_data_extents_allocated;
-            const bool succeeded = active_extent->new_offset(block_size,
-                                                             &relative_offset,
-                                                             &block_index);
+            const bool succeeded = extent->new_offset(block_size,
+                                                      &relative_offset,
+                                                      &block_index);
             guarantee(succeeded);
 
             // Push the current group of tokens, if it's nonempty, onto the return
@@ -1498,17 +1798,19 @@ data_block_manager_t::gimme_some_new_offsets(const buf_write_info_t *writes,
             }
         }
 
-        const int64_t offset = active_extent->extent_ref.offset() + relative_offset;
-        active_extent->was_written = true;
-        active_extent->mark_live_tokenwise(block_index);
+        const int64_t offset = extent->extent_ref.offset() + relative_offset;
+        extent->was_written = true;
+        extent->mark_live_tokenwise(block_index);
 
-        tokens.push_back(serializer->generate_block_token(offset, block_size));
+        tokens.push_back(serializer->generate_block_token(offset, block_size,
+                                                          block_size));
     }
 
     if (!tokens.empty()) {
         ret.push_back(std::move(tokens));
     }
 
+    *target_extent = extent;
     *cumulative_aligned_size_out = cumulative_aligned_size;
     return ret;
 }
@@ -1570,8 +1872,25 @@ bool data_block_manager_t::do_we_want_to_start_gcing() const {
     return gc_enabled && garbage_ratio() > GC_START_RATIO;
 }
 
+gc_policy_t data_block_manager_t::gc_policy() const {
+    return serializer->dynamic_config.gc_policy;
+}
+
+void data_block_manager_t::maybe_advance_gc_policy_clock() {
+    ASSERT_NO_CORO_WAITING;
+    if (gc_policy() != gc_policy_t::cost_benefit) {
+        return;
+    }
+    const kiloticks_t current_time = get_kiloticks();
+    if (current_time.micros - gc_policy_clock.micros > GC_POLICY_CLOCK_INTERVAL.micros) {
+        gc_policy_clock = current_time;
+        // The extents' priorities have all changed, but not by the same amount.
+        gc_pq.rebuild();
+    }
+}
+
 bool gc_entry_less_t::operator()(const gc_entry_t *x, const gc_entry_t *y) {
-    return x->garbage_bytes() < y->garbage_bytes();
+    return x->gc_priority() < y->gc_priority();
 }
 
 /****************
@@ -17,6 +17,7 @@
 #include "serializer/log/config.hpp"
 #include "serializer/log/extent_manager.hpp"
 #include "serializer/types.hpp"
+#include "time.hpp"
 
 class buf_ptr_t;
 class log_serializer_t;
@@ -53,6 +54,12 @@ public:
     buf_ptr_t read(int64_t off_in, block_size_t block_size,
                    file_account_t *io_account);
 
+    /* Reads several blocks.  Blocks that are close to each other on disk are read
+    with a single larger read.  Returns the blocks in the order of `offsets`. */
+    std::vector<buf_ptr_t> read_many(const std::vector<int64_t> &offsets,
+                                     const std::vector<block_size_t> &block_sizes,
+                                     file_account_t *io_account);
+
     /* exposed gc api */
     /* mark a buffer as garbage */
     void mark_garbage(int64_t offset, extent_transaction_t *txn);  // Takes a real int64_t.
@@ -92,15 +99,41 @@ public:
                 file_account_t *io_account,
                 iocallback_t *cb);
 
-    std::vector<std::vector<counted_t<block_token_t> > >
-    gimme_some_new_offsets(const buf_write_info_t *writes, size_t writes_count,
-                           uint64_t *cumulative_aligned_size_out);
-
     bool is_gc_active() const;
 
+    /* Defragmentation moves the blocks in old extents at the end of the file to free
+    extents further towards its start, so that the extent manager can shrink the
+    file once the extents at its end are empty.  It runs alongside the GC, and uses
+    the same machinery to move blocks. */
+    bool do_we_want_to_defrag() const;
+    void start_defrag();
+
+    // Returns false if no defragmentation is running.
+    bool get_defrag_progress(microtime_t *start_time_out, double *progress_out) const;
+
 private:
     void actually_shutdown();
 
+    // Like `many_writes`, but appends the blocks to `*target_extent` (which is either
+    // `&active_extent` or `&cold_active_extent`) instead of to `active_extent`.
+    std::vector<counted_t<block_token_t> >
+    many_writes_to(gc_entry_t **target_extent,
+                   const buf_write_info_t *writes,
+                   size_t writes_count,
+                   file_account_t *io_account,
+                   iocallback_t *cb);
+
+    std::vector<std::vector<counted_t<block_token_t> > >
+    gimme_some_new_offsets(gc_entry_t **target_extent,
+                           const buf_write_info_t *writes, size_t writes_count,
+                           uint64_t *cumulative_aligned_size_out);
+
+    gc_policy_t gc_policy() const;
+
+    // Advances `gc_policy_clock` if it's been a while, and reorders `gc_pq`
+    // accordingly.
+    void maybe_advance_gc_policy_clock();
+
     struct gc_state_t : public intrusive_list_node_t<gc_state_t>{
     public:
         // The entry we're currently GCing.
@@ -127,7 +160,20 @@ private:
     we should keep GCing. */
     void run_gc(gc_state_t *gc_state);
 
-    void gc_one_extent(gc_state_t *gc_state);
+    // GCs `victim`, or the extent at the top of `gc_pq` if `victim` is null.
+    void gc_one_extent(gc_state_t *gc_state, gc_entry_t *victim = nullptr);
+
+    /* Runs in a coroutine and keeps moving extents for as long as
+    `pick_defrag_extent()` finds one. */
+    void run_defrag(gc_state_t *gc_state);
+
+    // Returns the old extent that is closest to the end of the file, if there is a
+    // free extent before it that its blocks could move to.
+    gc_entry_t *pick_defrag_extent() const;
+
+    // The number of old extents past the point where the file would end if it
+    // had no free extents.
+    int64_t count_defrag_extents() const;
 
     void write_gcs(
         std::vector<gc_write_t> &&writes,
@@ -198,15 +244,26 @@ private:
     /* Contains every extent in the gc_entry_t::state_reconstructing state */
     intrusive_list_t<gc_entry_t> reconstructed_extents;
 
-    /* Contains the extent in the gc_entry_t::state_active state. */
+    /* Contains the extent in the gc_entry_t::state_active state that new blocks get
+    written to. */
     gc_entry_t *active_extent;
 
+    /* If `gc_separate_cold_data` is set, contains the extent in the
+    gc_entry_t::state_active state that the GC moves blocks to. This isn't recorded in
+    the metablock, so after a restart it is treated like any other old extent. */
+    gc_entry_t *cold_active_extent;
+
     /* Contains every extent in the gc_entry_t::state_young state */
     intrusive_list_t<gc_entry_t> young_extent_queue;
 
     /* Contains every extent in the gc_entry_t::state_old state */
     priority_queue_t<gc_entry_t *, gc_entry_less_t> gc_pq;
 
+    /* The time that the `cost_benefit` GC policy computes the age of extents
+    relative to. It only advances once in a while, because the order of `gc_pq`
+    depends on it. */
+    kiloticks_t gc_policy_clock;
+
     /* \brief structure to keep track of global stats about the data blocks
      */
     class gc_stat_t {
@@ -224,6 +281,13 @@ private:
     /* The state of all currently active GC coroutines */
     intrusive_list_t<gc_state_t> active_gcs;
 
+    /* The state of the defragmentation coroutine, if it's running.  It's also in
+    `active_gcs`. */
+    gc_state_t *defrag_state;
+    microtime_t defrag_start_time;
+    int64_t defrag_extents_moved;
+    int64_t defrag_extents_total;
+
     /* We aggregate GC index writes into few large index writes
     to improve GC efficiency on drives with slow random access. */
     struct gc_index_write_t {
@@ -76,6 +76,19 @@ public:
         return held_extents_;
     }
 
+    size_t num_extents() const {
+        return extents.size();
+    }
+
+    int64_t first_free_extent() const {
+        // Entries that point past the end of the file don't count, and if the
+        // smallest entry does, all of them do.
+        if (free_queue.empty() || free_queue.top() >= extents.size()) {
+            return NULL_OFFSET;
+        }
+        return free_queue.top() * extent_size;
+    }
+
     extent_zone_t(file_t *_dbfile, uint64_t _extent_size,
                   log_serializer_stats_t *_stats)
         : extent_size(_extent_size), dbfile(_dbfile), stats(_stats), held_extents_(0) {
@@ -325,3 +338,13 @@ size_t extent_manager_t::held_extents() {
     assert_thread();
     return zone->held_extents();
 }
+
+size_t extent_manager_t::num_extents() {
+    assert_thread();
+    return zone->num_extents();
+}
+
+int64_t extent_manager_t::first_free_extent() {
+    assert_thread();
+    return zone->first_free_extent();
+}
@@ -131,6 +131,13 @@ public:
     /* Number of extents that have been released but not handed back out again. */
     size_t held_extents();
 
+    /* Number of extents in the file, including free ones. */
+    size_t num_extents();
+
+    /* The offset of the free extent closest to the start of the file, which is the
+    one that `gen_extent()` hands out next, or NULL_OFFSET if there is none. */
+    int64_t first_free_extent();
+
     log_serializer_stats_t *const stats;
     const uint64_t extent_size;   /* Same as static_config->extent_size */
 
@@ -3,10 +3,181 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
+
+#include "containers/scoped.hpp"
+#include "math.hpp"
 #include "serializer/log/lba/disk_format.hpp"
 
+// The largest value that fits into the 40 bits of a packed offset.
+const uint64_t MAX_PACKED_OFFSET = (uint64_t(1) << 40) - 1;
+
+class in_memory_index_t::chunk_t {
+public:
+    chunk_t() : count_(0), infos_(), recency_base_(0) { }
+
+    index_block_info_t get(size_t index) const {
+        const index_packed_block_info_t &packed = infos_[index];
+        const uint64_t packed_offset
+            = packed.offset_low | (static_cast<uint64_t>(packed.offset_high) << 32);
+        return index_block_info_t(
+            packed_offset == 0
+                ? flagged_off64_t::unused()
+                : flagged_off64_t::make((packed_offset - 1) * DEVICE_BLOCK_SIZE),
+            get_recency(index),
+            packed.ser_block_size,
+            packed.uncompressed_ser_block_size);
+    }
+
+    void set(size_t index, const index_block_info_t &info) {
+        const bool was_empty = is_empty(index);
+
+        index_packed_block_info_t packed;
+        if (info.offset.has_value()) {
+            const int64_t offset = info.offset.get_value();
+            guarantee(divides(DEVICE_BLOCK_SIZE, offset),
+                      "Unaligned block offset %" PRIi64, offset);
+            const uint64_t packed_offset = offset / DEVICE_BLOCK_SIZE + 1;
+            guarantee(packed_offset <= MAX_PACKED_OFFSET,
+                      "Block offset %" PRIi64 " is too large", offset);
+            packed.offset_low = static_cast<uint32_t>(packed_offset);
+            packed.offset_high = static_cast<uint8_t>(packed_offset >> 32);
+        } else {
+            packed.offset_low = 0;
+            packed.offset_high = 0;
+        }
+        packed.ser_block_size = info.ser_block_size;
+        packed.uncompressed_ser_block_size = info.uncompressed_ser_block_size;
+        infos_[index] = packed;
+        set_recency(index, info.recency);
+
+        const bool is_empty_now = is_empty(index);
+        if (was_empty && !is_empty_now) {
+            ++count_;
+        } else if (!was_empty && is_empty_now) {
+            --count_;
+        }
+    }
+
+    // The number of blocks in the chunk that don't have the default info.
+    size_t count() const { return count_; }
+
+    size_t memory_usage() const {
+        return sizeof(chunk_t)
+            + (narrow_recencies_.has() ? CHUNK_SIZE * sizeof(uint32_t) : 0)
+            + (wide_recencies_.has() ? CHUNK_SIZE * sizeof(repli_timestamp_t) : 0);
+    }
+
+private:
+    bool is_empty(size_t index) const {
+        const index_packed_block_info_t &packed = infos_[index];
+        return packed.offset_low == 0
+            && packed.offset_high == 0
+            && packed.ser_block_size == 0
+            && packed.uncompressed_ser_block_size == 0
+            && get_recency(index) == repli_timestamp_t::invalid;
+    }
+
+    repli_timestamp_t get_recency(size_t index) const {
+        if (wide_recencies_.has()) {
+            return wide_recencies_[index];
+        }
+        if (narrow_recencies_.has() && narrow_recencies_[index] != 0) {
+            repli_timestamp_t ret;
+            ret.longtime = recency_base_ + narrow_recencies_[index] - 1;
+            return ret;
+        }
+        return repli_timestamp_t::invalid;
+    }
+
+    void set_recency(size_t index, repli_timestamp_t recency) {
+        if (wide_recencies_.has()) {
+            wide_recencies_[index] = recency;
+            return;
+        }
+        if (recency == repli_timestamp_t::invalid) {
+            if (narrow_recencies_.has()) {
+                narrow_recencies_[index] = 0;
+            }
+            return;
+        }
+
+        if (!narrow_recencies_.has()) {
+            narrow_recencies_.init(CHUNK_SIZE);
+            std::fill(narrow_recencies_.data(), narrow_recencies_.data() + CHUNK_SIZE,
+                      0);
+            recency_base_ = recency.longtime;
+        }
+        if (recency.longtime < recency_base_) {
+            rebase_recencies(recency.longtime);
+        }
+        if (!wide_recencies_.has() && recency.longtime - recency_base_ >= UINT32_MAX) {
+            widen_recencies();
+        }
+
+        if (wide_recencies_.has()) {
+            wide_recencies_[index] = recency;
+        } else {
+            narrow_recencies_[index]
+                = static_cast<uint32_t>(recency.longtime - recency_base_ + 1);
+        }
+    }
+
+    // Lowers `recency_base_` to `new_base`, or switches to wide recencies if that
+    // would make some of the narrow ones overflow.
+    void rebase_recencies(uint64_t new_base) {
+        rassert(new_base < recency_base_);
+        const uint64_t shift = recency_base_ - new_base;
+        const uint32_t max_narrow = *std::max_element(
+            narrow_recencies_.data(), narrow_recencies_.data() + CHUNK_SIZE);
+        if (shift > UINT32_MAX - max_narrow) {
+            widen_recencies();
+            return;
+        }
+        for (size_t i = 0; i < CHUNK_SIZE; ++i) {
+            if (narrow_recencies_[i] != 0) {
+                narrow_recencies_[i] += shift;
+            }
+        }
+        recency_base_ = new_base;
+    }
+
+    void widen_recencies() {
+        scoped_array_t<repli_timestamp_t> wide(CHUNK_SIZE);
+        for (size_t i = 0; i < CHUNK_SIZE; ++i) {
+            wide[i] = get_recency(i);
+        }
+        wide_recencies_ = std::move(wide);
+        narrow_recencies_.reset();
+    }
+
+    size_t count_;
+    index_packed_block_info_t infos_[CHUNK_SIZE];
+
+    // A recency is stored as its offset from `recency_base_` plus one, or as zero if
+    // it is `repli_timestamp_t::invalid`.  Once `wide_recencies_` has been
+    // allocated, it is used instead.  If neither is allocated, all recencies are
+    // invalid.
+    uint64_t recency_base_;
+    scoped_array_t<uint32_t> narrow_recencies_;
+    scoped_array_t<repli_timestamp_t> wide_recencies_;
+
+    DISABLE_COPYING(chunk_t);
+};
+
 in_memory_index_t::in_memory_index_t()
-    : end_block_id_(0), end_aux_block_id_(FIRST_AUX_BLOCK_ID) { }
+    : end_block_id_(0),
+      end_aux_block_id_(FIRST_AUX_BLOCK_ID),
+      chunks_memory_usage_(0) { }
+
+in_memory_index_t::~in_memory_index_t() {
+    for (chunk_t *chunk : chunks_) {
+        delete chunk;
+    }
+    for (chunk_t *chunk : aux_chunks_) {
+        delete chunk;
+    }
+}
 
 block_id_t in_memory_index_t::end_block_id() {
     return end_block_id_;
@@ -16,21 +187,26 @@ block_id_t in_memory_index_t::end_aux_block_id() {
     return end_aux_block_id_;
 }
 
+in_memory_index_t::chunk_t *in_memory_index_t::find_chunk(block_id_t id) const {
+    const std::vector<chunk_t *> &chunks = is_aux_block_id(id) ? aux_chunks_ : chunks_;
+    const size_t relative_id = is_aux_block_id(id) ? make_aux_block_id_relative(id) : id;
+    const size_t chunk_id = relative_id / CHUNK_SIZE;
+    return chunk_id < chunks.size() ? chunks[chunk_id] : nullptr;
+}
+
 index_block_info_t in_memory_index_t::get_block_info(block_id_t id) {
-    if (is_aux_block_id(id)) {
-        index_aux_block_info_t aux_info
-            = aux_infos_.get(make_aux_block_id_relative(id));
-        return index_block_info_t(aux_info.offset,
-                                  repli_timestamp_t::invalid,
-                                  aux_info.ser_block_size);
-    } else {
-        return infos_.get(id);
+    chunk_t *chunk = find_chunk(id);
+    if (chunk == nullptr) {
+        return index_block_info_t();
     }
+    const size_t relative_id = is_aux_block_id(id) ? make_aux_block_id_relative(id) : id;
+    return chunk->get(relative_id % CHUNK_SIZE);
 }
 
 void in_memory_index_t::set_block_info(block_id_t id, repli_timestamp_t recency,
                                        flagged_off64_t offset,
-                                       uint16_t ser_block_size) {
+                                       uint16_t ser_block_size,
+                                       uint16_t uncompressed_ser_block_size) {
     if (is_aux_block_id(id)) {
         if (id >= end_aux_block_id_) {
             end_aux_block_id_ = id + 1;
@@ -39,14 +215,52 @@ void in_memory_index_t::set_block_info(block_id_t id, repli_timestamp_t recency,
         // other than `invalid`, you might be doing something wrong. It will be
         // discarded anyway.
         rassert(recency == repli_timestamp_t::invalid);
-        index_aux_block_info_t info(offset, ser_block_size);
-        aux_infos_.set(make_aux_block_id_relative(id), info);
+        set_in_chunks(&aux_chunks_, make_aux_block_id_relative(id),
+                      index_block_info_t(offset, repli_timestamp_t::invalid,
+                                         ser_block_size, uncompressed_ser_block_size));
     } else {
         if (id >= end_block_id_) {
             end_block_id_ = id + 1;
         }
-        index_block_info_t info(offset, recency, ser_block_size);
-        infos_.set(id, info);
+        set_in_chunks(&chunks_, id,
+                      index_block_info_t(offset, recency, ser_block_size,
+                                         uncompressed_ser_block_size));
+    }
+}
+
+void in_memory_index_t::set_in_chunks(std::vector<chunk_t *> *chunks,
+                                      size_t relative_id,
+                                      const index_block_info_t &info) {
+    const size_t chunk_id = relative_id / CHUNK_SIZE;
+    if (chunk_id >= chunks->size() || (*chunks)[chunk_id] == nullptr) {
+        if (info == index_block_info_t()) {
+            return;
+        }
+        if (chunk_id >= chunks->size()) {
+            chunks->resize(chunk_id + 1, nullptr);
+        }
+        (*chunks)[chunk_id] = new chunk_t;
+        chunks_memory_usage_ += (*chunks)[chunk_id]->memory_usage();
+    }
+
+    chunk_t *chunk = (*chunks)[chunk_id];
+    chunks_memory_usage_ -= chunk->memory_usage();
+    chunk->set(relative_id % CHUNK_SIZE, info);
+    chunks_memory_usage_ += chunk->memory_usage();
+
+    if (chunk->count() == 0) {
+        chunks_memory_usage_ -= chunk->memory_usage();
+        (*chunks)[chunk_id] = nullptr;
+        delete chunk;
+
+        while (!chunks->empty() && chunks->back() == nullptr) {
+            chunks->pop_back();
+        }
     }
 }
 
+size_t in_memory_index_t::memory_usage() const {
+    return sizeof(in_memory_index_t)
+        + (chunks_.capacity() + aux_chunks_.capacity()) * sizeof(chunk_t *)
+        + chunks_memory_usage_;
+}
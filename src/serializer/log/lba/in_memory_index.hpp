@@ -2,8 +2,9 @@
 #ifndef SERIALIZER_LOG_LBA_IN_MEMORY_INDEX_HPP_
 #define SERIALIZER_LOG_LBA_IN_MEMORY_INDEX_HPP_
 
+#include <vector>
+
 #include "arch/compiler.hpp"
-#include "containers/two_level_array.hpp"
 #include "config/args.hpp"
 #include "serializer/serializer.hpp"
 #include "serializer/log/lba/disk_format.hpp"
@@ -12,60 +13,59 @@ ATTR_PACKED(struct index_block_info_t {
     index_block_info_t()
         : offset(flagged_off64_t::unused()),
           recency(repli_timestamp_t::invalid),
-          ser_block_size(0) { }
+          ser_block_size(0),
+          uncompressed_ser_block_size(0) { }
 
     index_block_info_t(flagged_off64_t _offset,
                        repli_timestamp_t _recency,
-                       uint16_t _ser_block_size)
+                       uint16_t _ser_block_size,
+                       uint16_t _uncompressed_ser_block_size)
         : offset(_offset),
           recency(_recency),
-          ser_block_size(_ser_block_size) { }
+          ser_block_size(_ser_block_size),
+          uncompressed_ser_block_size(_uncompressed_ser_block_size) { }
 
-    // For two_level_array_t.
     bool operator==(const index_block_info_t &other) const {
         return offset == other.offset &&
             recency == other.recency &&
-            ser_block_size == other.ser_block_size;
+            ser_block_size == other.ser_block_size &&
+            uncompressed_ser_block_size == other.uncompressed_ser_block_size;
     }
 
     flagged_off64_t offset;
     repli_timestamp_t recency;
+    // The size of the block on disk.
     uint16_t ser_block_size;
+    // Zero unless the block is stored compressed, see `lba_entry_t`.
+    uint16_t uncompressed_ser_block_size;
 });
 
-/* This is a reduced-size block info for auxiliary blocks (currently
-blob blocks used for large values). It doesn't store a replication
-timestamp, because we don't need it for those blocks. */
-ATTR_PACKED(struct index_aux_block_info_t {
-    index_aux_block_info_t()
-        : offset(flagged_off64_t::unused()),
-          ser_block_size(0) { }
-
-    index_aux_block_info_t(flagged_off64_t _offset,
-                           uint16_t _ser_block_size)
-        : offset(_offset),
-          ser_block_size(_ser_block_size) { }
-
-    // For two_level_array_t.
-    bool operator==(const index_aux_block_info_t &other) const {
-        return offset == other.offset &&
-            ser_block_size == other.ser_block_size;
-    }
-
-    flagged_off64_t offset;
+/* The in-memory index keeps an `index_block_info_t` for every block id, but doesn't
+store it as such, because on large databases the index takes up a lot of memory.
+Instead, block ids are split into chunks (like in `two_level_array_t`, chunks that
+contain no blocks aren't allocated), and each chunk stores:
+
+ - An `index_packed_block_info_t` per block: the block's offset in units of
+   DEVICE_BLOCK_SIZE (block offsets are always aligned to that) and its sizes.
+ - The blocks' recencies, as 32 bit offsets from a per-chunk base.  Chunks whose
+   recencies are too far apart fall back to storing full 64 bit recencies.  The
+   recency array is only allocated once a block in the chunk has a valid recency,
+   so chunks of aux blocks (which have no recencies) and of deleted blocks don't
+   pay for it. */
+
+ATTR_PACKED(struct index_packed_block_info_t {
+    // The block's offset divided by DEVICE_BLOCK_SIZE, plus one; zero if the block
+    // has no offset.  This is a 40 bit value.
+    uint32_t offset_low;
+    uint8_t offset_high;
     uint16_t ser_block_size;
+    uint16_t uncompressed_ser_block_size;
 });
 
-
-
 class in_memory_index_t {
-    two_level_array_t<index_block_info_t> infos_;
-    block_id_t end_block_id_;
-    two_level_array_t<index_aux_block_info_t> aux_infos_;
-    block_id_t end_aux_block_id_;
-
 public:
     in_memory_index_t();
+    ~in_memory_index_t();
 
     // end_block_id is one greater than the maximum used block id.
     block_id_t end_block_id();
@@ -73,9 +73,31 @@ public:
 
     index_block_info_t get_block_info(block_id_t id);
     void set_block_info(block_id_t id, repli_timestamp_t recency,
-                        flagged_off64_t offset, uint16_t ser_block_size);
+                        flagged_off64_t offset, uint16_t ser_block_size,
+                        uint16_t uncompressed_ser_block_size);
+
+    // The number of bytes of memory that the index currently uses.
+    size_t memory_usage() const;
+
+private:
+    class chunk_t;
+
+    static const size_t CHUNK_SIZE = 1 << 14;
+
+    // Returns the chunk that holds `id`, or null if there is none.
+    chunk_t *find_chunk(block_id_t id) const;
+    void set_in_chunks(std::vector<chunk_t *> *chunks, size_t relative_id,
+                       const index_block_info_t &info);
 
+    std::vector<chunk_t *> chunks_;
+    block_id_t end_block_id_;
+    std::vector<chunk_t *> aux_chunks_;
+    block_id_t end_aux_block_id_;
+
+    // The memory used by all chunks, not counting the `chunks_` vectors themselves.
+    size_t chunks_memory_usage_;
+
+    DISABLE_COPYING(in_memory_index_t);
 };
 
 #endif  // SERIALIZER_LOG_LBA_IN_MEMORY_INDEX_HPP_
-
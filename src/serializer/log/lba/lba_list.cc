@@ -3,6 +3,7 @@
 
 #include "utils.hpp"
 #include "serializer/log/lba/disk_format.hpp"
+#include "serializer/log/lba/snapshot.hpp"
 #include "arch/arch.hpp"
 #include "perfmon/perfmon.hpp"
 #include "serializer/log/stats.hpp"
@@ -13,7 +14,8 @@
 lba_list_t::lba_list_t(extent_manager_t *em,
         const lba_list_t::write_metablock_fun_t &_write_metablock_fun)
     : gc_drainer(new auto_drainer_t), write_metablock_fun(_write_metablock_fun),
-      extent_manager(em), state(state_unstarted), inline_lba_entries_count(0)
+      extent_manager(em), state(state_unstarted), reported_index_memory_usage(0),
+      index_loaded_from_snapshot(false), inline_lba_entries_count(0)
 {
     for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
         gc_active[i] = false;
@@ -50,8 +52,10 @@ void lba_list_t::prepare_metablock(lba_metablock_mixin_t *mb_out) {
            (LBA_NUM_INLINE_ENTRIES - inline_lba_entries_count) * sizeof(lba_entry_t));
 }
 
+/* Each LBA shard starts reading its extents as soon as its own superblock has been
+loaded, rather than waiting for the superblocks of all the other shards.  The shards
+cover disjoint sets of block ids, so they can fill the in-memory index in any order. */
 class lba_start_fsm_t :
-    private lba_disk_structure_t::load_callback_t,
     private lba_disk_structure_t::read_callback_t
 {
 public:
@@ -72,23 +76,35 @@ public:
                last_metablock->inline_lba_entries,
                last_metablock->inline_lba_entries_count * sizeof(lba_entry_t));
 
+        // Counts the shards that haven't been read completely yet.  Note that the
+        // last shard to finish deletes `this`, possibly before the loop is done.
         cbs_out = LBA_SHARD_FACTOR;
         for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
+            shard_loaders[i].parent = this;
+            shard_loaders[i].shard = i;
             owner->disk_structures[i] = new lba_disk_structure_t(
                 owner->extent_manager, owner->dbfile,
                 &last_metablock->shards[i]);
-            owner->disk_structures[i]->set_load_callback(this);
+            owner->disk_structures[i]->set_load_callback(&shard_loaders[i]);
         }
     }
 
-    void on_lba_load() {
-        rassert(cbs_out > 0);
-        cbs_out--;
-        if (cbs_out == 0) {
-            cbs_out = LBA_SHARD_FACTOR;
-            for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
-                owner->disk_structures[i]->read(&owner->in_memory_index, this);
-            }
+private:
+    struct shard_loader_t : public lba_disk_structure_t::load_callback_t {
+        void on_lba_load() {
+            parent->on_shard_load(shard);
+        }
+        lba_start_fsm_t *parent;
+        int shard;
+    };
+
+    void on_shard_load(int shard) {
+        if (owner->index_loaded_from_snapshot) {
+            // The in-memory index is already complete.  We only needed to load the
+            // superblock so that the shard knows about its extents.
+            on_lba_extents_read();
+        } else {
+            owner->disk_structures[shard]->read(&owner->in_memory_index, this);
         }
     }
 
@@ -98,25 +114,33 @@ public:
         if (cbs_out == 0) {
             // All LBA entries from the LBA extents have been read.
             // Now we can load the (more recent) inlined entries from
-            // the metablock into the index:
-            for (int32_t i = 0; i < owner->inline_lba_entries_count; ++i) {
+            // the metablock into the index.  A snapshot already includes them.
+            for (int32_t i = 0;
+                 i < owner->inline_lba_entries_count && !owner->index_loaded_from_snapshot;
+                 ++i) {
                 lba_entry_t *e = &owner->inline_lba_entries[i];
                 // The on-disk format still stores 32 bit block sizes.
                 // We've never actually used them, and we now use 16 bit block sizes
                 // for the in-memory index to save a few bytes.
                 guarantee(e->ser_block_size <= std::numeric_limits<uint16_t>::max());
+                guarantee(e->uncompressed_ser_block_size
+                          <= std::numeric_limits<uint16_t>::max());
                 owner->in_memory_index.set_block_info(
                         e->block_id,
                         e->recency,
                         e->offset,
-                        static_cast<uint16_t>(e->ser_block_size));
+                        static_cast<uint16_t>(e->ser_block_size),
+                        static_cast<uint16_t>(e->uncompressed_ser_block_size));
             }
 
+            owner->update_index_memory_stat();
             owner->state = lba_list_t::state_ready;
             if (callback) callback->on_lba_ready();
             delete this;
         }
     }
+
+    shard_loader_t shard_loaders[LBA_SHARD_FACTOR];
 };
 
 bool lba_list_t::start_existing(file_t *file, lba_metablock_mixin_t *last_metablock,
@@ -124,7 +148,9 @@ bool lba_list_t::start_existing(file_t *file, lba_metablock_mixin_t *last_metabl
     rassert(state == state_unstarted);
 
     dbfile = file;
-    gc_io_account.init(new file_account_t(dbfile, LBA_GC_IO_PRIORITY));
+    gc_io_account.init(new file_account_t(dbfile, LBA_GC_IO_PRIORITY,
+                                          UNLIMITED_OUTSTANDING_REQUESTS,
+                                          io_class_t::gc));
 
     lba_start_fsm_t *starter = new lba_start_fsm_t(this, last_metablock);
     if (state == state_ready) {
@@ -135,6 +161,19 @@ bool lba_list_t::start_existing(file_t *file, lba_metablock_mixin_t *last_metabl
     }
 }
 
+bool lba_list_t::load_snapshot(const std::string &path,
+                               const lba_snapshot_header_t &expected) {
+    rassert(state == state_unstarted);
+    index_loaded_from_snapshot = load_lba_snapshot(path, expected, &in_memory_index);
+    return index_loaded_from_snapshot;
+}
+
+bool lba_list_t::write_snapshot(const std::string &path,
+                                const lba_snapshot_header_t &header) {
+    rassert(state == state_ready || state == state_gc_shutting_down);
+    return write_lba_snapshot(path, header, &in_memory_index);
+}
+
 block_id_t lba_list_t::end_block_id() {
     rassert(state == state_ready || state == state_gc_shutting_down);
 
@@ -192,11 +231,14 @@ segmented_vector_t<repli_timestamp_t> lba_list_t::get_block_recencies(block_id_t
 
 void lba_list_t::set_block_info(block_id_t block, repli_timestamp_t recency,
                                 flagged_off64_t offset, uint16_t ser_block_size,
+                                uint16_t uncompressed_ser_block_size,
                                 file_account_t *io_account, extent_transaction_t *txn,
                                 optional<std::vector<checksum_filerange>> *checksums) {
     rassert(state == state_ready || state == state_gc_shutting_down);
 
-    in_memory_index.set_block_info(block, recency, offset, ser_block_size);
+    in_memory_index.set_block_info(block, recency, offset, ser_block_size,
+                                   uncompressed_ser_block_size);
+    update_index_memory_stat();
 
     // If the inline LBA is full, free it up first by moving its entries to
     // the LBA extents
@@ -205,7 +247,20 @@ void lba_list_t::set_block_info(block_id_t block, repli_timestamp_t recency,
         rassert(!check_inline_lba_full());
     }
     // Then store the entry inline
-    add_inline_entry(block, recency, offset, ser_block_size);
+    add_inline_entry(block, recency, offset, ser_block_size,
+                     uncompressed_ser_block_size);
+}
+
+void lba_list_t::update_index_memory_stat() {
+    const size_t usage = in_memory_index.memory_usage();
+    if (usage >= reported_index_memory_usage) {
+        extent_manager->stats->pm_serializer_lba_index_memory_bytes
+            += usage - reported_index_memory_usage;
+    } else {
+        extent_manager->stats->pm_serializer_lba_index_memory_bytes
+            -= reported_index_memory_usage - usage;
+    }
+    reported_index_memory_usage = usage;
 }
 
 bool lba_list_t::check_inline_lba_full() const {
@@ -245,6 +300,7 @@ void lba_list_t::move_inline_entries_to_extents(
                 e.recency,
                 e.offset,
                 e.ser_block_size,
+                e.uncompressed_ser_block_size,
                 io_account,
                 txn,
                 checksums);
@@ -254,11 +310,13 @@ void lba_list_t::move_inline_entries_to_extents(
 }
 
 void lba_list_t::add_inline_entry(block_id_t block, repli_timestamp_t recency,
-                                flagged_off64_t offset, uint16_t ser_block_size) {
+                                flagged_off64_t offset, uint16_t ser_block_size,
+                                uint16_t uncompressed_ser_block_size) {
 
     rassert(!check_inline_lba_full());
     inline_lba_entries[inline_lba_entries_count++] =
-            lba_entry_t::make(block, recency, offset, ser_block_size);
+            lba_entry_t::make(block, recency, offset, ser_block_size,
+                              uncompressed_ser_block_size);
 }
 
 class lba_writer_t :
@@ -359,13 +417,13 @@ void lba_list_t::gc(int lba_shard, auto_drainer_t::lock_t) {
             break;
         }
 
-        flagged_off64_t off = get_block_offset(id);
-        if (off.has_value()) {
-            uint16_t ser_block_size = get_ser_block_size(id);
+        index_block_info_t info = get_block_info(id);
+        if (info.offset.has_value()) {
             disk_structures[lba_shard]->add_entry(id,
-                                                  get_block_recency(id),
-                                                  off,
-                                                  ser_block_size,
+                                                  info.recency,
+                                                  info.offset,
+                                                  info.ser_block_size,
+                                                  info.uncompressed_ser_block_size,
                                                   gc_io_account.get(),
                                                   txns.back().get(),
                                                   &checksums);
@@ -507,6 +565,10 @@ void lba_list_t::shutdown() {
 
     gc_io_account.reset();
 
+    extent_manager->stats->pm_serializer_lba_index_memory_bytes
+        -= reported_index_memory_usage;
+    reported_index_memory_usage = 0;
+
     state = state_shut_down;
 }
 
@@ -3,6 +3,7 @@
 #define SERIALIZER_LOG_LBA_LBA_LIST_HPP_
 
 #include <functional>
+#include <string>
 
 #include "concurrency/signal.hpp"
 #include "concurrency/auto_drainer.hpp"
@@ -16,6 +17,7 @@
 
 class lba_start_fsm_t;
 class lba_syncer_t;
+struct lba_snapshot_header_t;
 
 class lba_list_t
 {
@@ -39,6 +41,16 @@ public:
     bool start_existing(file_t *dbfile, lba_metablock_mixin_t *last_metablock,
                         ready_callback_t *cb);
 
+    /* Fills the in-memory index from the LBA snapshot at `path` if there is one that
+    matches `expected` (see serializer/log/lba/snapshot.hpp).  Must be called before
+    `start_existing()`, which then doesn't need to read the LBA extents.  Blocks, so
+    it should be run in the blocker pool. */
+    bool load_snapshot(const std::string &path, const lba_snapshot_header_t &expected);
+
+    /* Writes a snapshot of the in-memory index to `path`.  Nothing may modify the LBA
+    while this runs.  Blocks, so it should be run in the blocker pool. */
+    bool write_snapshot(const std::string &path, const lba_snapshot_header_t &header);
+
     index_block_info_t get_block_info(block_id_t block);
 
     // These return individual fields of get_block_info.
@@ -64,6 +76,7 @@ public:
                         repli_timestamp_t recency,
                         flagged_off64_t offset,
                         uint16_t ser_block_size,
+                        uint16_t uncompressed_ser_block_size,
                         file_account_t *io_account,
                         extent_transaction_t *txn,
                         optional<std::vector<checksum_filerange>> *checksums);
@@ -112,6 +125,14 @@ private:
 
     in_memory_index_t in_memory_index;
 
+    // Brings the `serializer_lba_index_memory_bytes` stat up to date with the
+    // memory usage of `in_memory_index`.
+    void update_index_memory_stat();
+    size_t reported_index_memory_usage;
+
+    // True if `load_snapshot()` filled `in_memory_index`.
+    bool index_loaded_from_snapshot;
+
     // This is a set of inlined LBA entries which are written directly into the
     // metablock. When the array gets full, all inlined LBA entries are moved
     // to the active LBA extent of their respective LBA shards, as computed from
@@ -123,7 +144,8 @@ private:
             file_account_t *io_account, extent_transaction_t *txn,
             optional<std::vector<checksum_filerange>> *checksums);
     void add_inline_entry(block_id_t block, repli_timestamp_t recency,
-                          flagged_off64_t offset, uint16_t ser_block_size);
+                          flagged_off64_t offset, uint16_t ser_block_size,
+                          uint16_t uncompressed_ser_block_size);
 
     lba_disk_structure_t *disk_structures[LBA_SHARD_FACTOR];
 
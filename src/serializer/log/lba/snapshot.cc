@@ -0,0 +1,258 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "serializer/log/lba/snapshot.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <vector>
+
+#include "arch/io/disk.hpp"
+#include "arch/io/io_utils.hpp"
+#include "logger.hpp"
+#include "serializer/log/lba/in_memory_index.hpp"
+
+void make_lba_snapshot_header(uint64_t block_size,
+                              uint64_t extent_size,
+                              metablock_version_t metablock_version,
+                              const lba_metablock_mixin_t &lba_metablock,
+                              lba_snapshot_header_t *header_out) {
+    memset(header_out, 0, sizeof(*header_out));
+    memcpy(header_out->magic, LBA_SNAPSHOT_MAGIC, sizeof(LBA_SNAPSHOT_MAGIC));
+    header_out->block_size = block_size;
+    header_out->extent_size = extent_size;
+    header_out->metablock_version = metablock_version;
+    header_out->lba_metablock = lba_metablock;
+}
+
+#ifdef _WIN32
+
+// TODO WINDOWS: LBA snapshots aren't supported on Windows yet.
+
+bool write_lba_snapshot(const std::string &,
+                        const lba_snapshot_header_t &,
+                        in_memory_index_t *) {
+    return false;
+}
+
+bool load_lba_snapshot(const std::string &,
+                       const lba_snapshot_header_t &,
+                       in_memory_index_t *) {
+    return false;
+}
+
+#else  // _WIN32
+
+// How many entries we buffer before writing them out.
+const size_t LBA_SNAPSHOT_WRITE_BATCH = 65536;
+
+CT_ASSERT(sizeof(lba_snapshot_entry_t) % serializer_checksum::word_size == 0);
+
+lba_snapshot_entry_t make_lba_snapshot_entry(const index_block_info_t &info) {
+    lba_snapshot_entry_t entry;
+    entry.offset = info.offset;
+    entry.recency = info.recency;
+    entry.ser_block_size = info.ser_block_size;
+    entry.uncompressed_ser_block_size = info.uncompressed_ser_block_size;
+    entry.padding = 0;
+    return entry;
+}
+
+bool write_all(int fd, const void *buf, size_t size) {
+    const char *p = static_cast<const char *>(buf);
+    while (size > 0) {
+        const ssize_t res = ::write(fd, p, size);
+        if (res == -1 && get_errno() == EINTR) {
+            continue;
+        }
+        if (res <= 0) {
+            return false;
+        }
+        p += res;
+        size -= res;
+    }
+    return true;
+}
+
+bool write_lba_snapshot(const std::string &path,
+                        const lba_snapshot_header_t &header_in,
+                        in_memory_index_t *index) {
+    const std::string temporary_path = path + ".tmp";
+    scoped_fd_t fd(::open(temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644));
+    if (fd.get() == INVALID_FD) {
+        logWRN("Could not create LBA snapshot file %s: %s",
+               temporary_path.c_str(), errno_string(get_errno()).c_str());
+        return false;
+    }
+
+    lba_snapshot_header_t header = header_in;
+    header.end_block_id = index->end_block_id();
+    header.end_aux_block_id = index->end_aux_block_id();
+
+    // We fill in the checksum and rewrite the header once we've written the entries.
+    bool ok = write_all(fd.get(), &header, sizeof(header));
+
+    serializer_checksum checksum = identity_checksum();
+    std::vector<lba_snapshot_entry_t> batch;
+    batch.reserve(LBA_SNAPSHOT_WRITE_BATCH);
+    auto flush_batch = [&]() {
+        const size_t wordcount = batch.size() * sizeof(lba_snapshot_entry_t)
+            / serializer_checksum::word_size;
+        checksum = compute_checksum_concat(
+            checksum, compute_checksum(batch.data(), wordcount), wordcount);
+        ok = ok && write_all(fd.get(), batch.data(),
+                             batch.size() * sizeof(lba_snapshot_entry_t));
+        batch.clear();
+    };
+    auto add_range = [&](block_id_t begin, block_id_t end) {
+        for (block_id_t id = begin; id < end && ok; ++id) {
+            batch.push_back(make_lba_snapshot_entry(index->get_block_info(id)));
+            if (batch.size() == LBA_SNAPSHOT_WRITE_BATCH) {
+                flush_batch();
+            }
+        }
+    };
+    add_range(0, header.end_block_id);
+    add_range(FIRST_AUX_BLOCK_ID, header.end_aux_block_id);
+    flush_batch();
+
+    header.entries_checksum = checksum;
+    ok = ok && ::pwrite(fd.get(), &header, sizeof(header), 0) == sizeof(header);
+    ok = ok && ::fsync(fd.get()) == 0;
+    if (!ok) {
+        logWRN("Could not write LBA snapshot file %s: %s",
+               temporary_path.c_str(), errno_string(get_errno()).c_str());
+        fd.reset();
+        UNUSED int res = ::unlink(temporary_path.c_str());
+        return false;
+    }
+    fd.reset();
+
+    if (::rename(temporary_path.c_str(), path.c_str()) != 0) {
+        logWRN("Could not rename LBA snapshot file %s to %s: %s",
+               temporary_path.c_str(), path.c_str(),
+               errno_string(get_errno()).c_str());
+        UNUSED int res = ::unlink(temporary_path.c_str());
+        return false;
+    }
+    warn_fsync_parent_directory(path.c_str());
+    return true;
+}
+
+bool snapshot_identity_matches(const lba_snapshot_header_t &header,
+                               const lba_snapshot_header_t &expected) {
+    return memcmp(header.magic, LBA_SNAPSHOT_MAGIC, sizeof(LBA_SNAPSHOT_MAGIC)) == 0
+        && header.block_size == expected.block_size
+        && header.extent_size == expected.extent_size
+        && header.metablock_version == expected.metablock_version
+        && memcmp(&header.lba_metablock, &expected.lba_metablock,
+                  sizeof(lba_metablock_mixin_t)) == 0;
+}
+
+bool load_mapped_lba_snapshot(const char *data, size_t size,
+                              const lba_snapshot_header_t &expected,
+                              in_memory_index_t *index) {
+    if (size < sizeof(lba_snapshot_header_t)) {
+        return false;
+    }
+    const lba_snapshot_header_t *header
+        = reinterpret_cast<const lba_snapshot_header_t *>(data);
+    if (!snapshot_identity_matches(*header, expected)) {
+        return false;
+    }
+
+    const int64_t end_block_id = header->end_block_id;
+    const int64_t end_aux_block_id = header->end_aux_block_id;
+    if (end_block_id < 0
+        || is_aux_block_id(end_block_id)
+        || end_aux_block_id < static_cast<int64_t>(FIRST_AUX_BLOCK_ID)) {
+        return false;
+    }
+    const uint64_t num_entries = static_cast<uint64_t>(end_block_id)
+        + (end_aux_block_id - FIRST_AUX_BLOCK_ID);
+    if (size - sizeof(lba_snapshot_header_t)
+        != num_entries * sizeof(lba_snapshot_entry_t)) {
+        return false;
+    }
+
+    const lba_snapshot_entry_t *entries
+        = reinterpret_cast<const lba_snapshot_entry_t *>(
+            data + sizeof(lba_snapshot_header_t));
+    const serializer_checksum checksum = compute_checksum(
+        entries,
+        num_entries * sizeof(lba_snapshot_entry_t) / serializer_checksum::word_size);
+    if (checksum.value != header->entries_checksum.value) {
+        return false;
+    }
+
+    rassert(index->end_block_id() == 0);
+    rassert(index->end_aux_block_id() == FIRST_AUX_BLOCK_ID);
+    const index_block_info_t unused_info;
+    auto load_range = [&](const lba_snapshot_entry_t *range, block_id_t begin,
+                          block_id_t end) {
+        for (block_id_t id = begin; id < end; ++id) {
+            const lba_snapshot_entry_t &e = range[id - begin];
+            const index_block_info_t info(e.offset, e.recency, e.ser_block_size,
+                                          e.uncompressed_ser_block_size);
+            // Skipping unused entries keeps the index sparse, but we must still set
+            // the last entry so that the index ends up with the right end block id.
+            if (!(info == unused_info) || id + 1 == end) {
+                index->set_block_info(id,
+                                      is_aux_block_id(id)
+                                          ? repli_timestamp_t::invalid
+                                          : info.recency,
+                                      info.offset,
+                                      info.ser_block_size,
+                                      info.uncompressed_ser_block_size);
+            }
+        }
+    };
+    load_range(entries, 0, end_block_id);
+    load_range(entries + end_block_id, FIRST_AUX_BLOCK_ID, end_aux_block_id);
+    return true;
+}
+
+bool load_lba_snapshot(const std::string &path,
+                       const lba_snapshot_header_t &expected,
+                       in_memory_index_t *index) {
+    scoped_fd_t fd(::open(path.c_str(), O_RDONLY));
+    if (fd.get() == INVALID_FD) {
+        if (get_errno() != ENOENT) {
+            logWRN("Could not open LBA snapshot file %s: %s",
+                   path.c_str(), errno_string(get_errno()).c_str());
+        }
+        return false;
+    }
+
+    bool loaded = false;
+    struct stat st;
+    if (::fstat(fd.get(), &st) == 0 && st.st_size > 0) {
+        const size_t size = st.st_size;
+        void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+        if (data != MAP_FAILED) {
+            UNUSED int res = ::madvise(data, size, MADV_SEQUENTIAL);
+            loaded = load_mapped_lba_snapshot(static_cast<const char *>(data), size,
+                                              expected, index);
+            res = ::munmap(data, size);
+            guarantee_err(res == 0, "munmap failed");
+        }
+    }
+    fd.reset();
+
+    if (!loaded) {
+        logINF("Ignoring outdated LBA snapshot file %s", path.c_str());
+    }
+
+    // The snapshot becomes invalid as soon as the serializer writes a new metablock,
+    // so we always get rid of it.
+    if (::unlink(path.c_str()) != 0) {
+        logWRN("Could not remove LBA snapshot file %s: %s",
+               path.c_str(), errno_string(get_errno()).c_str());
+    }
+    return loaded;
+}
+
+#endif  // _WIN32
@@ -0,0 +1,77 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_LOG_LBA_SNAPSHOT_HPP_
+#define SERIALIZER_LOG_LBA_SNAPSHOT_HPP_
+
+#include <string>
+
+#include "arch/compiler.hpp"
+#include "serializer/checksum.hpp"
+#include "serializer/log/metablock.hpp"
+
+class in_memory_index_t;
+
+/* An LBA snapshot is a copy of the in-memory LBA index that a serializer writes next
+to its file when it shuts down cleanly.  The next time the serializer is opened, it can
+fill its in-memory index from the snapshot instead of reading every LBA extent.
+
+A snapshot is only valid for the metablock that was current when it was written,
+which is recorded in its header.  Any later metablock write invalidates it.  The
+serializer deletes the snapshot when it opens the file, whether or not it could use it,
+so that a stale snapshot never lingers around. */
+
+static const char LBA_SNAPSHOT_MAGIC[8] = {'l', 'b', 'a', 's', 'n', 'a', 'p', '1'};
+
+ATTR_PACKED(struct lba_snapshot_header_t {
+    char magic[sizeof(LBA_SNAPSHOT_MAGIC)];
+
+    // These identify the state of the serializer file that the snapshot belongs to.
+    uint64_t block_size;
+    uint64_t extent_size;
+    metablock_version_t metablock_version;
+    lba_metablock_mixin_t lba_metablock;
+
+    // The header is followed by an `lba_snapshot_entry_t` for each block id in [0,
+    // end_block_id), and then one for each block id in [FIRST_AUX_BLOCK_ID,
+    // end_aux_block_id).
+    int64_t end_block_id;
+    int64_t end_aux_block_id;
+
+    // The checksum of all the entries.
+    serializer_checksum entries_checksum;
+});
+
+ATTR_PACKED(struct lba_snapshot_entry_t {
+    flagged_off64_t offset;
+    repli_timestamp_t recency;
+    uint16_t ser_block_size;
+    uint16_t uncompressed_ser_block_size;
+    uint32_t padding;
+});
+
+/* Fills in the fields of `header_out` that identify the serializer file state. */
+void make_lba_snapshot_header(uint64_t block_size,
+                              uint64_t extent_size,
+                              metablock_version_t metablock_version,
+                              const lba_metablock_mixin_t &lba_metablock,
+                              lba_snapshot_header_t *header_out);
+
+/* Both of these block, so they should be run in the blocker pool.  No one else may
+access `index` while they run. */
+
+/* Writes a snapshot of `index` to `path`, replacing any existing snapshot.  The write
+is atomic: the snapshot gets written to a temporary file first which is then renamed.
+`header` must have been filled in by `make_lba_snapshot_header`.  Returns false (after
+logging a warning) if the snapshot couldn't be written. */
+bool write_lba_snapshot(const std::string &path,
+                        const lba_snapshot_header_t &header,
+                        in_memory_index_t *index);
+
+/* Memory-maps the snapshot at `path` and, if it matches `expected` (which must have been
+filled in by `make_lba_snapshot_header`) and is intact, loads it into the empty `index`.
+Deletes the snapshot file afterwards.  Returns true if `index` was loaded, false if
+there was no usable snapshot (in which case `index` is left untouched). */
+bool load_lba_snapshot(const std::string &path,
+                       const lba_snapshot_header_t &expected,
+                       in_memory_index_t *index);
+
+#endif  // SERIALIZER_LOG_LBA_SNAPSHOT_HPP_
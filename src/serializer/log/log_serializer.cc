@@ -11,12 +11,15 @@
 #include "arch/io/disk.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/thread_pool.hpp"
 #include "buffer_cache/types.hpp"
 #include "concurrency/new_mutex.hpp"
 #include "logger.hpp"
 #include "perfmon/perfmon.hpp"
 #include "serializer/buf_ptr.hpp"
+#include "serializer/log/block_compression.hpp"
 #include "serializer/log/data_block_manager.hpp"
+#include "serializer/log/lba/snapshot.hpp"
 
 filepath_file_opener_t::filepath_file_opener_t(const serializer_filepath_t &filepath,
                                                io_backender_t *backender)
@@ -114,15 +117,26 @@ void filepath_file_opener_t::unlink_serializer_file() {
     guarantee_err(res == 0, "unlink() failed");
 }
 
+std::string filepath_file_opener_t::lba_snapshot_file_name() const {
+#ifdef _WIN32
+    // TODO WINDOWS: support LBA snapshots
+    return std::string();
+#else
+    return filepath_.lba_snapshot_path();
+#endif
+}
+
 
 
 log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
     : serializer_collection(),
       pm_serializer_block_reads(secs_to_ticks(1)),
       pm_serializer_index_reads(),
+      pm_serializer_coalesced_block_reads(),
       pm_serializer_block_writes(),
       pm_serializer_index_writes(secs_to_ticks(1)),
       pm_serializer_index_writes_size(secs_to_ticks(1), false),
+      pm_serializer_metablock_writes(secs_to_ticks(1)),
       pm_serializer_read_bytes_per_sec(secs_to_ticks(1)),
       pm_serializer_read_bytes_total(),
       pm_serializer_written_bytes_per_sec(secs_to_ticks(1)),
@@ -133,16 +147,24 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
       pm_serializer_data_extents(),
       pm_serializer_data_extents_allocated(),
       pm_serializer_data_extents_gced(),
+      pm_serializer_data_extents_defragged(),
       pm_serializer_old_garbage_block_bytes(),
       pm_serializer_old_total_block_bytes(),
+      pm_serializer_gc_bytes_moved(),
+      pm_serializer_gc_bytes_freed(),
       pm_serializer_lba_gcs(),
+      pm_serializer_lba_index_memory_bytes(),
+      pm_serializer_compressed_block_writes(),
+      pm_serializer_compression_saved_bytes(),
       parent_collection_membership(parent, &serializer_collection, "serializer"),
       stats_membership(&serializer_collection,
           &pm_serializer_block_reads, "serializer_block_reads",
           &pm_serializer_index_reads, "serializer_index_reads",
+          &pm_serializer_coalesced_block_reads, "serializer_coalesced_block_reads",
           &pm_serializer_block_writes, "serializer_block_writes",
           &pm_serializer_index_writes, "serializer_index_writes",
           &pm_serializer_index_writes_size, "serializer_index_writes_size",
+          &pm_serializer_metablock_writes, "serializer_metablock_writes",
           &pm_serializer_read_bytes_per_sec, "serializer_read_bytes_per_sec",
           &pm_serializer_read_bytes_total, "serializer_read_bytes_total",
           &pm_serializer_written_bytes_per_sec, "serializer_written_bytes_per_sec",
@@ -153,9 +175,17 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
           &pm_serializer_data_extents, "serializer_data_extents",
           &pm_serializer_data_extents_allocated, "serializer_data_extents_allocated",
           &pm_serializer_data_extents_gced, "serializer_data_extents_gced",
+          &pm_serializer_data_extents_defragged, "serializer_data_extents_defragged",
           &pm_serializer_old_garbage_block_bytes, "serializer_old_garbage_block_bytes",
           &pm_serializer_old_total_block_bytes, "serializer_old_total_block_bytes",
-          &pm_serializer_lba_gcs, "serializer_lba_gcs")
+          &pm_serializer_gc_bytes_moved, "serializer_gc_bytes_moved",
+          &pm_serializer_gc_bytes_freed, "serializer_gc_bytes_freed",
+          &pm_serializer_lba_gcs, "serializer_lba_gcs",
+          &pm_serializer_lba_index_memory_bytes, "serializer_lba_index_memory_bytes",
+          &pm_serializer_compressed_block_writes,
+          "serializer_compressed_block_writes",
+          &pm_serializer_compression_saved_bytes,
+          "serializer_compression_saved_bytes")
 { }
 
 void log_serializer_stats_t::bytes_read(size_t count) {
@@ -276,6 +306,19 @@ struct ls_start_existing_fsm_t :
             }
         }
 
+        if (start_existing_state == state_load_lba_snapshot) {
+            guarantee(metablock_found, "Could not find any valid metablock.");
+
+            if (ser->lba_snapshot_path.empty()) {
+                start_existing_state = state_start_lba;
+            } else {
+                start_existing_state = state_waiting_for_lba_snapshot;
+                coro_t::spawn_sometime(
+                    std::bind(&ls_start_existing_fsm_t::load_lba_snapshot, this));
+                return false;
+            }
+        }
+
         if (start_existing_state == state_start_lba) {
             // STATE G
             guarantee(metablock_found, "Could not find any valid metablock.");
@@ -362,6 +405,24 @@ struct ls_start_existing_fsm_t :
     void on_metablock_read() {
         rassert(start_existing_state == state_waiting_for_metablock);
         // state after F, state before G
+        start_existing_state = state_load_lba_snapshot;
+        next_starting_up_step();
+    }
+
+    void load_lba_snapshot() {
+        rassert(start_existing_state == state_waiting_for_lba_snapshot);
+        lba_snapshot_header_t expected;
+        make_lba_snapshot_header(ser->static_config.block_size_,
+                                 ser->static_config.extent_size(),
+                                 ser->metablock_manager->latest_version(),
+                                 metablock_buffer.lba_index_part,
+                                 &expected);
+        // If there's a usable snapshot, the LBA doesn't have to read its extents
+        // when we start it.
+        thread_pool_t::run_in_blocker_pool([&]() {
+            UNUSED bool loaded
+                = ser->lba_index->load_snapshot(ser->lba_snapshot_path, expected);
+        });
         start_existing_state = state_start_lba;
         // STATE G
         next_starting_up_step();
@@ -388,6 +449,8 @@ struct ls_start_existing_fsm_t :
         state_waiting_for_static_header,
         state_find_metablock,
         state_waiting_for_metablock,
+        state_load_lba_snapshot,
+        state_waiting_for_lba_snapshot,
         state_start_lba,
         state_waiting_for_lba,
         state_reconstruct,
@@ -417,6 +480,8 @@ log_serializer_t::log_serializer_t(dynamic_config_t _dynamic_config,
       expecting_no_more_tokens(false),
 #endif
       dynamic_config(_dynamic_config),
+      block_compression(_dynamic_config.block_compression),
+      lba_snapshot_path(file_opener->lba_snapshot_file_name()),
       shutdown_callback(nullptr),
       shutdown_state(shutdown_not_started),
       state(state_unstarted),
@@ -447,10 +512,11 @@ log_serializer_t::~log_serializer_t() {
 }
 
 file_account_t *log_serializer_t::make_io_account(int priority,
-                                                  int outstanding_requests_limit) {
+                                                  int outstanding_requests_limit,
+                                                  io_class_t io_class) {
     assert_thread();
     rassert(dbfile);
-    return new file_account_t(dbfile, priority, outstanding_requests_limit);
+    return new file_account_t(dbfile, priority, outstanding_requests_limit, io_class);
 }
 
 buf_ptr_t log_serializer_t::block_read(const counted_t<block_token_t> &token,
@@ -462,13 +528,45 @@ buf_ptr_t log_serializer_t::block_read(const counted_t<block_token_t> &token,
     ticks_t pm_time;
     stats->pm_serializer_block_reads.begin(&pm_time);
 
-    buf_ptr_t ret = data_block_manager->read(token->offset_, token->block_size(),
+    buf_ptr_t ret = data_block_manager->read(token->offset_, token->disk_block_size_,
                                              io_account);
+    if (token->disk_block_size_ != token->block_size_) {
+        ret = decompress_block(ret, token->block_size_);
+    }
 
     stats->pm_serializer_block_reads.end(&pm_time);
     return ret;
 }
 
+std::vector<buf_ptr_t> log_serializer_t::block_reads(
+        const std::vector<counted_t<block_token_t>> &tokens,
+        file_account_t *io_account) {
+    assert_thread();
+    guarantee(state == state_ready);
+
+    std::vector<ticks_t> pm_times(tokens.size());
+    std::vector<int64_t> offsets;
+    std::vector<block_size_t> disk_block_sizes;
+    offsets.reserve(tokens.size());
+    disk_block_sizes.reserve(tokens.size());
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        guarantee(tokens[i].has());
+        stats->pm_serializer_block_reads.begin(&pm_times[i]);
+        offsets.push_back(tokens[i]->offset_);
+        disk_block_sizes.push_back(tokens[i]->disk_block_size_);
+    }
+
+    std::vector<buf_ptr_t> ret
+        = data_block_manager->read_many(offsets, disk_block_sizes, io_account);
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        if (tokens[i]->disk_block_size_ != tokens[i]->block_size_) {
+            ret[i] = decompress_block(ret[i], tokens[i]->block_size_);
+        }
+        stats->pm_serializer_block_reads.end(&pm_times[i]);
+    }
+    return ret;
+}
+
 void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
                                    const std::function<void()> &on_writes_reflected,
                                    const std::vector<index_write_op_t> &write_ops) {
@@ -495,8 +593,10 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
              write_op_it != write_ops.end();
              ++write_op_it) {
             const index_write_op_t &op = *write_op_it;
-            flagged_off64_t offset = lba_index->get_block_offset(op.block_id);
-            uint16_t ser_block_size = lba_index->get_ser_block_size(op.block_id);
+            const index_block_info_t info = lba_index->get_block_info(op.block_id);
+            flagged_off64_t offset = info.offset;
+            uint16_t ser_block_size = info.ser_block_size;
+            uint16_t uncompressed_ser_block_size = info.uncompressed_ser_block_size;
 
             if (op.token) {
                 // Update the offset pointed to, and mark garbage/liveness as necessary.
@@ -510,7 +610,11 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
                 // Write new token to index, or remove from index as appropriate.
                 if (token.has()) {
                     offset = flagged_off64_t::make(token->offset_);
-                    ser_block_size = token->block_size().ser_value();
+                    ser_block_size = token->disk_block_size_.ser_value();
+                    uncompressed_ser_block_size =
+                        token->disk_block_size_ != token->block_size_
+                        ? token->block_size_.ser_value()
+                        : 0;
 
                     if (checksums) {
                         serializer_checksum checksum = token->checksum_;
@@ -530,10 +634,11 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
 
                     /* mark the life */
                     data_block_manager->mark_live(offset.get_value(),
-                                                  token->block_size());
+                                                  token->disk_block_size_);
                 } else {
                     offset = flagged_off64_t::unused();
                     ser_block_size = 0;
+                    uncompressed_ser_block_size = 0;
                 }
             }
 
@@ -542,6 +647,7 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
 
             lba_index->set_block_info(op.block_id, recency,
                                       offset, ser_block_size,
+                                      uncompressed_ser_block_size,
                                       index_writes_io_account.get(), &txn,
                                       &checksums);
         }
@@ -552,8 +658,8 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
 
     // Before we fully commit the write to disk, we must migrate the static header
     // if necessary.
-    // Note that this is early enough for upgrading from the 1.13 serializer
-    // version to 2.2, since only the format of the LBA changed.
+    // Note that this is early enough for upgrading from the 1.13 and 2.2 serializer
+    // versions to 2.6, since only the format of the LBA changed.
     // Future serializer format changes might require this step to happen earlier.
     {
         new_mutex_acq_t acq(&static_header_migration_mutex);
@@ -650,6 +756,8 @@ void log_serializer_t::write_metablock(
     }
     guarantee(metablock_waiter_queue.front() == &on_prev_write_submitted_metablock);
 
+    ticks_t pm_time;
+    stats->pm_serializer_metablock_writes.begin(&pm_time);
     struct : public cond_t, public metablock_manager_t::metablock_write_callback_t {
         void on_metablock_write() { pulse(); }
     } on_metablock_write;
@@ -666,6 +774,7 @@ void log_serializer_t::write_metablock(
     }
 
     on_metablock_write.wait();
+    stats->pm_serializer_metablock_writes.end(&pm_time);
 }
 
 void log_serializer_t::write_metablock_sans_pipelining(
@@ -678,9 +787,11 @@ void log_serializer_t::write_metablock_sans_pipelining(
 }
 
 counted_t<block_token_t>
-log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size) {
+log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size,
+                                       block_size_t disk_block_size) {
     assert_thread();
-    counted_t<block_token_t> token(new block_token_t(this, offset, block_size));
+    counted_t<block_token_t> token(
+        new block_token_t(this, offset, block_size, disk_block_size));
 
     auto location = offset_tokens.find(offset);
     if (location == offset_tokens.end()) {
@@ -699,9 +810,57 @@ log_serializer_t::block_writes(const buf_write_info_t *write_infos,
     assert_thread();
     stats->pm_serializer_block_writes += write_infos_count;
 
+    if (block_compression == block_compression_t::none) {
+        std::vector<counted_t<block_token_t> > result
+            = data_block_manager->many_writes(write_infos, write_infos_count,
+                                              io_account, cb);
+        guarantee(result.size() == write_infos_count);
+        return result;
+    }
+
+    // The compressed buffers have to stay around until the writes are complete.
+    struct compressed_writes_cb_t : public iocallback_t {
+        void on_io_complete() {
+            iocallback_t *local_cb = cb;
+            delete this;
+            local_cb->on_io_complete();
+        }
+
+        std::vector<buf_ptr_t> compressed_bufs;
+        iocallback_t *cb;
+    };
+
+    compressed_writes_cb_t *const compressed_cb = new compressed_writes_cb_t;
+    compressed_cb->cb = cb;
+    compressed_cb->compressed_bufs.resize(write_infos_count);
+
+    std::vector<buf_write_info_t> writes(write_infos, write_infos + write_infos_count);
+    for (size_t i = 0; i < write_infos_count; ++i) {
+        // `many_writes` would set this for us, but it only sees the compressed copy.
+        write_infos[i].buf->ser_header.block_id = write_infos[i].block_id;
+
+        buf_ptr_t *compressed = &compressed_cb->compressed_bufs[i];
+        if (compress_block(block_compression, write_infos[i].buf,
+                           write_infos[i].block_size, compressed)) {
+            writes[i] = buf_write_info_t(compressed->ser_buffer(),
+                                         compressed->block_size(),
+                                         write_infos[i].block_id);
+            ++stats->pm_serializer_compressed_block_writes;
+            stats->pm_serializer_compression_saved_bytes
+                += buf_ptr_t::compute_aligned_block_size(write_infos[i].block_size)
+                - compressed->aligned_block_size();
+        }
+    }
+
     std::vector<counted_t<block_token_t> > result
-        = data_block_manager->many_writes(write_infos, write_infos_count, io_account, cb);
+        = data_block_manager->many_writes(writes.data(), write_infos_count,
+                                          io_account, compressed_cb);
     guarantee(result.size() == write_infos_count);
+
+    // The tokens report the block's uncompressed size to the cache.
+    for (size_t i = 0; i < write_infos_count; ++i) {
+        result[i]->block_size_ = write_infos[i].block_size;
+    }
     return result;
 }
 
@@ -783,12 +942,31 @@ max_block_size_t log_serializer_t::max_block_size() const {
     return static_config.max_block_size();
 }
 
+uint64_t log_serializer_t::extent_size() const {
+    return static_config.extent_size();
+}
+
 bool log_serializer_t::coop_lock_and_check() {
     assert_thread();
     rassert(dbfile != nullptr);
     return dbfile->coop_lock_and_check();
 }
 
+bool log_serializer_t::get_defrag_progress(microtime_t *start_time_out,
+                                           double *progress_out) {
+    assert_thread();
+    if (state != state_ready) {
+        return false;
+    }
+    return data_block_manager->get_defrag_progress(start_time_out, progress_out);
+}
+
+void log_serializer_t::set_block_compression(block_compression_t method) {
+    assert_thread();
+    guarantee(block_compression_supported(method));
+    block_compression = method;
+}
+
 bool log_serializer_t::is_gc_active() const {
     return data_block_manager->is_gc_active() || lba_index->is_any_gc_active();
 }
@@ -820,8 +998,14 @@ counted_t<block_token_t> log_serializer_t::index_read(block_id_t block_id) {
 
     index_block_info_t info = lba_index->get_block_info(block_id);
     if (info.offset.has_value()) {
+        const block_size_t disk_block_size
+            = block_size_t::unsafe_make(info.ser_block_size);
         return generate_block_token(info.offset.get_value(),
-                                    block_size_t::unsafe_make(info.ser_block_size));
+                                    info.uncompressed_ser_block_size != 0
+                                    ? block_size_t::unsafe_make(
+                                        info.uncompressed_ser_block_size)
+                                    : disk_block_size,
+                                    disk_block_size);
     } else {
         return counted_t<block_token_t>();
     }
@@ -902,7 +1086,16 @@ void log_serializer_t::next_shutdown_step() {
 
     rassert(expecting_no_more_tokens);
 
-    if (shutdown_state == shutdown_waiting_on_block_tokens) {
+    if (shutdown_state == shutdown_waiting_on_block_tokens
+        && dynamic_config.lba_snapshot && !lba_snapshot_path.empty()) {
+        shutdown_state = shutdown_writing_lba_snapshot;
+        coro_t::spawn_sometime(std::bind(
+            &log_serializer_t::write_lba_snapshot_and_continue_shutdown, this));
+        return;
+    }
+
+    if (shutdown_state == shutdown_waiting_on_block_tokens
+        || shutdown_state == shutdown_writing_lba_snapshot) {
         lba_index->shutdown();
         metablock_manager->shutdown();
         extent_manager->shutdown();
@@ -947,6 +1140,25 @@ void log_serializer_t::delete_dbfile_and_continue_shutdown() {
     next_shutdown_step();
 }
 
+void log_serializer_t::write_lba_snapshot_and_continue_shutdown() {
+    assert_thread();
+    rassert(shutdown_state == shutdown_writing_lba_snapshot);
+
+    // Nothing is writing anymore, so the LBA matches the latest metablock on disk.
+    lba_metablock_mixin_t lba_metablock;
+    lba_index->prepare_metablock(&lba_metablock);
+    lba_snapshot_header_t header;
+    make_lba_snapshot_header(static_config.block_size_,
+                             static_config.extent_size(),
+                             metablock_manager->latest_version(),
+                             lba_metablock,
+                             &header);
+    thread_pool_t::run_in_blocker_pool([&]() {
+        UNUSED bool written = lba_index->write_snapshot(lba_snapshot_path, header);
+    });
+    next_shutdown_step();
+}
+
 void log_serializer_t::on_datablock_manager_shutdown() {
     assert_thread();
     next_shutdown_step();
@@ -978,6 +1190,10 @@ void log_serializer_t::consider_start_gc() {
         // (i.e. shutting down)
         data_block_manager->start_gc();
     }
+    if (data_block_manager->do_we_want_to_defrag()
+        && state == log_serializer_t::state_ready) {
+        data_block_manager->start_defrag();
+    }
 }
 
 
@@ -1016,9 +1232,11 @@ bool log_serializer_t::should_perform_read_ahead() {
 
 block_token_t::block_token_t(log_serializer_t *serializer,
                              int64_t initial_offset,
-                             block_size_t initial_block_size)
+                             block_size_t initial_block_size,
+                             block_size_t initial_disk_block_size)
     : serializer_(serializer), ref_count_(0),
       block_size_(initial_block_size),
+      disk_block_size_(initial_disk_block_size),
       checksum_(no_checksum()),
       offset_(initial_offset) {
     serializer_->assert_thread();
@@ -60,6 +60,7 @@ public:
     void move_serializer_file_to_permanent_location();
     void open_serializer_file_existing(scoped_ptr_t<file_t> *file_out);
     void unlink_serializer_file();
+    std::string lba_snapshot_file_name() const;
 
 private:
     void open_serializer_file(const std::string &path, int extra_flags, scoped_ptr_t<file_t> *file_out);
@@ -124,7 +125,8 @@ public:
     virtual ~log_serializer_t();
 
     using serializer_t::make_io_account;
-    file_account_t *make_io_account(int priority, int outstanding_requests_limit);
+    file_account_t *make_io_account(int priority, int outstanding_requests_limit,
+                                    io_class_t io_class);
 
     void register_read_ahead_cb(serializer_read_ahead_callback_t *cb);
     void unregister_read_ahead_cb(serializer_read_ahead_callback_t *cb);
@@ -138,6 +140,9 @@ public:
 
     buf_ptr_t block_read(const counted_t<block_token_t> &token,
                        file_account_t *io_account);
+    std::vector<buf_ptr_t> block_reads(
+        const std::vector<counted_t<block_token_t>> &tokens,
+        file_account_t *io_account);
 
     void index_write(new_mutex_in_line_t *mutex_acq,
                      const std::function<void()> &on_writes_reflected,
@@ -151,15 +156,23 @@ public:
 
     max_block_size_t max_block_size() const;
 
+    uint64_t extent_size() const;
+
     bool coop_lock_and_check();
 
     virtual bool is_gc_active() const;
 
+    bool get_defrag_progress(microtime_t *start_time_out, double *progress_out);
+
+    /* Changes how blocks that get written from now on are compressed. */
+    void set_block_compression(block_compression_t method);
+
 private:
     void unregister_block_token(block_token_t *token);
     void remap_block_to_new_offset(int64_t current_offset, int64_t new_offset);
     counted_t<block_token_t> generate_block_token(int64_t offset,
-                                                             block_size_t block_size);
+                                                  block_size_t block_size,
+                                                  block_size_t disk_block_size);
 
     void offer_buf_to_read_ahead_callbacks(
             block_id_t block_id,
@@ -181,6 +194,8 @@ private:
     void next_shutdown_step();
 
     void delete_dbfile_and_continue_shutdown();
+    // Must be run in a coroutine.
+    void write_lba_snapshot_and_continue_shutdown();
 
     virtual void on_datablock_manager_shutdown();
 
@@ -226,6 +241,13 @@ private:
     const dynamic_config_t dynamic_config;
     static_config_t static_config;
 
+    // Starts out as `dynamic_config.block_compression`.
+    block_compression_t block_compression;
+
+    // Where we look for an LBA snapshot on start-up and write one on shutdown if
+    // `dynamic_config.lba_snapshot` is set.  Empty if there is no place for one.
+    const std::string lba_snapshot_path;
+
     cond_t *shutdown_callback;
 
     enum shutdown_state_t {
@@ -234,6 +256,7 @@ private:
         shutdown_waiting_on_serializer,
         shutdown_waiting_on_datablock_manager,
         shutdown_waiting_on_block_tokens,
+        shutdown_writing_lba_snapshot,
         shutdown_waiting_on_dbfile_destruction,
     } shutdown_state;
 
@@ -64,6 +64,12 @@ public:
 
     void shutdown();
 
+    // The version of the metablock that was most recently read or written.
+    metablock_version_t latest_version() const {
+        rassert(state == state_ready);
+        return next_version_number - 1;
+    }
+
 private:
     void start_existing_callback(file_t *dbfile,
                                  bool *mb_found,
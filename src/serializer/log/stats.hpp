@@ -13,9 +13,13 @@ struct log_serializer_stats_t {
 
     perfmon_duration_sampler_t pm_serializer_block_reads;
     perfmon_counter_t pm_serializer_index_reads;
+    /* Blocks that were read as part of a larger, coalesced read */
+    perfmon_counter_t pm_serializer_coalesced_block_reads;
     perfmon_counter_t pm_serializer_block_writes;
     perfmon_duration_sampler_t pm_serializer_index_writes;
     perfmon_sampler_t pm_serializer_index_writes_size;
+    /* Metablock writes, including the fdatasync that makes them durable */
+    perfmon_duration_sampler_t pm_serializer_metablock_writes;
 
     perfmon_rate_monitor_t pm_serializer_read_bytes_per_sec;
     perfmon_counter_t pm_serializer_read_bytes_total;
@@ -33,11 +37,20 @@ struct log_serializer_stats_t {
     perfmon_counter_t pm_serializer_data_extents;
     perfmon_counter_t pm_serializer_data_extents_allocated;
     perfmon_counter_t pm_serializer_data_extents_gced;
+    perfmon_counter_t pm_serializer_data_extents_defragged;
     perfmon_counter_t pm_serializer_old_garbage_block_bytes;
     perfmon_counter_t pm_serializer_old_total_block_bytes;
+    /* Live bytes the GC had to move, and the bytes it freed by doing so */
+    perfmon_counter_t pm_serializer_gc_bytes_moved;
+    perfmon_counter_t pm_serializer_gc_bytes_freed;
 
     /* used in serializer/log/lba/lba_list.cc */
     perfmon_counter_t pm_serializer_lba_gcs;
+    perfmon_counter_t pm_serializer_lba_index_memory_bytes;
+
+    /* Blocks written compressed, and the disk space that saved (not counting GC) */
+    perfmon_counter_t pm_serializer_compressed_block_writes;
+    perfmon_counter_t pm_serializer_compression_saved_bytes;
 
     perfmon_membership_t parent_collection_membership;
     perfmon_multi_membership_t stats_membership;
@@ -6,17 +6,34 @@
 #include "errors.hpp"
 
 #include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
+#include "assignment_sentry.hpp"
 #include "concurrency/new_mutex.hpp"
+#include "concurrency/wait_any.hpp"
 #include "config/args.hpp"
 #include "serializer/types.hpp"
 
 
-merger_serializer_t::merger_serializer_t(scoped_ptr_t<serializer_t> _inner,
-                                         int _max_active_writes) :
+merger_serializer_t::merger_serializer_t(
+        scoped_ptr_t<serializer_t> _inner,
+        int _max_active_writes,
+        const merger_group_commit_config_t &_group_commit_config,
+        perfmon_collection_t *perfmon_collection) :
     inner(std::move(_inner)),
     block_writes_io_account(make_io_account(MERGER_BLOCK_WRITE_IO_PRIORITY)),
-    write_committer(std::bind(&merger_serializer_t::do_index_write, this),
-                    _max_active_writes) { }
+    group_commit_config(_group_commit_config),
+    outstanding_index_writes(0),
+    outstanding_index_write_bytes(0),
+    batch_full_cond(nullptr),
+    pm_group_commit_batch_size(secs_to_ticks(1), false),
+    write_committer(std::bind(&merger_serializer_t::do_index_write, this, ph::_1),
+                    _max_active_writes) {
+    if (perfmon_collection != nullptr) {
+        pm_group_commit_batch_size_membership.init(new perfmon_membership_t(
+            perfmon_collection, &pm_group_commit_batch_size,
+            "serializer_group_commit_batch_size"));
+    }
+}
 
 merger_serializer_t::~merger_serializer_t() {
     assert_thread();
@@ -48,6 +65,7 @@ void merger_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
         for (auto op = write_ops.begin(); op != write_ops.end(); ++op) {
             push_index_write_op(*op);
         }
+        ++outstanding_index_writes;
     }
 
     // Changes are now visible for subsequent `index_read()` calls.
@@ -64,9 +82,28 @@ void merger_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
     write_committer.flush(&non_interruptor);
 }
 
-void merger_serializer_t::do_index_write() {
+void merger_serializer_t::wait_for_group_commit_window(signal_t *interruptor) {
+    if (group_commit_config.max_batch_bytes != 0
+        && outstanding_index_write_bytes >= group_commit_config.max_batch_bytes) {
+        return;
+    }
+    signal_timer_t window_timer(group_commit_config.window_ms);
+    cond_t batch_full;
+    assignment_sentry_t<cond_t *> batch_full_sentry(&batch_full_cond, &batch_full);
+    // If we get interrupted, we still commit what we have.
+    wait_any_t waiter(&window_timer, &batch_full, interruptor);
+    waiter.wait_lazily_unordered();
+}
+
+void merger_serializer_t::do_index_write(signal_t *interruptor) {
     assert_thread();
 
+    // Give more index writes a chance to join this batch, so that they can share
+    // its metablock write.
+    if (group_commit_config.window_ms > 0) {
+        wait_for_group_commit_window(interruptor);
+    }
+
     // Pause changes to outstanding_index_write_ops
     new_mutex_in_line_t outstanding_mutex_acq(&outstanding_index_write_mutex);
     outstanding_mutex_acq.acq_signal()->wait_lazily_unordered();
@@ -89,7 +126,10 @@ void merger_serializer_t::do_index_write() {
             // Once the writes are reflected in future calls to `inner->index_read()`,
             // we can reset outstanding_index_write_ops and allow new write ops to
             // get in line.
+            pm_group_commit_batch_size.record(outstanding_index_writes);
             outstanding_index_write_ops.clear();
+            outstanding_index_writes = 0;
+            outstanding_index_write_bytes = 0;
             outstanding_mutex_acq.reset();
         },
         write_ops);
@@ -107,6 +147,15 @@ void merger_serializer_t::merge_index_write_op(const index_write_op_t &to_be_mer
 }
 
 void merger_serializer_t::push_index_write_op(const index_write_op_t &op) {
+    if (op.token.has_value() && op.token->has()) {
+        outstanding_index_write_bytes += (*op.token)->block_size().ser_value();
+        if (batch_full_cond != nullptr
+            && group_commit_config.max_batch_bytes != 0
+            && outstanding_index_write_bytes >= group_commit_config.max_batch_bytes) {
+            batch_full_cond->pulse_if_not_already_pulsed();
+        }
+    }
+
     auto existing_pair =
         outstanding_index_write_ops.insert(
             std::pair<block_id_t, index_write_op_t>(op.block_id, op));
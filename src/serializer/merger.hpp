@@ -10,6 +10,7 @@
 #include "concurrency/new_mutex.hpp"
 #include "concurrency/pump_coro.hpp"
 #include "containers/scoped.hpp"
+#include "perfmon/perfmon.hpp"
 #include "serializer/buf_ptr.hpp"
 #include "serializer/serializer.hpp"
 
@@ -26,19 +27,40 @@
  * for all block_writes, so reduce the amount of random disk seeks that can
  * occur when writes from multiple different accounts get interleaved (see
  * https://github.com/rethinkdb/rethinkdb/issues/3348 )
+ *
+ * Since every index_write of the inner serializer ends in a metablock write (and,
+ * for hard durability, an fdatasync), merging index writes amounts to group
+ * commit. With a `merger_group_commit_config_t` window, the merger additionally
+ * waits for more index writes to join a batch before committing it, unless the
+ * batch already covers `max_batch_bytes` worth of blocks.
  */
 
+struct merger_group_commit_config_t {
+    merger_group_commit_config_t() : window_ms(0), max_batch_bytes(0) { }
+
+    // How long to wait for more index writes before committing a batch.  With 0,
+    // a batch gets committed as soon as the previous one has been.
+    int64_t window_ms;
+    // Commit a batch right away once its blocks add up to this many bytes.  0
+    // means that there is no limit.
+    uint64_t max_batch_bytes;
+};
+
 class merger_serializer_t : public serializer_t {
 public:
-    merger_serializer_t(scoped_ptr_t<serializer_t> _inner, int _max_active_writes);
+    merger_serializer_t(scoped_ptr_t<serializer_t> _inner, int _max_active_writes,
+                        const merger_group_commit_config_t &_group_commit_config
+                            = merger_group_commit_config_t(),
+                        perfmon_collection_t *perfmon_collection = nullptr);
     ~merger_serializer_t();
 
 
     /* Allocates a new io account for the underlying file.
     Use delete to free it. */
     using serializer_t::make_io_account;
-    file_account_t *make_io_account(int priority, int outstanding_requests_limit) {
-        return inner->make_io_account(priority, outstanding_requests_limit);
+    file_account_t *make_io_account(int priority, int outstanding_requests_limit,
+                                    io_class_t io_class) {
+        return inner->make_io_account(priority, outstanding_requests_limit, io_class);
     }
 
     /* Some serializer implementations support read-ahead to speed up cache warmup.
@@ -58,6 +80,11 @@ public:
                        file_account_t *io_account) {
         return inner->block_read(token, io_account);
     }
+    std::vector<buf_ptr_t> block_reads(
+            const std::vector<counted_t<block_token_t>> &tokens,
+            file_account_t *io_account) {
+        return inner->block_reads(tokens, io_account);
+    }
 
     /* The index stores three pieces of information for each ID:
      * 1. A pointer to a data block on disk (which may be NULL)
@@ -108,6 +135,8 @@ public:
     /* The size, in bytes, of each serializer block */
     max_block_size_t max_block_size() const { return inner->max_block_size(); }
 
+    uint64_t extent_size() const { return inner->extent_size(); }
+
     /* Return true if no other processes have the file locked */
     bool coop_lock_and_check() { return inner->coop_lock_and_check(); }
 
@@ -116,6 +145,10 @@ public:
         return inner->is_gc_active();
     }
 
+    bool get_defrag_progress(microtime_t *start_time_out, double *progress_out) {
+        return inner->get_defrag_progress(start_time_out, progress_out);
+    }
+
 private:
     // Adds `op` to `outstanding_index_write_ops`, using `merge_index_write_op()` if
     // necessary
@@ -124,7 +157,11 @@ private:
     void merge_index_write_op(const index_write_op_t &to_be_merged,
                               index_write_op_t *into_out) const;
 
-    void do_index_write();
+    void do_index_write(signal_t *interruptor);
+
+    // Waits until the group commit window has passed, or the outstanding index
+    // writes exceed the byte budget.
+    void wait_for_group_commit_window(signal_t *interruptor);
 
     const scoped_ptr_t<serializer_t> inner;
     const scoped_ptr_t<file_account_t> block_writes_io_account;
@@ -142,6 +179,20 @@ private:
     // serializer.
     new_mutex_t outstanding_index_write_mutex;
 
+    const merger_group_commit_config_t group_commit_config;
+
+    // The number of `index_write()` calls and the block bytes that are waiting in
+    // `outstanding_index_write_ops`.
+    int outstanding_index_writes;
+    uint64_t outstanding_index_write_bytes;
+    // Pulsed when `outstanding_index_write_bytes` reaches the byte budget while
+    // `wait_for_group_commit_window()` is waiting.
+    cond_t *batch_full_cond;
+
+    // The number of `index_write()` calls that got committed together.
+    perfmon_sampler_t pm_group_commit_batch_size;
+    scoped_ptr_t<perfmon_membership_t> pm_group_commit_batch_size_membership;
+
     pump_coro_t write_committer;
 
     DISABLE_COPYING(merger_serializer_t);
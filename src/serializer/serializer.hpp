@@ -10,6 +10,7 @@
 #include "containers/segmented_vector.hpp"
 #include "repli_timestamp.hpp"
 #include "serializer/types.hpp"
+#include "time.hpp"
 
 class buf_ptr_t;
 class new_mutex_in_line_t;
@@ -50,7 +51,8 @@ public:
     Use delete to free it. */
     file_account_t *make_io_account(int priority);
     virtual file_account_t *make_io_account(int priority,
-                                            int outstanding_requests_limit) = 0;
+                                            int outstanding_requests_limit,
+                                            io_class_t io_class) = 0;
 
     /* Some serializer implementations support read-ahead to speed up cache warmup.
     This is supported through a serializer_read_ahead_callback_t which gets called
@@ -64,6 +66,14 @@ public:
     virtual buf_ptr_t block_read(const counted_t<block_token_t> &token,
                                  file_account_t *io_account) = 0;
 
+    // Reads several blocks, blocks the coroutine.  Returns the blocks in the same
+    // order as `tokens`.  Blocks that are close to each other on disk may get read
+    // with a single larger read, so this is cheaper than calling `block_read` for
+    // each of them.
+    virtual std::vector<buf_ptr_t> block_reads(
+        const std::vector<counted_t<block_token_t>> &tokens,
+        file_account_t *io_account) = 0;
+
     /* The index stores three pieces of information for each ID:
      * 1. A pointer to a data block on disk (which may be NULL)
      * 2. A repli_timestamp_t, called the "recency"
@@ -120,12 +130,22 @@ public:
     /* The maximum size (and right now the typical size) that a block can have. */
     virtual max_block_size_t max_block_size() const = 0;
 
+    /* The size of the extents that blocks are written to.  Writes that are a multiple
+    of it fill whole extents. */
+    virtual uint64_t extent_size() const = 0;
+
     /* Return true if no other processes have the file locked */
     virtual bool coop_lock_and_check() = 0;
 
     /* Return true if the garbage collector is active */
     virtual bool is_gc_active() const = 0;
 
+    /* Returns true if the serializer is moving data towards the start of its file so
+    that the file can shrink, along with when that started and how far along it is
+    (between 0 and 1). */
+    virtual bool get_defrag_progress(microtime_t *start_time_out,
+                                     double *progress_out) = 0;
+
 private:
     DISABLE_COPYING(serializer_t);
 };
@@ -235,8 +235,9 @@ translator_serializer_t::translator_serializer_t(serializer_t *_inner, int _mod_
     rassert(mod_id < mod_count);
 }
 
-file_account_t *translator_serializer_t::make_io_account(int priority, int outstanding_requests_limit) {
-    return inner->make_io_account(priority, outstanding_requests_limit);
+file_account_t *translator_serializer_t::make_io_account(int priority, int outstanding_requests_limit,
+                                                         io_class_t io_class) {
+    return inner->make_io_account(priority, outstanding_requests_limit, io_class);
 }
 
 void translator_serializer_t::index_write(
@@ -271,6 +272,12 @@ buf_ptr_t translator_serializer_t::block_read(const counted_t<block_token_t> &to
     return inner->block_read(token, io_account);
 }
 
+std::vector<buf_ptr_t> translator_serializer_t::block_reads(
+        const std::vector<counted_t<block_token_t>> &tokens,
+        file_account_t *io_account) {
+    return inner->block_reads(tokens, io_account);
+}
+
 counted_t<block_token_t> translator_serializer_t::index_read(block_id_t block_id) {
     return inner->index_read(translate_block_id(block_id));
 }
@@ -279,6 +286,10 @@ max_block_size_t translator_serializer_t::max_block_size() const {
     return inner->max_block_size();
 }
 
+uint64_t translator_serializer_t::extent_size() const {
+    return inner->extent_size();
+}
+
 bool translator_serializer_t::coop_lock_and_check() {
     return inner->coop_lock_and_check();
 }
@@ -287,6 +298,11 @@ bool translator_serializer_t::is_gc_active() const {
     return inner->is_gc_active();
 }
 
+bool translator_serializer_t::get_defrag_progress(microtime_t *start_time_out,
+                                                  double *progress_out) {
+    return inner->get_defrag_progress(start_time_out, progress_out);
+}
+
 // A helper function for `end_block_id` and `end_aux_block_id`
 // `first_block_id` is the lowest block ID in the range, either 0 for regular block
 // IDs or FIRST_AUX_BLOCK_ID for aux blocks.
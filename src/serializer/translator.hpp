@@ -119,7 +119,8 @@ public:
                             config_block_id_t cfgid);
 
     /* Allocates a new io account for the underlying file */
-    file_account_t *make_io_account(int priority, int outstanding_requests_limit);
+    file_account_t *make_io_account(int priority, int outstanding_requests_limit,
+                                    io_class_t io_class);
 
     void index_write(new_mutex_in_line_t *mutex_acq,
                      const std::function<void()> &on_writes_reflected,
@@ -131,10 +132,14 @@ public:
 
     max_block_size_t max_block_size() const;
 
+    uint64_t extent_size() const;
+
     bool coop_lock_and_check();
 
     bool is_gc_active() const;
 
+    bool get_defrag_progress(microtime_t *start_time_out, double *progress_out);
+
     block_id_t end_block_id();
     block_id_t end_aux_block_id();
 
@@ -144,6 +149,9 @@ public:
 
     buf_ptr_t block_read(const counted_t<block_token_t> &token,
                        file_account_t *io_account);
+    std::vector<buf_ptr_t> block_reads(
+        const std::vector<counted_t<block_token_t>> &tokens,
+        file_account_t *io_account);
     counted_t<block_token_t> index_read(block_id_t block_id);
 
 public:
@@ -135,6 +135,8 @@ class block_token_t {
 public:
     int64_t offset() const { return offset_; }
     block_size_t block_size() const { return block_size_; }
+    // Smaller than `block_size()` if the block is stored compressed.
+    block_size_t disk_block_size() const { return disk_block_size_; }
 
 private:
     friend class log_serializer_t;
@@ -146,7 +148,8 @@ private:
 
     block_token_t(log_serializer_t *serializer,
                   int64_t initial_offset,
-                  block_size_t initial_ser_block_size);
+                  block_size_t initial_ser_block_size,
+                  block_size_t initial_disk_block_size);
 
     log_serializer_t *const serializer_;
     std::atomic<intptr_t> ref_count_;
@@ -154,13 +157,17 @@ private:
     // The block's size.
     block_size_t block_size_;
 
+    // The size the block takes up on disk.  This is smaller than `block_size_` if
+    // the block is stored compressed, and equal to it otherwise.
+    block_size_t disk_block_size_;
+
     // Either (a.) a checksum of what the block's on-disk contents should be, (b.)(i.)
     // the value datasync_checksum(), which means the block's write has been datasynced,
     // or (b.)(ii.) the value no_checksum(), which means the block is not known to have
     // been datasynced.
     //
-    // This holds the checksum of the DEVICE_BLOCK_SIZE-aligned block, with padding
-    // included.
+    // This holds the checksum of the DEVICE_BLOCK_SIZE-aligned block as it is stored
+    // on disk, with padding included.
     serializer_checksum checksum_;
 
     // The block's offset on disk.
@@ -192,6 +199,10 @@ public:
     virtual void move_serializer_file_to_permanent_location() = 0;
     virtual void open_serializer_file_existing(scoped_ptr_t<file_t> *file_out) = 0;
     virtual void unlink_serializer_file() = 0;
+
+    // Where the serializer can keep a snapshot of its LBA index across restarts (see
+    // serializer/log/lba/snapshot.hpp), or an empty string if it can't keep one.
+    virtual std::string lba_snapshot_file_name() const { return std::string(); }
 };
 
 class serializer_t;
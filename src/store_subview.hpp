@@ -107,6 +107,10 @@ public:
             interruptor);
     }
 
+    bool read_lock_free(const read_t &_read, read_response_t *response) {
+        return store_view->read_lock_free(_read, response);
+    }
+
     void write(
             DEBUG_ONLY(const metainfo_checker_t& metainfo_checker, )
             const region_map_t<binary_blob_t>& new_metainfo,
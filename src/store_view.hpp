@@ -80,6 +80,18 @@ public:
             signal_t *interruptor)
             THROWS_ONLY(interrupted_exc_t) = 0;
 
+    /* Tries to perform the read without acquiring any blocks and without waiting for
+    a read token, from copies of pages that the store's cache published for lock-free
+    reads.  Can be called on any thread.  The result reflects every write that the
+    store has finished, but not necessarily writes that are still in flight, so the
+    caller has to wait for the writes the read must see first (as `replica_t` does).
+    Returns false if the read has to be performed the normal way. */
+    virtual bool read_lock_free(
+            UNUSED const read_t &read,
+            UNUSED read_response_t *response) {
+        return false;
+    }
+
     /* Performs a write. `new_metainfo`'s region must be a subset of the store's region,
     and the write's region must be a subset of `new_metainfo`'s region. */
     virtual void write(
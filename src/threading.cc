@@ -1,6 +1,7 @@
 #include "threading.hpp"
 
 #include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/numa.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "errors.hpp"
 
@@ -64,18 +65,26 @@ thread_allocator_t::~thread_allocator_t() {
 }
 
 thread_allocation_t::thread_allocation_t(thread_allocator_t *p)
+    : thread_allocation_t(p, -1) { }
+
+thread_allocation_t::thread_allocation_t(thread_allocator_t *p, int numa_node)
     : thread(0), /* temporary, will be overwritten below */
       parent(p) {
     parent->assert_thread();
-    int32_t best_thread = 0;
-    for (int32_t i = 1; static_cast<size_t>(i) < parent->num_allocated.size(); ++i) {
-        if (parent->num_allocated[i] < parent->num_allocated[best_thread]) {
+    int32_t best_thread = -1;
+    for (int32_t i = 0; static_cast<size_t>(i) < parent->num_allocated.size(); ++i) {
+        if (numa_node != -1 && get_thread_numa_node(threadnum_t(i)) != numa_node) {
+            continue;
+        }
+        if (best_thread == -1
+            || parent->num_allocated[i] < parent->num_allocated[best_thread]) {
             best_thread = i;
         } else if (parent->num_allocated[i] == parent->num_allocated[best_thread] &&
                    parent->secondary_lt(threadnum_t(i), threadnum_t(best_thread))) {
             best_thread = i;
         }
     }
+    guarantee(best_thread != -1, "No db threads on NUMA node %d", numa_node);
     thread = threadnum_t(best_thread);
     ++parent->num_allocated[best_thread];
 }
@@ -111,6 +111,9 @@ private:
 class thread_allocation_t {
 public:
     explicit thread_allocation_t(thread_allocator_t *p);
+    // Only considers the threads on the given NUMA node (see arch/runtime/numa.hpp),
+    // unless it's -1.
+    thread_allocation_t(thread_allocator_t *p, int numa_node);
     ~thread_allocation_t();
     threadnum_t get_thread() const;
 private:
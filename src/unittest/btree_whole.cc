@@ -3,6 +3,9 @@
 #include "arch/io/disk.hpp"
 #include "arch/types.hpp"
 #include "btree/depth_first_traversal.hpp"
+#include "btree/erase_range.hpp"
+#include "btree/internal_node.hpp"
+#include "btree/leaf_node.hpp"
 #include "btree/reql_specific.hpp"
 #include "buffer_cache/cache_balancer.hpp"
 #include "rdb_protocol/btree.hpp"
@@ -17,7 +20,9 @@ namespace unittest {
 
 class map_filler_callback_t : public depth_first_traversal_callback_t {
 public:
-    explicit map_filler_callback_t(std::map<store_key_t, std::string> *m_out) : m_out_(m_out) { }
+    explicit map_filler_callback_t(std::map<store_key_t, std::string> *m_out,
+                                   size_t read_ahead_budget = 0)
+        : m_out_(m_out), read_ahead_budget_(read_ahead_budget) { }
 
     continue_bool_t handle_pair(scoped_key_value_t &&keyvalue, UNUSED signal_t *interruptor) {
         store_key_t store_key(keyvalue.key());
@@ -32,11 +37,82 @@ public:
         return continue_bool_t::CONTINUE;
     }
 
+    size_t read_ahead_budget() {
+        return read_ahead_budget_;
+    }
+
 private:
     std::map<store_key_t, std::string> *m_out_;
+    size_t read_ahead_budget_;
     scoped_ptr_t<store_key_t> last_key;
 };
 
+class leaf_size_callback_t : public depth_first_traversal_callback_t {
+public:
+    leaf_size_callback_t(value_sizer_t *sizer, std::vector<int> *live_sizes_out,
+                         std::vector<bool> *underfull_out)
+        : sizer_(sizer), live_sizes_out_(live_sizes_out),
+          underfull_out_(underfull_out) { }
+
+    continue_bool_t handle_pre_leaf(
+            const counted_t<counted_buf_lock_and_read_t> &buf,
+            UNUSED const btree_key_t *left_excl_or_null,
+            UNUSED const btree_key_t *right_incl,
+            UNUSED signal_t *interruptor,
+            bool *skip_out) {
+        const leaf_node_t *node
+            = static_cast<const leaf_node_t *>(buf->read->get_data_read());
+        live_sizes_out_->push_back(node->live_size);
+        underfull_out_->push_back(leaf::is_underfull(sizer_, node));
+        *skip_out = true;
+        return continue_bool_t::CONTINUE;
+    }
+
+    continue_bool_t handle_pair(UNUSED scoped_key_value_t &&keyvalue,
+                                UNUSED signal_t *interruptor) {
+        unreachable();
+    }
+
+private:
+    value_sizer_t *sizer_;
+    std::vector<int> *live_sizes_out_;
+    std::vector<bool> *underfull_out_;
+};
+
+class counting_value_deleter_t : public value_deleter_t {
+public:
+    explicit counting_value_deleter_t(int *count_out) : count_out_(count_out) { }
+
+    void delete_value(UNUSED buf_parent_t leaf_node, UNUSED const void *value) const {
+        ++*count_out_;
+    }
+
+private:
+    int *count_out_;
+};
+
+// Returns how many nodes there are in the subtree with its root in `block_id`.
+int count_nodes(buf_parent_t parent, block_id_t block_id) {
+    buf_lock_t buf(parent, block_id, access_t::read);
+    std::vector<block_id_t> children;
+    {
+        buf_read_t read(&buf);
+        const node_t *node = static_cast<const node_t *>(read.get_data_read());
+        if (node::is_internal(node)) {
+            const internal_node_t *internal
+                = reinterpret_cast<const internal_node_t *>(node);
+            for (int i = 0; i < internal->npairs; ++i) {
+                children.push_back(internal_node::get_pair_by_index(internal, i)->lnode);
+            }
+        }
+    }
+    int count = 1;
+    for (block_id_t child : children) {
+        count += count_nodes(buf_parent_t(&buf), child);
+    }
+    return count;
+}
+
 class BTreeTestContext {
 public:
     BTreeTestContext()
@@ -73,7 +149,8 @@ public:
     }
 
     void run_txn_fn(bool readwrite,
-        const std::function<void(scoped_ptr_t<real_superblock_t> &&)> &fn) {
+        const std::function<void(scoped_ptr_t<real_superblock_t> &&)> &fn,
+        write_durability_t durability = write_durability_t::SOFT) {
 
         scoped_ptr_t<txn_t> txn;
         scoped_ptr_t<real_superblock_t> superblock;
@@ -84,7 +161,7 @@ public:
                 nullptr,
                 write_access_t::write,
                 1,
-                write_durability_t::SOFT,
+                durability,
                 &superblock,
                 &txn);
         } else {
@@ -211,13 +288,13 @@ public:
         remove(key, repli_timestamp_t::distant_past);
     }
 
-    void range(const key_range_t &_range) {
+    void range(const key_range_t &_range, size_t read_ahead_budget = 0) {
         std::map<store_key_t, std::string> bt_map;
 
         run_txn_fn(false, [&](scoped_ptr_t<real_superblock_t> &&superblock){
             cond_t interruptor;
 
-            map_filler_callback_t filler_cb(&bt_map);
+            map_filler_callback_t filler_cb(&bt_map, read_ahead_budget);
 
             btree_depth_first_traversal(
                 superblock.get(),
@@ -240,6 +317,61 @@ public:
         expect_maps_equal(bt_map, kv_map);
     }
 
+    // Erases `_range` in passes, the way `store_t::reset_data()` does, and returns how
+    // many values got deleted.
+    int erase_range(const key_range_t &_range) {
+        int deleted_values = 0;
+        noop_value_deleter_t detacher;
+        counting_value_deleter_t deleter(&deleted_values);
+        key_range_t remaining_range = _range;
+        for (continue_bool_t done_erasing = continue_bool_t::CONTINUE;
+             done_erasing == continue_bool_t::CONTINUE;) {
+            run_txn_fn(true, [&](scoped_ptr_t<real_superblock_t> &&superblock){
+                std::vector<block_id_t> detached;
+                key_range_t erased_range;
+                done_erasing = erase_leaves_in_range(
+                    sizer.get(), superblock.get(), remaining_range, &detacher,
+                    &deleter, &detached, &erased_range);
+                const block_id_t stat_block_id = superblock->get_stat_block_id();
+                buf_parent_t parent(superblock->expose_buf().txn());
+                superblock.reset();
+                free_detached_nodes(parent, stat_block_id, detached, &detacher,
+                                    &deleter);
+                if (done_erasing == continue_bool_t::CONTINUE) {
+                    remaining_range.left = erased_range.right.key();
+                }
+            });
+        }
+
+        for (auto it = kv.begin(); it != kv.end();) {
+            if (_range.contains_key(it->first)) {
+                it = kv.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return deleted_values;
+    }
+
+    // Writes everything out to the serializer, and then counts the blocks it has and
+    // the nodes in the tree.
+    void count_blocks(int *blocks_out, int *nodes_out) {
+        run_txn_fn(true, [&](scoped_ptr_t<real_superblock_t> &&superblock){
+            const block_id_t root_id = superblock->get_root_block_id();
+            *nodes_out = root_id == NULL_BLOCK_ID
+                ? 0
+                : count_nodes(superblock->expose_buf(), root_id);
+            superblock.reset();
+        }, write_durability_t::HARD);
+
+        *blocks_out = 0;
+        for (block_id_t id = 0; id < serializer->end_block_id(); ++id) {
+            if (serializer->index_read(id).has()) {
+                ++*blocks_out;
+            }
+        }
+    }
+
     bool should_have(const store_key_t &key) {
         return kv.find(key) != kv.end();
     }
@@ -283,6 +415,29 @@ public:
         expect_maps_equal(bt_map, kv);
     }
 
+    // Collects the live size of every leaf, and whether it's underfull, from left
+    // to right.
+    void get_leaves(std::vector<int> *live_sizes_out, std::vector<bool> *underfull_out) {
+        run_txn_fn(false, [&](scoped_ptr_t<real_superblock_t> &&superblock){
+            cond_t interruptor;
+
+            leaf_size_callback_t leaf_cb(sizer.get(), live_sizes_out, underfull_out);
+
+            btree_depth_first_traversal(
+                superblock.get(),
+                key_range_t::universe(),
+                &leaf_cb,
+                access_t::read,
+                direction_t::FORWARD,
+                release_superblock_t::RELEASE,
+                &interruptor);
+        });
+    }
+
+    int block_size() {
+        return sizer->block_size().value();
+    }
+
     store_key_t pick_random_key(rng_t *rng) {
         if (is_empty()) {
             return store_key_t();
@@ -504,4 +659,93 @@ TPTEST(BTree, RemoveRandomOrder) {
     ctx.verify();
 }
 
+TPTEST(BTree, AscendingAppendFill) {
+    BTreeTestContext ctx;
+
+    // Keys in ascending order, the way a restore inserts them.
+    for (int i = 0; i < 5000; i++) {
+        ctx.set(store_key_t(strprintf("key%06d", i)), std::string(40, 'v'));
+    }
+    ctx.verify();
+
+    std::vector<int> live_sizes;
+    std::vector<bool> underfull;
+    ctx.get_leaves(&live_sizes, &underfull);
+    ASSERT_LT(10u, live_sizes.size());
+
+    // Every leaf but the last one got split off by an append, which left as much of
+    // it in place as it could without leaving the new leaf underfull.  Even splits
+    // would leave them about 49% full.
+    int64_t total_live_size = 0;
+    for (size_t i = 0; i < live_sizes.size() - 1; i++) {
+        ASSERT_FALSE(underfull[i]);
+        total_live_size += live_sizes[i];
+    }
+    ASSERT_LT(ctx.block_size() * 60 / 100,
+              total_live_size / static_cast<int64_t>(live_sizes.size() - 1));
+    ASSERT_FALSE(underfull.back());
+}
+
+TPTEST(BTree, EraseLeavesInRange) {
+    BTreeTestContext ctx;
+
+    // Long keys, so that the internal nodes hold few of them and the tree gets more
+    // than two levels.
+    auto key = [](int i) {
+        return store_key_t(strprintf("%06d", i) + std::string(150, 'k'));
+    };
+    for (int i = 0; i < 3000; i++) {
+        ctx.set(key(i), std::string(20, 'v'));
+    }
+
+    int blocks, nodes;
+    ctx.count_blocks(&blocks, &nodes);
+    std::vector<int> live_sizes;
+    std::vector<bool> underfull;
+    ctx.get_leaves(&live_sizes, &underfull);
+    ASSERT_LT(static_cast<int>(live_sizes.size()) + 1, nodes);
+    const int other_blocks = blocks - nodes;
+
+    // The ends of the range fall inside leaf nodes.
+    ASSERT_EQ(2100, ctx.erase_range(key_range_t(key_range_t::closed, key(450),
+                                                key_range_t::open, key(2550))));
+    ctx.verify();
+    const int nodes_before = nodes;
+    ctx.count_blocks(&blocks, &nodes);
+    ASSERT_EQ(other_blocks, blocks - nodes);
+    ASSERT_LT(nodes, nodes_before / 2);
+
+    // Up to the right end of the tree.
+    ASSERT_EQ(890, ctx.erase_range(key_range_t(key_range_t::closed, key(10),
+                                               key_range_t::none, store_key_t())));
+    ctx.verify();
+    ctx.count_blocks(&blocks, &nodes);
+    ASSERT_EQ(other_blocks, blocks - nodes);
+
+    // The tree still works.
+    for (int i = 0; i < 1000; i++) {
+        ctx.set(key(i * 7 % 3000), std::string(20, 'w'));
+    }
+    ctx.verify();
+}
+
+TPTEST(BTree, RangeReadAhead) {
+    BTreeTestContext ctx;
+    rng_t rng;
+
+    for (int i = 0; i < 1000; i++) {
+        ctx.set(store_key_t(random_letter_string(&rng, 1, 250)),
+                random_letter_string(&rng, 0, 250));
+    }
+
+    // Ranges over many leaves, with budgets smaller and larger than the number of
+    // leaves below an internal node.
+    ctx.range(key_range_t::universe(), 1);
+    ctx.range(key_range_t::universe(), 4);
+    ctx.range(key_range_t::universe(), 1000);
+    for (int i = 0; i < 20; i++) {
+        ctx.range(random_key_range(&rng), 4);
+    }
+}
+
 } // namespace unittest
@@ -0,0 +1,156 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <inttypes.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/runtime.hpp"
+#include "config/args.hpp"
+#include "memory_utils.hpp"
+#include "random.hpp"
+#include "serializer/buf_slab.hpp"
+#include "time.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+TPTEST(BufSlabTest, BuffersAreAlignedAndDisjoint) {
+    std::vector<std::pair<char *, size_t> > bufs;
+    for (size_t size = DEVICE_BLOCK_SIZE / 2;
+         size <= BUF_SLAB_MAX_BUF_SIZE;
+         size += DEVICE_BLOCK_SIZE * 3) {
+        for (int i = 0; i < 10; ++i) {
+            char *buf = static_cast<char *>(buf_slab_alloc(size));
+            ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(buf) % DEVICE_BLOCK_SIZE);
+            memset(buf, static_cast<int>(bufs.size() % 256), size);
+            bufs.push_back(std::make_pair(buf, size));
+        }
+    }
+    // No buffer got overwritten by a later one.
+    for (size_t i = 0; i < bufs.size(); ++i) {
+        for (size_t j = 0; j < bufs[i].second; ++j) {
+            ASSERT_EQ(static_cast<char>(i % 256), bufs[i].first[j]);
+        }
+    }
+    for (const auto &pair : bufs) {
+        buf_slab_free(pair.first);
+    }
+}
+
+TPTEST(BufSlabTest, FreedBuffersGetReused) {
+    void *buf = buf_slab_alloc(4 * KILOBYTE);
+    buf_slab_free(buf);
+    void *again = buf_slab_alloc(4 * KILOBYTE);
+    ASSERT_EQ(buf, again);
+    buf_slab_free(again);
+    buf_slab_free(nullptr);
+}
+
+void free_bufs(std::vector<void *> *bufs) {
+    for (void *buf : *bufs) {
+        buf_slab_free(buf);
+    }
+    bufs->clear();
+}
+
+// Buffers that get allocated on one thread and freed on another have to find their way
+// back through the depot, or the allocating thread would keep mapping new slabs.
+TPTEST(BufSlabTest, CrossThreadFreesGetReused, 2) {
+    const size_t bufs_per_round = 1000;
+    const int rounds = 50;
+    std::vector<void *> bufs;
+    const uint64_t reserved_before = get_buf_slab_stats().reserved_bytes;
+    for (int round = 0; round < rounds; ++round) {
+        on_thread_t thread_switcher((threadnum_t(0)));
+        for (size_t i = 0; i < bufs_per_round; ++i) {
+            bufs.push_back(buf_slab_alloc(4 * KILOBYTE));
+        }
+        {
+            on_thread_t other_thread_switcher((threadnum_t(1)));
+            free_bufs(&bufs);
+        }
+    }
+    const uint64_t reserved_after = get_buf_slab_stats().reserved_bytes;
+    // One round takes about two slabs.
+    ASSERT_LE(reserved_after - reserved_before,
+              static_cast<uint64_t>(4 * BUF_SLAB_SIZE));
+}
+
+// This is not really a unit test, but a micro benchmark that compares the slab
+// allocator with `raw_malloc_aligned` under a cache-like load: a large working set of
+// buffers, mostly 4K with some other sizes, where random buffers keep getting freed and
+// replaced.  It reports the throughput and how much the resident set grew.  No need to
+// run this in debug mode.
+#if defined(NDEBUG) && defined(__linux__)
+uint64_t get_rss_bytes() {
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (statm == nullptr) {
+        return 0;
+    }
+    uint64_t size_pages = 0;
+    uint64_t resident_pages = 0;
+    int res = fscanf(statm, "%" SCNu64 " %" SCNu64, &size_pages, &resident_pages);
+    fclose(statm);
+    return res == 2 ? resident_pages * sysconf(_SC_PAGESIZE) : 0;
+}
+
+void run_buf_churn(const char *name,
+                   void *(*alloc)(size_t),
+                   void (*dealloc)(void *)) {
+    const size_t working_set = 16384;
+    const size_t churn_ops = 2000000;
+    rng_t rng(0);
+    auto random_size = [&]() -> size_t {
+        // Mostly full blocks, like the page cache holds.
+        return rng.randint(8) == 0
+            ? DEVICE_BLOCK_SIZE * (1 + rng.randsize(16))
+            : 4 * KILOBYTE;
+    };
+
+    const uint64_t rss_before = get_rss_bytes();
+    ticks_t start_ticks = get_ticks();
+    std::vector<void *> bufs(working_set);
+    for (size_t i = 0; i < working_set; ++i) {
+        size_t size = random_size();
+        bufs[i] = alloc(size);
+        memset(bufs[i], 1, size);
+    }
+    for (size_t op = 0; op < churn_ops; ++op) {
+        size_t i = rng.randsize(working_set);
+        dealloc(bufs[i]);
+        size_t size = random_size();
+        bufs[i] = alloc(size);
+        memset(bufs[i], 1, size);
+    }
+    double secs = ticks_to_secs(ticks_t{get_ticks().nanos - start_ticks.nanos});
+    const uint64_t rss_after = get_rss_bytes();
+    for (void *buf : bufs) {
+        dealloc(buf);
+    }
+
+    printf("%s: %.2f M alloc/free pairs per second, RSS grew by %" PRIu64 " MB "
+           "for a working set of about %zu MB\n",
+           name,
+           (working_set + churn_ops) / secs / MILLION,
+           (rss_after - std::min(rss_before, rss_after)) / MEGABYTE,
+           working_set * 4 * KILOBYTE / MEGABYTE);
+}
+
+void *raw_malloc_device_block_aligned(size_t size) {
+    return raw_malloc_aligned(size, DEVICE_BLOCK_SIZE);
+}
+
+TPTEST(BufSlabTest, ChurnBenchmark) {
+    run_buf_churn("raw_malloc_aligned",
+                  &raw_malloc_device_block_aligned, &raw_free_aligned);
+    run_buf_churn("buf_slab_alloc", &buf_slab_alloc, &buf_slab_free);
+    buf_slab_stats_t stats = get_buf_slab_stats();
+    printf("buf_slab: %" PRIu64 " MB reserved, %" PRIu64 " slabs on huge pages\n",
+           stats.reserved_bytes / MEGABYTE, stats.huge_page_slabs);
+}
+#endif  // defined(NDEBUG) && defined(__linux__)
+
+}  // namespace unittest
@@ -0,0 +1,64 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <vector>
+
+#include "buffer_cache/cache_balancer.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+uint64_t sum_of(const std::vector<uint64_t> &sizes) {
+    uint64_t sum = 0;
+    for (uint64_t size : sizes) {
+        sum += size;
+    }
+    return sum;
+}
+
+TEST(CacheBalancer, DefaultQuotasChangeNothing) {
+    std::vector<cache_quota_t> quotas(3, default_cache_quota());
+    std::vector<uint64_t> sizes = {100, 200, 700};
+    apply_cache_quotas(quotas, 1000, &sizes);
+    ASSERT_EQ((std::vector<uint64_t>{100, 200, 700}), sizes);
+}
+
+TEST(CacheBalancer, MinimumIsGuaranteed) {
+    std::vector<cache_quota_t> quotas(3, default_cache_quota());
+    quotas[0].min_bytes = 400;
+    std::vector<uint64_t> sizes = {100, 200, 700};
+    apply_cache_quotas(quotas, 1000, &sizes);
+    ASSERT_EQ(400u, sizes[0]);
+    ASSERT_EQ(1000u, sum_of(sizes));
+    // The other two caches give up the 300 bytes equally.
+    ASSERT_EQ(50u, sizes[1]);
+    ASSERT_EQ(550u, sizes[2]);
+}
+
+TEST(CacheBalancer, MaximumIsEnforced) {
+    std::vector<cache_quota_t> quotas(3, default_cache_quota());
+    quotas[2].max_bytes = 300;
+    quotas[1].priority = 3;
+    std::vector<uint64_t> sizes = {100, 200, 700};
+    apply_cache_quotas(quotas, 1000, &sizes);
+    ASSERT_EQ(300u, sizes[2]);
+    ASSERT_EQ(1000u, sum_of(sizes));
+    // The 400 freed bytes get split up by priority.
+    ASSERT_EQ(200u, sizes[0]);
+    ASSERT_EQ(500u, sizes[1]);
+}
+
+TEST(CacheBalancer, BoundsWin) {
+    std::vector<cache_quota_t> quotas(2, default_cache_quota());
+    quotas[0].min_bytes = 600;
+    quotas[1].min_bytes = 600;
+    std::vector<uint64_t> sizes = {500, 500};
+    apply_cache_quotas(quotas, 1000, &sizes);
+    ASSERT_EQ((std::vector<uint64_t>{600, 600}), sizes);
+
+    quotas[0] = quotas[1] = default_cache_quota();
+    quotas[0].max_bytes = 100;
+    quotas[1].max_bytes = 100;
+    apply_cache_quotas(quotas, 1000, &sizes);
+    ASSERT_EQ((std::vector<uint64_t>{100, 100}), sizes);
+}
+
+}  // namespace unittest
@@ -0,0 +1,608 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+
+/* A microbenchmark of the page cache.  Every db thread gets a serializer (on a
+`mock_file_t`, or on a real file if `--file` is given, which should be on a tmpfs to
+keep the disk out of the numbers) and a `cache_t` over it, creates `--blocks` blocks,
+and then runs `--clients` coroutines that acquire blocks for a while.  A client picks
+the blocks from a zipfian distribution, a uniform one, or scans a range of them, in
+the proportions that `--zipf`, `--uniform` and `--scan` give.
+
+The results go to stdout as a single JSON object, so that runs against different
+revisions can be compared by a script.  Run with `--help` for the options. */
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "arch/io/disk.hpp"
+#include "arch/runtime/starter.hpp"
+#include "arch/timing.hpp"
+#include "buffer_cache/alt.hpp"
+#include "buffer_cache/cache_balancer.hpp"
+#include "concurrency/pmap.hpp"
+#include "perfmon/perfmon.hpp"
+#include "random.hpp"
+#include "serializer/log/log_serializer.hpp"
+#include "time.hpp"
+#include "unittest/mock_file.hpp"
+#include "unittest/unittest_utils.hpp"
+#include "utils.hpp"
+
+namespace {
+
+struct bench_config_t {
+    bench_config_t()
+        : blocks(65536), cache_ratio(0.25), threads(4), clients(16),
+          zipf_weight(1.0), uniform_weight(0.0), scan_weight(0.0),
+          zipf_theta(0.99), scan_length(64), write_fraction(0.0),
+          warmup_secs(5), secs(10),
+          eviction_policy(cache_eviction_policy_t::sampled_lru),
+          compressed_tier_percent(0), seed(0) { }
+
+    // The blocks and clients are per thread.
+    uint64_t blocks;
+    double cache_ratio;
+    uint64_t threads;
+    uint64_t clients;
+    double zipf_weight;
+    double uniform_weight;
+    double scan_weight;
+    double zipf_theta;
+    uint64_t scan_length;
+    double write_fraction;
+    uint64_t warmup_secs;
+    uint64_t secs;
+    cache_eviction_policy_t eviction_policy;
+    uint64_t compressed_tier_percent;
+    uint64_t seed;
+    // Each thread's serializer file is this with the thread number appended.  If
+    // it's empty, the serializers use a `mock_file_t`.
+    std::string file;
+};
+
+void print_usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [--option=value ...]\n"
+            "  --blocks=N              blocks per thread (default 65536)\n"
+            "  --cache-ratio=R         cache size over dataset size (default 0.25)\n"
+            "  --threads=N             db threads, each with its own cache "
+            "(default 4)\n"
+            "  --clients=N             concurrent clients per thread (default 16)\n"
+            "  --zipf=W                weight of zipfian point reads (default 1)\n"
+            "  --uniform=W             weight of uniform point reads (default 0)\n"
+            "  --scan=W                weight of scans (default 0)\n"
+            "  --zipf-theta=T          skew of the zipfian distribution, in (0, 1) "
+            "(default 0.99)\n"
+            "  --scan-length=N         blocks per scan (default 64)\n"
+            "  --writes=F              fraction of point accesses that write "
+            "(default 0)\n"
+            "  --warmup=S              seconds before measuring (default 5)\n"
+            "  --seconds=S             seconds to measure (default 10)\n"
+            "  --policy=P              sampled_lru or two_q (default sampled_lru)\n"
+            "  --compressed-tier=PCT   compressed tier percent (default 0)\n"
+            "  --seed=N                random seed (default 0)\n"
+            "  --file=PATH             serializer file prefix, e.g. on a tmpfs "
+            "(default: in memory)\n",
+            program);
+}
+
+bool parse_uint64(const std::string &value, uint64_t *out) {
+    char *end;
+    set_errno(0);
+    unsigned long long res = strtoull(value.c_str(), &end, 10);  // NOLINT(runtime/int)
+    if (value.empty() || *end != '\0' || get_errno() != 0 || value[0] == '-') {
+        return false;
+    }
+    *out = res;
+    return true;
+}
+
+bool parse_double(const std::string &value, double *out) {
+    char *end;
+    double res = strtod(value.c_str(), &end);
+    if (value.empty() || *end != '\0' || !(res >= 0)) {
+        return false;
+    }
+    *out = res;
+    return true;
+}
+
+bool parse_args(int argc, char **argv, bench_config_t *config) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0 || arg.find('=') == std::string::npos) {
+            fprintf(stderr, "Unexpected argument '%s'.\n", arg.c_str());
+            return false;
+        }
+        const size_t eq = arg.find('=');
+        const std::string key = arg.substr(2, eq - 2);
+        const std::string value = arg.substr(eq + 1);
+        bool ok;
+        if (key == "blocks") {
+            ok = parse_uint64(value, &config->blocks) && config->blocks > 0;
+        } else if (key == "cache-ratio") {
+            ok = parse_double(value, &config->cache_ratio);
+        } else if (key == "threads") {
+            ok = parse_uint64(value, &config->threads)
+                && config->threads > 0 && config->threads <= MAX_THREADS;
+        } else if (key == "clients") {
+            ok = parse_uint64(value, &config->clients) && config->clients > 0;
+        } else if (key == "zipf") {
+            ok = parse_double(value, &config->zipf_weight);
+        } else if (key == "uniform") {
+            ok = parse_double(value, &config->uniform_weight);
+        } else if (key == "scan") {
+            ok = parse_double(value, &config->scan_weight);
+        } else if (key == "zipf-theta") {
+            ok = parse_double(value, &config->zipf_theta)
+                && config->zipf_theta > 0 && config->zipf_theta < 1;
+        } else if (key == "scan-length") {
+            ok = parse_uint64(value, &config->scan_length) && config->scan_length > 0;
+        } else if (key == "writes") {
+            ok = parse_double(value, &config->write_fraction)
+                && config->write_fraction <= 1;
+        } else if (key == "warmup") {
+            ok = parse_uint64(value, &config->warmup_secs);
+        } else if (key == "seconds") {
+            ok = parse_uint64(value, &config->secs) && config->secs > 0;
+        } else if (key == "policy") {
+            ok = true;
+            if (value == "sampled_lru") {
+                config->eviction_policy = cache_eviction_policy_t::sampled_lru;
+            } else if (value == "two_q") {
+                config->eviction_policy = cache_eviction_policy_t::two_q;
+            } else {
+                ok = false;
+            }
+        } else if (key == "compressed-tier") {
+            ok = parse_uint64(value, &config->compressed_tier_percent)
+                && config->compressed_tier_percent <= MAX_COMPRESSED_TIER_PERCENT;
+        } else if (key == "seed") {
+            ok = parse_uint64(value, &config->seed);
+        } else if (key == "file") {
+            config->file = value;
+            ok = !value.empty();
+        } else {
+            fprintf(stderr, "Unknown option '--%s'.\n", key.c_str());
+            return false;
+        }
+        if (!ok) {
+            fprintf(stderr, "Invalid value for '--%s': '%s'.\n",
+                    key.c_str(), value.c_str());
+            return false;
+        }
+    }
+    if (config->zipf_weight + config->uniform_weight + config->scan_weight <= 0) {
+        fprintf(stderr, "At least one of --zipf, --uniform and --scan must be "
+                "positive.\n");
+        return false;
+    }
+    return true;
+}
+
+/* Draws from a zipfian distribution over [0, n) the way YCSB does (after Gray et al.,
+"Quickly Generating Billion-Record Synthetic Databases").  The ranks get scrambled, so
+that the popular blocks are spread over the whole block id range instead of being
+neighbours. */
+class zipfian_generator_t {
+public:
+    zipfian_generator_t(uint64_t n, double theta)
+        : n_(n), theta_(theta), alpha_(1.0 / (1.0 - theta)), zetan_(zeta(n, theta)) {
+        eta_ = (1.0 - pow(2.0 / n_, 1.0 - theta_)) / (1.0 - zeta(2, theta_) / zetan_);
+    }
+
+    uint64_t next(rng_t *rng) const {
+        const double u = rng->randdouble();
+        const double uz = u * zetan_;
+        uint64_t rank;
+        if (uz < 1.0) {
+            rank = 0;
+        } else if (uz < 1.0 + pow(0.5, theta_)) {
+            rank = 1;
+        } else {
+            rank = static_cast<uint64_t>(n_ * pow(eta_ * u - eta_ + 1.0, alpha_));
+        }
+        rank = std::min(rank, n_ - 1);
+        return ((rank + 1) * 0x9E3779B97F4A7C15ull) % n_;
+    }
+
+private:
+    static double zeta(uint64_t n, double theta) {
+        double sum = 0;
+        for (uint64_t i = 1; i <= n; ++i) {
+            sum += 1.0 / pow(i, theta);
+        }
+        return sum;
+    }
+
+    const uint64_t n_;
+    const double theta_;
+    const double alpha_;
+    const double zetan_;
+    double eta_;
+
+    DISABLE_COPYING(zipfian_generator_t);
+};
+
+/* A log-linear histogram of latencies in nanoseconds.  Values below 2^SUB_BITS get a
+bucket each, and every power of two above that is split into 2^SUB_BITS buckets, so a
+percentile is off by at most 1/2^SUB_BITS. */
+class latency_histogram_t {
+public:
+    latency_histogram_t() : counts_(NUM_BUCKETS, 0), total_(0) { }
+
+    void add(uint64_t nanos) {
+        ++counts_[bucket_of(nanos)];
+        ++total_;
+    }
+
+    void merge(const latency_histogram_t &other) {
+        for (int i = 0; i < NUM_BUCKETS; ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        total_ += other.total_;
+    }
+
+    uint64_t total() const { return total_; }
+
+    // Returns the upper bound of the bucket that holds the `fraction` percentile.
+    uint64_t percentile(double fraction) const {
+        const uint64_t rank = std::max<uint64_t>(1, ceil(fraction * total_));
+        uint64_t seen = 0;
+        for (int i = 0; i < NUM_BUCKETS; ++i) {
+            seen += counts_[i];
+            if (seen >= rank) {
+                return bucket_upper_bound(i);
+            }
+        }
+        return 0;
+    }
+
+private:
+    static const int SUB_BITS = 5;
+    static const int NUM_BUCKETS = (64 - SUB_BITS + 1) << SUB_BITS;
+
+    static int bucket_of(uint64_t nanos) {
+        if (nanos < (1u << SUB_BITS)) {
+            return nanos;
+        }
+        const int exponent = 63 - __builtin_clzll(nanos);
+        return ((exponent - SUB_BITS + 1) << SUB_BITS)
+            + ((nanos >> (exponent - SUB_BITS)) & ((1u << SUB_BITS) - 1));
+    }
+
+    static uint64_t bucket_upper_bound(int bucket) {
+        if (bucket < (1 << SUB_BITS)) {
+            return bucket;
+        }
+        const int exponent = (bucket >> SUB_BITS) + SUB_BITS - 1;
+        const uint64_t sub = bucket & ((1u << SUB_BITS) - 1);
+        return (1ull << exponent) + ((sub + 1) << (exponent - SUB_BITS)) - 1;
+    }
+
+    std::vector<uint64_t> counts_;
+    uint64_t total_;
+};
+
+// What we read from a cache's stats, in `read_cache_counters()`.
+struct cache_counters_t {
+    cache_counters_t()
+        : hits(0), misses(0), pages_evicted(0), eviction_secs(0) { }
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t pages_evicted;
+    double eviction_secs;
+};
+
+// Must be called on the cache's thread, for `collection` being what the cache got
+// as its perfmon collection.
+cache_counters_t read_cache_counters(perfmon_collection_t *collection) {
+    void *ctx = collection->begin_stats();
+    collection->visit_stats(ctx);
+    ql::datum_t stats = collection->end_stats(ctx);
+    ql::datum_t eviction = stats.get_field("cache").get_field("eviction");
+    cache_counters_t counters;
+    counters.hits = eviction.get_field("hits").as_num();
+    counters.misses = eviction.get_field("misses").as_num();
+    counters.pages_evicted = eviction.get_field("pages_evicted").as_num();
+    counters.eviction_secs = eviction.get_field("eviction_secs").as_num();
+    return counters;
+}
+
+struct shard_result_t {
+    shard_result_t() : ops(0), point_reads(0), point_writes(0), scans(0), secs(0) { }
+    uint64_t ops;
+    uint64_t point_reads;
+    uint64_t point_writes;
+    uint64_t scans;
+    double secs;
+    cache_counters_t counters;
+    latency_histogram_t latencies;
+};
+
+class shard_t {
+public:
+    shard_t(const bench_config_t *config,
+            const zipfian_generator_t *zipfian,
+            int thread,
+            shard_result_t *result)
+        : config_(config), zipfian_(zipfian), thread_(thread), result_(result),
+          measuring_(false), stopping_(false) { }
+
+    void run() {
+        scoped_ptr_t<io_backender_t> io_backender;
+        scoped_ptr_t<serializer_file_opener_t> file_opener;
+        std::string file_name;
+        if (config_->file.empty()) {
+            file_opener.init(new unittest::mock_file_opener_t());
+        } else {
+            file_name = strprintf("%s.%d", config_->file.c_str(), thread_);
+            io_backender.init(new io_backender_t(
+                file_direct_io_mode_t::buffered_desired));
+            file_opener.init(new filepath_file_opener_t(
+                unittest::manual_serializer_filepath(file_name, file_name + ".create"),
+                io_backender.get()));
+        }
+
+        log_serializer_t::create(file_opener.get(),
+                                 log_serializer_t::static_config_t());
+        {
+            perfmon_collection_t serializer_stats;
+            log_serializer_t serializer(log_serializer_t::dynamic_config_t(),
+                                        file_opener.get(),
+                                        &serializer_stats);
+            const uint64_t dataset_bytes
+                = config_->blocks * serializer.max_block_size().value();
+            dummy_cache_balancer_t balancer(
+                std::max<uint64_t>(1, config_->cache_ratio * dataset_bytes),
+                config_->eviction_policy,
+                config_->compressed_tier_percent);
+
+            load(&serializer, &balancer);
+
+            // The measured cache starts out cold, without the pages that `load()`
+            // created.
+            perfmon_collection_t cache_stats;
+            cache_t cache(&serializer, &balancer, &cache_stats,
+                          which_cpu_shard_t{thread_,
+                                            static_cast<int>(config_->threads)});
+            pmap(config_->clients + 1, [&](int64_t i) {
+                if (i == 0) {
+                    control(&cache_stats);
+                } else {
+                    client(&cache, i);
+                }
+            });
+        }
+        if (!file_name.empty()) {
+            ::unlink(file_name.c_str());
+        }
+    }
+
+private:
+    static const block_id_t LOAD_BATCH_BLOCKS = 256;
+
+    void load(serializer_t *serializer, cache_balancer_t *balancer) {
+        perfmon_collection_t cache_stats;
+        cache_t cache(serializer, balancer, &cache_stats,
+                      which_cpu_shard_t{thread_, static_cast<int>(config_->threads)});
+        cache_conn_t cache_conn(&cache);
+        const block_id_t blocks = config_->blocks;
+        for (block_id_t first = 0; first < blocks; first += LOAD_BATCH_BLOCKS) {
+            const block_id_t end
+                = std::min<block_id_t>(first + LOAD_BATCH_BLOCKS, blocks);
+            txn_t txn(&cache_conn, write_durability_t::SOFT, end - first);
+            for (block_id_t block_id = first; block_id < end; ++block_id) {
+                buf_lock_t lock(&txn, block_id, alt_create_t::create);
+                buf_write_t write(&lock);
+                void *data = write.get_data_write();
+                memset(data, 0, cache.max_block_size().value());
+                memcpy(data, &block_id, sizeof(block_id));
+            }
+            txn.commit();
+        }
+    }
+
+    void control(perfmon_collection_t *cache_stats) {
+        nap(config_->warmup_secs * THOUSAND);
+        const cache_counters_t before = read_cache_counters(cache_stats);
+        const ticks_t start = get_ticks();
+        measuring_ = true;
+        nap(config_->secs * THOUSAND);
+        measuring_ = false;
+        const ticks_t end = get_ticks();
+        const cache_counters_t after = read_cache_counters(cache_stats);
+        stopping_ = true;
+
+        result_->secs = static_cast<double>(end.nanos - start.nanos) / BILLION;
+        result_->counters.hits = after.hits - before.hits;
+        result_->counters.misses = after.misses - before.misses;
+        result_->counters.pages_evicted = after.pages_evicted - before.pages_evicted;
+        result_->counters.eviction_secs = after.eviction_secs - before.eviction_secs;
+    }
+
+    void client(cache_t *cache, int64_t client_index) {
+        rng_t rng(config_->seed * 1000003 + thread_ * 10007 + client_index);
+        cache_conn_t cache_conn(cache);
+        const double total_weight = config_->zipf_weight + config_->uniform_weight
+            + config_->scan_weight;
+        while (!stopping_) {
+            const double pick = rng.randdouble() * total_weight;
+            if (pick < config_->zipf_weight + config_->uniform_weight) {
+                const block_id_t block_id = pick < config_->zipf_weight
+                    ? zipfian_->next(&rng)
+                    : rng.randuint64(config_->blocks);
+                if (rng.randdouble() < config_->write_fraction) {
+                    point_write(&cache_conn, block_id);
+                    count_op(&result_->point_writes);
+                } else {
+                    point_read(&cache_conn, block_id);
+                    count_op(&result_->point_reads);
+                }
+            } else {
+                scan(&cache_conn, rng.randuint64(config_->blocks));
+                count_op(&result_->scans);
+            }
+        }
+    }
+
+    void point_read(cache_conn_t *cache_conn, block_id_t block_id) {
+        txn_t txn(cache_conn, read_access_t::read);
+        read_block(&txn, block_id);
+    }
+
+    void point_write(cache_conn_t *cache_conn, block_id_t block_id) {
+        txn_t txn(cache_conn, write_durability_t::SOFT, 1);
+        {
+            const ticks_t start = get_ticks();
+            buf_lock_t lock(buf_parent_t(&txn), block_id, access_t::write);
+            buf_write_t write(&lock);
+            char *data = static_cast<char *>(write.get_data_write());
+            record_latency(start);
+            ++data[sizeof(block_id_t)];
+        }
+        txn.commit();
+    }
+
+    void scan(cache_conn_t *cache_conn, block_id_t first) {
+        txn_t txn(cache_conn, read_access_t::read);
+        for (uint64_t i = 0; i < config_->scan_length; ++i) {
+            read_block(&txn, (first + i) % config_->blocks);
+        }
+    }
+
+    void read_block(txn_t *txn, block_id_t block_id) {
+        const ticks_t start = get_ticks();
+        buf_lock_t lock(buf_parent_t(txn), block_id, access_t::read);
+        buf_read_t read(&lock);
+        const void *data = read.get_data_read();
+        record_latency(start);
+        guarantee(memcmp(data, &block_id, sizeof(block_id)) == 0);
+    }
+
+    void record_latency(ticks_t start) {
+        if (measuring_) {
+            result_->latencies.add(get_ticks().nanos - start.nanos);
+        }
+    }
+
+    void count_op(uint64_t *counter) {
+        if (measuring_) {
+            ++*counter;
+            ++result_->ops;
+        }
+    }
+
+    const bench_config_t *const config_;
+    const zipfian_generator_t *const zipfian_;
+    const int thread_;
+    shard_result_t *const result_;
+
+    // The clients run on the same thread as `control()`, so these needn't be atomic.
+    bool measuring_;
+    bool stopping_;
+
+    DISABLE_COPYING(shard_t);
+};
+
+void print_results(const bench_config_t &config,
+                   const std::vector<shard_result_t> &results) {
+    shard_result_t total;
+    double secs = 0;
+    for (const shard_result_t &result : results) {
+        total.ops += result.ops;
+        total.point_reads += result.point_reads;
+        total.point_writes += result.point_writes;
+        total.scans += result.scans;
+        total.counters.hits += result.counters.hits;
+        total.counters.misses += result.counters.misses;
+        total.counters.pages_evicted += result.counters.pages_evicted;
+        total.counters.eviction_secs += result.counters.eviction_secs;
+        total.latencies.merge(result.latencies);
+        secs = std::max(secs, result.secs);
+    }
+    const uint64_t accesses = total.counters.hits + total.counters.misses;
+
+    printf("{\n");
+    printf("  \"version\": \"%s\",\n", RETHINKDB_VERSION);
+    printf("  \"config\": {\"blocks\": %" PRIu64 ", \"cache_ratio\": %g, "
+           "\"threads\": %" PRIu64 ", \"clients\": %" PRIu64 ", \"zipf\": %g, "
+           "\"uniform\": %g, \"scan\": %g, \"zipf_theta\": %g, "
+           "\"scan_length\": %" PRIu64 ", \"writes\": %g, \"warmup\": %" PRIu64 ", "
+           "\"seconds\": %" PRIu64 ", \"policy\": \"%s\", "
+           "\"compressed_tier\": %" PRIu64 ", \"seed\": %" PRIu64 ", "
+           "\"file\": %s},\n",
+           config.blocks, config.cache_ratio, config.threads, config.clients,
+           config.zipf_weight, config.uniform_weight, config.scan_weight,
+           config.zipf_theta, config.scan_length, config.write_fraction,
+           config.warmup_secs, config.secs,
+           cache_eviction_policy_name(config.eviction_policy),
+           config.compressed_tier_percent, config.seed,
+           config.file.empty() ? "false" : "true");
+    printf("  \"seconds\": %.3f,\n", secs);
+    printf("  \"ops\": %" PRIu64 ",\n", total.ops);
+    printf("  \"ops_per_sec\": %.1f,\n", total.ops / secs);
+    printf("  \"point_reads\": %" PRIu64 ",\n", total.point_reads);
+    printf("  \"point_writes\": %" PRIu64 ",\n", total.point_writes);
+    printf("  \"scans\": %" PRIu64 ",\n", total.scans);
+    printf("  \"acquires\": %" PRIu64 ",\n", total.latencies.total());
+    printf("  \"acquires_per_sec\": %.1f,\n", total.latencies.total() / secs);
+    printf("  \"hits\": %" PRIu64 ",\n", total.counters.hits);
+    printf("  \"misses\": %" PRIu64 ",\n", total.counters.misses);
+    if (accesses > 0) {
+        printf("  \"hit_ratio\": %.6f,\n",
+               static_cast<double>(total.counters.hits) / accesses);
+    } else {
+        printf("  \"hit_ratio\": null,\n");
+    }
+    printf("  \"pages_evicted\": %" PRIu64 ",\n", total.counters.pages_evicted);
+    printf("  \"eviction_secs\": %.6f,\n", total.counters.eviction_secs);
+    if (total.counters.pages_evicted > 0) {
+        printf("  \"eviction_usecs_per_page\": %.3f,\n",
+               total.counters.eviction_secs * MILLION / total.counters.pages_evicted);
+    } else {
+        printf("  \"eviction_usecs_per_page\": null,\n");
+    }
+    printf("  \"acquire_latency_usecs\": {\"p50\": %.3f, \"p99\": %.3f}\n",
+           total.latencies.percentile(0.50) / 1000.0,
+           total.latencies.percentile(0.99) / 1000.0);
+    printf("}\n");
+}
+
+void run_bench(const bench_config_t &config) {
+    const zipfian_generator_t zipfian(config.blocks, config.zipf_theta);
+    std::vector<shard_result_t> results(config.threads);
+    pmap(config.threads, [&](int64_t thread) {
+        on_thread_t thread_switcher((threadnum_t(thread)));
+        shard_t shard(&config, &zipfian, thread, &results[thread]);
+        shard.run();
+    });
+    print_results(config, results);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    bench_config_t config;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+    }
+    if (!parse_args(argc, argv, &config)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    startup_shutdown_t startup_shutdown;
+    run_in_thread_pool(std::bind(&run_bench, std::cref(config)), config.threads);
+    return 0;
+}
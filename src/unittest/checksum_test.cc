@@ -0,0 +1,119 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <vector>
+
+#include "config/args.hpp"
+#include "random.hpp"
+#include "serializer/checksum.hpp"
+#include "time.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+const checksum_impl_t all_checksum_impls[] = {
+    checksum_impl_t::scalar, checksum_impl_t::sse42, checksum_impl_t::avx2 };
+
+const char *checksum_impl_name(checksum_impl_t impl) {
+    switch (impl) {
+    case checksum_impl_t::scalar: return "scalar";
+    case checksum_impl_t::sse42: return "sse4.2";
+    case checksum_impl_t::avx2: return "avx2";
+    default: unreachable();
+    }
+}
+
+void check_impls_agree(const uint32_t *words, size_t wordcount) {
+    const serializer_checksum expected
+        = compute_checksum_with_impl(checksum_impl_t::scalar, words, wordcount);
+    ASSERT_TRUE(has_checksum(expected));
+    for (checksum_impl_t impl : all_checksum_impls) {
+        if (!checksum_impl_supported(impl)) {
+            continue;
+        }
+        ASSERT_EQ(expected.value,
+                  compute_checksum_with_impl(impl, words, wordcount).value)
+            << "implementation " << checksum_impl_name(impl)
+            << ", wordcount " << wordcount;
+    }
+    ASSERT_EQ(expected.value, compute_checksum(words, wordcount).value);
+}
+
+TEST(ChecksumTest, ImplementationsAgreeOnRandomBuffers) {
+    rng_t rng;
+    std::vector<uint32_t> words(70000 + 16);
+    for (int trial = 0; trial < 2000; ++trial) {
+        for (uint32_t &w : words) {
+            w = rng.randuint64(uint64_t(1) << 32);
+        }
+        // Mostly block-sized buffers, sometimes large ones, at unaligned offsets.
+        const size_t wordcount = trial % 10 == 0
+            ? rng.randsize(70000)
+            : rng.randsize(2048);
+        const size_t offset = rng.randsize(16);
+        check_impls_agree(words.data() + offset, wordcount);
+    }
+}
+
+TEST(ChecksumTest, ImplementationsAgreeOnEdgeValues) {
+    // Words that xor to 0 or 0xFFFFFFFF stress the modular reduction.
+    const uint32_t values[] = { 0, 1, 0xFFFFFFFEu, 0xFFFFFFFFu };
+    const size_t wordcounts[] = { 0, 1, 3, 4, 7, 8, 9, 1024, 65535, 65536, 131073 };
+    for (uint32_t value : values) {
+        for (size_t wordcount : wordcounts) {
+            std::vector<uint32_t> words(wordcount + 1, value);
+            check_impls_agree(words.data(), wordcount);
+        }
+    }
+}
+
+TEST(ChecksumTest, ConcatMatchesChecksumOfConcatenation) {
+    rng_t rng;
+    std::vector<uint32_t> words(4096);
+    for (uint32_t &w : words) {
+        w = rng.randuint64(uint64_t(1) << 32);
+    }
+    for (int trial = 0; trial < 100; ++trial) {
+        const size_t split = rng.randsize(words.size() + 1);
+        const serializer_checksum left = compute_checksum(words.data(), split);
+        const serializer_checksum right
+            = compute_checksum(words.data() + split, words.size() - split);
+        ASSERT_EQ(compute_checksum(words.data(), words.size()).value,
+                  compute_checksum_concat(left, right, words.size() - split).value);
+    }
+}
+
+// This is not really a unit test, but a micro benchmark that reports the
+// throughput of each checksum implementation. No need to run this in debug mode.
+#ifdef NDEBUG
+TEST(ChecksumTest, ThroughputBenchmark) {
+    const size_t block_words = 4096 / serializer_checksum::word_size;
+    const size_t num_blocks = 4096;
+    std::vector<uint32_t> words(block_words * num_blocks);
+    rng_t rng;
+    for (uint32_t &w : words) {
+        w = rng.randuint64(uint64_t(1) << 32);
+    }
+
+    for (checksum_impl_t impl : all_checksum_impls) {
+        if (!checksum_impl_supported(impl)) {
+            printf("%s: not supported on this CPU\n", checksum_impl_name(impl));
+            continue;
+        }
+        const int repetitions = 20;
+        uint64_t sink = 0;
+        ticks_t start_ticks = get_ticks();
+        for (int r = 0; r < repetitions; ++r) {
+            for (size_t i = 0; i < num_blocks; ++i) {
+                sink += compute_checksum_with_impl(
+                    impl, words.data() + i * block_words, block_words).value;
+            }
+        }
+        double secs = ticks_to_secs(ticks_t{get_ticks().nanos - start_ticks.nanos});
+        double bytes = static_cast<double>(repetitions) * words.size()
+            * serializer_checksum::word_size;
+        printf("%s: %.2f GB/s over 4KB blocks (%" PRIu64 ")\n",
+               checksum_impl_name(impl), bytes / secs / BILLION, sink);
+    }
+}
+#endif  // NDEBUG
+
+}  // namespace unittest
@@ -111,6 +111,7 @@ public:
     store_t *get_underlying_store(UNUSED size_t i) {
         crash("not implemented for this unit test");
     }
+    void set_block_compression(UNUSED block_compression_t method) { }
 private:
     friend class executor_tester_t;
     server_id_t server_id;
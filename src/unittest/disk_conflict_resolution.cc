@@ -3,7 +3,7 @@
 #include <vector>
 
 #include "arch/io/disk/conflict_resolving.hpp"
-#include "arch/io/disk/accounting.hpp"
+#include "arch/io/disk/scheduling.hpp"
 #include "arch/runtime/thread_pool.hpp"
 #include "containers/intrusive_list.hpp"
 #include "containers/scoped.hpp"
@@ -27,15 +27,15 @@ struct test_driver_t {
     // has a unique pointer value.
     std::vector<scoped_ptr_t<action_t> > allocated_actions;
 
-    std::set<accounting_diskmgr_action_t *> running_actions;
+    std::set<scheduling_diskmgr_action_t *> running_actions;
     std::vector<char> data;
 
     conflict_resolving_diskmgr_t conflict_resolver;
 
     // These work because all actions are part of allocated_actions -- they have
     // unique pointer values.
-    std::set<accounting_diskmgr_action_t *> actions_that_have_begun;
-    std::set<accounting_diskmgr_action_t *> actions_that_are_done;
+    std::set<scheduling_diskmgr_action_t *> actions_that_have_begun;
+    std::set<scheduling_diskmgr_action_t *> actions_that_are_done;
 
     int old_thread_id;
     test_driver_t() : conflict_resolver(&get_global_perfmon_collection()) {
@@ -61,15 +61,15 @@ struct test_driver_t {
         return allocated_actions.back().get();
     }
 
-    bool action_has_begun(accounting_diskmgr_action_t *action) const {
+    bool action_has_begun(scheduling_diskmgr_action_t *action) const {
         return actions_that_have_begun.find(action) != actions_that_have_begun.end();
     }
 
-    bool action_is_done(accounting_diskmgr_action_t *action) const {
+    bool action_is_done(scheduling_diskmgr_action_t *action) const {
         return actions_that_are_done.find(action) != actions_that_are_done.end();
     }
 
-    void submit_from_conflict_resolving_diskmgr(accounting_diskmgr_action_t *a) {
+    void submit_from_conflict_resolving_diskmgr(scheduling_diskmgr_action_t *a) {
 
         rassert(!action_has_begun(a));
         rassert(!action_is_done(a));
@@ -78,7 +78,7 @@ struct test_driver_t {
         /* The conflict_resolving_diskmgr_t should not have sent us two potentially
         conflicting actions */
         for (auto it = running_actions.begin(); it != running_actions.end(); ++it) {
-            accounting_diskmgr_action_t *const p = *it;
+            scheduling_diskmgr_action_t *const p = *it;
             if (!(a->get_is_read() && p->get_is_read())) {
                 ASSERT_TRUE(a->get_offset() >= static_cast<int64_t>(p->get_offset() + p->get_count())
                             || p->get_offset() >= static_cast<int64_t>(a->get_offset() + a->get_count()));
@@ -89,7 +89,7 @@ struct test_driver_t {
         ASSERT_TRUE(insertion_took_place);
     }
 
-    void permit(accounting_diskmgr_action_t *a) {
+    void permit(scheduling_diskmgr_action_t *a) {
         if (action_is_done(a)) {
             return;
         }
@@ -117,7 +117,7 @@ struct test_driver_t {
         conflict_resolver.done(a);
     }
 
-    void done_from_conflict_resolving_diskmgr(accounting_diskmgr_action_t *a) {
+    void done_from_conflict_resolving_diskmgr(scheduling_diskmgr_action_t *a) {
         actions_that_are_done.insert(a);
     }
 };
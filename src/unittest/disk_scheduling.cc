@@ -0,0 +1,112 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <vector>
+
+#include "arch/io/disk/scheduling.hpp"
+#include "arch/timing.hpp"
+#include "containers/scoped.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+struct scheduling_test_driver_t {
+    typedef scheduling_diskmgr_t::action_t action_t;
+
+    explicit scheduling_test_driver_t(int max_depth)
+        : scheduler(&stats, max_depth),
+          accounter(1),
+          foreground_account(&accounter, 1, UNLIMITED_OUTSTANDING_REQUESTS,
+                             io_class_t::foreground),
+          gc_account(&accounter, 1, UNLIMITED_OUTSTANDING_REQUESTS, io_class_t::gc) {
+        scheduler.submit_fun = [this](accounting_diskmgr_action_t *a) {
+            running.push_back(static_cast<action_t *>(a));
+        };
+        scheduler.done_fun = [](action_t *) { };
+    }
+
+    action_t *submit(accounting_diskmgr_account_t *account, bool is_read) {
+        actions.push_back(make_scoped<action_t>());
+        action_t *a = actions.back().get();
+        if (is_read) {
+            a->make_read(0, buf, sizeof(buf), 0);
+        } else {
+            a->make_write(0, buf, sizeof(buf), 0, datasync_op::no_datasyncs);
+        }
+        a->account = account;
+        scheduler.submit(a);
+        return a;
+    }
+
+    void finish(action_t *a) {
+        for (auto it = running.begin(); it != running.end(); ++it) {
+            if (*it == a) {
+                running.erase(it);
+                scheduler.done(a);
+                return;
+            }
+        }
+        ADD_FAILURE() << "Finished an action that wasn't running";
+    }
+
+    bool is_running(action_t *a) const {
+        for (action_t *r : running) {
+            if (r == a) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    perfmon_collection_t stats;
+    scheduling_diskmgr_t scheduler;
+    accounting_diskmgr_t accounter;
+    accounting_diskmgr_account_t foreground_account;
+    accounting_diskmgr_account_t gc_account;
+    std::vector<scoped_ptr_t<action_t> > actions;
+    std::vector<action_t *> running;
+    char buf[DEVICE_BLOCK_SIZE];
+};
+
+TPTEST(DiskScheduling, DepthLimits) {
+    scheduling_test_driver_t driver(2);
+
+    // GC writes are limited to two at a time, but foreground reads aren't held back
+    // by them.
+    auto gc1 = driver.submit(&driver.gc_account, false);
+    auto gc2 = driver.submit(&driver.gc_account, false);
+    auto gc3 = driver.submit(&driver.gc_account, false);
+    auto read = driver.submit(&driver.foreground_account, true);
+    ASSERT_TRUE(driver.is_running(gc1));
+    ASSERT_TRUE(driver.is_running(gc2));
+    ASSERT_FALSE(driver.is_running(gc3));
+    ASSERT_TRUE(driver.is_running(read));
+
+    driver.finish(gc1);
+    ASSERT_TRUE(driver.is_running(gc3));
+    driver.finish(gc2);
+    driver.finish(gc3);
+    driver.finish(read);
+    ASSERT_TRUE(driver.running.empty());
+}
+
+TPTEST(DiskScheduling, ThrottleOnMissedTarget) {
+    scheduling_test_driver_t driver(2);
+
+    // A foreground read that takes far longer than its latency target makes the
+    // scheduler throttle GC down to a single operation at a time.
+    auto slow_read = driver.submit(&driver.foreground_account, true);
+    nap(250);
+    driver.finish(slow_read);
+
+    auto gc1 = driver.submit(&driver.gc_account, false);
+    auto gc2 = driver.submit(&driver.gc_account, false);
+    ASSERT_TRUE(driver.is_running(gc1));
+    ASSERT_FALSE(driver.is_running(gc2));
+
+    // GC isn't starved, though.
+    driver.finish(gc1);
+    ASSERT_TRUE(driver.is_running(gc2));
+    driver.finish(gc2);
+}
+
+}  // namespace unittest
@@ -0,0 +1,94 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <string.h>
+
+#include <vector>
+
+#include "arch/io/disk.hpp"
+#include "arch/io/disk/uring.hpp"
+#include "concurrency/cond_var.hpp"
+#include "containers/scoped.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+class counting_iocallback_t : public linux_iocallback_t {
+public:
+    explicit counting_iocallback_t(int expected) : remaining(expected) { }
+
+    void on_io_complete() {
+        --remaining;
+        if (remaining == 0) {
+            done.pulse();
+        }
+    }
+
+    int remaining;
+    cond_t done;
+};
+
+void fill_block(char *block, int i) {
+    for (int64_t j = 0; j < DEVICE_BLOCK_SIZE; ++j) {
+        block[j] = static_cast<char>(i * 31 + j);
+    }
+}
+
+TPTEST(DiskUring, ReadWrite) {
+    if (!uring_diskmgr_t::is_supported()) {
+        // Nothing to test on kernels without io_uring.
+        return;
+    }
+
+    temp_file_t temp_file;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired,
+                                DEFAULT_MAX_CONCURRENT_IO_REQUESTS,
+                                file_io_backend_t::uring);
+    scoped_ptr_t<file_t> file;
+    const file_open_result_t res = open_file(
+        temp_file.name().permanent_path().c_str(),
+        linux_file_t::mode_read | linux_file_t::mode_write | linux_file_t::mode_create,
+        &io_backender, &file);
+    ASSERT_NE(file_open_result_t::ERROR, res.outcome);
+
+    // More blocks than the ring holds at once, so some have to wait for room.
+    const int num_blocks = DEFAULT_MAX_CONCURRENT_IO_REQUESTS * 4;
+    file->set_file_size_at_least(num_blocks * DEVICE_BLOCK_SIZE, DEVICE_BLOCK_SIZE);
+
+    std::vector<scoped_device_block_aligned_ptr_t<char> > written;
+    {
+        counting_iocallback_t cb(num_blocks);
+        for (int i = 0; i < num_blocks; ++i) {
+            written.emplace_back(DEVICE_BLOCK_SIZE);
+            fill_block(written.back().get(), i);
+            file->write_async(i * DEVICE_BLOCK_SIZE, DEVICE_BLOCK_SIZE,
+                              written.back().get(), DEFAULT_DISK_ACCOUNT, &cb,
+                              i % 8 == 0
+                              ? datasync_op::wrap_in_datasyncs
+                              : datasync_op::no_datasyncs);
+        }
+        cb.done.wait();
+    }
+
+    // Read every block back, and a range of them with a single request.
+    std::vector<scoped_device_block_aligned_ptr_t<char> > read;
+    scoped_device_block_aligned_ptr_t<char> range(num_blocks * DEVICE_BLOCK_SIZE);
+    {
+        counting_iocallback_t cb(num_blocks + 1);
+        for (int i = 0; i < num_blocks; ++i) {
+            read.emplace_back(DEVICE_BLOCK_SIZE);
+            file->read_async(i * DEVICE_BLOCK_SIZE, DEVICE_BLOCK_SIZE,
+                             read.back().get(), DEFAULT_DISK_ACCOUNT, &cb);
+        }
+        file->read_async(0, num_blocks * DEVICE_BLOCK_SIZE, range.get(),
+                         DEFAULT_DISK_ACCOUNT, &cb);
+        cb.done.wait();
+    }
+
+    for (int i = 0; i < num_blocks; ++i) {
+        ASSERT_EQ(0, memcmp(written[i].get(), read[i].get(), DEVICE_BLOCK_SIZE));
+        ASSERT_EQ(0, memcmp(written[i].get(), range.get() + i * DEVICE_BLOCK_SIZE,
+                            DEVICE_BLOCK_SIZE));
+    }
+}
+
+}  // namespace unittest
@@ -6,11 +6,14 @@
 
 #include "btree/internal_node.hpp"
 #include "btree/node.hpp"
+#include "config/args.hpp"
+#include "containers/scoped.hpp"
+#include "random.hpp"
 
 namespace unittest {
 
 void verify(block_size_t block_size, const internal_node_t *buf) {
-    EXPECT_TRUE(buf->magic == internal_node_t::expected_magic);
+    EXPECT_TRUE(node::is_internal(reinterpret_cast<const node_t *>(buf)));
 
     // Internal nodes must have at least one pair.
     ASSERT_LE(1, buf->npairs);
@@ -61,6 +64,155 @@ TEST(InternalNodeTest, Offsets) {
     EXPECT_EQ(9u, sizeof(btree_internal_pair));
 }
 
+// Checks that `get_offset_index` finds the same index as a linear scan does.
+void check_offset_index(const internal_node_t *node, const btree_key_t *key) {
+    int expected = 0;
+    while (expected < node->npairs - 1
+           && btree_key_cmp(&internal_node::get_pair_by_index(node, expected)->key, key) < 0) {
+        ++expected;
+    }
+    ASSERT_EQ(expected, internal_node::get_offset_index(node, key));
+}
+
+// Inserts random keys into `node` until it has `npairs` pairs or is full.  Half of
+// the keys share their first eight bytes, so that they have equal heads.
+void fill_internal_node(internal_node_t *node, int npairs, rng_t *rng,
+                        std::vector<store_key_t> *keys) {
+    while (node->npairs < npairs && !internal_node::is_full(node)) {
+        std::string key = rng->randint(2) == 0 ? "shared h" : "";
+        for (int i = rng->randint(6); i >= 0; --i) {
+            key += 'a' + rng->randint(26);
+        }
+        store_key_t store_key(key);
+        if (std::find(keys->begin(), keys->end(), store_key) != keys->end()) {
+            continue;
+        }
+        const block_id_t id = keys->size() + 1;
+        ASSERT_TRUE(internal_node::insert(node, store_key.btree_key(), id, id + 1));
+        keys->push_back(store_key);
+    }
+}
+
+void check_offset_indexes(const internal_node_t *node,
+                          const std::vector<store_key_t> &keys, rng_t *rng) {
+    for (const store_key_t &key : keys) {
+        check_offset_index(node, key.btree_key());
+    }
+    for (int i = 0; i < 1000; ++i) {
+        std::string key = rng->randint(2) == 0 ? "shared h" : "";
+        for (int j = rng->randint(7); j >= 0; --j) {
+            key += 'a' + rng->randint(26);
+        }
+        check_offset_index(node, store_key_t(key).btree_key());
+    }
+}
+
+TEST(InternalNodeTest, SearchHeads) {
+    const block_size_t block_size = block_size_t::unsafe_make(4096);
+    scoped_malloc_t<internal_node_t> node(block_size.value());
+    internal_node::init(block_size, node.get());
+    rng_t rng;
+    std::vector<store_key_t> keys;
+
+    fill_internal_node(node.get(), 100, &rng, &keys);
+    ASSERT_TRUE(node->magic == internal_node_t::search_heads_magic);
+    internal_node::validate(block_size, node.get());
+    verify(block_size, node.get());
+    check_offset_indexes(node.get(), keys, &rng);
+
+    // A full node has no room left for the heads.
+    fill_internal_node(node.get(), block_size.value(), &rng, &keys);
+    ASSERT_TRUE(node->magic == internal_node_t::expected_magic);
+    internal_node::validate(block_size, node.get());
+    verify(block_size, node.get());
+    check_offset_indexes(node.get(), keys, &rng);
+
+    std::vector<store_key_t> kept_keys;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (i % 3 == 0) {
+            kept_keys.push_back(keys[i]);
+        } else {
+            internal_node::remove(block_size, node.get(), keys[i].btree_key());
+        }
+    }
+    ASSERT_TRUE(node->magic == internal_node_t::search_heads_magic);
+    verify(block_size, node.get());
+    check_offset_indexes(node.get(), kept_keys, &rng);
+}
+
+TEST(InternalNodeTest, Splitting) {
+    const block_size_t block_size = block_size_t::unsafe_make(4096);
+    const int percents[] = { 50, 75, 100 };
+    for (int left_percent : percents) {
+        scoped_malloc_t<internal_node_t> node(block_size.value());
+        scoped_malloc_t<internal_node_t> rnode(block_size.value());
+        internal_node::init(block_size, node.get());
+        rng_t rng;
+        std::vector<store_key_t> keys;
+        fill_internal_node(node.get(), block_size.value(), &rng, &keys);
+        const int npairs = node->npairs;
+        const int used = block_size.value() - node->frontmost_offset;
+
+        store_key_t median;
+        internal_node::split(block_size, node.get(), rnode.get(), median.btree_key(),
+                             left_percent);
+        verify(block_size, node.get());
+        verify(block_size, rnode.get());
+        ASSERT_EQ(npairs, node->npairs + rnode->npairs);
+        // More than half of the node stays in place for an uneven split, but neither
+        // half is underfull.
+        ASSERT_FALSE(internal_node::is_underfull(block_size, node.get()));
+        ASSERT_FALSE(internal_node::is_underfull(block_size, rnode.get()));
+        const int left_used = block_size.value() - node->frontmost_offset;
+        if (left_percent == 50) {
+            ASSERT_LE(used / 2 - static_cast<int>(sizeof(btree_internal_pair) + MAX_KEY_SIZE),
+                      left_used);
+        } else {
+            ASSERT_LT(used / 2, left_used);
+        }
+
+        // The median becomes the special key of the left node; the keys before it
+        // stay in the left node and the keys after it move to the right one.
+        for (const store_key_t &key : keys) {
+            if (key == median) {
+                continue;
+            }
+            const internal_node_t *half = key < median ? node.get() : rnode.get();
+            const btree_internal_pair *pair = internal_node::get_pair_by_index(
+                half, internal_node::get_offset_index(half, key.btree_key()));
+            ASSERT_EQ(0, btree_key_cmp(&pair->key, key.btree_key()));
+        }
+    }
+}
+
+// Inserting keys of the maximum size must fill the node one insertion after the
+// ones that `insertions_until_full` promises, whatever is in it already.
+TEST(InternalNodeTest, InsertionsUntilFull) {
+    const block_size_t block_size = block_size_t::unsafe_make(4096);
+    for (int npairs = 1; npairs < 200; npairs += 13) {
+        scoped_malloc_t<internal_node_t> node(block_size.value());
+        internal_node::init(block_size, node.get());
+        rng_t rng;
+        std::vector<store_key_t> keys;
+        fill_internal_node(node.get(), npairs, &rng, &keys);
+
+        // The last insertion is the one that the node has room for when it's not full.
+        const int insertions = internal_node::insertions_until_full(node.get()) + 1;
+        for (int i = 0; i < insertions; ++i) {
+            ASSERT_EQ(insertions - i - 1,
+                      internal_node::insertions_until_full(node.get()));
+            ASSERT_FALSE(internal_node::is_full(node.get()));
+            std::string key(MAX_KEY_SIZE, 'z');
+            key[MAX_KEY_SIZE - 2] = 'a' + i / 26;
+            key[MAX_KEY_SIZE - 1] = 'a' + i % 26;
+            const block_id_t id = keys.size() + i + 1;
+            ASSERT_TRUE(internal_node::insert(node.get(), store_key_t(key).btree_key(),
+                                              id, id + 1));
+            verify(block_size, node.get());
+        }
+        ASSERT_TRUE(internal_node::is_full(node.get()));
+    }
+}
 
 }  // namespace unittest
 
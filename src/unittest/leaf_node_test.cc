@@ -164,13 +164,13 @@ public:
         sibling->Verify();
     }
 
-    void Split(LeafNodeTracker *right) {
+    void Split(LeafNodeTracker *right, int left_percent = 50) {
         ASSERT_EQ(bs_.ser_value(), right->bs_.ser_value());
 
         ASSERT_TRUE(leaf::is_empty(right->node()));
 
         store_key_t median;
-        leaf::split(&sizer_, node(), right->node(), median.btree_key());
+        leaf::split(&sizer_, node(), right->node(), median.btree_key(), left_percent);
 
         std::map<store_key_t, std::string>::iterator p = kv_.end();
         --p;
@@ -183,6 +183,14 @@ public:
         right->Verify();
     }
 
+    void UpdatePrefix(const store_key_t &left_exclusive,
+                      const store_key_t &right_inclusive) {
+        leaf::update_prefix(&sizer_, node(), left_exclusive.btree_key(),
+                            right_inclusive.btree_key());
+
+        Verify();
+    }
+
     bool IsFull(const store_key_t& key, const std::string& value) {
         short_value_buffer_t value_buf(value);
         return leaf::is_full(&sizer_, node(), key.btree_key(), value_buf.data());
@@ -699,6 +707,34 @@ TEST(LeafNodeTest, Splitting) {
     left.Split(&right);
 }
 
+TEST(LeafNodeTest, AppendSplitting) {
+    const int percents[] = { 75, 100 };
+    for (int left_percent : percents) {
+        LeafNodeTracker left;
+        LeafNodeTracker even_left;
+        int i = 0;
+        while (left.Insert(store_key_t(strprintf("a%05d", i)), strprintf("A%d", i))) {
+            ASSERT_TRUE(even_left.Insert(store_key_t(strprintf("a%05d", i)),
+                                         strprintf("A%d", i)));
+            ++i;
+        }
+
+        LeafNodeTracker right;
+        LeafNodeTracker even_right;
+        left.Split(&right, left_percent);
+        even_left.Split(&even_right);
+
+        // More than half of the node stays in place, but the right node still gets
+        // enough not to be underfull.
+        ASSERT_FALSE(left.IsUnderfull());
+        ASSERT_FALSE(right.IsUnderfull());
+        ASSERT_GT(left.node()->num_pairs, even_left.node()->num_pairs);
+
+        // The key that didn't fit goes in the right node.
+        ASSERT_TRUE(right.Insert(store_key_t(strprintf("a%05d", i)), strprintf("A%d", i)));
+    }
+}
+
 TEST(LeafNodeTest, Fullness) {
     LeafNodeTracker node;
     int i;
@@ -709,4 +745,86 @@ TEST(LeafNodeTest, Fullness) {
     ASSERT_TRUE(node.IsFull(store_key_t(strprintf("a%d", i)), strprintf("A%d", i)));
 }
 
+TEST(LeafNodeTest, PrefixUpgrade) {
+    LeafNodeTracker node;
+    for (int i = 0; i < 50; ++i) {
+        node.Insert(store_key_t(strprintf("table_prefix_a%d", i)), strprintf("A%d", i));
+    }
+    node.Remove(store_key_t("table_prefix_a7"));
+
+    // The node gets rewritten with the prefix, and keeps working afterwards.
+    node.UpdatePrefix(store_key_t("table_prefix_a"), store_key_t("table_prefix_b"));
+    for (int i = 50; i < 100; ++i) {
+        node.Insert(store_key_t(strprintf("table_prefix_a%d", i)), strprintf("A%d", i));
+    }
+    node.Remove(store_key_t("table_prefix_a12"));
+}
+
+TEST(LeafNodeTest, PrefixedFullness) {
+    LeafNodeTracker plain;
+    LeafNodeTracker prefixed;
+
+    int plain_count = 0;
+    while (plain.Insert(store_key_t(strprintf("table_prefix_a%d", plain_count)), "A")) {
+        ++plain_count;
+    }
+    int prefixed_count = 0;
+    while (prefixed.Insert(store_key_t(strprintf("table_prefix_a%d", prefixed_count)), "A")) {
+        ++prefixed_count;
+        if (prefixed_count == 10) {
+            prefixed.UpdatePrefix(store_key_t("table_prefix_a"), store_key_t("table_prefix_b"));
+        }
+    }
+
+    ASSERT_GT(prefixed_count, plain_count * 3 / 2);
+}
+
+TEST(LeafNodeTest, PrefixedSplitting) {
+    LeafNodeTracker left;
+    for (int i = 0; left.Insert(store_key_t(strprintf("table_prefix_a%d", i)), "A"); ++i) {
+        if (i == 10) {
+            left.UpdatePrefix(store_key_t("table_prefix_a"), store_key_t("table_prefix_b"));
+        }
+    }
+
+    LeafNodeTracker right;
+
+    left.Split(&right);
+    right.Insert(store_key_t("table_prefix_a99999"), "A");
+}
+
+TEST(LeafNodeTest, PrefixedMerging) {
+    LeafNodeTracker left;
+    LeafNodeTracker right;
+
+    for (int i = 0; i < 20; ++i) {
+        left.Insert(store_key_t(strprintf("table_prefix_a%d", i)), strprintf("A%d", i));
+        right.Insert(store_key_t(strprintf("table_prefix_b%d", i)), strprintf("B%d", i));
+    }
+    left.UpdatePrefix(store_key_t("table_prefix_a"), store_key_t("table_prefix_a~"));
+    right.UpdatePrefix(store_key_t("table_prefix_b"), store_key_t("table_prefix_b~"));
+
+    // The nodes have different prefixes, so merging falls back to the prefix they
+    // have in common.
+    right.Merge(&left);
+}
+
+TEST(LeafNodeTest, PrefixedLeveling) {
+    LeafNodeTracker left;
+    LeafNodeTracker right;
+
+    for (int i = 0; i < 250; ++i) {
+        right.Insert(store_key_t(strprintf("table_prefix_b%d", i)), strprintf("B%d", i));
+    }
+    for (int i = 0; i < 3; ++i) {
+        left.Insert(store_key_t(strprintf("table_prefix_a%d", i)), strprintf("A%d", i));
+    }
+    left.UpdatePrefix(store_key_t("table_prefix_a"), store_key_t("table_prefix_a~"));
+    right.UpdatePrefix(store_key_t("table_prefix_b"), store_key_t("table_prefix_b~"));
+
+    bool could_level;
+    left.Level(-1, &right, &could_level);
+    ASSERT_TRUE(could_level);
+}
+
 }  // namespace unittest
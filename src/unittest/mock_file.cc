@@ -81,6 +81,10 @@ std::string mock_file_opener_t::file_name() const {
     return "<mock file>";
 }
 
+std::string mock_file_opener_t::lba_snapshot_file_name() const {
+    return lba_snapshot_file_name_;
+}
+
 void mock_file_opener_t::open_serializer_file_create_temporary(scoped_ptr_t<file_t> *file_out) {
     ASSERT_EQ(no_file, file_existence_state_);
     file_out->init(new mock_file_t(mock_file_t::mode_rw, &file_));
@@ -32,7 +32,8 @@ public:
     void writev_async(int64_t offset, size_t length, scoped_array_t<iovec> &&bufs,
                       file_account_t *account, linux_iocallback_t *cb);
 
-    void *create_account(UNUSED int priority, UNUSED int outstanding_requests_limit) {
+    void *create_account(UNUSED int priority, UNUSED int outstanding_requests_limit,
+                         UNUSED io_class_t io_class) {
         // We don't care about accounts.  Return an arbitrary non-null pointer.
         return this;
     }
@@ -52,8 +53,16 @@ private:
 
 class mock_file_opener_t : public serializer_file_opener_t {
 public:
-    mock_file_opener_t() : file_existence_state_(no_file) { }
+    // If `lba_snapshot_file_name` is not empty, the serializer can keep an LBA
+    // snapshot in that (real) file.
+    explicit mock_file_opener_t(const std::string &lba_snapshot_file_name = "")
+        : file_existence_state_(no_file),
+          lba_snapshot_file_name_(lba_snapshot_file_name) { }
     std::string file_name() const;
+    std::string lba_snapshot_file_name() const;
+
+    // The current size of the mock serializer file.
+    int64_t file_size() const { return file_.size(); }
 
     void open_serializer_file_create_temporary(scoped_ptr_t<file_t> *file_out);
     void move_serializer_file_to_permanent_location();
@@ -64,6 +73,7 @@ private:
     enum existence_state_t { no_file, temporary_file, permanent_file, unlinked_file };
     existence_state_t file_existence_state_;
     std::vector<char> file_;
+    std::string lba_snapshot_file_name_;
 };
 
 }  // namespace unittest
@@ -0,0 +1,63 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <algorithm>
+#include <vector>
+
+#include "arch/runtime/numa.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+numa_node_placement_t make_node(int32_t os_node, int32_t first_cpu, int32_t num_cpus) {
+    numa_node_placement_t node;
+    node.os_node = os_node;
+    for (int32_t i = 0; i < num_cpus; ++i) {
+        node.cpus.push_back(first_cpu + i);
+    }
+    return node;
+}
+
+TEST(NumaTest, ThreadsSplitByCpus) {
+    std::vector<numa_node_placement_t> nodes;
+    nodes.push_back(make_node(0, 0, 4));
+    nodes.push_back(make_node(1, 4, 4));
+    std::vector<int32_t> cpus = place_numa_threads(8, &nodes);
+
+    ASSERT_EQ(2u, nodes.size());
+    EXPECT_EQ((std::vector<int32_t>{0, 1, 2, 3}), nodes[0].threads);
+    EXPECT_EQ((std::vector<int32_t>{4, 5, 6, 7}), nodes[1].threads);
+    EXPECT_EQ((std::vector<int32_t>{0, 1, 2, 3, 4, 5, 6, 7}), cpus);
+}
+
+TEST(NumaTest, UnevenNodesAndMoreThreadsThanCpus) {
+    std::vector<numa_node_placement_t> nodes;
+    nodes.push_back(make_node(0, 0, 2));
+    nodes.push_back(make_node(2, 8, 6));
+    std::vector<int32_t> cpus = place_numa_threads(16, &nodes);
+
+    ASSERT_EQ(2u, nodes.size());
+    EXPECT_EQ(4u, nodes[0].threads.size());
+    EXPECT_EQ(12u, nodes[1].threads.size());
+    ASSERT_EQ(16u, cpus.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        for (int32_t thread : nodes[i].threads) {
+            const std::vector<int32_t> &node_cpus = nodes[i].cpus;
+            EXPECT_NE(node_cpus.end(),
+                      std::find(node_cpus.begin(), node_cpus.end(), cpus[thread]));
+        }
+    }
+}
+
+TEST(NumaTest, NodesWithoutThreadsAreDropped) {
+    std::vector<numa_node_placement_t> nodes;
+    nodes.push_back(make_node(0, 0, 4));
+    nodes.push_back(make_node(1, 4, 4));
+    nodes.push_back(make_node(3, 8, 4));
+    std::vector<int32_t> cpus = place_numa_threads(2, &nodes);
+
+    ASSERT_EQ(2u, cpus.size());
+    ASSERT_EQ(2u, nodes.size());
+    EXPECT_EQ(1, nodes[0].os_node);
+    EXPECT_EQ(3, nodes[1].os_node);
+}
+
+}  // namespace unittest
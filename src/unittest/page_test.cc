@@ -4,8 +4,10 @@
 #include "buffer_cache/page_cache.hpp"
 #include "buffer_cache/alt.hpp"
 #include "buffer_cache/cache_balancer.hpp"
+#include "buffer_cache/warm_up.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/pmap.hpp"
+#include "config/args.hpp"
 #include "containers/scoped.hpp"
 #include "serializer/log/log_serializer.hpp"
 #include "unittest/gtest.hpp"
@@ -312,8 +314,13 @@ TPTEST(PageTest, WriteWaitForFlush, 4) {
 
 class bigger_test_t {
 public:
-    explicit bigger_test_t(uint64_t _memory_limit)
-        : memory_limit(_memory_limit), mock(), c(NULL),
+    explicit bigger_test_t(uint64_t _memory_limit,
+                           cache_eviction_policy_t _eviction_policy
+                               = cache_eviction_policy_t::sampled_lru,
+                           uint32_t _compressed_tier_percent = 0)
+        : memory_limit(_memory_limit), eviction_policy(_eviction_policy),
+          compressed_tier_percent(_compressed_tier_percent),
+          mock(), c(NULL),
           txn1_ptr(NULL), txn2_ptr(NULL) {
         for (size_t i = 0; i < b_len; ++i) {
             b[i] = NULL_BLOCK_ID;
@@ -322,7 +329,8 @@ public:
 
     void run() {
         {
-            dummy_cache_balancer_t balancer(memory_limit);
+            dummy_cache_balancer_t balancer(memory_limit, eviction_policy,
+                                            compressed_tier_percent);
             test_cache_t cache(mock.ser.get(), &balancer, mock.throttler.get());
             auto_drainer_t drain;
             c = &cache;
@@ -368,7 +376,8 @@ public:
         c = nullptr;
 
         {
-            dummy_cache_balancer_t balancer(memory_limit);
+            dummy_cache_balancer_t balancer(memory_limit, eviction_policy,
+                                            compressed_tier_percent);
             test_cache_t cache(mock.ser.get(), &balancer, mock.throttler.get());
             auto_drainer_t drain;
             c = &cache;
@@ -1127,6 +1136,8 @@ private:
     }
 
     const uint64_t memory_limit;
+    const cache_eviction_policy_t eviction_policy;
+    const uint32_t compressed_tier_percent;
 
     mock_ser_t mock;
     test_cache_t *c;
@@ -1177,4 +1188,376 @@ TPTEST(PageTest, BiggerTestNoMemory, 4) {
     test.run();
 }
 
+TPTEST(PageTest, BiggerTestTightMemoryTwoQ, 4) {
+    bigger_test_t test(8192, cache_eviction_policy_t::two_q);
+    test.run();
+}
+
+TPTEST(PageTest, BiggerTestNoMemoryTwoQ, 4) {
+    bigger_test_t test(0, cache_eviction_policy_t::two_q);
+    test.run();
+}
+
+TPTEST(PageTest, BiggerTestTightMemoryCompressedTier, 4) {
+    bigger_test_t test(8192, cache_eviction_policy_t::sampled_lru, 50);
+    test.run();
+}
+
+#ifdef HAS_LZ4
+TPTEST(PageTest, CompressedTier, 4) {
+    mock_ser_t mock;
+    const block_id_t num_blocks = 16;
+    {
+        dummy_cache_balancer_t balancer(GIGABYTE);
+        test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+        auto txn = make_scoped<test_txn_t>(&page_cache);
+        for (block_id_t i = 0; i < num_blocks; ++i) {
+            current_test_acq_t acq(txn.get(), i, access_t::write, page_create_t::yes);
+            test_acq_t page_acq;
+            page_acq.init(acq.current_page_for_write(), &page_cache);
+            char *const p = static_cast<char *>(page_acq.get_buf_write());
+            memset(p, 0, page_acq.get_buf_size().value());
+            snprintf(p, page_acq.get_buf_size().value(), "block %" PRIu64, i);
+        }
+        page_txn_complete_cb_t flushed;
+        page_cache.flush_and_destroy_txn(
+            std::move(txn), write_durability_t::HARD, &flushed);
+        flushed.cond.wait();
+    }
+
+    // There's only room for a few uncompressed pages, but the compressed copies of
+    // all the blocks fit into the tier.
+    dummy_cache_balancer_t balancer(4 * 4096, cache_eviction_policy_t::sampled_lru,
+                                    MAX_COMPRESSED_TIER_PERCENT);
+    test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+    for (int pass = 0; pass < 3; ++pass) {
+        for (block_id_t i = 0; i < num_blocks; ++i) {
+            current_test_acq_t acq(&page_cache, i, read_access_t::read);
+            test_acq_t page_acq;
+            page_acq.init(acq.current_page_for_read(), &page_cache);
+            const char *const p = static_cast<const char *>(page_acq.get_buf_read());
+            ASSERT_EQ(strprintf("block %" PRIu64, i), std::string(p));
+        }
+    }
+    const alt::compressed_page_tier_t &tier = page_cache.evicter().compressed_tier();
+    ASSERT_GT(tier.hits(), 0u);
+    ASSERT_LE(tier.size(), tier.capacity());
+    ASSERT_LT(tier.compressed_bytes(), tier.uncompressed_bytes());
+}
+#endif  // HAS_LZ4
+
+// Writes blocks [0, num_blocks), each holding its own block id.
+void write_numbered_blocks(mock_ser_t *mock, block_id_t num_blocks) {
+    dummy_cache_balancer_t balancer(GIGABYTE);
+    test_cache_t page_cache(mock->ser.get(), &balancer, mock->throttler.get());
+    auto txn = make_scoped<test_txn_t>(&page_cache);
+    for (block_id_t i = 0; i < num_blocks; ++i) {
+        current_test_acq_t acq(txn.get(), i, access_t::write, page_create_t::yes);
+        test_acq_t page_acq;
+        page_acq.init(acq.current_page_for_write(), &page_cache);
+        char *const p = static_cast<char *>(page_acq.get_buf_write());
+        memset(p, 0, page_acq.get_buf_size().value());
+        snprintf(p, page_acq.get_buf_size().value(), "block %" PRIu64, i);
+    }
+    page_txn_complete_cb_t flushed;
+    page_cache.flush_and_destroy_txn(std::move(txn), write_durability_t::HARD, &flushed);
+    flushed.cond.wait();
+}
+
+// Reads the blocks [begin, end) that `write_numbered_blocks()` wrote, one after the
+// other.
+void read_numbered_blocks(test_cache_t *page_cache, block_id_t begin, block_id_t end) {
+    for (block_id_t i = begin; i < end; ++i) {
+        current_test_acq_t acq(page_cache, i, read_access_t::read);
+        test_acq_t page_acq;
+        page_acq.init(acq.current_page_for_read(), page_cache);
+        const char *const p = static_cast<const char *>(page_acq.get_buf_read());
+        ASSERT_EQ(strprintf("block %" PRIu64, i), std::string(p));
+    }
+}
+
+// Returns how many pages of a small hot set had to be reloaded after a single scan
+// over twice as many pages as fit into the cache.
+uint64_t hot_set_misses_after_scan(cache_eviction_policy_t eviction_policy) {
+    // Roughly how many pages fit into the cache.
+    const block_id_t cache_pages = 32;
+    const block_id_t hot_pages = 4;
+    // Cycling through this many other pages between accesses to the hot set evicts
+    // the hot set from time to time, but the other pages never come back while
+    // the evicter still remembers them.
+    const block_id_t filler_pages = 4 * cache_pages;
+    const block_id_t scan_pages = 2 * cache_pages;
+    const block_id_t filler_begin = hot_pages;
+    const block_id_t scan_begin = filler_begin + filler_pages;
+    mock_ser_t mock;
+    write_numbered_blocks(&mock, scan_begin + scan_pages);
+
+    dummy_cache_balancer_t balancer(cache_pages * 4096, eviction_policy);
+    test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+    // The hot set gets used over and over, with a cache full of other pages in
+    // between.  Under 2Q, that gets the hot pages promoted once they come back
+    // shortly after having been evicted.
+    for (int round = 0; round < 30; ++round) {
+        read_numbered_blocks(&page_cache, 0, hot_pages);
+        const block_id_t begin = filler_begin + (round % 4) * cache_pages;
+        read_numbered_blocks(&page_cache, begin, begin + cache_pages);
+    }
+    read_numbered_blocks(&page_cache, 0, hot_pages);
+
+    // A one-pass scan that doesn't fit into the cache.
+    read_numbered_blocks(&page_cache, scan_begin, scan_begin + scan_pages);
+
+    const uint64_t misses_before = page_cache.evicter().page_misses();
+    read_numbered_blocks(&page_cache, 0, hot_pages);
+    return page_cache.evicter().page_misses() - misses_before;
+}
+
+TPTEST(PageTest, TwoQScanResistance, 4) {
+    // Under sampled LRU, the scan pushes the hot set out of the cache.  Under 2Q it
+    // only evicts pages on probation, and the hot set stays.
+    ASSERT_GT(hot_set_misses_after_scan(cache_eviction_policy_t::sampled_lru), 0u);
+    ASSERT_EQ(0u, hot_set_misses_after_scan(cache_eviction_policy_t::two_q));
+}
+
+TPTEST(PageTest, FlushWritesInBlockIdOrder, 4) {
+    mock_ser_t mock;
+    const block_id_t num_blocks = 64;
+    {
+        dummy_cache_balancer_t balancer(GIGABYTE);
+        test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+        auto txn = make_scoped<test_txn_t>(&page_cache);
+        for (block_id_t i = num_blocks; i-- > 0;) {
+            current_test_acq_t acq(txn.get(), i, access_t::write, page_create_t::yes);
+            test_acq_t page_acq;
+            page_acq.init(acq.current_page_for_write(), &page_cache);
+            char *const p = static_cast<char *>(page_acq.get_buf_write());
+            memset(p, 0, page_acq.get_buf_size().value());
+            snprintf(p, page_acq.get_buf_size().value(), "block %" PRIu64, i);
+        }
+        page_txn_complete_cb_t flushed;
+        page_cache.flush_and_destroy_txn(
+            std::move(txn), write_durability_t::HARD, &flushed);
+        flushed.cond.wait();
+    }
+
+    // The blocks got created in reverse, but they're laid out in the order of their
+    // ids.
+    for (block_id_t i = 1; i < num_blocks; ++i) {
+        ASSERT_LT(mock.ser->index_read(i - 1)->offset(),
+                  mock.ser->index_read(i)->offset());
+    }
+}
+
+// Reads every block and publishes it, like `buf_read_t` does.
+void read_and_publish_blocks(test_cache_t *page_cache, block_id_t num_blocks) {
+    for (block_id_t i = 0; i < num_blocks; ++i) {
+        current_test_acq_t acq(page_cache, i, read_access_t::read);
+        test_acq_t page_acq;
+        page_acq.init(acq.current_page_for_read(), page_cache);
+        acq.maybe_publish(page_acq.get_buf_read(), page_acq.get_buf_size());
+    }
+}
+
+// Looks the blocks up from another thread, without any locks.
+std::vector<std::string> find_published_blocks(alt::published_pages_t *published,
+                                               block_id_t num_blocks) {
+    on_thread_t thread_switcher((threadnum_t(1)));
+    std::vector<std::string> contents;
+    alt::published_pages_t::reader_t reader(published);
+    for (block_id_t i = 0; i < num_blocks; ++i) {
+        block_size_t block_size = block_size_t::undefined();
+        const char *p = static_cast<const char *>(reader.find(i, &block_size));
+        contents.push_back(p == nullptr ? std::string() : std::string(p));
+    }
+    guarantee(reader.validate());
+    return contents;
+}
+
+TPTEST(PageTest, PublishedPages, 4) {
+    mock_ser_t mock;
+    dummy_cache_balancer_t balancer(GIGABYTE, cache_eviction_policy_t::sampled_lru,
+                                    0, MAX_LOCK_FREE_READS_PERCENT);
+    test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+    alt::published_pages_t *published = &page_cache.evicter().published_pages();
+    const block_id_t num_blocks = 8;
+    {
+        auto txn = make_scoped<test_txn_t>(&page_cache);
+        for (block_id_t i = 0; i < num_blocks; ++i) {
+            current_test_acq_t acq(txn.get(), i, access_t::write, page_create_t::yes);
+            test_acq_t page_acq;
+            page_acq.init(acq.current_page_for_write(), &page_cache);
+            char *const p = static_cast<char *>(page_acq.get_buf_write());
+            memset(p, 0, page_acq.get_buf_size().value());
+            snprintf(p, page_acq.get_buf_size().value(), "block %" PRIu64, i);
+        }
+        page_cache.flush(std::move(txn));
+    }
+
+    read_and_publish_blocks(&page_cache, num_blocks);
+    ASSERT_EQ(num_blocks, published->num_pages());
+    std::vector<std::string> contents = find_published_blocks(published, num_blocks);
+    for (block_id_t i = 0; i < num_blocks; ++i) {
+        ASSERT_EQ(strprintf("block %" PRIu64, i), contents[i]);
+    }
+
+    // A write acquirer takes the block's copy away before it can change the block.
+    {
+        auto txn = make_scoped<test_txn_t>(&page_cache);
+        {
+            current_test_acq_t acq(txn.get(), 3, access_t::write);
+            ASSERT_FALSE(published->is_published(3));
+            ASSERT_EQ("", find_published_blocks(published, num_blocks)[3]);
+            test_acq_t page_acq;
+            page_acq.init(acq.current_page_for_write(), &page_cache);
+            char *const p = static_cast<char *>(page_acq.get_buf_write());
+            snprintf(p, page_acq.get_buf_size().value(), "changed");
+        }
+        page_cache.flush(std::move(txn));
+    }
+    ASSERT_FALSE(published->is_published(3));
+    read_and_publish_blocks(&page_cache, num_blocks);
+    ASSERT_EQ("changed", find_published_blocks(published, num_blocks)[3]);
+    ASSERT_LE(published->size(), published->capacity());
+}
+
+TPTEST(PageTest, PublishedPagesConcurrentReads, 4) {
+    mock_ser_t mock;
+    // There's room for half of the pages, and for three published copies, so pages keep
+    // getting evicted and copies keep getting dropped while the readers look at them.
+    dummy_cache_balancer_t balancer(16 * 4096, cache_eviction_policy_t::sampled_lru,
+                                    0, MAX_LOCK_FREE_READS_PERCENT);
+    test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+    alt::published_pages_t *published = &page_cache.evicter().published_pages();
+    const block_id_t num_blocks = 32;
+    auto write_block = [&](block_id_t i, int version) {
+        auto txn = make_scoped<test_txn_t>(&page_cache);
+        {
+            current_test_acq_t acq(txn.get(), i, access_t::write,
+                                   version == 0 ? page_create_t::yes : page_create_t::no);
+            test_acq_t page_acq;
+            page_acq.init(acq.current_page_for_write(), &page_cache);
+            char *const p = static_cast<char *>(page_acq.get_buf_write());
+            memset(p, 0, page_acq.get_buf_size().value());
+            snprintf(p, page_acq.get_buf_size().value(),
+                     "block %" PRIu64 " v%d", i, version);
+        }
+        page_cache.flush(std::move(txn));
+    };
+    for (block_id_t i = 0; i < num_blocks; ++i) {
+        write_block(i, 0);
+    }
+
+    std::atomic<bool> done(false);
+    std::atomic<int64_t> copies_seen[4];
+    for (int n = 0; n < 4; ++n) {
+        copies_seen[n].store(0);
+    }
+    auto all_readers_saw_copies = [&]() {
+        return copies_seen[1].load() > 0 && copies_seen[2].load() > 0
+            && copies_seen[3].load() > 0;
+    };
+    pmap(4, [&](int64_t n) {
+        if (n == 0) {
+            // Every write takes a copy away, and every pass of reads publishes new copies
+            // and drops old ones, so the readers keep racing with reclamation.  We keep
+            // going until every reader had its share of the race.
+            for (int round = 1;
+                 round <= 200 || (round <= 100000 && !all_readers_saw_copies());
+                 ++round) {
+                write_block(round % num_blocks, round);
+                read_and_publish_blocks(&page_cache, num_blocks);
+                ASSERT_LE(published->size(), published->capacity());
+                coro_t::yield();
+            }
+            done.store(true);
+            return;
+        }
+        on_thread_t thread_switcher((threadnum_t(n)));
+        while (!done.load()) {
+            {
+                alt::published_pages_t::reader_t reader(published);
+                for (block_id_t i = 0; i < num_blocks; ++i) {
+                    block_size_t block_size = block_size_t::undefined();
+                    const char *p = static_cast<const char *>(reader.find(i, &block_size));
+                    if (p != nullptr) {
+                        // A copy that got freed and reused while we held the reader
+                        // would have the wrong contents.
+                        const std::string prefix = strprintf("block %" PRIu64 " v", i);
+                        ASSERT_EQ(prefix, std::string(p, prefix.size()));
+                        ++copies_seen[n];
+                    }
+                }
+            }
+            coro_t::yield();
+        }
+    });
+    ASSERT_TRUE(all_readers_saw_copies());
+
+    // Once there are no readers left, reclamation frees all but a batch of the copies
+    // that got dropped.
+    for (int round = 0; round < 4; ++round) {
+        read_and_publish_blocks(&page_cache, num_blocks);
+    }
+    ASSERT_LE(published->num_retired(), num_blocks);
+    ASSERT_LE(published->size(), published->capacity());
+}
+
+TPTEST(PageTest, WarmUp, 4) {
+    mock_ser_t mock;
+    dummy_cache_balancer_t balancer(GIGABYTE);
+    const block_id_t num_blocks = 8;
+    {
+        test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+        auto txn = make_scoped<test_txn_t>(&page_cache);
+        for (block_id_t i = 0; i < num_blocks; ++i) {
+            current_test_acq_t acq(txn.get(), i, access_t::write, page_create_t::yes);
+            test_acq_t page_acq;
+            page_acq.init(acq.current_page_for_write(), &page_cache);
+            char *const p = static_cast<char *>(page_acq.get_buf_write());
+            memset(p, 0, page_acq.get_buf_size().value());
+            snprintf(p, page_acq.get_buf_size().value(), "block %" PRIu64, i);
+        }
+        page_txn_complete_cb_t flushed;
+        page_cache.flush_and_destroy_txn(
+            std::move(txn), write_durability_t::HARD, &flushed);
+        flushed.cond.wait();
+    }
+
+    // A fresh cache on the same file loads the blocks back in, but only the ones
+    // that exist.
+    test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+    cache_account_t account = page_cache.create_cache_account(
+        CACHE_WARM_UP_CACHE_PRIORITY, io_class_t::backfill);
+    pmap(static_cast<int64_t>(num_blocks), [&](int64_t i) {
+        ASSERT_TRUE(page_cache.load_block_for_warm_up(i, &account));
+    });
+    ASSERT_FALSE(page_cache.load_block_for_warm_up(num_blocks + 10, &account));
+
+    // Reading a block makes it the hottest one.
+    {
+        current_test_acq_t acq(&page_cache, 3, read_access_t::read);
+        test_acq_t page_acq;
+        page_acq.init(acq.current_page_for_read(), &page_cache);
+        page_acq.get_buf_read();
+    }
+    std::vector<block_id_t> hot_block_ids = page_cache.hot_block_ids();
+    ASSERT_EQ(static_cast<size_t>(num_blocks), hot_block_ids.size());
+    ASSERT_EQ(3u, hot_block_ids[0]);
+}
+
+TPTEST(PageTest, HotSetManifest, 4) {
+    temp_file_t temp_file;
+    const std::string path = temp_file.name().permanent_path();
+
+    std::vector<block_id_t> block_ids = {17, 3, 42, 0, 1000};
+    ASSERT_TRUE(write_hot_set_manifest(path, block_ids));
+    std::vector<block_id_t> read_block_ids;
+    ASSERT_TRUE(read_hot_set_manifest(path, &read_block_ids));
+    ASSERT_EQ(block_ids, read_block_ids);
+
+    // A manifest that got cut off is ignored.
+    ASSERT_EQ(0, ::truncate(path.c_str(), 32));
+    ASSERT_FALSE(read_hot_set_manifest(path, &read_block_ids));
+}
+
 }  // namespace unittest
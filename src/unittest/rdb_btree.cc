@@ -7,6 +7,8 @@
 #include "btree/operations.hpp"
 #include "btree/reql_specific.hpp"
 #include "buffer_cache/cache_balancer.hpp"
+#include "clustering/immediate_consistency/history.hpp"
+#include "concurrency/queue/disk_backed_queue_wrapper.hpp"
 #include "containers/archive/boost_types.hpp"
 #include "containers/archive/vector_stream.hpp"
 #include "containers/uuid.hpp"
@@ -375,6 +377,88 @@ TPTEST(RDBBtree, SindexEraseRange) {
     check_keys_are_NOT_present(&store, sindex_name);
 }
 
+// Checks that the rows that `insert_rows()` inserted are there, except for the ones in
+// `erased`.
+void check_rows_outside_range_are_present(store_t *store, const key_range_t &erased) {
+    for (int i = 0; i < TOTAL_KEYS_TO_INSERT; ++i) {
+        cond_t dummy_interruptor;
+        read_token_t token;
+        store->new_read_token(&token);
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> super_block;
+        store->acquire_superblock_for_read(
+            &token, &txn, &super_block, &dummy_interruptor, false);
+
+        store_key_t pk(ql::datum_t(static_cast<double>(i)).print_primary());
+        point_read_response_t response;
+        rdb_get(pk, store->btree.get(), super_block.get(), &response, nullptr);
+        if (erased.contains_key(pk)) {
+            ASSERT_EQ(ql::datum_t::null(), response.data) << "row " << i;
+        } else {
+            ASSERT_EQ(ql::datum_t(static_cast<double>(i)),
+                      response.data.get_field("id")) << "row " << i;
+        }
+    }
+}
+
+TPTEST(RDBBtree, ResetDataWithoutSindexes) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(
+        &file_opener,
+        log_serializer_t::static_config_t());
+
+    log_serializer_t serializer(
+        log_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    store_t store(
+            region_t::universe(),
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            generate_uuid(),
+            update_sindexes_t::UPDATE,
+            which_cpu_shard_t{0, 1});
+
+    cond_t dummy_interruptor;
+
+    insert_rows(0, TOTAL_KEYS_TO_INSERT, &store);
+
+    /* Without secondary indexes, `reset_data()` frees the leaf nodes that only hold
+    rows in the range, and erases the rest of the range from the leaf nodes at its
+    ends. */
+    const key_range_t erased(
+        key_range_t::closed,
+        store_key_t(ql::datum_t(static_cast<double>(200)).print_primary()),
+        key_range_t::open,
+        store_key_t(ql::datum_t(static_cast<double>(700)).print_primary()));
+    region_t region = region_t::universe();
+    region.inner = erased;
+    store.reset_data(binary_blob_t(version_t::zero()), region,
+                     write_durability_t::SOFT, &dummy_interruptor);
+    check_rows_outside_range_are_present(&store, erased);
+
+    /* Rows can go in the range again. */
+    insert_rows(200, 700, &store);
+    check_rows_outside_range_are_present(&store, key_range_t::empty());
+
+    store.reset_data(binary_blob_t(version_t::zero()), region_t::universe(),
+                     write_durability_t::SOFT, &dummy_interruptor);
+    check_rows_outside_range_are_present(&store, key_range_t::universe());
+}
+
 TPTEST(RDBBtree, SindexInterruptionViaDrop) {
     recreate_temporary_directory(base_path_t("."));
     temp_file_t temp_file;
@@ -457,4 +541,219 @@ TPTEST(RDBBtree, SindexInterruptionViaStoreDelete) {
     store.reset();
 }
 
+// Sets each row in `ids` to a document with `pads[i]` bytes of padding, and a count of
+// how many times it was set before, or deletes it if `pads[i]` is negative.
+class counting_replacer_t : public btree_batched_replacer_t {
+public:
+    counting_replacer_t(const std::vector<int> &_ids, const std::vector<int> &_pads)
+        : ids(_ids), pads(_pads) { }
+    ql::datum_t replace(const ql::datum_t &d, size_t index) const {
+        if (pads[index] < 0) {
+            return ql::datum_t::null();
+        }
+        int count = 0;
+        if (d.get_type() != ql::datum_t::R_NULL) {
+            ql::datum_t old_count = d.get_field("count", ql::NOTHROW);
+            if (old_count.has()) {
+                count = old_count.as_int() + 1;
+            }
+        }
+        std::string data = strprintf("{\"id\" : %d, \"count\" : %d, \"pad\" : \"%s\"}",
+                                     ids[index], count,
+                                     std::string(pads[index], 'x').c_str());
+        rapidjson::Document doc;
+        doc.Parse(data.c_str());
+        return ql::to_datum(doc, ql::configured_limits_t(), reql_version_t::LATEST);
+    }
+    return_changes_t should_return_changes() const { return return_changes_t::NO; }
+private:
+    const std::vector<int> &ids;
+    const std::vector<int> &pads;
+};
+
+// Does a batched replace of the rows in `ids` with `counting_replacer_t`, and returns
+// the modification reports it made, in the order in which they were reported.
+std::vector<rdb_modification_report_t> batched_replace_rows(
+        store_t *store,
+        const std::vector<int> &ids,
+        const std::vector<int> &pads,
+        ql::datum_t *response_out) {
+    disk_backed_queue_wrapper_t<rdb_modification_report_t> mod_queue(
+        store->io_backender_,
+        serializer_filepath_t(store->base_path_, "batched_replace_test"),
+        &get_global_perfmon_collection(),
+        GIGABYTE);
+
+    cond_t dummy_interruptor;
+    scoped_ptr_t<txn_t> txn;
+    {
+        scoped_ptr_t<real_superblock_t> superblock;
+        write_token_t token;
+        store->new_write_token(&token);
+        store->acquire_superblock_for_write(
+            ids.size(), write_durability_t::SOFT,
+            &token, &txn, &superblock, &dummy_interruptor);
+        buf_lock_t sindex_block(
+            superblock->expose_buf(),
+            superblock->get_sindex_block_id(),
+            access_t::write);
+        {
+            new_mutex_in_line_t acq = store->get_in_line_for_sindex_queue(&sindex_block);
+            store->register_sindex_queue(&mod_queue, key_range_t::universe(), &acq);
+        }
+
+        std::vector<store_key_t> keys;
+        for (int id : ids) {
+            keys.push_back(
+                store_key_t(ql::datum_t(static_cast<double>(id)).print_primary()));
+        }
+        counting_replacer_t replacer(ids, pads);
+        rdb_modification_report_cb_t mod_cb(
+            store, &sindex_block, auto_drainer_t::lock_t(&store->drainer));
+        profile::sampler_t sampler("Batched replace.",
+                                   static_cast<profile::trace_t *>(nullptr));
+        *response_out = rdb_batched_replace(
+            btree_info_t(store->btree.get(), repli_timestamp_t::distant_past,
+                         datum_string_t("id")),
+            &superblock, keys, &replacer, &mod_cb, ql::configured_limits_t(),
+            &sampler, nullptr);
+
+        new_mutex_in_line_t acq = store->get_in_line_for_sindex_queue(&sindex_block);
+        store->deregister_sindex_queue(&mod_queue, &acq);
+    }
+    txn->commit();
+
+    std::vector<rdb_modification_report_t> mod_reports;
+    while (mod_queue.size() > 0) {
+        mod_reports.push_back(mod_queue.pop());
+    }
+    return mod_reports;
+}
+
+ql::datum_t get_row(store_t *store, int id) {
+    cond_t dummy_interruptor;
+    read_token_t token;
+    store->new_read_token(&token);
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> super_block;
+    store->acquire_superblock_for_read(
+        &token, &txn, &super_block, &dummy_interruptor, false);
+
+    store_key_t pk(ql::datum_t(static_cast<double>(id)).print_primary());
+    point_read_response_t response;
+    rdb_get(pk, store->btree.get(), super_block.get(), &response, nullptr);
+    return response.data;
+}
+
+void assert_same_datum(const ql::datum_t &expected, const ql::datum_t &actual) {
+    ASSERT_EQ(expected.has(), actual.has());
+    if (expected.has()) {
+        ASSERT_EQ(expected.print(), actual.print());
+    }
+}
+
+TPTEST(RDBBtree, BatchedReplaceMatchesSingleReplaces) {
+    recreate_temporary_directory(base_path_t("."));
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    /* We do the same replaces in one store with a single batched replace, and in the
+    other with a batched replace for each row. */
+    temp_file_t temp_files[2];
+    scoped_ptr_t<filepath_file_opener_t> file_openers[2];
+    scoped_ptr_t<log_serializer_t> serializers[2];
+    scoped_ptr_t<store_t> stores[2];
+    for (int i = 0; i < 2; ++i) {
+        file_openers[i].init(
+            new filepath_file_opener_t(temp_files[i].name(), &io_backender));
+        log_serializer_t::create(
+            file_openers[i].get(),
+            log_serializer_t::static_config_t());
+        serializers[i].init(new log_serializer_t(
+            log_serializer_t::dynamic_config_t(),
+            file_openers[i].get(),
+            &get_global_perfmon_collection()));
+        stores[i].init(new store_t(
+            region_t::universe(),
+            serializers[i].get(),
+            &balancer,
+            strprintf("unit_test_store_%d", i),
+            true,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            generate_uuid(),
+            update_sindexes_t::UPDATE,
+            which_cpu_shard_t{0, 1}));
+        insert_rows(0, TOTAL_KEYS_TO_INSERT, stores[i].get());
+    }
+
+    std::vector<int> ids, pads;
+    auto add = [&](int id, int pad) {
+        ids.push_back(id);
+        pads.push_back(pad);
+    };
+    // Growing rows in ascending order splits their leaf nodes in the middle of the
+    // batch, so that the rows after a split go in the new sibling.
+    for (int id = 100; id < 350; ++id) {
+        add(id, 150);
+    }
+    // The same row several times in a row, and again after a row that comes before
+    // it, with each replace seeing what the one before did.
+    add(350, 10);
+    add(350, 20);
+    add(350, 30);
+    add(360, 20);
+    add(355, 20);
+    add(360, 40);
+    // Deleting rows merges and levels their leaf nodes, which moves the rows after
+    // them to a sibling.
+    for (int id = 500; id < 800; ++id) {
+        add(id, -1);
+    }
+    // Rows that go past all the others.
+    for (int id = TOTAL_KEYS_TO_INSERT; id < TOTAL_KEYS_TO_INSERT + 200; ++id) {
+        add(id, 150);
+    }
+    add(TOTAL_KEYS_TO_INSERT + 100, -1);
+    add(TOTAL_KEYS_TO_INSERT + 100, 5);
+
+    ql::datum_t batched_response;
+    std::vector<rdb_modification_report_t> batched_reports
+        = batched_replace_rows(stores[0].get(), ids, pads, &batched_response);
+
+    std::vector<rdb_modification_report_t> single_reports;
+    std::map<std::string, double> single_stats;
+    for (size_t i = 0; i < ids.size(); ++i) {
+        ql::datum_t response;
+        std::vector<rdb_modification_report_t> reports = batched_replace_rows(
+            stores[1].get(), make_vector(ids[i]), make_vector(pads[i]), &response);
+        single_reports.insert(single_reports.end(), reports.begin(), reports.end());
+        for (const char *field : {"inserted", "replaced", "deleted", "unchanged"}) {
+            single_stats[field] += response.get_field(field).as_num();
+        }
+    }
+
+    /* The modification reports drive the secondary index updates and the changefeed
+    messages, in this order. */
+    ASSERT_EQ(single_reports.size(), batched_reports.size());
+    for (size_t i = 0; i < single_reports.size(); ++i) {
+        ASSERT_EQ(single_reports[i].primary_key, batched_reports[i].primary_key);
+        assert_same_datum(single_reports[i].info.deleted.first,
+                          batched_reports[i].info.deleted.first);
+        assert_same_datum(single_reports[i].info.added.first,
+                          batched_reports[i].info.added.first);
+    }
+    for (const auto &pair : single_stats) {
+        ASSERT_EQ(pair.second,
+                  batched_response.get_field(pair.first.c_str()).as_num())
+            << pair.first;
+    }
+
+    for (int id = 0; id < TOTAL_KEYS_TO_INSERT + 200; ++id) {
+        assert_same_datum(get_row(stores[1].get(), id), get_row(stores[0].get(), id));
+    }
+}
+
 } //namespace unittest
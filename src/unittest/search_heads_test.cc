@@ -0,0 +1,229 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <inttypes.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "btree/internal_node.hpp"
+#include "btree/leaf_node.hpp"
+#include "btree/node.hpp"
+#include "btree/search_heads.hpp"
+#include "config/args.hpp"
+#include "containers/scoped.hpp"
+#include "random.hpp"
+#include "time.hpp"
+#include "unittest/btree_utils.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+const search_heads_impl_t all_search_heads_impls[] = {
+    search_heads_impl_t::scalar, search_heads_impl_t::sse42, search_heads_impl_t::avx2 };
+
+const char *search_heads_impl_name(search_heads_impl_t impl) {
+    switch (impl) {
+    case search_heads_impl_t::scalar: return "scalar";
+    case search_heads_impl_t::sse42: return "sse4.2";
+    case search_heads_impl_t::avx2: return "avx2";
+    default: unreachable();
+    }
+}
+
+void check_range(const std::vector<uint64_t> &heads, uint64_t head) {
+    const int expected_begin
+        = std::lower_bound(heads.begin(), heads.end(), head) - heads.begin();
+    const int expected_end
+        = std::upper_bound(heads.begin(), heads.end(), head) - heads.begin();
+    for (search_heads_impl_t impl : all_search_heads_impls) {
+        if (!search_heads_impl_supported(impl)) {
+            continue;
+        }
+        int begin;
+        int end;
+        find_search_head_range_with_impl(impl, heads.data(), heads.size(), head,
+                                         &begin, &end);
+        ASSERT_EQ(expected_begin, begin)
+            << "implementation " << search_heads_impl_name(impl)
+            << ", count " << heads.size();
+        ASSERT_EQ(expected_end, end)
+            << "implementation " << search_heads_impl_name(impl)
+            << ", count " << heads.size();
+    }
+    int begin;
+    int end;
+    find_search_head_range(heads.data(), heads.size(), head, &begin, &end);
+    ASSERT_EQ(expected_begin, begin);
+    ASSERT_EQ(expected_end, end);
+}
+
+TEST(SearchHeadsTest, HeadsCompareLikeKeys) {
+    const char *keys[] = { "", "a", "a\x01", "ab", "abcdefgh", "abcdefgh\xff",
+                           "abcdefgi", "b", "\x80", "\xff\xff\xff\xff\xff\xff\xff\xff" };
+    for (size_t i = 0; i + 1 < sizeof(keys) / sizeof(keys[0]); ++i) {
+        const std::string a(keys[i]);
+        const std::string b(keys[i + 1]);
+        ASSERT_LE(search_head(reinterpret_cast<const uint8_t *>(a.data()), a.size()),
+                  search_head(reinterpret_cast<const uint8_t *>(b.data()), b.size()))
+            << "keys " << i << " and " << i + 1;
+    }
+    const uint8_t bytes[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    EXPECT_EQ(0x0102030405060708ull, search_head(bytes, 9));
+    EXPECT_EQ(0x0102030000000000ull, search_head(bytes, 3));
+    EXPECT_EQ(0u, search_head(bytes, 0));
+}
+
+TEST(SearchHeadsTest, ImplementationsAgreeOnRandomHeads) {
+    rng_t rng;
+    for (int trial = 0; trial < 2000; ++trial) {
+        // Draw from a small range some of the time, so that there are many ties, and
+        // put some heads at the top of the range to catch signed comparisons.
+        const uint64_t range = trial % 2 == 0 ? 8 : uint64_t(1) << 40;
+        const uint64_t base = trial % 3 == 0 ? ~uint64_t(0) - range : 0;
+        std::vector<uint64_t> heads(rng.randsize(600));
+        for (uint64_t &h : heads) {
+            h = base + rng.randuint64(range);
+        }
+        std::sort(heads.begin(), heads.end());
+        for (int i = 0; i < 20; ++i) {
+            check_range(heads, base + rng.randuint64(range + 1));
+        }
+        if (!heads.empty()) {
+            check_range(heads, heads.front());
+            check_range(heads, heads.back());
+        }
+    }
+}
+
+TEST(SearchHeadsTest, ImplementationsAgreeOnEdgeValues) {
+    const uint64_t values[] = { 0, 1, 0x7FFFFFFFFFFFFFFFull, 0x8000000000000000ull,
+                                ~uint64_t(0) };
+    const int counts[] = { 0, 1, 2, 3, 4, 5, 31, 32, 33, 64, 65, 509 };
+    for (int count : counts) {
+        for (uint64_t value : values) {
+            std::vector<uint64_t> heads(count, value);
+            for (uint64_t head : values) {
+                check_range(heads, head);
+            }
+        }
+    }
+}
+
+// These are not really unit tests, but micro benchmarks that report how many lookups
+// per second `internal_node::lookup()` and `leaf::find_key()` do in 4KB nodes with
+// short keys, with and without search heads.  No need to run them in debug mode.
+#ifdef NDEBUG
+const int benchmark_num_nodes = 256;
+const int benchmark_num_lookups = 1 << 20;
+
+std::string random_benchmark_key(rng_t *rng) {
+    std::string key;
+    for (int i = 8 + rng->randint(5); i > 0; --i) {
+        key += 'a' + rng->randint(26);
+    }
+    return key;
+}
+
+// Picks `benchmark_num_lookups` keys, each one from the node it gets looked up in.
+std::vector<store_key_t> pick_benchmark_lookups(
+        const std::vector<std::vector<store_key_t> > &keys, rng_t *rng) {
+    std::vector<store_key_t> lookups;
+    for (int i = 0; i < benchmark_num_lookups; ++i) {
+        const std::vector<store_key_t> &node_keys = keys[i % keys.size()];
+        lookups.push_back(node_keys[rng->randint(node_keys.size())]);
+    }
+    return lookups;
+}
+
+template <class lookup_fun_t>
+void report_benchmark(const char *what, const lookup_fun_t &lookup) {
+    uint64_t sink = 0;
+    ticks_t start_ticks = get_ticks();
+    for (int i = 0; i < benchmark_num_lookups; ++i) {
+        sink += lookup(i);
+    }
+    double secs = ticks_to_secs(ticks_t{get_ticks().nanos - start_ticks.nanos});
+    printf("%s: %.2f million lookups/s (%" PRIu64 ")\n",
+           what, benchmark_num_lookups / secs / MILLION, sink);
+}
+
+TEST(SearchHeadsTest, InternalLookupBenchmark) {
+    const block_size_t block_size = block_size_t::unsafe_make(4096);
+    rng_t rng;
+    std::vector<scoped_malloc_t<internal_node_t> > nodes;
+    std::vector<scoped_malloc_t<internal_node_t> > headless_nodes;
+    std::vector<std::vector<store_key_t> > keys(benchmark_num_nodes);
+    for (int i = 0; i < benchmark_num_nodes; ++i) {
+        nodes.emplace_back(block_size.value());
+        internal_node_t *node = nodes.back().get();
+        internal_node::init(block_size, node);
+        // Stop while there is still room for the heads.
+        while (node->npairs < 100) {
+            store_key_t key(random_benchmark_key(&rng));
+            if (std::find(keys[i].begin(), keys[i].end(), key) == keys[i].end()) {
+                ASSERT_TRUE(internal_node::insert(node, key.btree_key(), 1, 2));
+                keys[i].push_back(key);
+            }
+        }
+        ASSERT_TRUE(node->magic == internal_node_t::search_heads_magic);
+        headless_nodes.emplace_back(block_size.value());
+        memcpy(headless_nodes.back().get(), node, block_size.value());
+        headless_nodes.back()->magic = internal_node_t::expected_magic;
+    }
+    const std::vector<store_key_t> lookups = pick_benchmark_lookups(keys, &rng);
+
+    report_benchmark("internal nodes with heads", [&](int i) {
+        return internal_node::lookup(
+            nodes[i % benchmark_num_nodes].get(), lookups[i].btree_key());
+    });
+    report_benchmark("internal nodes without heads", [&](int i) {
+        return internal_node::lookup(
+            headless_nodes[i % benchmark_num_nodes].get(), lookups[i].btree_key());
+    });
+}
+
+TEST(SearchHeadsTest, LeafFindKeyBenchmark) {
+    const max_block_size_t block_size = max_block_size_t::unsafe_make(4096);
+    short_value_sizer_t sizer(block_size);
+    short_value_buffer_t value(std::string("v"));
+    rng_t rng;
+    std::vector<scoped_malloc_t<leaf_node_t> > nodes;
+    std::vector<scoped_malloc_t<leaf_node_t> > headless_nodes;
+    std::vector<std::vector<store_key_t> > keys(benchmark_num_nodes);
+    for (int i = 0; i < benchmark_num_nodes; ++i) {
+        nodes.emplace_back(block_size.value());
+        leaf_node_t *node = nodes.back().get();
+        leaf::init(&sizer, node);
+        // Stop while there is still room for the heads.
+        while (node->num_pairs < 100) {
+            store_key_t key(random_benchmark_key(&rng));
+            int index;
+            if (!leaf::find_key(node, key.btree_key(), &index)) {
+                leaf::insert(&sizer, node, key.btree_key(), value.data(),
+                             repli_timestamp_t::distant_past,
+                             repli_timestamp_t::distant_past);
+                keys[i].push_back(key);
+            }
+        }
+        headless_nodes.emplace_back(block_size.value());
+        memcpy(headless_nodes.back().get(), node, block_size.value());
+        leaf::drop_search_heads(headless_nodes.back().get());
+    }
+    const std::vector<store_key_t> lookups = pick_benchmark_lookups(keys, &rng);
+
+    report_benchmark("leaf nodes with heads", [&](int i) {
+        int index;
+        leaf::find_key(nodes[i % benchmark_num_nodes].get(), lookups[i].btree_key(),
+                       &index);
+        return index;
+    });
+    report_benchmark("leaf nodes without heads", [&](int i) {
+        int index;
+        leaf::find_key(headless_nodes[i % benchmark_num_nodes].get(),
+                       lookups[i].btree_key(), &index);
+        return index;
+    });
+}
+#endif  // NDEBUG
+
+}  // namespace unittest
@@ -1,9 +1,21 @@
+#include <algorithm>
 #include <functional>
+#include <map>
+#include <set>
 
+#include "arch/arch.hpp"
 #include "arch/runtime/starter.hpp"
+#include "arch/timing.hpp"
 #include "concurrency/new_mutex.hpp"
+#include "concurrency/pmap.hpp"
+#include "config/args.hpp"
+#include "paths.hpp"
+#include "random.hpp"
 #include "serializer/buf_ptr.hpp"
+#include "serializer/log/lba/in_memory_index.hpp"
 #include "serializer/log/log_serializer.hpp"
+#include "serializer/log/static_header.hpp"
+#include "serializer/merger.hpp"
 #include "unittest/mock_file.hpp"
 #include "unittest/gtest.hpp"
 #include "unittest/unittest_utils.hpp"
@@ -90,5 +102,736 @@ TEST(SerializerTest, AddDeleteRepeatedlyWithIndex) {
     run_in_thread_pool(std::bind(run_AddDeleteRepeatedly, true), 4);
 }
 
+void fill_test_block(block_id_t block_id, const buf_ptr_t &buf) {
+    char *data = reinterpret_cast<char *>(buf.cache_data());
+    const size_t size = buf.block_size().value();
+    if (block_id % 3 == 0) {
+        // Not compressible.
+        rng_t rng(block_id);
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = rng.randint(256);
+        }
+    } else {
+        // Highly compressible.
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = 'a' + (i / 64 + block_id) % 26;
+        }
+    }
+}
+
+void check_test_block(block_id_t block_id, max_block_size_t block_size,
+                      const buf_ptr_t &buf) {
+    buf_ptr_t expected = buf_ptr_t::alloc_zeroed(block_size);
+    fill_test_block(block_id, expected);
+    ASSERT_EQ(block_size.ser_value(), buf.block_size().ser_value());
+    ASSERT_EQ(0, memcmp(expected.cache_data(), buf.cache_data(), block_size.value()));
+}
+
+#ifdef HAS_LZ4
+void run_CompressedBlocks() {
+    const block_id_t num_blocks = 30;
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    {
+        log_serializer_t::dynamic_config_t config;
+        config.block_compression = block_compression_t::lz4;
+        log_serializer_t ser(config, &file_opener, &get_global_perfmon_collection());
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+
+        std::vector<buf_ptr_t> bufs;
+        std::vector<buf_write_info_t> infos;
+        for (block_id_t i = 0; i < num_blocks; ++i) {
+            bufs.push_back(buf_ptr_t::alloc_zeroed(ser.max_block_size()));
+            fill_test_block(i, bufs.back());
+            infos.push_back(buf_write_info_t(bufs.back().ser_buffer(),
+                                             bufs.back().block_size(), i));
+        }
+
+        struct : public iocallback_t, public cond_t {
+            void on_io_complete() {
+                pulse();
+            }
+        } cb;
+        std::vector<counted_t<block_token_t>> tokens
+            = ser.block_writes(infos.data(), infos.size(), account.get(), &cb);
+        cb.wait();
+
+        std::vector<index_write_op_t> write_ops;
+        for (block_id_t i = 0; i < num_blocks; ++i) {
+            // Tokens report the uncompressed size, no matter how the block is stored.
+            ASSERT_EQ(ser.max_block_size().ser_value(),
+                      tokens[i]->block_size().ser_value());
+            if (i % 3 == 0) {
+                ASSERT_EQ(tokens[i]->block_size().ser_value(),
+                          tokens[i]->disk_block_size().ser_value());
+            } else {
+                ASSERT_LT(tokens[i]->disk_block_size().ser_value(),
+                          tokens[i]->block_size().ser_value());
+            }
+            check_test_block(i, ser.max_block_size(),
+                             ser.block_read(tokens[i], account.get()));
+            write_ops.push_back(index_write_op_t(
+                i, make_optional(tokens[i]),
+                make_optional(repli_timestamp_t::distant_past)));
+        }
+        new_mutex_in_line_t dummy_acq;
+        ser.index_write(&dummy_acq, []{ }, write_ops);
+    }
+
+    // Compressed blocks must stay readable with compression turned off.
+    log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                         &file_opener,
+                         &get_global_perfmon_collection());
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+    for (block_id_t i = 0; i < num_blocks; ++i) {
+        counted_t<block_token_t> token = ser.index_read(i);
+        ASSERT_TRUE(token.has());
+        ASSERT_EQ(ser.max_block_size().ser_value(), token->block_size().ser_value());
+        check_test_block(i, ser.max_block_size(), ser.block_read(token, account.get()));
+    }
+}
+
+TEST(SerializerTest, CompressedBlocks) {
+    run_in_thread_pool(run_CompressedBlocks, 4);
+}
+#endif  // HAS_LZ4
+
+// Writes test blocks with the ids in [begin, end) and deletes the block `deleted_id`.
+void write_test_blocks(log_serializer_t *ser, block_id_t begin, block_id_t end,
+                       block_id_t deleted_id) {
+    scoped_ptr_t<file_account_t> account(ser->make_io_account(1));
+    std::vector<buf_ptr_t> bufs;
+    std::vector<buf_write_info_t> infos;
+    for (block_id_t i = begin; i < end; ++i) {
+        bufs.push_back(buf_ptr_t::alloc_zeroed(ser->max_block_size()));
+        fill_test_block(i, bufs.back());
+        infos.push_back(buf_write_info_t(bufs.back().ser_buffer(),
+                                         bufs.back().block_size(), i));
+    }
+
+    struct : public iocallback_t, public cond_t {
+        void on_io_complete() {
+            pulse();
+        }
+    } cb;
+    std::vector<counted_t<block_token_t>> tokens
+        = ser->block_writes(infos.data(), infos.size(), account.get(), &cb);
+    cb.wait();
+
+    std::vector<index_write_op_t> write_ops;
+    for (block_id_t i = begin; i < end; ++i) {
+        write_ops.push_back(index_write_op_t(
+            i, make_optional(tokens[i - begin]),
+            make_optional(repli_timestamp_t::distant_past)));
+    }
+    {
+        new_mutex_in_line_t dummy_acq;
+        ser->index_write(&dummy_acq, []{ }, write_ops);
+    }
+    tokens.clear();
+
+    write_ops.clear();
+    write_ops.push_back(index_write_op_t(
+        deleted_id, make_optional(counted_t<block_token_t>())));
+    new_mutex_in_line_t dummy_acq;
+    ser->index_write(&dummy_acq, []{ }, write_ops);
+}
+
+void check_test_blocks(log_serializer_t *ser, block_id_t end,
+                       const std::set<block_id_t> &deleted_ids) {
+    scoped_ptr_t<file_account_t> account(ser->make_io_account(1));
+    ASSERT_EQ(end, ser->end_block_id());
+    for (block_id_t i = 0; i < end; ++i) {
+        counted_t<block_token_t> token = ser->index_read(i);
+        if (deleted_ids.count(i) == 1) {
+            ASSERT_FALSE(token.has());
+        } else {
+            ASSERT_TRUE(token.has());
+            check_test_block(i, ser->max_block_size(),
+                             ser->block_read(token, account.get()));
+        }
+    }
+}
+
+#ifdef HAS_LZ4
+std::string get_static_header_version(mock_file_opener_t *file_opener) {
+    scoped_ptr_t<file_t> file;
+    file_opener->open_serializer_file_existing(&file);
+    scoped_device_block_aligned_ptr_t<static_header_t> header(DEVICE_BLOCK_SIZE);
+    co_read(file.get(), 0, DEVICE_BLOCK_SIZE, header.get(), DEFAULT_DISK_ACCOUNT);
+    return std::string(header->version);
+}
+
+void set_static_header_version(mock_file_opener_t *file_opener, const char *version) {
+    scoped_ptr_t<file_t> file;
+    file_opener->open_serializer_file_existing(&file);
+    scoped_device_block_aligned_ptr_t<static_header_t> header(DEVICE_BLOCK_SIZE);
+    co_read(file.get(), 0, DEVICE_BLOCK_SIZE, header.get(), DEFAULT_DISK_ACCOUNT);
+    memset(header->version, 0, sizeof(header->version));
+    strcpy(header->version, version);
+    co_write(file.get(), 0, DEVICE_BLOCK_SIZE, header.get(), DEFAULT_DISK_ACCOUNT,
+             datasync_op::no_datasyncs);
+}
+
+void run_MigrateStaticHeader() {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    ASSERT_EQ("2.6", get_static_header_version(&file_opener));
+
+    // A file from before LBA entries could describe compressed blocks gets upgraded
+    // by the first index write, before that write can add a compressed block.
+    set_static_header_version(&file_opener, "2.2");
+    {
+        log_serializer_t::dynamic_config_t config;
+        config.block_compression = block_compression_t::lz4;
+        log_serializer_t ser(config, &file_opener, &get_global_perfmon_collection());
+        ASSERT_EQ("2.2", get_static_header_version(&file_opener));
+        write_test_blocks(&ser, 0, 30, 7);
+        ASSERT_EQ("2.6", get_static_header_version(&file_opener));
+    }
+
+    log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                         &file_opener,
+                         &get_global_perfmon_collection());
+    check_test_blocks(&ser, 30, {7});
+}
+
+TEST(SerializerTest, MigrateStaticHeader) {
+    run_in_thread_pool(run_MigrateStaticHeader, 4);
+}
+
+void check_stored_compression(log_serializer_t *ser,
+                              const std::map<block_id_t, int64_t> &offsets,
+                              const std::set<block_id_t> &compressed_ids) {
+    for (const auto &pair : offsets) {
+        const counted_t<block_token_t> token = ser->index_read(pair.first);
+        ASSERT_EQ(ser->max_block_size().ser_value(), token->block_size().ser_value());
+        if (compressed_ids.count(pair.first) == 1) {
+            ASSERT_LT(token->disk_block_size().ser_value(),
+                      token->block_size().ser_value());
+        } else {
+            ASSERT_EQ(token->block_size().ser_value(),
+                      token->disk_block_size().ser_value());
+        }
+    }
+}
+
+void run_GcCompressedBlocks() {
+    const block_id_t num_blocks = 4000;
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    std::set<block_id_t> deleted_ids;
+    std::map<block_id_t, int64_t> offsets;
+    std::set<block_id_t> compressed_ids;
+    {
+        log_serializer_t::dynamic_config_t config;
+        config.block_compression = block_compression_t::lz4;
+        log_serializer_t ser(config, &file_opener, &get_global_perfmon_collection());
+        for (block_id_t i = 0; i < num_blocks; i += 500) {
+            write_test_blocks(&ser, i, i + 500, i + 499);
+            deleted_ids.insert(i + 499);
+        }
+
+        // Deleting three out of four blocks leaves every extent mostly garbage, so
+        // that the GC moves the remaining blocks.  Every third block doesn't compress,
+        // and the others get stored compressed.
+        {
+            std::vector<index_write_op_t> write_ops;
+            for (block_id_t i = 0; i < num_blocks; ++i) {
+                if (i % 4 != 0 && deleted_ids.count(i) == 0) {
+                    write_ops.push_back(index_write_op_t(
+                        i, make_optional(counted_t<block_token_t>())));
+                    deleted_ids.insert(i);
+                }
+            }
+            new_mutex_in_line_t dummy_acq;
+            ser.index_write(&dummy_acq, []{ }, write_ops);
+        }
+        for (block_id_t i = 0; i < num_blocks; i += 4) {
+            const counted_t<block_token_t> token = ser.index_read(i);
+            offsets[i] = token->offset();
+            if (token->disk_block_size().ser_value()
+                < token->block_size().ser_value()) {
+                compressed_ids.insert(i);
+            }
+        }
+        ASSERT_FALSE(compressed_ids.empty());
+        ASSERT_LT(compressed_ids.size(), offsets.size());
+
+        // Extents only get collected once they are no longer young, and the GC only
+        // starts after index writes, so we keep rewriting a block until both a
+        // compressed and an uncompressed block have been moved.
+        bool moved_compressed = false;
+        bool moved_uncompressed = false;
+        for (int i = 0; i < 200 && !(moved_compressed && moved_uncompressed); ++i) {
+            nap(50);
+            write_test_blocks(&ser, num_blocks - 3, num_blocks - 2, num_blocks - 3);
+            for (const auto &pair : offsets) {
+                if (ser.index_read(pair.first)->offset() != pair.second) {
+                    if (compressed_ids.count(pair.first) == 1) {
+                        moved_compressed = true;
+                    } else {
+                        moved_uncompressed = true;
+                    }
+                }
+            }
+        }
+        ASSERT_TRUE(moved_compressed);
+        ASSERT_TRUE(moved_uncompressed);
+
+        // The moved blocks still report their uncompressed size, and stay stored
+        // the way they were.
+        check_stored_compression(&ser, offsets, compressed_ids);
+        check_test_blocks(&ser, num_blocks, deleted_ids);
+    }
+
+    // The LBA entries that the GC wrote still describe the blocks correctly.
+    log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                         &file_opener,
+                         &get_global_perfmon_collection());
+    check_stored_compression(&ser, offsets, compressed_ids);
+    check_test_blocks(&ser, num_blocks, deleted_ids);
+}
+
+TEST(SerializerTest, GcCompressedBlocks) {
+    run_in_thread_pool(run_GcCompressedBlocks, 4);
+}
+#endif  // HAS_LZ4
+
+/* Leaves ten old extents behind, two of which have garbage in them: the blocks in
+`*old_survivors_out` were written more than a second before the ones in
+`*young_survivors_out`, but a smaller part of their extent is garbage. Returns the
+offsets of the surviving blocks in the two extents. The garbage adds up to just over
+10% of the old extents, which makes a single GC coroutine start collecting them. Once
+it has collected the young extent, the garbage ratio is below 5% and the GC stops. The
+surviving blocks of both extents fit into one extent. */
+block_id_t set_up_gc_victims(log_serializer_t *ser,
+                             std::map<block_id_t, int64_t> *old_survivors_out,
+                             std::map<block_id_t, int64_t> *young_survivors_out) {
+    const block_id_t per_extent
+        = log_serializer_t::static_config_t().blocks_per_extent();
+    const block_id_t old_garbage = per_extent * 35 / 100;
+    const block_id_t young_garbage = per_extent * 66 / 100;
+    const block_id_t end = 10 * per_extent;
+
+    write_test_blocks(ser, 0, per_extent, 0);
+    // The `cost_benefit` policy measures ages against a clock that advances once a
+    // second.
+    nap(1100);
+    write_test_blocks(ser, per_extent, end, per_extent);
+    // Extents stop being young 50 ms after they were started, but only get moved to
+    // the GC's priority queue once the next extent fills up.
+    nap(100);
+    write_test_blocks(ser, end, end + 1, 1);
+
+    std::vector<index_write_op_t> write_ops;
+    for (block_id_t i = 2; i < old_garbage; ++i) {
+        write_ops.push_back(index_write_op_t(
+            i, make_optional(counted_t<block_token_t>())));
+    }
+    for (block_id_t i = per_extent + 1; i < per_extent + young_garbage; ++i) {
+        write_ops.push_back(index_write_op_t(
+            i, make_optional(counted_t<block_token_t>())));
+    }
+    for (block_id_t i = old_garbage; i < per_extent; ++i) {
+        (*old_survivors_out)[i] = ser->index_read(i)->offset();
+    }
+    for (block_id_t i = per_extent + young_garbage; i < 2 * per_extent; ++i) {
+        (*young_survivors_out)[i] = ser->index_read(i)->offset();
+    }
+    new_mutex_in_line_t dummy_acq;
+    ser->index_write(&dummy_acq, []{ }, write_ops);
+    return end + 1;
+}
+
+// Waits for the GC to move all the blocks in `*offsets`, and updates their offsets.
+bool wait_for_gc_to_move(log_serializer_t *ser, std::map<block_id_t, int64_t> *offsets) {
+    for (int i = 0; i < 500; ++i) {
+        bool all_moved = true;
+        for (const auto &pair : *offsets) {
+            if (ser->index_read(pair.first)->offset() == pair.second) {
+                all_moved = false;
+            }
+        }
+        if (all_moved) {
+            for (auto &pair : *offsets) {
+                pair.second = ser->index_read(pair.first)->offset();
+            }
+            return true;
+        }
+        nap(10);
+    }
+    return false;
+}
+
+void run_GcVictimOrder(gc_policy_t gc_policy) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    log_serializer_t::dynamic_config_t config;
+    config.gc_policy = gc_policy;
+    config.gc_separate_cold_data = true;
+    log_serializer_t ser(config, &file_opener, &get_global_perfmon_collection());
+
+    std::map<block_id_t, int64_t> old_survivors;
+    std::map<block_id_t, int64_t> young_survivors;
+    set_up_gc_victims(&ser, &old_survivors, &young_survivors);
+    const std::map<block_id_t, int64_t> old_offsets = old_survivors;
+
+    // The GC writes the blocks it moves to the extent for cold data in the order it
+    // collects their extents.
+    ASSERT_TRUE(wait_for_gc_to_move(&ser, &young_survivors));
+    int64_t min_young_offset = INT64_MAX;
+    for (const auto &pair : young_survivors) {
+        min_young_offset = std::min(min_young_offset, pair.second);
+    }
+    if (gc_policy == gc_policy_t::cost_benefit) {
+        // The old extent has less garbage, but it has been around for a lot longer.
+        ASSERT_TRUE(wait_for_gc_to_move(&ser, &old_survivors));
+        for (const auto &pair : old_survivors) {
+            ASSERT_LT(pair.second, min_young_offset);
+        }
+    } else {
+        // The young extent has the most garbage, so it goes first and the GC stops
+        // after it.
+        for (const auto &pair : old_survivors) {
+            ASSERT_EQ(old_offsets.at(pair.first), ser.index_read(pair.first)->offset());
+        }
+    }
+}
+
+TEST(SerializerTest, GcVictimOrderGreedy) {
+    unittest::run_in_thread_pool(std::bind(run_GcVictimOrder, gc_policy_t::greedy), 4);
+}
+
+TEST(SerializerTest, GcVictimOrderCostBenefit) {
+    unittest::run_in_thread_pool(std::bind(run_GcVictimOrder, gc_policy_t::cost_benefit), 4);
+}
+
+void run_GcSeparateColdData(bool separate_cold_data) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    log_serializer_t::dynamic_config_t config;
+    config.gc_separate_cold_data = separate_cold_data;
+    log_serializer_t ser(config, &file_opener, &get_global_perfmon_collection());
+
+    std::map<block_id_t, int64_t> old_survivors;
+    std::map<block_id_t, int64_t> cold_blocks;
+    const block_id_t end = set_up_gc_victims(&ser, &old_survivors, &cold_blocks);
+    ASSERT_TRUE(wait_for_gc_to_move(&ser, &cold_blocks));
+    std::set<int64_t> cold_extents;
+    for (const auto &pair : cold_blocks) {
+        cold_extents.insert(pair.second / ser.extent_size());
+    }
+
+    // New writes go to the extent that already has the block that triggered the
+    // GC in it, which still has plenty of room.
+    write_test_blocks(&ser, end, end + 10, end);
+    bool shared_extent = false;
+    for (block_id_t i = end + 1; i < end + 10; ++i) {
+        const int64_t extent = ser.index_read(i)->offset() / ser.extent_size();
+        shared_extent = shared_extent || cold_extents.count(extent) == 1;
+    }
+    ASSERT_EQ(!separate_cold_data, shared_extent);
+}
+
+TEST(SerializerTest, GcSeparateColdData) {
+    unittest::run_in_thread_pool(std::bind(run_GcSeparateColdData, true), 4);
+}
+
+TEST(SerializerTest, GcMixedColdData) {
+    unittest::run_in_thread_pool(std::bind(run_GcSeparateColdData, false), 4);
+}
+
+void run_LbaSnapshot() {
+    temp_directory_t tmp_dir;
+    const std::string snapshot_path = tmp_dir.path().path() + "/lba_snapshot";
+    mock_file_opener_t file_opener(snapshot_path);
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+
+    log_serializer_t::dynamic_config_t config;
+    config.lba_snapshot = true;
+
+    // A snapshot gets written on shutdown.
+    {
+        log_serializer_t ser(config, &file_opener, &get_global_perfmon_collection());
+        write_test_blocks(&ser, 0, 1000, 7);
+    }
+    const std::string first_snapshot = blocking_read_file(snapshot_path.c_str());
+
+    // The next start-up uses the snapshot and deletes it.
+    {
+        log_serializer_t ser(config, &file_opener, &get_global_perfmon_collection());
+        ASSERT_NE(0, access(snapshot_path.c_str(), F_OK));
+        check_test_blocks(&ser, 1000, {7});
+        write_test_blocks(&ser, 1000, 1100, 8);
+    }
+
+    // Put the first snapshot back.  It no longer matches the serializer file, so the
+    // serializer has to ignore it and read the LBA from disk.
+    {
+        FILE *f = fopen(snapshot_path.c_str(), "wb");
+        ASSERT_TRUE(f != nullptr);
+        ASSERT_EQ(first_snapshot.size(),
+                  fwrite(first_snapshot.data(), 1, first_snapshot.size(), f));
+        ASSERT_EQ(0, fclose(f));
+    }
+    log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                         &file_opener,
+                         &get_global_perfmon_collection());
+    ASSERT_NE(0, access(snapshot_path.c_str(), F_OK));
+    check_test_blocks(&ser, 1100, {7, 8});
+}
+
+TEST(SerializerTest, LbaSnapshot) {
+    run_in_thread_pool(run_LbaSnapshot, 4);
+}
+
+// Counts the index writes, each of which ends in its own metablock write.
+class index_write_counting_serializer_t : public log_serializer_t {
+public:
+    index_write_counting_serializer_t(serializer_file_opener_t *file_opener,
+                                      int *index_writes_out)
+        : log_serializer_t(log_serializer_t::dynamic_config_t(),
+                           file_opener,
+                           &get_global_perfmon_collection()),
+          index_writes_out_(index_writes_out) { }
+
+    void index_write(new_mutex_in_line_t *mutex_acq,
+                     const std::function<void()> &on_writes_reflected,
+                     const std::vector<index_write_op_t> &write_ops) {
+        ++*index_writes_out_;
+        log_serializer_t::index_write(mutex_acq, on_writes_reflected, write_ops);
+    }
+
+private:
+    int *const index_writes_out_;
+};
+
+void run_GroupCommit() {
+    const int num_writers = 16;
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    int index_writes = 0;
+    {
+        merger_group_commit_config_t group_commit_config;
+        group_commit_config.window_ms = 20;
+        merger_serializer_t ser(
+            make_scoped<index_write_counting_serializer_t>(&file_opener,
+                                                           &index_writes),
+            MERGER_SERIALIZER_MAX_ACTIVE_WRITES,
+            group_commit_config);
+
+        // The writers' index writes get committed in groups.
+        pmap(num_writers, [&](int i) {
+            buf_ptr_t buf = buf_ptr_t::alloc_zeroed(ser.max_block_size());
+            fill_test_block(i, buf);
+            buf_write_info_t info(buf.ser_buffer(), buf.block_size(), i);
+            struct : public iocallback_t, public cond_t {
+                void on_io_complete() {
+                    pulse();
+                }
+            } cb;
+            std::vector<counted_t<block_token_t>> tokens
+                = ser.block_writes(&info, 1, nullptr, &cb);
+            cb.wait();
+
+            std::vector<index_write_op_t> write_ops;
+            write_ops.push_back(index_write_op_t(
+                i, make_optional(tokens[0]),
+                make_optional(repli_timestamp_t::distant_past)));
+            new_mutex_in_line_t dummy_acq;
+            ser.index_write(&dummy_acq, []{ }, write_ops);
+        });
+    }
+    // The window lets the writers' index writes share commits.
+    ASSERT_LT(index_writes, num_writers);
+
+    log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                         &file_opener,
+                         &get_global_perfmon_collection());
+    check_test_blocks(&ser, num_writers, {});
+}
+
+TEST(SerializerTest, GroupCommit) {
+    run_in_thread_pool(run_GroupCommit, 4);
+}
+
+
+void run_BlockReads() {
+    const block_id_t num_blocks = 300;
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    log_serializer_t::dynamic_config_t config;
+#ifdef HAS_LZ4
+    config.block_compression = block_compression_t::lz4;
+#endif
+    log_serializer_t ser(config, &file_opener, &get_global_perfmon_collection());
+    // Two separate writes, so that the blocks end up in more than one run on disk.
+    write_test_blocks(&ser, 0, num_blocks / 2, 7);
+    write_test_blocks(&ser, num_blocks / 2, num_blocks, 8);
+
+    // Read the blocks in a scrambled order, skipping some of them and reading one
+    // of them twice.
+    std::vector<block_id_t> ids;
+    for (block_id_t i = 0; i < num_blocks; ++i) {
+        const block_id_t id = (i * 7919) % num_blocks;
+        if (id != 7 && id != 8 && id % 5 != 0) {
+            ids.push_back(id);
+        }
+    }
+    ids.push_back(ids.front());
+    std::vector<counted_t<block_token_t>> tokens;
+    for (block_id_t id : ids) {
+        tokens.push_back(ser.index_read(id));
+        ASSERT_TRUE(tokens.back().has());
+    }
+
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+    std::vector<buf_ptr_t> bufs = ser.block_reads(tokens, account.get());
+    ASSERT_EQ(ids.size(), bufs.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+        check_test_block(ids[i], ser.max_block_size(), bufs[i]);
+    }
+    ASSERT_TRUE(ser.block_reads({ }, account.get()).empty());
+}
+
+TEST(SerializerTest, BlockReads) {
+    run_in_thread_pool(run_BlockReads, 4);
+}
+
+void run_Defrag() {
+    const block_id_t num_blocks = 16000;
+    const block_id_t num_deleted_blocks = num_blocks * 3 / 4;
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    std::set<block_id_t> deleted_ids;
+    int64_t defragged_file_size;
+    {
+        log_serializer_t::dynamic_config_t config;
+        config.defrag = true;
+        log_serializer_t ser(config, &file_opener, &get_global_perfmon_collection());
+
+        for (block_id_t i = 0; i < num_blocks; i += 1000) {
+            write_test_blocks(&ser, i, i + 1000, i + 999);
+            deleted_ids.insert(i + 999);
+        }
+
+        // Deleting the blocks at the front of the file leaves the remaining ones at
+        // its end, in extents without any garbage that the GC wouldn't touch.  The
+        // file can only shrink if defragmentation moves them.
+        {
+            std::vector<index_write_op_t> write_ops;
+            for (block_id_t i = 0; i < num_deleted_blocks; ++i) {
+                write_ops.push_back(index_write_op_t(
+                    i, make_optional(counted_t<block_token_t>())));
+                deleted_ids.insert(i);
+            }
+            new_mutex_in_line_t dummy_acq;
+            ser.index_write(&dummy_acq, []{ }, write_ops);
+        }
+        const int64_t initial_file_size = file_opener.file_size();
+        std::map<block_id_t, int64_t> offsets;
+        for (block_id_t i = num_deleted_blocks; i < num_blocks - 3; ++i) {
+            if (deleted_ids.count(i) == 0) {
+                offsets[i] = ser.index_read(i)->offset();
+            }
+        }
+
+        // Extents only get moved once they are no longer young, and defragmentation
+        // is only considered after index writes, so we keep rewriting a block until
+        // defragmentation is done.
+        microtime_t start_time;
+        double progress;
+        bool saw_defrag = false;
+        for (int i = 0; i < 200; ++i) {
+            nap(50);
+            write_test_blocks(&ser, num_blocks - 2, num_blocks - 1, 0);
+            if (ser.get_defrag_progress(&start_time, &progress)) {
+                saw_defrag = true;
+            } else if (file_opener.file_size() <= initial_file_size / 2) {
+                break;
+            }
+        }
+        ASSERT_TRUE(saw_defrag);
+        defragged_file_size = file_opener.file_size();
+        ASSERT_GE(initial_file_size / 2, defragged_file_size);
+
+        // The blocks got moved towards the front of the file.
+        for (const auto &pair : offsets) {
+            ASSERT_LT(ser.index_read(pair.first)->offset(), pair.second);
+        }
+        check_test_blocks(&ser, num_blocks, deleted_ids);
+    }
+
+    // The file stays short, and the moved blocks stay readable once the serializer
+    // has been restarted.
+    log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                         &file_opener,
+                         &get_global_perfmon_collection());
+    ASSERT_GE(defragged_file_size, file_opener.file_size());
+    check_test_blocks(&ser, num_blocks, deleted_ids);
+}
+
+TEST(SerializerTest, Defrag) {
+    run_in_thread_pool(run_Defrag, 4);
+}
+
+repli_timestamp_t make_test_recency(uint64_t longtime) {
+    repli_timestamp_t ret;
+    ret.longtime = longtime;
+    return ret;
+}
+
+TEST(SerializerTest, CompactLbaIndex) {
+    in_memory_index_t index;
+    const size_t empty_usage = index.memory_usage();
+
+    // Sparse block ids, with recencies that are far apart so that the index has to
+    // rebase and then widen its recencies, and an offset that needs all 40 bits.
+    const std::vector<std::pair<block_id_t, index_block_info_t> > infos = {
+        { 3, index_block_info_t(flagged_off64_t::make(DEVICE_BLOCK_SIZE * 7),
+                                make_test_recency(1000), 4096, 0) },
+        { 5, index_block_info_t(flagged_off64_t::make(0),
+                                make_test_recency(10), 1200, 4096) },
+        { 6, index_block_info_t(flagged_off64_t::make(DEVICE_BLOCK_SIZE * 8),
+                                repli_timestamp_t::distant_past, 512, 0) },
+        { 7, index_block_info_t(flagged_off64_t::unused(),
+                                make_test_recency(uint64_t(1) << 40), 0, 0) },
+        { 1000000, index_block_info_t(
+            flagged_off64_t::make(((int64_t(1) << 40) - 2) * DEVICE_BLOCK_SIZE),
+            make_test_recency(5), 4096, 0) },
+        { FIRST_AUX_BLOCK_ID + 2, index_block_info_t(
+            flagged_off64_t::make(DEVICE_BLOCK_SIZE * 9),
+            repli_timestamp_t::invalid, 512, 0) } };
+    for (const auto &pair : infos) {
+        index.set_block_info(pair.first, pair.second.recency, pair.second.offset,
+                             pair.second.ser_block_size,
+                             pair.second.uncompressed_ser_block_size);
+    }
+
+    for (const auto &pair : infos) {
+        EXPECT_TRUE(index.get_block_info(pair.first) == pair.second);
+    }
+    EXPECT_TRUE(index.get_block_info(4) == index_block_info_t());
+    EXPECT_TRUE(index.get_block_info(999999) == index_block_info_t());
+    EXPECT_TRUE(index.get_block_info(FIRST_AUX_BLOCK_ID) == index_block_info_t());
+    EXPECT_EQ(1000001u, index.end_block_id());
+    EXPECT_EQ(FIRST_AUX_BLOCK_ID + 3, index.end_aux_block_id());
+
+    // The index should be a lot smaller than a flat array of `index_block_info_t`.
+    const size_t usage = index.memory_usage();
+    EXPECT_LT(empty_usage, usage);
+    EXPECT_GT(1000000 * sizeof(index_block_info_t), usage);
+
+    // Deleting all blocks frees the chunks again.
+    for (const auto &pair : infos) {
+        index.set_block_info(pair.first, repli_timestamp_t::invalid,
+                             flagged_off64_t::unused(), 0, 0);
+    }
+    for (const auto &pair : infos) {
+        EXPECT_TRUE(index.get_block_info(pair.first) == index_block_info_t());
+    }
+    EXPECT_GT(empty_usage + 4096, index.memory_usage());
+}
 
 }  // namespace unittest